@@ -17,8 +17,29 @@ AgvBase::~AgvBase()
         m_pSocket->waitForDisconnected(-1);
     }
 
+    if(m_pWheel)
+    {
+        m_pWheel->CancelSync(m_reconnectTimer);
+    }
+
     m_thread.quit();
     m_thread.wait();
+
+    // 按AGV建立的指标序列随AGV删除
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+    _registry.Remove(m_metrics.m_rxBytes);
+    _registry.Remove(m_metrics.m_rxPackets);
+    _registry.Remove(m_metrics.m_txBytes);
+    _registry.Remove(m_metrics.m_txPackets);
+    _registry.Remove(m_metrics.m_sendQueue);
+    _registry.Remove(m_metrics.m_connects);
+    _registry.Remove(m_metrics.m_linkBreaks);
+    _registry.Remove(m_metrics.m_reconnects);
+    _registry.Remove(m_metrics.m_updates);
+    _registry.Remove(m_metrics.m_processTime);
+    _registry.Remove(m_metrics.m_heartbeatRtt);
+    _registry.Remove(m_metrics.m_heartbeatLost);
+    _registry.Remove(m_metrics.m_linkScore);
 }
 
 void AgvBase::Initialize(const AgvType& _type, const AId_t &_id,
@@ -39,6 +60,11 @@ void AgvBase::Initialize(const AgvType& _type, const AId_t &_id,
     this->m_id = _id;
 
     this->m_pSocket = nullptr;
+    this->m_pRecorder = nullptr;
+    this->m_pWheel = nullptr;
+    this->m_reconnectTimer = TimingWheel::INVALID_TIMER;
+    this->m_backoff = std::chrono::milliseconds(100);
+    this->m_lastHeartbeat.store(std::chrono::steady_clock::now().time_since_epoch().count());
     this->m_bClient = _bClient;
     this->m_peerAddr = _peerAddr;
     this->m_peerPort = _peerPort;
@@ -47,6 +73,8 @@ void AgvBase::Initialize(const AgvType& _type, const AId_t &_id,
 
     InitAttribute();
 
+    InitMetrics();
+
     if(m_bClient == false)
     {
         Connect();
@@ -67,6 +95,7 @@ void AgvBase::InitAttribute()
     this->m_speed = 0;
     this->m_cargo = 0;
     this->m_error = Err_None;
+    this->m_errSelf = Err_None;
 
     this->m_action = 0;
     this->m_actStatus = 0;
@@ -78,11 +107,51 @@ void AgvBase::InitAttribute()
     this->m_oldEndRfid = m_endRfid;
 }
 
+void AgvBase::InitMetrics()
+{
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+
+    std::string _labels = "agv=\"" + std::to_string(m_id) + "\"";
+
+    m_metrics.m_rxBytes = _registry.AddCounter("agv_rx_bytes_total","Bytes received from the AGV",_labels);
+    m_metrics.m_rxPackets = _registry.AddCounter("agv_rx_packets_total","Valid packets received from the AGV",_labels);
+    m_metrics.m_txBytes = _registry.AddCounter("agv_tx_bytes_total","Bytes sent to the AGV",_labels);
+    m_metrics.m_txPackets = _registry.AddCounter("agv_tx_packets_total","Packets sent to the AGV",_labels);
+    m_metrics.m_sendQueue = _registry.AddGauge("agv_send_queue_depth","Packets waiting in the send list",_labels);
+    m_metrics.m_connects = _registry.AddCounter("agv_connects_total","Successful connections",_labels);
+    m_metrics.m_linkBreaks = _registry.AddCounter("agv_link_breaks_total","Connections closed",_labels);
+    m_metrics.m_reconnects = _registry.AddCounter("agv_reconnects_total","Reconnect attempts after socket errors",_labels);
+    m_metrics.m_updates = _registry.AddCounter("agv_updates_total","Update signals emitted",_labels);
+    m_metrics.m_processTime = _registry.AddHistogram("agv_process_seconds","Time spent decoding and processing received data",
+                                                     {0.00001,0.00005,0.0001,0.0005,0.001,0.005,0.01,0.05},_labels);
+    m_metrics.m_heartbeatRtt = _registry.AddHistogram("agv_heartbeat_rtt_seconds","Heartbeat round-trip time",
+                                                      {0.005,0.01,0.02,0.05,0.1,0.2,0.5,1.0},_labels);
+    m_metrics.m_heartbeatLost = _registry.AddCounter("agv_heartbeat_lost_total","Heartbeats without a reply before the timeout",_labels);
+    m_metrics.m_linkScore = _registry.AddGauge("agv_link_score","Link quality score from 0 to 100",_labels);
+
+    return;
+}
+
 AgvType AgvBase::GetType() const
 {
     return *m_pType;
 }
 
+unsigned char AgvBase::GetAbility() const
+{
+    return m_pType->m_type;
+}
+
+float AgvBase::GetMaxWeight() const
+{
+    return m_pType->m_maxWeight;
+}
+
+float AgvBase::GetMaxSpeed() const
+{
+    return m_pType->m_maxSpeed;
+}
+
 AgvBase::AId_t AgvBase::GetID() const
 {
     return m_id;
@@ -401,6 +470,8 @@ bool AgvBase::UpdateCurRfid(const RfidBase::Rfid_t &_rfid)
         m_oldRfid = m_curRfid;
         m_curRfid = _rfid;
 
+        emit RfidChanged();
+
         return true;
     }
 
@@ -505,42 +576,7 @@ AgvBase::CmdErr AgvBase::Move(const unsigned short &_rfid)
         return Cmd_StatusErr;
     }
 
-    // 编号 + 功能 + 起始RFID + 终止RFID
-    unsigned int _size = sizeof(m_id) + 1 + sizeof(m_curRfid) * 2;  /*!< 数据包大小 */
-
-    char* _packet = new char[_size];    /*!< 数据包 */
-
-    // 初始化数据包
-    memset(_packet,0,_size);
-
-    unsigned int _index = 0;    /*!< 下标 */
-
-    // 编号
-    for(unsigned int i = sizeof(m_id); i > 0;--i)
-    {
-        _packet[_index++] = static_cast<char>((m_id >> 8 * (i-1)) & 0xFF);
-    }
-
-    // 功能
-    _packet[_index++] = Func_Move;
-
-    // 当前RFID地标卡
-    for(unsigned int i = sizeof(m_curRfid); i > 0;--i)
-    {
-        _packet[_index++] = static_cast<char>((m_curRfid >> 8 * (i-1)) & 0xFF);
-    }
-
-    // 终止RFID地标卡
-    for(unsigned int i = sizeof(m_curRfid); i > 0;--i)
-    {
-        _packet[_index++] = static_cast<char>((_rfid >> 8 * (i-1)) & 0xFF);
-    }
-
-    // 合成报文包
-    m_listSend.push_back(m_pType->m_pProtocol->CreatePacket(QByteArray(_packet,static_cast<int>(_index))));
-
-    // 释放内存
-    delete[] _packet;
+    m_listSend.push_back(CreateMovePacket(m_curRfid,_rfid));
 
     return Cmd_Success;
 }
@@ -812,6 +848,25 @@ void AgvBase::Heartbeat()
     return;
 }
 
+void AgvBase::HeartbeatSent()
+{
+    // 记录写出的时间,与回复配对计算往返时间
+    std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now();
+
+    size_t _lost = m_link.Expire(_now);
+
+    m_link.Sent(_now);
+
+    if(_lost > 0)
+    {
+        MetricsRegistry& _registry = MetricsRegistry::Instance();
+        _registry.Add(m_metrics.m_heartbeatLost,_lost);
+        _registry.Set(m_metrics.m_linkScore,m_link.GetScore());
+    }
+
+    return;
+}
+
 AgvBase::CmdErr AgvBase::SetStatus(const unsigned char& _cmd)
 {
     if(IsConnected() == false)
@@ -961,6 +1016,55 @@ AgvBase::CmdErr AgvBase::Action(const unsigned char &_act)
         return Cmd_StatusErr;
     }
 
+    m_listSend.push_back(CreateActionPacket(m_curRfid,_act));
+
+    return Cmd_Success;
+}
+
+QByteArray AgvBase::CreateMovePacket(const RfidBase::Rfid_t &_from, const unsigned short &_rfid) const
+{
+    // 编号 + 功能 + 起始RFID + 终止RFID
+    unsigned int _size = sizeof(m_id) + 1 + sizeof(m_curRfid) * 2;  /*!< 数据包大小 */
+
+    char* _packet = new char[_size];    /*!< 数据包 */
+
+    // 初始化数据包
+    memset(_packet,0,_size);
+
+    unsigned int _index = 0;    /*!< 下标 */
+
+    // 编号
+    for(unsigned int i = sizeof(m_id); i > 0;--i)
+    {
+        _packet[_index++] = static_cast<char>((m_id >> 8 * (i-1)) & 0xFF);
+    }
+
+    // 功能
+    _packet[_index++] = Func_Move;
+
+    // 起始RFID地标卡
+    for(unsigned int i = sizeof(m_curRfid); i > 0;--i)
+    {
+        _packet[_index++] = static_cast<char>((_from >> 8 * (i-1)) & 0xFF);
+    }
+
+    // 终止RFID地标卡
+    for(unsigned int i = sizeof(m_curRfid); i > 0;--i)
+    {
+        _packet[_index++] = static_cast<char>((_rfid >> 8 * (i-1)) & 0xFF);
+    }
+
+    // 合成报文包
+    QByteArray _frame = m_pType->m_pProtocol->CreatePacket(QByteArray(_packet,static_cast<int>(_index)));
+
+    // 释放内存
+    delete[] _packet;
+
+    return _frame;
+}
+
+QByteArray AgvBase::CreateActionPacket(const RfidBase::Rfid_t &_rfid, const unsigned char &_act) const
+{
     // 编号 + 功能 + 当前RFID + 动作码
     unsigned int _size = sizeof(m_id) + 1 + sizeof(m_curRfid) + sizeof(m_action);   /*!< 数据包大小 */
 
@@ -983,7 +1087,7 @@ AgvBase::CmdErr AgvBase::Action(const unsigned char &_act)
     // 当前RFID地标卡
     for(unsigned int i = sizeof(m_curRfid); i > 0;--i)
     {
-        _packet[_index++] = static_cast<char>((m_curRfid >> 8 * (i-1)) & 0xFF);
+        _packet[_index++] = static_cast<char>((_rfid >> 8 * (i-1)) & 0xFF);
     }
 
     // 动作码
@@ -993,14 +1097,49 @@ AgvBase::CmdErr AgvBase::Action(const unsigned char &_act)
     }
 
     // 合成报文包
-    m_listSend.push_back(m_pType->m_pProtocol->CreatePacket(QByteArray(_packet,static_cast<int>(_index))));
+    QByteArray _frame = m_pType->m_pProtocol->CreatePacket(QByteArray(_packet,static_cast<int>(_index)));
 
     // 释放内存
     delete[] _packet;
 
+    return _frame;
+}
+
+AgvBase::CmdErr AgvBase::SendCommand(const QByteArray &_packet)
+{
+    if(IsConnected() == false)
+    {
+        // 网络未连接
+        return Cmd_NetErr;
+    }
+
+    if(m_mode != Mode_Auto)
+    {
+        // 未处于自动模式
+        return Cmd_StatusErr;
+    }
+
+    if(m_status != Sta_Wait)
+    {
+        // 未处于待机状态
+        return Cmd_StatusErr;
+    }
+
+    m_listSend.push_back(_packet);
+
     return Cmd_Success;
 }
 
+AgvBase::AAction_t AgvBase::GetLoadAction() const
+{
+    return 0;
+}
+
+AgvBase::AAction_t AgvBase::GetUnloadAction() const
+{
+    return 0;
+}
+
 void AgvBase::ProcessPacket(const QByteArray &_packet)
 {
     unsigned int _sizeLen = 0;
@@ -1042,6 +1181,23 @@ void AgvBase::ProcessPacket(const QByteArray &_packet)
     {
         // 心跳报文回复
 
+        // 往返时间
+        double _rtt = 0.0;
+
+        std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now();
+
+        MetricsRegistry& _registry = MetricsRegistry::Instance();
+        _registry.Add(m_metrics.m_heartbeatLost,m_link.Expire(_now));
+
+        m_lastHeartbeat.store(_now.time_since_epoch().count(),std::memory_order_relaxed);
+
+        if(m_link.Received(_now,_rtt))
+        {
+            _registry.Observe(m_metrics.m_heartbeatRtt,_rtt / 1000.0);
+        }
+
+        _registry.Set(m_metrics.m_linkScore,m_link.GetScore());
+
         // 模式
         AMode_t _mode = 0;
 
@@ -1192,6 +1348,8 @@ void AgvBase::ProcessPacket(const QByteArray &_packet)
 
         if(bUpdate)
         {
+            MetricsRegistry::Instance().Add(m_metrics.m_updates);
+
             emit Update();
         }
 
@@ -1343,8 +1501,44 @@ bool AgvBase::IsConnected() const
     return m_pSocket->isOpen();
 }
 
+LinkQuality::LinkStat AgvBase::GetLinkStat() const
+{
+    return m_link.GetStat();
+}
+
+int AgvBase::GetLinkScore() const
+{
+    return m_link.GetScore();
+}
+
+std::chrono::steady_clock::time_point AgvBase::GetLastHeartbeat() const
+{
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_lastHeartbeat.load(std::memory_order_relaxed)));
+}
+
+void AgvBase::SetTimingWheel(TimingWheel *_wheel)
+{
+    m_pWheel = _wheel;
+
+    return;
+}
+
+void AgvBase::SetRecorder(WireRecorder *_recorder)
+{
+    m_pRecorder = _recorder;
+
+    return;
+}
+
 void AgvBase::Connected()
 {
+    MetricsRegistry::Instance().Add(m_metrics.m_connects);
+
+    m_backoff = std::chrono::milliseconds(100);
+
+    // 新建立的连接从此刻开始计算心跳回复的期限
+    m_lastHeartbeat.store(std::chrono::steady_clock::now().time_since_epoch().count(),std::memory_order_relaxed);
+
     m_timer.start();
 
     if(m_errSelf == Err_Net)
@@ -1352,6 +1546,9 @@ void AgvBase::Connected()
         m_errSelf = Err_None;
     }
 
+    // 重新连接后心跳回复的信息可能与断开前相同,不会发出Update信号
+    emit Update();
+
     return;
 }
 
@@ -1368,6 +1565,13 @@ void AgvBase::DisConnected()
 
     m_listSend.clear();
 
+    m_link.Reset();
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+    _registry.Add(m_metrics.m_linkBreaks);
+    _registry.Set(m_metrics.m_sendQueue,0);
+    _registry.Set(m_metrics.m_linkScore,0);
+
     emit LinkBreak();
 
     return;
@@ -1375,30 +1579,110 @@ void AgvBase::DisConnected()
 
 void AgvBase::Error()
 {
+    if(m_pWheel == nullptr)
+    {
+        Reconnect();
+
+        return;
+    }
+
+    if(m_reconnectTimer != TimingWheel::INVALID_TIMER)
+    {
+        // 已在等待重新连接
+        return;
+    }
+
+    // 析构时同步取消定时器,等待正在执行的回调返回;已投递的调用随AGV删除而丢弃
+    m_reconnectTimer = m_pWheel->Start(m_backoff,[this]{ QMetaObject::invokeMethod(this,"Reconnect",Qt::QueuedConnection); });
+
+    // 连接失败的次数越多,等待时间越长,最长10s
+    m_backoff = std::min(m_backoff * 2,std::chrono::milliseconds(10000));
+
+    return;
+}
+
+void AgvBase::Reconnect()
+{
+    m_reconnectTimer = TimingWheel::INVALID_TIMER;
+
+    if(m_bClient || m_pSocket == nullptr)
+    {
+        // 客户端模式由AGV主动连接
+        return;
+    }
+
+    MetricsRegistry::Instance().Add(m_metrics.m_reconnects);
+
     // 重新连接客户端
     m_pSocket->connectToHost(m_peerAddr,m_peerPort);
 
     return;
 }
 
+void AgvBase::HeartbeatLost()
+{
+    UpdateErrorSelf(Err_Net);
+
+    if(m_pSocket)
+    {
+        // 半开的连接不会触发断开信号,主动中止连接
+        m_pSocket->abort();
+    }
+
+    if(m_pSocket)
+    {
+        DisConnected();
+    }
+
+    if(m_bClient == false)
+    {
+        // 服务端模式下重新建立连接
+        Connect();
+    }
+
+    return;
+}
+
 void AgvBase::ReadData()
 {
     if(m_pSocket->isReadable())
     {
-        m_buf += m_pSocket->readAll();
+        QByteArray _data = m_pSocket->readAll();
 
-        // 处理数据
-        QByteArrayList _list = m_pType->m_pProtocol->ProcessData(m_buf);
+        MetricsRegistry::Instance().Add(m_metrics.m_rxBytes,static_cast<unsigned long long>(_data.size()));
 
-        for(QByteArrayList::iterator it = _list.begin(); it != _list.end();++it)
+        if(m_pRecorder)
         {
-            ProcessPacket(*it);
+            m_pRecorder->Record(m_id,WireRecorder::Dir_In,_data);
         }
+
+        ReceiveData(_data);
     }
 
     return;
 }
 
+void AgvBase::ReceiveData(const QByteArray &_data)
+{
+    std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();   /*!< 开始处理的时间 */
+
+    m_buf += _data;
+
+    // 处理数据
+    QByteArrayList _list = m_pType->m_pProtocol->ProcessData(m_buf);
+
+    for(QByteArrayList::iterator it = _list.begin(); it != _list.end();++it)
+    {
+        ProcessPacket(*it);
+    }
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+    _registry.Add(m_metrics.m_rxPackets,static_cast<unsigned long long>(_list.size()));
+    _registry.Observe(m_metrics.m_processTime,std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count());
+
+    return;
+}
+
 void AgvBase::SendPacket()
 {
     if(IsConnected())
@@ -1408,6 +1692,13 @@ void AgvBase::SendPacket()
 
     Heartbeat();
 
+    // 心跳报文位于列表末尾,排在其前的报文写出后才写出
+    int _heartbeat = m_listSend.size() - 1;
+    int _written = 0;
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+    _registry.Set(m_metrics.m_sendQueue,m_listSend.size());
+
     for(QByteArrayList::iterator it = m_listSend.begin();it != m_listSend.end();++it)
     {
         if(m_pSocket->write(it->data(),it->size()) == -1)
@@ -1419,6 +1710,19 @@ void AgvBase::SendPacket()
             return;
         }
 
+        if(m_pRecorder)
+        {
+            m_pRecorder->Record(m_id,WireRecorder::Dir_Out,*it);
+        }
+
+        if(_written++ == _heartbeat)
+        {
+            HeartbeatSent();
+        }
+
+        _registry.Add(m_metrics.m_txPackets);
+        _registry.Add(m_metrics.m_txBytes,static_cast<unsigned long long>(it->size()));
+
         m_thread.wait(100);
     }
 
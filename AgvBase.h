@@ -11,9 +11,13 @@
 #include <QObject>
 #include <QtNetwork>
 #include <QThread>
+#include <atomic>
 #include "ProtocolStm32.h"
 #include "ProtocolPlc.h"
 #include "RfidBase.h"
+#include "WireRecorder.h"
+#include "LinkQuality.h"
+#include "TimingWheel.h"
 
 /*!
  * @brief 描述AGV类型信息的结构体
@@ -122,6 +126,33 @@ protected:
     QThread m_thread;                                   /*!< 用以发送数据的线程 */
     QByteArrayList m_listSend;                          /*!< 待发送的报文列表 */
     QTimer m_timer;                                     /*!< 发送报文的时间间隔 计时器 */
+    WireRecorder* m_pRecorder;                          /*!< 通信数据录制器 */
+    LinkQuality m_link;                                 /*!< 心跳报文往返时间与链路质量 */
+    TimingWheel* m_pWheel;                              /*!< 共用的时间轮 */
+    TimingWheel::TimerId m_reconnectTimer;              /*!< 重新连接的定时器 */
+    std::chrono::milliseconds m_backoff;                /*!< 下一次重新连接前的等待时间 */
+    std::atomic<long long> m_lastHeartbeat;             /*!< 最后一次收到心跳回复的时间,可在任意线程读取 */
+
+protected:
+    /*! @brief 描述AGV运行指标编号的结构体 */
+    struct AgvMetrics
+    {
+        MetricsRegistry::MetricId m_rxBytes;            /*!< 接收的字节数 */
+        MetricsRegistry::MetricId m_rxPackets;          /*!< 接收的报文数量 */
+        MetricsRegistry::MetricId m_txBytes;            /*!< 发送的字节数 */
+        MetricsRegistry::MetricId m_txPackets;          /*!< 发送的报文数量 */
+        MetricsRegistry::MetricId m_sendQueue;          /*!< 待发送的报文数量 */
+        MetricsRegistry::MetricId m_connects;           /*!< 连接成功的次数 */
+        MetricsRegistry::MetricId m_linkBreaks;         /*!< 连接中断的次数 */
+        MetricsRegistry::MetricId m_reconnects;         /*!< 重新连接的次数 */
+        MetricsRegistry::MetricId m_updates;            /*!< 发出Update信号的次数 */
+        MetricsRegistry::MetricId m_processTime;        /*!< 处理接收数据的耗时 */
+        MetricsRegistry::MetricId m_heartbeatRtt;       /*!< 心跳报文往返时间 */
+        MetricsRegistry::MetricId m_heartbeatLost;      /*!< 丢失的心跳报文数量 */
+        MetricsRegistry::MetricId m_linkScore;          /*!< 链路质量评分 */
+    };
+
+    AgvMetrics m_metrics;                               /*!< 运行指标编号 */
 
 protected:
     /*!
@@ -144,6 +175,11 @@ protected:
      */
     void InitAttribute();
 
+    /*!
+     * @brief 注册运行指标
+     */
+    void InitMetrics();
+
 public:
     /*!
      * @brief 获取类型信息
@@ -151,6 +187,24 @@ public:
      */
     AgvType GetType() const;
 
+    /*!
+     * @brief 获取功能,不复制类型信息
+     * @return unsigned char 功能,见AgvType::AgvAbility
+     */
+    unsigned char GetAbility() const;
+
+    /*!
+     * @brief 获取最大载重量,不复制类型信息
+     * @return float 最大载重量:单位(kg)
+     */
+    float GetMaxWeight() const;
+
+    /*!
+     * @brief 获取最大速度,不复制类型信息
+     * @return float 最大速度:单位(m/min)
+     */
+    float GetMaxSpeed() const;
+
     /*!
      * @brief 获取编号
      * @return AId_t 编号
@@ -403,13 +457,15 @@ public:
      * @param const unsigned short& 指定的目的地RFID地标卡
      * @return CmdErr 指令发送成功返回0
      */
-    CmdErr Move(const unsigned short& _rfid);
+    Q_INVOKABLE CmdErr Move(const unsigned short& _rfid);
 
     /*!
      * @brief 允许AGV通过交通管制点
+     *
+     * 可由QMetaObject::invokeMethod从其他线程投递至AGV所在的线程调用
      * @return CmdErr 指令发送成功返回0
      */
-    CmdErr TrafficPass();
+    Q_INVOKABLE CmdErr TrafficPass();
 
     /*!
      * @brief 调整AGV最大速度
@@ -431,12 +487,54 @@ public:
      */
     CmdErr StopAction();
 
+    /*!
+     * @brief 生成移动控制报文,不发送
+     * @param const RfidBase::Rfid_t& 起始RFID地标卡
+     * @param const unsigned short& 目的地RFID地标卡
+     * @return QByteArray 报文包
+     */
+    QByteArray CreateMovePacket(const RfidBase::Rfid_t& _from,const unsigned short& _rfid) const;
+
+    /*!
+     * @brief 生成动作控制报文,不发送
+     * @param const RfidBase::Rfid_t& 执行动作的RFID地标卡
+     * @param const unsigned char& 动作码
+     * @return QByteArray 报文包
+     */
+    QByteArray CreateActionPacket(const RfidBase::Rfid_t& _rfid,const unsigned char& _act) const;
+
+    /*!
+     * @brief 发送预先生成的移动或动作控制报文
+     *
+     * 与Move、Action相同,只在自动模式的待机状态下发送
+     * @param const QByteArray& 报文包
+     * @return CmdErr 指令发送成功返回0
+     */
+    CmdErr SendCommand(const QByteArray& _packet);
+
+    /*!
+     * @brief 获取取货的动作码
+     * @return AAction_t 动作码,0为取货无需动作
+     */
+    virtual AAction_t GetLoadAction() const;
+
+    /*!
+     * @brief 获取卸货的动作码
+     * @return AAction_t 动作码,0为卸货无需动作
+     */
+    virtual AAction_t GetUnloadAction() const;
+
 protected:    
     /*!
      * @brief 发生心跳报文至AGV
      */
     void Heartbeat();
 
+    /*!
+     * @brief 心跳报文已写出,记录发送时间以计算往返时间
+     */
+    void HeartbeatSent();
+
     /*!
      * @brief 发送状态控制报文
      * @param const unsigned char& 状态控制码
@@ -480,6 +578,50 @@ public:
      */
     bool IsConnected() const;
 
+    /*!
+     * @brief 获取链路统计信息
+     * @return LinkQuality::LinkStat 心跳报文往返时间、抖动与丢包率等统计信息
+     */
+    LinkQuality::LinkStat GetLinkStat() const;
+
+    /*!
+     * @brief 获取链路质量评分
+     *
+     * 可在任意线程调用,调度时应避免将实时性要求高的任务分配给评分低的AGV
+     * @return int 链路质量评分:0~100
+     */
+    int GetLinkScore() const;
+
+    /*!
+     * @brief 获取最后一次收到心跳回复的时间
+     *
+     * 可在任意线程调用,连接成功时也会更新此时间
+     * @return std::chrono::steady_clock::time_point 最后一次收到心跳回复的时间
+     */
+    std::chrono::steady_clock::time_point GetLastHeartbeat() const;
+
+    /*!
+     * @brief 设置共用的时间轮
+     *
+     * 设置后连接失败时按指数退避重新连接,否则立即重新连接
+     * @param TimingWheel* 时间轮
+     */
+    void SetTimingWheel(TimingWheel* _wheel);
+
+    /*!
+     * @brief 设置通信数据录制器
+     * @param WireRecorder* 录制器,为nullptr时停止录制
+     */
+    void SetRecorder(WireRecorder* _recorder);
+
+    /*!
+     * @brief 处理接收到的数据
+     *
+     * 网络接收与数据回放共用此函数
+     * @param const QByteArray& 接收到的原始数据
+     */
+    void ReceiveData(const QByteArray& _data);
+
 signals:
     /*!
      * @brief 当与AGV通信中断时发出此信号
@@ -488,9 +630,16 @@ signals:
 
     /*!
      * @brief 当AGV更新时发出此信号
+     *
+     * 心跳回复的信息改变或连接成功时发出
      */
     void Update();
 
+    /*!
+     * @brief 当AGV的当前RFID地标卡改变时发出此信号
+     */
+    void RfidChanged();
+
     /*!
      * @breif 当AGV发生异常时发出此信息
      */
@@ -513,6 +662,18 @@ protected slots:
      */
     void Error();
 
+    /*!
+     * @brief 重新连接AGV的槽函数
+     */
+    void Reconnect();
+
+    /*!
+     * @brief 超过期限未收到心跳回复时触发的槽函数
+     *
+     * 设置Err_Net异常,关闭可能已半开的连接并重新连接
+     */
+    void HeartbeatLost();
+
     /*!
      * @brief 有数据读取时触发的槽函数
      */
@@ -0,0 +1,316 @@
+#include "AgvIndex.h"
+
+const unsigned char AgvIndex::ABILITY_COUNT = 8;
+
+AgvIndex::AgvIndex()
+    : m_buckets(ABILITY_COUNT * Avail_Count)
+{
+}
+
+AgvIndex::~AgvIndex()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    for(std::map<AgvBase::AId_t,Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        QObject::disconnect(it->second.m_update);
+        QObject::disconnect(it->second.m_linkBreak);
+    }
+}
+
+void AgvIndex::Add(AgvBase *_agv)
+{
+    if(_agv == nullptr)
+    {
+        return;
+    }
+
+    Remove(_agv->GetID());
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    // 添加时在调用线程中采集一次,之后由信号在AGV所在的线程中更新
+    Entry& _entry = m_entries[_agv->GetID()];
+    _entry.m_snapshot = Capture(_agv);
+    _entry.m_claim = Claim_None;
+
+    Insert(_entry);
+
+    // 信号在AGV所在的线程中发出,直接在该线程中判定,读取的状态与信号一致
+    _entry.m_update = QObject::connect(_agv,&AgvBase::Update,[this,_agv]{ Refresh(_agv); });
+    _entry.m_linkBreak = QObject::connect(_agv,&AgvBase::LinkBreak,[this,_agv]{ Refresh(_agv); });
+
+    return;
+}
+
+void AgvIndex::Remove(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Entry>::iterator it = m_entries.find(_id);
+
+    if(it == m_entries.end())
+    {
+        return;
+    }
+
+    QObject::disconnect(it->second.m_update);
+    QObject::disconnect(it->second.m_linkBreak);
+
+    Erase(it->second);
+
+    m_entries.erase(it);
+
+    return;
+}
+
+void AgvIndex::Refresh(AgvBase *_agv)
+{
+    Snapshot _snapshot = Capture(_agv);
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Entry>::iterator it = m_entries.find(_snapshot.m_id);
+
+    if(it == m_entries.end())
+    {
+        return;
+    }
+
+    if(it->second.m_snapshot.m_state == _snapshot.m_state)
+    {
+        it->second.m_snapshot = _snapshot;
+        return;
+    }
+
+    Erase(it->second);
+
+    if(_snapshot.m_state == Avail_Idle && it->second.m_claim != Claim_Order)
+    {
+        // 已到达停车点或充电结束
+        it->second.m_claim = Claim_None;
+    }
+
+    it->second.m_snapshot = _snapshot;
+
+    Insert(it->second);
+
+    return;
+}
+
+size_t AgvIndex::Get(const unsigned char &_ability, const AgvIndex::Availability &_state, std::vector<AgvBase *> &_agvs)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    size_t _count = 0;
+
+    for(unsigned char i = 0; i < ABILITY_COUNT; ++i)
+    {
+        if(_ability != 0 && _ability != i)
+        {
+            continue;
+        }
+
+        const std::vector<Entry*>& _bucket = m_buckets[Bucket(i,_state)];
+
+        for(std::vector<Entry*>::const_iterator it = _bucket.begin(); it != _bucket.end(); ++it)
+        {
+            _agvs.push_back((*it)->m_snapshot.m_pAgv);
+        }
+
+        _count += _bucket.size();
+    }
+
+    return _count;
+}
+
+size_t AgvIndex::GetSnapshots(const unsigned char &_ability, const AgvIndex::Availability &_state, std::vector<AgvIndex::Snapshot> &_snapshots)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    size_t _count = 0;
+
+    for(unsigned char i = 0; i < ABILITY_COUNT; ++i)
+    {
+        if(_ability != 0 && _ability != i)
+        {
+            continue;
+        }
+
+        const std::vector<Entry*>& _bucket = m_buckets[Bucket(i,_state)];
+
+        for(std::vector<Entry*>::const_iterator it = _bucket.begin(); it != _bucket.end(); ++it)
+        {
+            _snapshots.push_back((*it)->m_snapshot);
+        }
+
+        _count += _bucket.size();
+    }
+
+    return _count;
+}
+
+bool AgvIndex::GetSnapshot(const AgvBase::AId_t &_id, AgvIndex::Snapshot &_snapshot)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Entry>::const_iterator it = m_entries.find(_id);
+
+    if(it == m_entries.end())
+    {
+        return false;
+    }
+
+    _snapshot = it->second.m_snapshot;
+
+    return true;
+}
+
+size_t AgvIndex::GetCount(const unsigned char &_ability, const AgvIndex::Availability &_state)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(_ability != 0)
+    {
+        return _ability < ABILITY_COUNT ? m_buckets[Bucket(_ability,_state)].size() : 0;
+    }
+
+    size_t _count = 0;
+
+    for(unsigned char i = 0; i < ABILITY_COUNT; ++i)
+    {
+        _count += m_buckets[Bucket(i,_state)].size();
+    }
+
+    return _count;
+}
+
+AgvIndex::Availability AgvIndex::GetState(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Entry>::const_iterator it = m_entries.find(_id);
+
+    if(it == m_entries.end())
+    {
+        return Avail_Offline;
+    }
+
+    return it->second.m_snapshot.m_state;
+}
+
+bool AgvIndex::Claim(const AgvBase::AId_t &_id, const AgvIndex::Claimant &_claimant)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Entry>::iterator it = m_entries.find(_id);
+
+    if(it == m_entries.end() || it->second.m_snapshot.m_state != Avail_Idle || it->second.m_claim >= _claimant)
+    {
+        return false;
+    }
+
+    it->second.m_claim = _claimant;
+
+    return true;
+}
+
+void AgvIndex::Unclaim(const AgvBase::AId_t &_id, const AgvIndex::Claimant &_claimant)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Entry>::iterator it = m_entries.find(_id);
+
+    if(it == m_entries.end() || it->second.m_claim != _claimant)
+    {
+        return;
+    }
+
+    it->second.m_claim = Claim_None;
+
+    return;
+}
+
+AgvIndex::Claimant AgvIndex::GetClaim(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Entry>::const_iterator it = m_entries.find(_id);
+
+    if(it == m_entries.end())
+    {
+        return Claim_None;
+    }
+
+    return it->second.m_claim;
+}
+
+AgvIndex::Availability AgvIndex::Classify(const AgvBase *_agv)
+{
+    if(_agv->IsConnected() == false)
+    {
+        return Avail_Offline;
+    }
+
+    if(_agv->GetMode() != AgvBase::Mode_Auto
+            || _agv->GetStatus() != AgvBase::Sta_Wait
+            || _agv->GetError() != AgvBase::Err_None)
+    {
+        return Avail_Busy;
+    }
+
+    if(_agv->GetCargo() != 0)
+    {
+        return Avail_Loaded;
+    }
+
+    return Avail_Idle;
+}
+
+AgvIndex::Snapshot AgvIndex::Capture(AgvBase *_agv)
+{
+    Snapshot _snapshot;
+    _snapshot.m_pAgv = _agv;
+    _snapshot.m_id = _agv->GetID();
+    _snapshot.m_ability = _agv->GetAbility();
+    _snapshot.m_maxWeight = _agv->GetMaxWeight();
+    _snapshot.m_maxSpeed = _agv->GetMaxSpeed();
+    _snapshot.m_rfid = _agv->GetCurRfid();
+    _snapshot.m_battery = _agv->GetBattery();
+    _snapshot.m_cargo = _agv->GetCargo();
+    _snapshot.m_status = _agv->GetStatus();
+    _snapshot.m_state = Classify(_agv);
+
+    return _snapshot;
+}
+
+size_t AgvIndex::Bucket(const unsigned char &_ability, const AgvIndex::Availability &_state)
+{
+    // 超出分桶范围的功能归入0号分桶
+    return static_cast<size_t>(_ability < ABILITY_COUNT ? _ability : 0) * Avail_Count + _state;
+}
+
+void AgvIndex::Insert(AgvIndex::Entry &_entry)
+{
+    std::vector<Entry*>& _bucket = m_buckets[Bucket(_entry.m_snapshot.m_ability,_entry.m_snapshot.m_state)];
+
+    _entry.m_slot = _bucket.size();
+
+    _bucket.push_back(&_entry);
+
+    return;
+}
+
+void AgvIndex::Erase(AgvIndex::Entry &_entry)
+{
+    std::vector<Entry*>& _bucket = m_buckets[Bucket(_entry.m_snapshot.m_ability,_entry.m_snapshot.m_state)];
+
+    // 以末尾元素填补空位
+    Entry* _last = _bucket.back();
+    _bucket[_entry.m_slot] = _last;
+    _last->m_slot = _entry.m_slot;
+
+    _bucket.pop_back();
+
+    return;
+}
@@ -0,0 +1,207 @@
+/*!
+ * @file AgvIndex
+ * @brief 描述按功能与可用状态索引AGV功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef AGVINDEX_H
+#define AGVINDEX_H
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include "AgvBase.h"
+
+/*!
+ * @class AgvIndex
+ * @brief 按功能×可用状态分桶的AGV索引
+ *
+ * AGV发出Update或LinkBreak信号时在其所在的线程中重新判定可用状态,状态改变才移动分桶
+ * 查找某功能的空闲AGV只需读取对应分桶,不需要遍历车队,也不复制AgvType
+ * 分桶内以交换末尾元素的方式删除,添加、删除与移动均为O(1)
+ * 订单分配、停车点规划与充电调度共用同一索引时,派出空闲AGV前先认领,避免向同一辆AGV先后发送移动指令;
+ * 订单的认领优先于停车与充电,停车与充电的认领在AGV重新空闲时自动撤销,订单的认领由分配器在完成订单时撤销
+ * 判定可用状态的同时在AGV所在的线程中采集状态快照,其他线程中的调度模块读取快照,不直接读取AGV对象的状态
+ */
+class AgvIndex
+{
+public:
+    AgvIndex();
+    ~AgvIndex();
+
+public:
+    /*! @brief 描述AGV可用状态的枚举 */
+    enum Availability
+    {
+        Avail_Idle,         /*!< 空闲:自动模式、等待状态、无异常且未载货 */
+        Avail_Loaded,       /*!< 载货等待:满足空闲的条件但已载货 */
+        Avail_Busy,         /*!< 忙碌:非自动模式、非等待状态或有异常 */
+        Avail_Offline,      /*!< 离线:未连接 */
+        Avail_Count,
+    };
+
+    /*! @brief 描述AGV认领者的枚举,数值越大越优先 */
+    enum Claimant
+    {
+        Claim_None,         /*!< 未被认领 */
+        Claim_Parking,      /*!< 停车点规划 */
+        Claim_Charge,       /*!< 充电调度 */
+        Claim_Order,        /*!< 订单分配 */
+    };
+
+    static const unsigned char ABILITY_COUNT;  /*!< 分桶的功能数量,覆盖AgvType::AgvAbility */
+
+    /*! @brief 描述在AGV所在的线程中采集的AGV状态快照的结构体 */
+    struct Snapshot
+    {
+        AgvBase* m_pAgv;                        /*!< AGV对象,只用于在其所在的线程中发送指令 */
+        AgvBase::AId_t m_id;                    /*!< AGV编号 */
+        unsigned char m_ability;                /*!< 功能 */
+        float m_maxWeight;                      /*!< 最大载重:单位(kg) */
+        float m_maxSpeed;                       /*!< 最大速度:单位(m/min) */
+        RfidBase::Rfid_t m_rfid;                /*!< 当前RFID地标卡 */
+        AgvBase::ABattery_t m_battery;          /*!< 电量:单位(%) */
+        AgvBase::ACargo_t m_cargo;              /*!< 载货数量 */
+        AgvBase::AStatus_t m_status;            /*!< 状态 */
+        Availability m_state;                   /*!< 可用状态 */
+    };
+
+protected:
+    /*! @brief 描述被索引AGV的结构体 */
+    struct Entry
+    {
+        Snapshot m_snapshot;                    /*!< 最近一次采集的状态 */
+        Claimant m_claim;                       /*!< 认领者 */
+        size_t m_slot;                          /*!< 在分桶中的位置 */
+        QMetaObject::Connection m_update;       /*!< Update信号的连接 */
+        QMetaObject::Connection m_linkBreak;    /*!< LinkBreak信号的连接 */
+    };
+
+protected:
+    std::mutex m_mutex;                                 /*!< 互斥锁 */
+    std::map<AgvBase::AId_t,Entry> m_entries;           /*!< 被索引的AGV */
+    std::vector<std::vector<Entry*> > m_buckets;        /*!< 各功能×可用状态的分桶 */
+
+public:
+    /*!
+     * @brief 添加AGV并开始跟踪其状态
+     * @param AgvBase* AGV对象
+     */
+    void Add(AgvBase* _agv);
+
+    /*!
+     * @brief 移除AGV
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Remove(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 重新采集AGV的状态并判定可用状态,需在AGV所在的线程中调用
+     *
+     * 信号已自动触发,只在AGV状态被信号以外的途径改变时需要调用
+     * @param AgvBase* AGV对象
+     */
+    void Refresh(AgvBase* _agv);
+
+    /*!
+     * @brief 获取分桶中的AGV
+     * @param const unsigned char& 功能,0为全部功能
+     * @param const Availability& 可用状态
+     * @param std::vector<AgvBase*>& 追加AGV对象的列表
+     * @return size_t 追加的AGV数量
+     */
+    size_t Get(const unsigned char& _ability,const Availability& _state,std::vector<AgvBase*>& _agvs);
+
+    /*!
+     * @brief 获取分桶中AGV的状态快照
+     * @param const unsigned char& 功能,0为全部功能
+     * @param const Availability& 可用状态
+     * @param std::vector<Snapshot>& 追加快照的列表
+     * @return size_t 追加的快照数量
+     */
+    size_t GetSnapshots(const unsigned char& _ability,const Availability& _state,std::vector<Snapshot>& _snapshots);
+
+    /*!
+     * @brief 获取AGV的状态快照
+     * @param const AgvBase::AId_t& AGV编号
+     * @param Snapshot& 快照
+     * @return bool AGV未被索引时返回false
+     */
+    bool GetSnapshot(const AgvBase::AId_t& _id,Snapshot& _snapshot);
+
+    /*!
+     * @brief 获取分桶中的AGV数量
+     * @param const unsigned char& 功能,0为全部功能
+     * @param const Availability& 可用状态
+     * @return size_t AGV数量
+     */
+    size_t GetCount(const unsigned char& _ability,const Availability& _state);
+
+    /*!
+     * @brief 获取AGV的可用状态
+     * @param const AgvBase::AId_t& AGV编号
+     * @return Availability 可用状态,AGV未被索引时返回Avail_Offline
+     */
+    Availability GetState(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 认领空闲的AGV
+     *
+     * 被更优先的认领者取代的认领者,在向AGV发送指令前应以GetClaim确认仍持有认领
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const Claimant& 认领者
+     * @return bool AGV空闲且未被同等或更优先的认领者认领时返回true
+     */
+    bool Claim(const AgvBase::AId_t& _id,const Claimant& _claimant);
+
+    /*!
+     * @brief 撤销认领,AGV已被其他认领者认领时不改变
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const Claimant& 认领者
+     */
+    void Unclaim(const AgvBase::AId_t& _id,const Claimant& _claimant);
+
+    /*!
+     * @brief 获取AGV的认领者
+     * @param const AgvBase::AId_t& AGV编号
+     * @return Claimant 认领者,AGV未被索引时返回Claim_None
+     */
+    Claimant GetClaim(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 判定AGV的可用状态
+     * @param const AgvBase* AGV对象
+     * @return Availability 可用状态
+     */
+    static Availability Classify(const AgvBase* _agv);
+
+    /*!
+     * @brief 采集AGV的状态快照,需在AGV所在的线程中调用
+     * @param AgvBase* AGV对象
+     * @return Snapshot 快照
+     */
+    static Snapshot Capture(AgvBase* _agv);
+
+protected:
+    /*!
+     * @brief 分桶的编号
+     * @param const unsigned char& 功能
+     * @param const Availability& 可用状态
+     * @return size_t 分桶编号
+     */
+    static size_t Bucket(const unsigned char& _ability,const Availability& _state);
+
+    /*!
+     * @brief 将AGV加入分桶,调用方需持有锁
+     * @param Entry& AGV
+     */
+    void Insert(Entry& _entry);
+
+    /*!
+     * @brief 将AGV移出分桶,调用方需持有锁
+     * @param Entry& AGV
+     */
+    void Erase(Entry& _entry);
+};
+
+#endif // AGVINDEX_H
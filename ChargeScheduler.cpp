@@ -0,0 +1,679 @@
+#include "ChargeScheduler.h"
+
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+
+const double ChargeScheduler::ALPHA = 0.2;
+const double ChargeScheduler::MIN_DISTANCE = 0.001;
+
+ChargeScheduler::ChargeScheduler(const RfidMap &_map, TimingWheel &_wheel, const std::chrono::milliseconds &_period)
+    : m_map(_map),m_wheel(_wheel)
+{
+    m_period = _period;
+    m_threshold = 20;
+    m_full = 90;
+    m_maxCharging = 0;
+    m_maxShare = 0.25;
+    m_lead = std::chrono::minutes(5);
+    m_horizon = std::chrono::minutes(120);
+    m_pIndex = nullptr;
+    m_bStopped = false;
+    m_handler = [this](AgvBase* _agv,const RfidBase::Rfid_t& _charger){
+        // 指令需在AGV所在的线程中发送,发送前确认未被订单分配取代;本对象已析构时不再发送
+        LifeGuard::Token _token = m_guard.GetToken();
+
+        QTimer::singleShot(0,_agv,[this,_token,_agv,_charger]{
+            LifeGuard::Scope _scope(_token);
+
+            if(_scope.IsEntered())
+            {
+                Send(_agv,_charger);
+            }
+        });
+    };
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+
+    m_reserved = _registry.AddGauge("agv_charge_reservations","Charger reservations held");
+    m_dispatched = _registry.AddCounter("agv_charge_dispatched_total","AGVs sent to a charger");
+    m_late = _registry.AddGauge("agv_charge_late","Charger reservations starting after the predicted threshold time");
+
+    m_timer = m_wheel.Start(m_period,[this]{ Plan(); });
+}
+
+ChargeScheduler::~ChargeScheduler()
+{
+    // 等待已在AGV线程中执行的发送指令返回,之后投递的不再执行
+    m_guard.Close();
+
+    TimingWheel::TimerId _timer = TimingWheel::INVALID_TIMER;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        m_bStopped = true;
+        _timer = m_timer;
+    }
+
+    // 不持有锁等待正在执行的Plan返回,Plan看到m_bStopped后不再启动定时器
+    m_wheel.CancelSync(_timer);
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    for(std::map<AgvBase::AId_t,Model>::iterator it = m_models.begin(); it != m_models.end(); ++it)
+    {
+        QObject::disconnect(it->second.m_update);
+        QObject::disconnect(it->second.m_rfidChanged);
+    }
+}
+
+void ChargeScheduler::Watch(AgvBase *_agv)
+{
+    if(_agv == nullptr)
+    {
+        return;
+    }
+
+    AgvBase::AId_t _id = _agv->GetID();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_models.find(_id) != m_models.end())
+    {
+        // 已在监视
+        return;
+    }
+
+    Model& _model = m_models[_id];
+    _model.m_pAgv = _agv;
+    _model.m_rfid = _agv->GetCurRfid();
+    _model.m_battery = _agv->GetBattery();
+    _model.m_state = AgvIndex::Classify(_agv);
+    _model.m_sampled = std::chrono::steady_clock::now();
+    _model.m_empty = 0.0;
+    _model.m_loaded = 0.0;
+    _model.m_rateEmpty = 0.5;
+    _model.m_rateLoaded = 0.8;
+    _model.m_rateIdle = 1.0;
+    _model.m_rateCharge = 60.0;
+    _model.m_speed = 0.0;
+    _model.m_loadedShare = 0.0;
+
+    // 在AGV所在的线程中直接调用,断开连接时可能已在执行,同样以存活标记保护
+    LifeGuard::Token _token = m_guard.GetToken();
+
+    _model.m_update = QObject::connect(_agv,&AgvBase::Update,[this,_token,_id]{
+        LifeGuard::Scope _scope(_token);
+
+        if(_scope.IsEntered())
+        {
+            Sample(_id);
+        }
+    });
+    _model.m_rfidChanged = QObject::connect(_agv,&AgvBase::RfidChanged,[this,_token,_id]{
+        LifeGuard::Scope _scope(_token);
+
+        if(_scope.IsEntered())
+        {
+            Moved(_id);
+        }
+    });
+
+    return;
+}
+
+void ChargeScheduler::Unwatch(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Model>::iterator it = m_models.find(_id);
+
+    if(it == m_models.end())
+    {
+        return;
+    }
+
+    QObject::disconnect(it->second.m_update);
+    QObject::disconnect(it->second.m_rfidChanged);
+
+    m_models.erase(it);
+    m_reservations.erase(_id);
+
+    return;
+}
+
+void ChargeScheduler::AddCharger(const RfidBase::Rfid_t &_rfid)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(std::find(m_chargers.begin(),m_chargers.end(),_rfid) == m_chargers.end())
+    {
+        m_chargers.push_back(_rfid);
+    }
+
+    return;
+}
+
+void ChargeScheduler::SetThreshold(const AgvBase::ABattery_t &_threshold, const AgvBase::ABattery_t &_full)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_threshold = _threshold;
+    m_full = _full;
+
+    return;
+}
+
+void ChargeScheduler::SetMaxCharging(const size_t &_count, const double &_share)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_maxCharging = _count;
+    m_maxShare = std::max(_share,0.0);
+
+    return;
+}
+
+void ChargeScheduler::SetLead(const std::chrono::minutes &_lead, const std::chrono::minutes &_horizon)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_lead = _lead;
+    m_horizon = _horizon;
+
+    return;
+}
+
+void ChargeScheduler::SetHandler(const ChargeScheduler::Handler &_handler)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_handler = _handler;
+
+    return;
+}
+
+void ChargeScheduler::SetIndex(AgvIndex *_index)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_pIndex = _index;
+
+    return;
+}
+
+bool ChargeScheduler::GetDeadline(const AgvBase::AId_t &_id, ChargeScheduler::Time_t &_deadline)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Model>::const_iterator it = m_models.find(_id);
+
+    if(it == m_models.end())
+    {
+        return false;
+    }
+
+    _deadline = Predict(it->second,std::chrono::steady_clock::now());
+
+    return true;
+}
+
+bool ChargeScheduler::GetReservation(const AgvBase::AId_t &_id, ChargeScheduler::Reservation &_reservation)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Reservation>::const_iterator it = m_reservations.find(_id);
+
+    if(it == m_reservations.end())
+    {
+        return false;
+    }
+
+    _reservation = it->second;
+
+    return true;
+}
+
+void ChargeScheduler::Moved(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Model>::iterator it = m_models.find(_id);
+
+    if(it == m_models.end())
+    {
+        return;
+    }
+
+    Model& _model = it->second;
+
+    RfidBase::Rfid_t _rfid = _model.m_pAgv->GetCurRfid();
+
+    if(_model.m_pAgv->GetCargo() == 0)
+    {
+        _model.m_empty += Distance(_model.m_rfid,_rfid);
+    }
+    else
+    {
+        _model.m_loaded += Distance(_model.m_rfid,_rfid);
+    }
+
+    _model.m_rfid = _rfid;
+
+    return;
+}
+
+void ChargeScheduler::Sample(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Model>::iterator it = m_models.find(_id);
+
+    if(it == m_models.end())
+    {
+        return;
+    }
+
+    Model& _model = it->second;
+
+    AgvBase::ABattery_t _battery = _model.m_pAgv->GetBattery();
+    bool _bCharging = _model.m_pAgv->GetStatus() == AgvBase::Sta_Charging;
+
+    // 在AGV所在的线程中判定,供时间轮线程中的Plan读取
+    _model.m_state = AgvIndex::Classify(_model.m_pAgv);
+
+    std::map<AgvBase::AId_t,Reservation>::iterator _reservation = m_reservations.find(_id);
+
+    if(_reservation != m_reservations.end() && _reservation->second.m_bSent)
+    {
+        if(_bCharging)
+        {
+            _reservation->second.m_bCharging = true;
+        }
+        else if(_reservation->second.m_bCharging)
+        {
+            // 离开充电状态,释放充电桩
+            m_reservations.erase(_reservation);
+        }
+    }
+
+    if(_battery == _model.m_battery)
+    {
+        return;
+    }
+
+    Time_t _now = std::chrono::steady_clock::now();
+
+    double _hours = std::chrono::duration<double,std::ratio<3600> >(_now - _model.m_sampled).count();
+
+    if(_battery > _model.m_battery)
+    {
+        if(_bCharging && _hours > 0.0)
+        {
+            _model.m_rateCharge += ALPHA * ((_battery - _model.m_battery) / _hours - _model.m_rateCharge);
+        }
+    }
+    else if(_hours > 0.0)
+    {
+        double _drop = _model.m_battery - _battery;
+        double _distance = _model.m_empty + _model.m_loaded;
+
+        _model.m_speed += ALPHA * (_distance / _hours - _model.m_speed);
+
+        if(_distance < MIN_DISTANCE)
+        {
+            _model.m_rateIdle += ALPHA * (_drop / _hours - _model.m_rateIdle);
+        }
+        else
+        {
+            // 扣除静止耗电后按距离分摊,归入期间行驶较多的一类
+            double _rate = std::max(0.0,_drop - _model.m_rateIdle * _hours) / _distance;
+
+            _model.m_loadedShare += ALPHA * (_model.m_loaded / _distance - _model.m_loadedShare);
+
+            if(_model.m_loaded > _model.m_empty)
+            {
+                _model.m_rateLoaded += ALPHA * (_rate - _model.m_rateLoaded);
+            }
+            else
+            {
+                _model.m_rateEmpty += ALPHA * (_rate - _model.m_rateEmpty);
+            }
+        }
+    }
+
+    _model.m_battery = _battery;
+    _model.m_sampled = _now;
+    _model.m_empty = 0.0;
+    _model.m_loaded = 0.0;
+
+    return;
+}
+
+void ChargeScheduler::Plan()
+{
+    std::vector<std::pair<AgvBase*,RfidBase::Rfid_t> > _send;
+    Handler _handler;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        if(m_bStopped)
+        {
+            return;
+        }
+
+        Time_t _now = std::chrono::steady_clock::now();
+
+        // 未派出的预约重新安排,已派出的预约继续占用充电桩
+        for(std::map<AgvBase::AId_t,Reservation>::iterator it = m_reservations.begin(); it != m_reservations.end();)
+        {
+            if(it->second.m_bSent == false)
+            {
+                it = m_reservations.erase(it);
+                continue;
+            }
+
+            if(it->second.m_end < _now)
+            {
+                if(it->second.m_bCharging == false)
+                {
+                    // 派出后始终未开始充电
+                    it = m_reservations.erase(it);
+                    continue;
+                }
+
+                // 超过预计充满的时间仍未结束
+                it->second.m_end = _now + m_period;
+            }
+
+            ++it;
+        }
+
+        std::vector<std::pair<Time_t,AgvBase::AId_t> > _due;
+
+        for(std::map<AgvBase::AId_t,Model>::const_iterator it = m_models.begin(); it != m_models.end(); ++it)
+        {
+            if(m_reservations.find(it->first) != m_reservations.end())
+            {
+                continue;
+            }
+
+            Time_t _deadline = Predict(it->second,_now);
+
+            if(_deadline - _now > m_horizon)
+            {
+                continue;
+            }
+
+            _due.push_back(std::make_pair(_deadline,it->first));
+        }
+
+        // 阈值时间早的AGV优先选择充电桩
+        std::sort(_due.begin(),_due.end());
+
+        long long _late = 0;
+
+        for(std::vector<std::pair<Time_t,AgvBase::AId_t> >::iterator it = _due.begin(); it != _due.end(); ++it)
+        {
+            const Model& _model = m_models[it->second];
+
+            double _hours = std::max(0.0,static_cast<double>(m_full) - std::min(_model.m_battery,m_threshold)) / std::max(_model.m_rateCharge,1.0);
+
+            std::chrono::steady_clock::duration _duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double,std::ratio<3600> >(_hours));
+
+            Reservation _reservation;
+            _reservation.m_agv = it->second;
+            _reservation.m_deadline = it->first;
+            _reservation.m_bSent = false;
+            _reservation.m_bCharging = false;
+
+            Time_t _desired = it->first - m_lead;
+
+            if(FindSlot(_desired,_now,_duration,_reservation) == false)
+            {
+                continue;
+            }
+
+            if(_reservation.m_start > std::max(_desired,_now))
+            {
+                ++_late;
+            }
+
+            m_reservations[it->second] = _reservation;
+        }
+
+        for(std::map<AgvBase::AId_t,Reservation>::iterator it = m_reservations.begin(); it != m_reservations.end(); ++it)
+        {
+            if(it->second.m_bSent || it->second.m_start > _now)
+            {
+                continue;
+            }
+
+            const Model& _model = m_models[it->first];
+            AgvBase* _agv = _model.m_pAgv;
+
+            if(_model.m_state != AgvIndex::Avail_Idle)
+            {
+                // 执行任务中,空闲后再派出
+                continue;
+            }
+
+            if(m_pIndex && m_pIndex->Claim(it->first,AgvIndex::Claim_Charge) == false)
+            {
+                // 已被派往取货点,完成订单后再派出
+                continue;
+            }
+
+            it->second.m_bSent = true;
+
+            _send.push_back(std::make_pair(_agv,it->second.m_charger));
+        }
+
+        MetricsRegistry& _registry = MetricsRegistry::Instance();
+        _registry.Set(m_reserved,static_cast<long long>(m_reservations.size()));
+        _registry.Set(m_late,_late);
+
+        _handler = m_handler;
+
+        m_timer = m_wheel.Start(m_period,[this]{ Plan(); });
+    }
+
+    for(std::vector<std::pair<AgvBase*,RfidBase::Rfid_t> >::iterator it = _send.begin(); it != _send.end(); ++it)
+    {
+        MetricsRegistry::Instance().Add(m_dispatched);
+
+        if(_handler)
+        {
+            _handler(it->first,it->second);
+        }
+    }
+
+    return;
+}
+
+void ChargeScheduler::Send(AgvBase *_agv, const RfidBase::Rfid_t &_charger)
+{
+    AgvIndex* _index = nullptr;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        _index = m_pIndex;
+    }
+
+    if(_index == nullptr || _index->GetClaim(_agv->GetID()) == AgvIndex::Claim_Charge)
+    {
+        if(_agv->Move(_charger) == AgvBase::Cmd_Success)
+        {
+            return;
+        }
+
+        if(_index)
+        {
+            _index->Unclaim(_agv->GetID(),AgvIndex::Claim_Charge);
+        }
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Reservation>::iterator it = m_reservations.find(_agv->GetID());
+
+    if(it != m_reservations.end() && it->second.m_bCharging == false)
+    {
+        // 被订单分配取代或指令未能发送,下一周期重新预约
+        it->second.m_bSent = false;
+    }
+
+    return;
+}
+
+ChargeScheduler::Time_t ChargeScheduler::Predict(const ChargeScheduler::Model &_model, const ChargeScheduler::Time_t &_now) const
+{
+    if(_model.m_battery <= m_threshold)
+    {
+        return _now;
+    }
+
+    double _drain = _model.m_rateIdle
+            + _model.m_speed * (_model.m_loadedShare * _model.m_rateLoaded + (1.0 - _model.m_loadedShare) * _model.m_rateEmpty);
+
+    if(_drain <= 0.0)
+    {
+        return Time_t::max();
+    }
+
+    double _hours = (_model.m_battery - m_threshold) / _drain;
+
+    Time_t _deadline = _model.m_sampled + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double,std::ratio<3600> >(_hours));
+
+    return std::max(_deadline,_now);
+}
+
+bool ChargeScheduler::FindSlot(const ChargeScheduler::Time_t &_desired, const ChargeScheduler::Time_t &_earliest, const std::chrono::steady_clock::duration &_duration, ChargeScheduler::Reservation &_reservation) const
+{
+    // 可行的开始时间只可能是期望时间、最早时间,或与已有预约首尾相接的时间
+    std::vector<Time_t> _starts;
+    _starts.push_back(_desired);
+    _starts.push_back(_earliest);
+
+    for(std::map<AgvBase::AId_t,Reservation>::const_iterator it = m_reservations.begin(); it != m_reservations.end(); ++it)
+    {
+        _starts.push_back(it->second.m_start - _duration);
+        _starts.push_back(it->second.m_end);
+    }
+
+    bool _bFound = false;
+
+    // 不晚于期望时间的最晚时间
+    for(std::vector<Time_t>::iterator it = _starts.begin(); it != _starts.end(); ++it)
+    {
+        if(*it < _earliest || *it > _desired || (_bFound && *it <= _reservation.m_start))
+        {
+            continue;
+        }
+
+        for(std::vector<RfidBase::Rfid_t>::const_iterator _charger = m_chargers.begin(); _charger != m_chargers.end(); ++_charger)
+        {
+            if(IsFree(*_charger,*it,*it + _duration))
+            {
+                _bFound = true;
+                _reservation.m_charger = *_charger;
+                _reservation.m_start = *it;
+                break;
+            }
+        }
+    }
+
+    if(_bFound == false)
+    {
+        // 晚于期望时间的最早时间
+        for(std::vector<Time_t>::iterator it = _starts.begin(); it != _starts.end(); ++it)
+        {
+            if(*it < _earliest || *it <= _desired || (_bFound && *it >= _reservation.m_start))
+            {
+                continue;
+            }
+
+            for(std::vector<RfidBase::Rfid_t>::const_iterator _charger = m_chargers.begin(); _charger != m_chargers.end(); ++_charger)
+            {
+                if(IsFree(*_charger,*it,*it + _duration))
+                {
+                    _bFound = true;
+                    _reservation.m_charger = *_charger;
+                    _reservation.m_start = *it;
+                    break;
+                }
+            }
+        }
+    }
+
+    if(_bFound)
+    {
+        _reservation.m_end = _reservation.m_start + _duration;
+    }
+
+    return _bFound;
+}
+
+bool ChargeScheduler::IsFree(const RfidBase::Rfid_t &_charger, const ChargeScheduler::Time_t &_start, const ChargeScheduler::Time_t &_end) const
+{
+    size_t _count = 0;
+
+    for(std::map<AgvBase::AId_t,Reservation>::const_iterator it = m_reservations.begin(); it != m_reservations.end(); ++it)
+    {
+        if(it->second.m_start >= _end || _start >= it->second.m_end)
+        {
+            continue;
+        }
+
+        if(it->second.m_charger == _charger)
+        {
+            return false;
+        }
+
+        ++_count;
+    }
+
+    size_t _max = GetMaxCharging();
+
+    return _max == 0 || _count < _max;
+}
+
+size_t ChargeScheduler::GetMaxCharging() const
+{
+    if(m_maxCharging > 0 || m_maxShare <= 0.0)
+    {
+        return m_maxCharging;
+    }
+
+    // 充电桩较多时不让车队大部分同时离线
+    return std::max<size_t>(1,static_cast<size_t>(std::ceil(m_models.size() * m_maxShare)));
+}
+
+double ChargeScheduler::Distance(const RfidBase::Rfid_t &_from, const RfidBase::Rfid_t &_to) const
+{
+    RfidMap::Node_t _a = m_map.GetNode(_from);
+    RfidMap::Node_t _b = m_map.GetNode(_to);
+
+    if(_a == RfidMap::NIL || _b == RfidMap::NIL)
+    {
+        return 0.0;
+    }
+
+    RfidMap::Edge_t _edge = m_map.FindEdge(_a,_b);
+
+    if(_edge != RfidMap::NIL)
+    {
+        return m_map.GetWeight(_edge) / 1000000.0;
+    }
+
+    // 相邻地标卡之间没有路段时按直线距离计算
+    double _dx = m_map.GetX(_a) - m_map.GetX(_b);
+    double _dy = m_map.GetY(_a) - m_map.GetY(_b);
+
+    return std::sqrt(_dx * _dx + _dy * _dy) / 1000000.0;
+}
@@ -0,0 +1,251 @@
+/*!
+ * @file ChargeScheduler
+ * @brief 描述预测电量并预约充电桩功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef CHARGESCHEDULER_H
+#define CHARGESCHEDULER_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "AgvIndex.h"
+#include "LifeGuard.h"
+#include "RfidMap.h"
+#include "TimingWheel.h"
+
+/*!
+ * @class ChargeScheduler
+ * @brief 学习AGV耗电速率并提前预约充电桩的充电调度器
+ *
+ * 每次电量下降时,以期间空载、载货行驶的距离与经过的时间,按指数加权更新该AGV的耗电模型:
+ * 空载与载货每公里耗电、静止每小时耗电、平均速度与载货距离的比例;电量上升时更新充电速率
+ * 调度器按周期预测各AGV电量降至阈值的时间,按预测时间从早到晚为其预约充电桩:
+ * 在阈值时间之前尽量晚地开始充电,充电桩已被预约时提前,同时充电的AGV数量不超过上限,
+ * 避免交班高峰时车队同时失去运力;未设置上限时按被监视AGV数量的比例(默认1/4)限制
+ * 预约开始时AGV空闲则交由处理函数派往充电桩,默认令AGV移动至充电桩
+ * 设置AGV索引后,派出前以索引认领AGV,已被订单分配认领的AGV待完成订单后再派出,指令发送前被订单取代时不再发送
+ */
+class ChargeScheduler
+{
+public:
+    /*!
+     * @param const RfidMap& 路线图,用以计算行驶距离
+     * @param TimingWheel& 共用的时间轮
+     * @param const std::chrono::milliseconds& 重新预约的周期
+     */
+    ChargeScheduler(const RfidMap& _map,TimingWheel& _wheel,const std::chrono::milliseconds& _period = std::chrono::milliseconds(10000));
+    ~ChargeScheduler();
+
+public:
+    typedef std::chrono::steady_clock::time_point Time_t;
+
+    /*!
+     * @brief 派AGV充电的处理函数,在时间轮线程中调用
+     *
+     * 设置AGV索引时调用前AGV已以AgvIndex::Claim_Charge认领,指令未能发送时应以AgvIndex::Unclaim撤销
+     * @param AgvBase* AGV对象
+     * @param const RfidBase::Rfid_t& 充电桩所在的RFID地标卡编号
+     */
+    typedef std::function<void(AgvBase*,const RfidBase::Rfid_t&)> Handler;
+
+    /*! @brief 描述充电预约的结构体 */
+    struct Reservation
+    {
+        AgvBase::AId_t m_agv;           /*!< AGV编号 */
+        RfidBase::Rfid_t m_charger;     /*!< 充电桩所在的RFID地标卡编号 */
+        Time_t m_start;                 /*!< 开始充电的时间 */
+        Time_t m_end;                   /*!< 预计充满的时间 */
+        Time_t m_deadline;              /*!< 预计电量降至阈值的时间 */
+        bool m_bSent;                   /*!< 是否已派往充电桩 */
+        bool m_bCharging;               /*!< 是否正在充电 */
+    };
+
+protected:
+    /*! @brief 描述AGV耗电模型的结构体 */
+    struct Model
+    {
+        AgvBase* m_pAgv;                        /*!< AGV对象 */
+        QMetaObject::Connection m_update;       /*!< Update信号的连接 */
+        QMetaObject::Connection m_rfidChanged;  /*!< RfidChanged信号的连接 */
+        RfidBase::Rfid_t m_rfid;                /*!< 上一个地标卡 */
+        AgvBase::ABattery_t m_battery;          /*!< 上一次采样的电量:单位(%) */
+        AgvIndex::Availability m_state;         /*!< 上一次采样的可用状态,在AGV所在的线程中判定 */
+        Time_t m_sampled;                       /*!< 上一次电量改变的时间 */
+        double m_empty;                         /*!< 上一次电量改变后空载行驶的距离:单位(km) */
+        double m_loaded;                        /*!< 上一次电量改变后载货行驶的距离:单位(km) */
+        double m_rateEmpty;                     /*!< 空载每公里耗电:单位(%/km) */
+        double m_rateLoaded;                    /*!< 载货每公里耗电:单位(%/km) */
+        double m_rateIdle;                      /*!< 静止每小时耗电:单位(%/h) */
+        double m_rateCharge;                    /*!< 每小时充电:单位(%/h) */
+        double m_speed;                         /*!< 平均速度,含静止时间:单位(km/h) */
+        double m_loadedShare;                   /*!< 载货行驶距离的比例 */
+    };
+
+protected:
+    static const double ALPHA;                  /*!< 指数加权的系数 */
+    static const double MIN_DISTANCE;           /*!< 视为移动的最小距离:单位(km) */
+
+    const RfidMap& m_map;                       /*!< 路线图 */
+    TimingWheel& m_wheel;                       /*!< 时间轮 */
+    std::chrono::milliseconds m_period;         /*!< 重新预约的周期 */
+    std::mutex m_mutex;                         /*!< 互斥锁 */
+    std::map<AgvBase::AId_t,Model> m_models;    /*!< 各AGV的耗电模型 */
+    std::vector<RfidBase::Rfid_t> m_chargers;   /*!< 充电桩 */
+    std::map<AgvBase::AId_t,Reservation> m_reservations;    /*!< 各AGV的充电预约 */
+    AgvBase::ABattery_t m_threshold;            /*!< 需要充电的电量阈值:单位(%) */
+    AgvBase::ABattery_t m_full;                 /*!< 充电结束的电量:单位(%) */
+    size_t m_maxCharging;                       /*!< 同时充电的AGV数量上限,0为按比例限制 */
+    double m_maxShare;                          /*!< 未设置上限时同时充电的AGV占被监视AGV的比例 */
+    std::chrono::minutes m_lead;                /*!< 在阈值时间之前预留的前往充电桩的时间 */
+    std::chrono::minutes m_horizon;             /*!< 只为阈值时间在此范围内的AGV预约 */
+    Handler m_handler;                          /*!< 派AGV充电的处理函数 */
+    AgvIndex* m_pIndex;                         /*!< 认领AGV的索引,为nullptr时不认领 */
+    TimingWheel::TimerId m_timer;               /*!< 重新预约的定时器 */
+    bool m_bStopped;                            /*!< 已开始析构,不再重新启动定时器 */
+    LifeGuard m_guard;                          /*!< 投递到AGV线程的发送指令的存活标记 */
+    MetricsRegistry::MetricId m_reserved;       /*!< 充电预约数量的指标 */
+    MetricsRegistry::MetricId m_dispatched;     /*!< 派往充电桩次数的指标 */
+    MetricsRegistry::MetricId m_late;           /*!< 晚于阈值时间的预约数量的指标 */
+
+public:
+    /*!
+     * @brief 开始学习AGV的耗电模型并为其预约充电
+     * @param AgvBase* AGV对象
+     */
+    void Watch(AgvBase* _agv);
+
+    /*!
+     * @brief 停止为AGV预约充电
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Unwatch(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 添加充电桩,每个充电桩同时只能为一台AGV充电
+     * @param const RfidBase::Rfid_t& 充电桩所在的RFID地标卡编号
+     */
+    void AddCharger(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 设置充电的电量范围
+     * @param const AgvBase::ABattery_t& 需要充电的电量阈值:单位(%)
+     * @param const AgvBase::ABattery_t& 充电结束的电量:单位(%)
+     */
+    void SetThreshold(const AgvBase::ABattery_t& _threshold,const AgvBase::ABattery_t& _full);
+
+    /*!
+     * @brief 设置同时充电的AGV数量上限
+     * @param const size_t& 数量上限,0为按比例限制
+     * @param const double& 数量上限为0时同时充电的AGV占被监视AGV的比例,向上取整且至少为1;两者均为0时不限
+     */
+    void SetMaxCharging(const size_t& _count,const double& _share = 0.25);
+
+    /*!
+     * @brief 设置预约的时间参数
+     * @param const std::chrono::minutes& 在阈值时间之前预留的前往充电桩的时间
+     * @param const std::chrono::minutes& 只为阈值时间在此范围内的AGV预约
+     */
+    void SetLead(const std::chrono::minutes& _lead,const std::chrono::minutes& _horizon);
+
+    /*!
+     * @brief 设置派AGV充电的处理函数
+     * @param const Handler& 处理函数
+     */
+    void SetHandler(const Handler& _handler);
+
+    /*!
+     * @brief 设置认领AGV的索引,需与订单分配器、停车点规划器使用同一索引
+     * @param AgvIndex* AGV索引,为nullptr时不认领
+     */
+    void SetIndex(AgvIndex* _index);
+
+    /*!
+     * @brief 预测AGV电量降至阈值的时间
+     * @param const AgvBase::AId_t& AGV编号
+     * @param Time_t& 预测的时间
+     * @return bool AGV未被监视时返回false
+     */
+    bool GetDeadline(const AgvBase::AId_t& _id,Time_t& _deadline);
+
+    /*!
+     * @brief 获取AGV的充电预约
+     * @param const AgvBase::AId_t& AGV编号
+     * @param Reservation& 充电预约
+     * @return bool AGV没有充电预约时返回false
+     */
+    bool GetReservation(const AgvBase::AId_t& _id,Reservation& _reservation);
+
+protected:
+    /*!
+     * @brief AGV当前地标卡改变,累计行驶距离,在AGV所在的线程中调用
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Moved(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief AGV更新,按电量变化更新耗电模型与预约状态,在AGV所在的线程中调用
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Sample(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 重新预约并派出到达开始时间的AGV,在时间轮线程中调用
+     */
+    void Plan();
+
+    /*!
+     * @brief 向AGV发送前往充电桩的指令,被订单分配取代或发送失败时在下一周期重新预约,在AGV所在的线程中调用
+     * @param AgvBase* AGV对象
+     * @param const RfidBase::Rfid_t& 充电桩所在的RFID地标卡编号
+     */
+    void Send(AgvBase* _agv,const RfidBase::Rfid_t& _charger);
+
+    /*!
+     * @brief 预测电量降至阈值的时间,调用方需持有锁
+     * @param const Model& 耗电模型
+     * @param const Time_t& 当前时间
+     * @return Time_t 预测的时间
+     */
+    Time_t Predict(const Model& _model,const Time_t& _now) const;
+
+    /*!
+     * @brief 在充电桩上查找开始时间,调用方需持有锁
+     *
+     * 优先选择不晚于期望时间的最晚时间,不存在时选择最早的时间
+     * @param const Time_t& 期望的开始时间
+     * @param const Time_t& 最早的开始时间
+     * @param const std::chrono::steady_clock::duration& 充电时长
+     * @param Reservation& 填写充电桩与开始、结束时间
+     * @return bool 找到返回true
+     */
+    bool FindSlot(const Time_t& _desired,const Time_t& _earliest,const std::chrono::steady_clock::duration& _duration,Reservation& _reservation) const;
+
+    /*!
+     * @brief 充电桩在时间段内是否空闲且未超过同时充电的数量上限,调用方需持有锁
+     * @param const RfidBase::Rfid_t& 充电桩
+     * @param const Time_t& 开始时间
+     * @param const Time_t& 结束时间
+     * @return bool 可以预约返回true
+     */
+    bool IsFree(const RfidBase::Rfid_t& _charger,const Time_t& _start,const Time_t& _end) const;
+
+    /*!
+     * @brief 当前同时充电的AGV数量上限,调用方需持有锁
+     * @return size_t 数量上限,0为不限
+     */
+    size_t GetMaxCharging() const;
+
+    /*!
+     * @brief 计算两个地标卡之间的行驶距离
+     * @param const RfidBase::Rfid_t& 起点
+     * @param const RfidBase::Rfid_t& 终点
+     * @return double 距离:单位(km),地标卡不在路线图中时返回0
+     */
+    double Distance(const RfidBase::Rfid_t& _from,const RfidBase::Rfid_t& _to) const;
+};
+
+#endif // CHARGESCHEDULER_H
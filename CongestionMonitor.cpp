@@ -0,0 +1,291 @@
+#include "CongestionMonitor.h"
+
+#include <algorithm>
+
+const size_t CongestionMonitor::SLOT_COUNT;
+
+CongestionMonitor::CongestionMonitor(const RfidMap &_map, RfidRegistry &_registry, const EtaService &_eta, TimingWheel &_wheel, const std::chrono::milliseconds &_period)
+    : m_map(_map),m_registry(_registry),m_eta(_eta),m_wheel(_wheel)
+{
+    m_period = _period;
+    m_lockPenalty = 3000;
+    m_stopPenalty = 10000;
+    m_delayWeight = 1.0;
+    m_maxPenalty = 60000;
+    m_epoch = 0;
+    m_bStopped = false;
+
+    for(size_t i = 0; i < SLOT_COUNT; ++i)
+    {
+        m_slots[i].m_penalty.assign(m_map.GetEdgeCount(),0);
+        m_slots[i].m_epoch = 0;
+        m_slots[i].m_readers.store(0);
+    }
+
+    m_current.store(0);
+
+    MetricsRegistry& _metrics = MetricsRegistry::Instance();
+
+    m_refreshTime = _metrics.AddHistogram("agv_congestion_refresh_seconds","Time spent computing and publishing live edge costs",
+                                          {0.0005,0.001,0.002,0.005,0.01,0.02,0.05});
+    m_congested = _metrics.AddGauge("agv_congestion_edges","Edges carrying a congestion penalty in the latest published costs");
+    m_skipped = _metrics.AddCounter("agv_congestion_skipped_total","Cost refreshes not published because every buffer was held by planners");
+
+    m_timer = m_wheel.Start(m_period,[this]{ Refresh(); });
+}
+
+CongestionMonitor::~CongestionMonitor()
+{
+    // 等待已在AGV线程中执行的记录返回
+    m_guard.Close();
+
+    TimingWheel::TimerId _timer = TimingWheel::INVALID_TIMER;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        m_bStopped = true;
+        _timer = m_timer;
+
+        for(std::map<AgvBase::AId_t,Watched>::iterator it = m_agvs.begin(); it != m_agvs.end(); ++it)
+        {
+            QObject::disconnect(it->second.m_update);
+        }
+    }
+
+    // 不持有锁等待正在执行的Refresh返回,Refresh看到m_bStopped后不再启动定时器
+    m_wheel.CancelSync(_timer);
+}
+
+CongestionMonitor::View::View(const CongestionMonitor &_monitor)
+{
+    for(;;)
+    {
+        size_t _index = _monitor.m_current.load();
+
+        const Slot& _slot = _monitor.m_slots[_index];
+
+        _slot.m_readers.fetch_add(1);
+
+        // 登记后缓冲区仍是最近发布的,计算线程不会再选中它
+        if(_monitor.m_current.load() == _index)
+        {
+            m_pSlot = &_slot;
+            break;
+        }
+
+        _slot.m_readers.fetch_sub(1);
+    }
+}
+
+CongestionMonitor::View::~View()
+{
+    m_pSlot->m_readers.fetch_sub(1);
+}
+
+void CongestionMonitor::Watch(AgvBase *_agv)
+{
+    if(_agv == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    Watched& _watched = m_agvs[_agv->GetID()];
+
+    QObject::disconnect(_watched.m_update);
+
+    _watched.m_rfid = _agv->GetCurRfid();
+    _watched.m_bStopped = _agv->GetStatus() == AgvBase::Sta_TrafficStop;
+
+    // 在AGV所在的线程中直接调用,Refresh只读取记录的状态
+    LifeGuard::Token _token = m_guard.GetToken();
+
+    _watched.m_update = QObject::connect(_agv,&AgvBase::Update,[this,_token,_agv]{
+        LifeGuard::Scope _scope(_token);
+
+        if(_scope.IsEntered())
+        {
+            Sample(_agv);
+        }
+    });
+
+    return;
+}
+
+void CongestionMonitor::Unwatch(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Watched>::iterator it = m_agvs.find(_id);
+
+    if(it == m_agvs.end())
+    {
+        return;
+    }
+
+    QObject::disconnect(it->second.m_update);
+
+    m_agvs.erase(it);
+
+    return;
+}
+
+void CongestionMonitor::SetPenalty(const CongestionMonitor::Weight_t &_lock, const CongestionMonitor::Weight_t &_stop, const double &_delayWeight, const CongestionMonitor::Weight_t &_max)
+{
+    std::lock_guard<std::mutex> _guard(m_mutex);
+
+    m_lockPenalty = _lock;
+    m_stopPenalty = _stop;
+    m_delayWeight = _delayWeight;
+    m_maxPenalty = _max;
+
+    return;
+}
+
+bool CongestionMonitor::Plan(const RoutePlanner &_planner, const RfidBase::Rfid_t &_from, const RfidBase::Rfid_t &_to, std::vector<RfidBase::Rfid_t> &_route, CongestionMonitor::Weight_t *_cost) const
+{
+    View _view(*this);
+
+    return _planner.Plan(_from,_to,_route,_cost,_view.GetPenalty());
+}
+
+void CongestionMonitor::Refresh()
+{
+    std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+
+    MetricsRegistry& _metrics = MetricsRegistry::Instance();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_bStopped)
+    {
+        return;
+    }
+
+    m_timer = m_wheel.Start(m_period,[this]{ Refresh(); });
+
+    // 选择最近发布之外没有读者的缓冲区
+    size_t _current = m_current.load();
+    size_t _index = SLOT_COUNT;
+
+    for(size_t i = 0; i < SLOT_COUNT; ++i)
+    {
+        if(i != _current && m_slots[i].m_readers.load() == 0)
+        {
+            _index = i;
+            break;
+        }
+    }
+
+    if(_index == SLOT_COUNT)
+    {
+        _metrics.Add(m_skipped);
+        return;
+    }
+
+    Slot& _slot = m_slots[_index];
+    std::vector<Weight_t>& _penalty = _slot.m_penalty;
+
+    RfidMap::Edge_t _edges = m_map.GetEdgeCount();
+
+    for(RfidMap::Edge_t _edge = 0; _edge < _edges; ++_edge)
+    {
+        double _ratio = 1.0;
+
+        if(m_delayWeight > 0.0)
+        {
+            for(unsigned char _ability = 0; _ability < AgvIndex::ABILITY_COUNT; ++_ability)
+            {
+                EtaService::Seconds_t _prior = m_eta.Prior(_ability,_edge);
+
+                if(_prior > 0.0)
+                {
+                    _ratio = std::max(_ratio,m_eta.GetTravelTime(_ability,_edge) / _prior);
+                }
+            }
+        }
+
+        double _delay = (_ratio - 1.0) * m_delayWeight * m_map.GetWeight(_edge);
+
+        _penalty[_edge] = static_cast<Weight_t>(std::min(_delay,static_cast<double>(m_maxPenalty)));
+    }
+
+    RfidMap::Node_t _nodes = m_map.GetNodeCount();
+
+    for(RfidMap::Node_t _node = 0; _node < _nodes; ++_node)
+    {
+        if(m_registry.IsLocked(m_map.GetRfid(_node)))
+        {
+            AddInbound(_penalty,_node,m_lockPenalty);
+        }
+    }
+
+    for(std::map<AgvBase::AId_t,Watched>::const_iterator it = m_agvs.begin(); it != m_agvs.end(); ++it)
+    {
+        if(it->second.m_bStopped == false)
+        {
+            continue;
+        }
+
+        RfidMap::Node_t _node = m_map.GetNode(it->second.m_rfid);
+
+        if(_node != RfidMap::NIL)
+        {
+            // 后来的AGV需在停止的AGV后排队
+            AddInbound(_penalty,_node,m_stopPenalty);
+        }
+    }
+
+    long long _congested = 0;
+
+    for(RfidMap::Edge_t _edge = 0; _edge < _edges; ++_edge)
+    {
+        if(_penalty[_edge] > 0)
+        {
+            ++_congested;
+        }
+    }
+
+    _slot.m_epoch = ++m_epoch;
+
+    m_current.store(_index);
+
+    _metrics.Set(m_congested,_congested);
+    _metrics.Observe(m_refreshTime,std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count());
+
+    return;
+}
+
+void CongestionMonitor::Sample(AgvBase *_agv)
+{
+    RfidBase::Rfid_t _rfid = _agv->GetCurRfid();
+    bool _bStopped = _agv->GetStatus() == AgvBase::Sta_TrafficStop;
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Watched>::iterator it = m_agvs.find(_agv->GetID());
+
+    if(it == m_agvs.end())
+    {
+        return;
+    }
+
+    it->second.m_rfid = _rfid;
+    it->second.m_bStopped = _bStopped;
+
+    return;
+}
+
+void CongestionMonitor::AddInbound(std::vector<CongestionMonitor::Weight_t> &_penalty, const RfidMap::Node_t &_node, const CongestionMonitor::Weight_t &_value) const
+{
+    for(RfidMap::Edge_t _in = m_map.InEdgeBegin(_node); _in < m_map.InEdgeEnd(_node); ++_in)
+    {
+        Weight_t& _item = _penalty[m_map.GetInEdge(_in)];
+
+        _item = m_maxPenalty - _item < _value ? m_maxPenalty : _item + _value;
+    }
+
+    return;
+}
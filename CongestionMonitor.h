@@ -0,0 +1,180 @@
+/*!
+ * @file CongestionMonitor
+ * @brief 描述按路线图占用情况实时计算路段拥堵代价功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef CONGESTIONMONITOR_H
+#define CONGESTIONMONITOR_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "AgvIndex.h"
+#include "EtaService.h"
+#include "LifeGuard.h"
+#include "RfidRegistry.h"
+#include "RoutePlanner.h"
+#include "TimingWheel.h"
+
+/*!
+ * @class CongestionMonitor
+ * @brief 按周期汇总地标卡锁定、交通管制停止的AGV与近期通行时间,发布与路段下标对齐的拥堵代价
+ *
+ * 每条路段的附加代价(单位mm,与距离相加)由三部分组成:
+ * 1.路段终点地标卡已被锁定
+ * 2.路段终点有AGV处于交通管制停止,每辆AGV计一次;AGV的状态在其所在的线程中随Update信号记录
+ * 3.学习到的通行时间超出未拥堵时通行时间的比例乘以路段距离,各AGV功能取最大者
+ * 代价数组在定时器线程中计算,写入当前没有读者的缓冲区后整体发布,发布后不再修改
+ * 规划线程以View持有一份快照,获取与释放只有原子操作,不与计算线程共用锁;所有缓冲区都被持有时本次不发布
+ */
+class CongestionMonitor
+{
+public:
+    /*!
+     * @param const RfidMap& 路线图,存在期间不可改变
+     * @param RfidRegistry& RFID地标卡注册表
+     * @param const EtaService& 通行时间学习服务
+     * @param TimingWheel& 共用的时间轮
+     * @param const std::chrono::milliseconds& 刷新的周期
+     */
+    CongestionMonitor(const RfidMap& _map,RfidRegistry& _registry,const EtaService& _eta,TimingWheel& _wheel,
+                      const std::chrono::milliseconds& _period = std::chrono::milliseconds(1000));
+    ~CongestionMonitor();
+
+public:
+    typedef RfidMap::Weight_t Weight_t;
+
+    static const size_t SLOT_COUNT = 3;     /*!< 代价缓冲区的数量 */
+
+protected:
+    /*! @brief 描述一份代价数组的结构体 */
+    struct Slot
+    {
+        std::vector<Weight_t> m_penalty;                /*!< 各路段的附加代价:单位(mm) */
+        unsigned long long m_epoch;                     /*!< 发布的序号 */
+        mutable std::atomic<unsigned int> m_readers;    /*!< 持有该数组的读者数量 */
+    };
+
+    /*! @brief 描述被统计AGV的结构体 */
+    struct Watched
+    {
+        RfidBase::Rfid_t m_rfid;                /*!< 当前地标卡 */
+        bool m_bStopped;                        /*!< 是否处于交通管制停止 */
+        QMetaObject::Connection m_update;       /*!< Update信号的连接 */
+    };
+
+public:
+    /*!
+     * @class View
+     * @brief 持有最近发布的代价数组,存在期间数组不会被改写
+     */
+    class View
+    {
+    public:
+        /*!
+         * @param const CongestionMonitor& 拥堵监视器
+         */
+        explicit View(const CongestionMonitor& _monitor);
+        ~View();
+
+        View(const View&) = delete;
+        void operator=(const View&) = delete;
+
+    protected:
+        const Slot* m_pSlot;        /*!< 持有的代价数组 */
+
+    public:
+        /*!
+         * @brief 获取与路段下标对齐的附加代价
+         * @return const Weight_t* 附加代价:单位(mm)
+         */
+        const Weight_t* GetPenalty() const { return m_pSlot->m_penalty.data(); }
+
+        /*!
+         * @brief 获取发布的序号
+         * @return unsigned long long 发布的序号,尚未发布时为0
+         */
+        unsigned long long GetEpoch() const { return m_pSlot->m_epoch; }
+    };
+
+protected:
+    const RfidMap& m_map;                                   /*!< 路线图 */
+    RfidRegistry& m_registry;                               /*!< RFID地标卡注册表 */
+    const EtaService& m_eta;                                /*!< 通行时间学习服务 */
+    TimingWheel& m_wheel;                                   /*!< 时间轮 */
+    std::chrono::milliseconds m_period;                     /*!< 刷新的周期 */
+    std::mutex m_mutex;                                     /*!< 互斥锁,不保护已发布的代价数组 */
+    std::map<AgvBase::AId_t,Watched> m_agvs;                /*!< 统计交通管制停止的AGV */
+    Weight_t m_lockPenalty;                                 /*!< 终点被锁定的附加代价:单位(mm) */
+    Weight_t m_stopPenalty;                                 /*!< 终点每辆交通管制停止AGV的附加代价:单位(mm) */
+    double m_delayWeight;                                   /*!< 通行时间超出比例的权重 */
+    Weight_t m_maxPenalty;                                  /*!< 单条路段附加代价的上限:单位(mm) */
+    Slot m_slots[SLOT_COUNT];                               /*!< 代价缓冲区 */
+    std::atomic<size_t> m_current;                          /*!< 最近发布的缓冲区 */
+    unsigned long long m_epoch;                             /*!< 最近发布的序号 */
+    TimingWheel::TimerId m_timer;                           /*!< 刷新的定时器 */
+    bool m_bStopped;                                        /*!< 已开始析构,不再重新启动定时器 */
+    LifeGuard m_guard;                                      /*!< AGV线程中记录状态的存活标记 */
+    MetricsRegistry::MetricId m_refreshTime;                /*!< 刷新耗时的指标 */
+    MetricsRegistry::MetricId m_congested;                  /*!< 有附加代价的路段数量的指标 */
+    MetricsRegistry::MetricId m_skipped;                    /*!< 因缓冲区都被持有而未发布次数的指标 */
+
+public:
+    /*!
+     * @brief 统计AGV的交通管制停止
+     * @param AgvBase* AGV对象
+     */
+    void Watch(AgvBase* _agv);
+
+    /*!
+     * @brief 不再统计AGV
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Unwatch(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 设置附加代价的参数
+     * @param const Weight_t& 终点被锁定的附加代价:单位(mm)
+     * @param const Weight_t& 终点每辆交通管制停止AGV的附加代价:单位(mm)
+     * @param const double& 通行时间超出比例的权重,0为不考虑通行时间
+     * @param const Weight_t& 单条路段附加代价的上限:单位(mm)
+     */
+    void SetPenalty(const Weight_t& _lock,const Weight_t& _stop,const double& _delayWeight,const Weight_t& _max);
+
+    /*!
+     * @brief 按最近发布的拥堵代价规划路线
+     * @param const RoutePlanner& 基于同一路线图的规划器
+     * @param const RfidBase::Rfid_t& 起点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 终点RFID地标卡编号
+     * @param std::vector<RfidBase::Rfid_t>& 规划结果,包含起点与终点
+     * @param Weight_t* 路线的总代价,为nullptr时不输出
+     * @return bool 规划成功返回true,地标卡不在路线图中或不可达时返回false
+     */
+    bool Plan(const RoutePlanner& _planner,const RfidBase::Rfid_t& _from,const RfidBase::Rfid_t& _to,
+              std::vector<RfidBase::Rfid_t>& _route,Weight_t* _cost = nullptr) const;
+
+protected:
+    /*!
+     * @brief 重新计算并发布拥堵代价,在时间轮线程中调用
+     */
+    void Refresh();
+
+    /*!
+     * @brief 记录AGV的当前地标卡与是否处于交通管制停止,在AGV所在的线程中调用
+     * @param AgvBase* AGV对象
+     */
+    void Sample(AgvBase* _agv);
+
+    /*!
+     * @brief 为进入节点的路段累加附加代价,不超过上限
+     * @param std::vector<Weight_t>& 附加代价
+     * @param const RfidMap::Node_t& 节点
+     * @param const Weight_t& 累加的代价
+     */
+    void AddInbound(std::vector<Weight_t>& _penalty,const RfidMap::Node_t& _node,const Weight_t& _value) const;
+};
+
+#endif // CONGESTIONMONITOR_H
@@ -0,0 +1,1027 @@
+#include "ContractionHierarchy.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <string.h>
+
+const size_t ContractionHierarchy::WITNESS_LIMIT;
+const char ContractionHierarchy::FILE_MAGIC[8] = {'A','G','V','C','H','0','0','1'};
+
+typedef std::pair<RfidMap::Weight_t,RfidMap::Node_t> HeapItem_t;
+
+/*!
+ * @class ContractionBuilder
+ * @brief 建立收缩层次索引时使用的动态图
+ */
+class ContractionBuilder
+{
+public:
+    typedef RfidMap::Node_t Node_t;
+    typedef RfidMap::Weight_t Weight_t;
+
+    /*! @brief 描述动态图路段的结构体 */
+    struct Arc
+    {
+        Node_t m_node;      /*!< 相邻节点 */
+        Weight_t m_weight;  /*!< 距离 */
+        Node_t m_middle;    /*!< 捷径的中间节点 */
+    };
+
+    /*! @brief 描述捷径的结构体 */
+    struct Shortcut
+    {
+        Node_t m_from;      /*!< 起点 */
+        Node_t m_to;        /*!< 终点 */
+        Weight_t m_weight;  /*!< 距离 */
+    };
+
+public:
+    explicit ContractionBuilder(const RfidMap& _map)
+    {
+        size_t _count = _map.GetNodeCount();
+
+        m_out.resize(_count);
+        m_in.resize(_count);
+        m_deleted.assign(_count,0);
+        m_dist.assign(_count,RfidMap::INFINITE);
+        m_stamp.assign(_count,0);
+        m_generation = 0;
+
+        for(Node_t _from = 0; _from < _count; ++_from)
+        {
+            for(RfidMap::Edge_t _edge = _map.EdgeBegin(_from); _edge < _map.EdgeEnd(_from); ++_edge)
+            {
+                if(_map.GetTarget(_edge) != _from)
+                {
+                    AddArc(_from,_map.GetTarget(_edge),_map.GetWeight(_edge),RfidMap::NIL);
+                }
+            }
+        }
+    }
+
+public:
+    std::vector<std::vector<Arc> > m_out;   /*!< 未收缩节点的出边 */
+    std::vector<std::vector<Arc> > m_in;    /*!< 未收缩节点的入边 */
+    std::vector<unsigned int> m_deleted;    /*!< 已收缩的相邻节点数量 */
+    std::vector<Weight_t> m_dist;           /*!< 见证路径搜索的距离 */
+    std::vector<unsigned int> m_stamp;      /*!< 见证路径搜索的代数标记 */
+    std::vector<HeapItem_t> m_heap;         /*!< 见证路径搜索的优先队列 */
+    unsigned int m_generation;              /*!< 见证路径搜索的代数 */
+
+public:
+    /*!
+     * @brief 添加路段,已存在时保留较短的路段
+     */
+    void AddArc(const Node_t& _from,const Node_t& _to,const Weight_t& _weight,const Node_t& _middle)
+    {
+        for(std::vector<Arc>::iterator it = m_out[_from].begin(); it != m_out[_from].end(); ++it)
+        {
+            if(it->m_node != _to)
+            {
+                continue;
+            }
+
+            if(it->m_weight <= _weight)
+            {
+                return;
+            }
+
+            it->m_weight = _weight;
+            it->m_middle = _middle;
+
+            for(std::vector<Arc>::iterator in = m_in[_to].begin(); in != m_in[_to].end(); ++in)
+            {
+                if(in->m_node == _from)
+                {
+                    in->m_weight = _weight;
+                    in->m_middle = _middle;
+                    break;
+                }
+            }
+
+            return;
+        }
+
+        Arc _arc;
+        _arc.m_weight = _weight;
+        _arc.m_middle = _middle;
+
+        _arc.m_node = _to;
+        m_out[_from].push_back(_arc);
+
+        _arc.m_node = _from;
+        m_in[_to].push_back(_arc);
+
+        return;
+    }
+
+    /*!
+     * @brief 计算收缩节点所需的捷径
+     */
+    void FindShortcuts(const Node_t& _node,std::vector<Shortcut>& _shortcuts)
+    {
+        _shortcuts.clear();
+
+        const std::vector<Arc>& _in = m_in[_node];
+        const std::vector<Arc>& _out = m_out[_node];
+
+        for(std::vector<Arc>::const_iterator it = _in.begin(); it != _in.end(); ++it)
+        {
+            Weight_t _maxOut = 0;
+            bool _hasOut = false;
+
+            for(std::vector<Arc>::const_iterator out = _out.begin(); out != _out.end(); ++out)
+            {
+                if(out->m_node != it->m_node)
+                {
+                    _maxOut = std::max(_maxOut,out->m_weight);
+                    _hasOut = true;
+                }
+            }
+
+            if(_hasOut == false)
+            {
+                continue;
+            }
+
+            Witness(it->m_node,_node,it->m_weight + _maxOut);
+
+            for(std::vector<Arc>::const_iterator out = _out.begin(); out != _out.end(); ++out)
+            {
+                if(out->m_node == it->m_node)
+                {
+                    continue;
+                }
+
+                Weight_t _via = it->m_weight + out->m_weight;
+
+                if(m_stamp[out->m_node] == m_generation && m_dist[out->m_node] <= _via)
+                {
+                    // 存在不经过该节点且不更长的见证路径
+                    continue;
+                }
+
+                Shortcut _shortcut;
+                _shortcut.m_from = it->m_node;
+                _shortcut.m_to = out->m_node;
+                _shortcut.m_weight = _via;
+
+                _shortcuts.push_back(_shortcut);
+            }
+        }
+
+        return;
+    }
+
+    /*!
+     * @brief 在未收缩的节点中搜索不经过指定节点的见证路径
+     */
+    void Witness(const Node_t& _source,const Node_t& _skip,const Weight_t& _limit)
+    {
+        if(++m_generation == 0)
+        {
+            std::fill(m_stamp.begin(),m_stamp.end(),0);
+            m_generation = 1;
+        }
+
+        m_heap.clear();
+
+        m_dist[_source] = 0;
+        m_stamp[_source] = m_generation;
+        m_heap.push_back(HeapItem_t(0,_source));
+
+        size_t _settled = 0;
+
+        while(m_heap.empty() == false && _settled < ContractionHierarchy::WITNESS_LIMIT)
+        {
+            std::pop_heap(m_heap.begin(),m_heap.end(),std::greater<HeapItem_t>());
+            HeapItem_t _item = m_heap.back();
+            m_heap.pop_back();
+
+            if(_item.first != m_dist[_item.second])
+            {
+                continue;
+            }
+
+            if(_item.first > _limit)
+            {
+                break;
+            }
+
+            ++_settled;
+
+            const std::vector<Arc>& _out = m_out[_item.second];
+
+            for(std::vector<Arc>::const_iterator it = _out.begin(); it != _out.end(); ++it)
+            {
+                if(it->m_node == _skip)
+                {
+                    continue;
+                }
+
+                Weight_t _cost = _item.first + it->m_weight;
+
+                if(m_stamp[it->m_node] == m_generation && m_dist[it->m_node] <= _cost)
+                {
+                    continue;
+                }
+
+                m_stamp[it->m_node] = m_generation;
+                m_dist[it->m_node] = _cost;
+
+                m_heap.push_back(HeapItem_t(_cost,it->m_node));
+                std::push_heap(m_heap.begin(),m_heap.end(),std::greater<HeapItem_t>());
+            }
+        }
+
+        return;
+    }
+
+    /*!
+     * @brief 计算节点的收缩优先级,值越小越先收缩
+     */
+    int Priority(const Node_t& _node,std::vector<Shortcut>& _shortcuts)
+    {
+        FindShortcuts(_node,_shortcuts);
+
+        int _degree = static_cast<int>(m_in[_node].size() + m_out[_node].size());
+
+        // 边差值为主,已收缩的相邻节点越多越晚收缩,使收缩均匀分布
+        return 2 * (static_cast<int>(_shortcuts.size()) - _degree) + static_cast<int>(m_deleted[_node]);
+    }
+
+    /*!
+     * @brief 从动态图中移除节点并添加捷径
+     */
+    void Contract(const Node_t& _node,const std::vector<Shortcut>& _shortcuts)
+    {
+        for(std::vector<Arc>::const_iterator it = m_out[_node].begin(); it != m_out[_node].end(); ++it)
+        {
+            Remove(m_in[it->m_node],_node);
+            ++m_deleted[it->m_node];
+        }
+
+        for(std::vector<Arc>::const_iterator it = m_in[_node].begin(); it != m_in[_node].end(); ++it)
+        {
+            Remove(m_out[it->m_node],_node);
+            ++m_deleted[it->m_node];
+        }
+
+        for(std::vector<Shortcut>::const_iterator it = _shortcuts.begin(); it != _shortcuts.end(); ++it)
+        {
+            AddArc(it->m_from,it->m_to,it->m_weight,_node);
+        }
+
+        std::vector<Arc>().swap(m_out[_node]);
+        std::vector<Arc>().swap(m_in[_node]);
+
+        return;
+    }
+
+protected:
+    void Remove(std::vector<Arc>& _arcs,const Node_t& _node)
+    {
+        for(size_t i = 0; i < _arcs.size(); ++i)
+        {
+            if(_arcs[i].m_node == _node)
+            {
+                _arcs[i] = _arcs.back();
+                _arcs.pop_back();
+                return;
+            }
+        }
+
+        return;
+    }
+};
+
+ContractionHierarchy::ContractionHierarchy(const RfidMap &_map)
+    : m_map(_map)
+{
+    m_fingerprint = 0;
+}
+
+bool ContractionHierarchy::Prepare(const std::string &_mapFile)
+{
+    std::string _file = _mapFile + ".ch";
+
+    if(Load(_file))
+    {
+        return true;
+    }
+
+    Build();
+
+    if(Save(_file) == false)
+    {
+        // 保存失败不影响使用
+        m_error = "Cannot save index file: " + _file;
+    }
+
+    return IsReady();
+}
+
+void ContractionHierarchy::Build()
+{
+    size_t _count = m_map.GetNodeCount();
+
+    ContractionBuilder _builder(m_map);
+
+    std::vector<std::vector<Arc> > _up(_count);     /*!< 节点收缩时的出边,终点均未收缩 */
+    std::vector<std::vector<Arc> > _down(_count);   /*!< 节点收缩时的入边,起点均未收缩 */
+    std::vector<ContractionBuilder::Shortcut> _shortcuts;
+
+    std::priority_queue<std::pair<int,Node_t>,std::vector<std::pair<int,Node_t> >,std::greater<std::pair<int,Node_t> > > _queue;
+
+    for(Node_t i = 0; i < _count; ++i)
+    {
+        _queue.push(std::make_pair(_builder.Priority(i,_shortcuts),i));
+    }
+
+    m_rank.assign(_count,0);
+
+    unsigned int _rank = 0;
+
+    while(_queue.empty() == false)
+    {
+        Node_t _node = _queue.top().second;
+        _queue.pop();
+
+        // 优先级延迟更新:重新计算后若不再最小,则放回队列
+        int _priority = _builder.Priority(_node,_shortcuts);
+
+        if(_queue.empty() == false && _priority > _queue.top().first)
+        {
+            _queue.push(std::make_pair(_priority,_node));
+            continue;
+        }
+
+        m_rank[_node] = _rank++;
+
+        for(std::vector<ContractionBuilder::Arc>::const_iterator it = _builder.m_out[_node].begin(); it != _builder.m_out[_node].end(); ++it)
+        {
+            Arc _arc = { it->m_node, it->m_weight, it->m_middle };
+            _up[_node].push_back(_arc);
+        }
+
+        for(std::vector<ContractionBuilder::Arc>::const_iterator it = _builder.m_in[_node].begin(); it != _builder.m_in[_node].end(); ++it)
+        {
+            Arc _arc = { it->m_node, it->m_weight, it->m_middle };
+            _down[_node].push_back(_arc);
+        }
+
+        _builder.Contract(_node,_shortcuts);
+    }
+
+    m_fwdOffset.assign(_count + 1,0);
+    m_bwdOffset.assign(_count + 1,0);
+    m_fwdArcs.clear();
+    m_bwdArcs.clear();
+
+    for(Node_t i = 0; i < _count; ++i)
+    {
+        m_fwdArcs.insert(m_fwdArcs.end(),_up[i].begin(),_up[i].end());
+        m_bwdArcs.insert(m_bwdArcs.end(),_down[i].begin(),_down[i].end());
+
+        m_fwdOffset[i + 1] = static_cast<unsigned int>(m_fwdArcs.size());
+        m_bwdOffset[i + 1] = static_cast<unsigned int>(m_bwdArcs.size());
+    }
+
+    m_fingerprint = Fingerprint();
+    m_error.clear();
+
+    return;
+}
+
+bool ContractionHierarchy::Save(const std::string &_file) const
+{
+    if(IsReady() == false)
+    {
+        return false;
+    }
+
+    std::ofstream _out(_file.c_str(),std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if(_out.is_open() == false)
+    {
+        return false;
+    }
+
+    unsigned int _count = static_cast<unsigned int>(m_rank.size());
+    unsigned int _fwdCount = static_cast<unsigned int>(m_fwdArcs.size());
+    unsigned int _bwdCount = static_cast<unsigned int>(m_bwdArcs.size());
+
+    _out.write(FILE_MAGIC,sizeof(FILE_MAGIC));
+    _out.write(reinterpret_cast<const char*>(&m_fingerprint),sizeof(m_fingerprint));
+    _out.write(reinterpret_cast<const char*>(&_count),sizeof(_count));
+    _out.write(reinterpret_cast<const char*>(&_fwdCount),sizeof(_fwdCount));
+    _out.write(reinterpret_cast<const char*>(&_bwdCount),sizeof(_bwdCount));
+    _out.write(reinterpret_cast<const char*>(m_rank.data()),m_rank.size() * sizeof(unsigned int));
+    _out.write(reinterpret_cast<const char*>(m_fwdOffset.data()),m_fwdOffset.size() * sizeof(unsigned int));
+    _out.write(reinterpret_cast<const char*>(m_fwdArcs.data()),m_fwdArcs.size() * sizeof(Arc));
+    _out.write(reinterpret_cast<const char*>(m_bwdOffset.data()),m_bwdOffset.size() * sizeof(unsigned int));
+    _out.write(reinterpret_cast<const char*>(m_bwdArcs.data()),m_bwdArcs.size() * sizeof(Arc));
+
+    return _out.good();
+}
+
+bool ContractionHierarchy::Load(const std::string &_file)
+{
+    std::ifstream _in(_file.c_str(),std::ios::in | std::ios::binary);
+
+    if(_in.is_open() == false)
+    {
+        m_error = "Cannot open index file: " + _file;
+        return false;
+    }
+
+    char _magic[sizeof(FILE_MAGIC)] = {0};
+    unsigned long long _fingerprint = 0;
+    unsigned int _count = 0;
+    unsigned int _fwdCount = 0;
+    unsigned int _bwdCount = 0;
+
+    _in.read(_magic,sizeof(_magic));
+    _in.read(reinterpret_cast<char*>(&_fingerprint),sizeof(_fingerprint));
+    _in.read(reinterpret_cast<char*>(&_count),sizeof(_count));
+    _in.read(reinterpret_cast<char*>(&_fwdCount),sizeof(_fwdCount));
+    _in.read(reinterpret_cast<char*>(&_bwdCount),sizeof(_bwdCount));
+
+    if(!_in || memcmp(_magic,FILE_MAGIC,sizeof(FILE_MAGIC)) != 0)
+    {
+        m_error = "Invalid index file: " + _file;
+        return false;
+    }
+
+    if(_count != m_map.GetNodeCount() || _fingerprint != Fingerprint())
+    {
+        m_error = "Index file does not match the map: " + _file;
+        return false;
+    }
+
+    // 分配前按文件剩余的长度核对路段数量,损坏的数量不会导致过量分配
+    std::streampos _start = _in.tellg();
+    _in.seekg(0,std::ios::end);
+    unsigned long long _remain = static_cast<unsigned long long>(_in.tellg() - _start);
+    _in.seekg(_start);
+
+    unsigned long long _expected = (3ULL * _count + 2) * sizeof(unsigned int) + (static_cast<unsigned long long>(_fwdCount) + _bwdCount) * sizeof(Arc);
+
+    if(!_in || _remain != _expected)
+    {
+        m_error = "Corrupted index file: " + _file;
+        return false;
+    }
+
+    std::vector<unsigned int> _rank(_count);
+    std::vector<unsigned int> _fwdOffset(_count + 1);
+    std::vector<Arc> _fwdArcs(_fwdCount);
+    std::vector<unsigned int> _bwdOffset(_count + 1);
+    std::vector<Arc> _bwdArcs(_bwdCount);
+
+    _in.read(reinterpret_cast<char*>(_rank.data()),_rank.size() * sizeof(unsigned int));
+    _in.read(reinterpret_cast<char*>(_fwdOffset.data()),_fwdOffset.size() * sizeof(unsigned int));
+    _in.read(reinterpret_cast<char*>(_fwdArcs.data()),_fwdArcs.size() * sizeof(Arc));
+    _in.read(reinterpret_cast<char*>(_bwdOffset.data()),_bwdOffset.size() * sizeof(unsigned int));
+    _in.read(reinterpret_cast<char*>(_bwdArcs.data()),_bwdArcs.size() * sizeof(Arc));
+
+    if(!_in || _fwdOffset.back() != _fwdCount || _bwdOffset.back() != _bwdCount)
+    {
+        m_error = "Truncated index file: " + _file;
+        return false;
+    }
+
+    // 排名需为0至_count-1的排列
+    std::vector<bool> _ranked(_count,false);
+
+    for(std::vector<unsigned int>::iterator it = _rank.begin(); it != _rank.end(); ++it)
+    {
+        if(*it >= _count || _ranked[*it])
+        {
+            m_error = "Corrupted index file: " + _file;
+            return false;
+        }
+
+        _ranked[*it] = true;
+    }
+
+    if(CheckArcs(_rank,_fwdOffset,_fwdArcs) == false || CheckArcs(_rank,_bwdOffset,_bwdArcs) == false)
+    {
+        m_error = "Corrupted index file: " + _file;
+        return false;
+    }
+
+    m_rank.swap(_rank);
+    m_fwdOffset.swap(_fwdOffset);
+    m_fwdArcs.swap(_fwdArcs);
+    m_bwdOffset.swap(_bwdOffset);
+    m_bwdArcs.swap(_bwdArcs);
+    m_fingerprint = _fingerprint;
+    m_error.clear();
+
+    return true;
+}
+
+bool ContractionHierarchy::CheckArcs(const std::vector<unsigned int> &_rank, const std::vector<unsigned int> &_offset, const std::vector<ContractionHierarchy::Arc> &_arcs)
+{
+    Node_t _count = static_cast<Node_t>(_rank.size());
+
+    if(_offset.empty() || _offset.front() != 0)
+    {
+        return false;
+    }
+
+    for(Node_t _node = 0; _node < _count; ++_node)
+    {
+        if(_offset[_node] > _offset[_node + 1])
+        {
+            return false;
+        }
+
+        for(unsigned int i = _offset[_node]; i < _offset[_node + 1]; ++i)
+        {
+            const Arc& _arc = _arcs[i];
+
+            if(_arc.m_node >= _count)
+            {
+                return false;
+            }
+
+            if(_arc.m_middle == RfidMap::NIL)
+            {
+                continue;
+            }
+
+            if(_arc.m_middle >= _count || _rank[_arc.m_middle] >= _rank[_node] || _rank[_arc.m_middle] >= _rank[_arc.m_node])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ContractionHierarchy::IsReady() const
+{
+    return m_fwdOffset.size() == m_map.GetNodeCount() + 1 && m_rank.size() == m_map.GetNodeCount();
+}
+
+std::string ContractionHierarchy::GetError() const
+{
+    return m_error;
+}
+
+ContractionHierarchy::Weight_t ContractionHierarchy::Distance(const RfidBase::Rfid_t &_from, const RfidBase::Rfid_t &_to) const
+{
+    Node_t _source = m_map.GetNode(_from);
+    Node_t _target = m_map.GetNode(_to);
+
+    if(_source == RfidMap::NIL || _target == RfidMap::NIL || IsReady() == false)
+    {
+        return RfidMap::INFINITE;
+    }
+
+    Node_t _meet = RfidMap::NIL;
+
+    return Search(_source,_target,GetSearchSpace(),_meet);
+}
+
+bool ContractionHierarchy::Route(const RfidBase::Rfid_t &_from, const RfidBase::Rfid_t &_to, std::vector<RfidBase::Rfid_t> &_route, Weight_t *_cost) const
+{
+    _route.clear();
+
+    Node_t _source = m_map.GetNode(_from);
+    Node_t _target = m_map.GetNode(_to);
+
+    if(_source == RfidMap::NIL || _target == RfidMap::NIL || IsReady() == false)
+    {
+        return false;
+    }
+
+    SearchSpace& _space = GetSearchSpace();
+
+    Node_t _meet = RfidMap::NIL;
+    Weight_t _dist = Search(_source,_target,_space,_meet);
+
+    if(_meet == RfidMap::NIL)
+    {
+        return false;
+    }
+
+    // 起点至汇合节点
+    _space.m_path.clear();
+
+    for(Node_t _node = _meet; _node != RfidMap::NIL; _node = _space.m_forward.m_parent[_node])
+    {
+        _space.m_path.push_back(_node);
+    }
+
+    std::reverse(_space.m_path.begin(),_space.m_path.end());
+
+    // 汇合节点至终点
+    for(Node_t _node = _space.m_backward.m_parent[_meet]; _node != RfidMap::NIL; _node = _space.m_backward.m_parent[_node])
+    {
+        _space.m_path.push_back(_node);
+    }
+
+    _route.push_back(m_map.GetRfid(_space.m_path.front()));
+
+    for(size_t i = 1; i < _space.m_path.size(); ++i)
+    {
+        Unpack(_space.m_path[i - 1],_space.m_path[i],_space,_route);
+    }
+
+    if(_cost)
+    {
+        *_cost = _dist;
+    }
+
+    return true;
+}
+
+bool ContractionHierarchy::Table(const std::vector<RfidBase::Rfid_t> &_sources, const std::vector<RfidBase::Rfid_t> &_targets, std::vector<Weight_t> &_table) const
+{
+    /*! @brief 描述桶中记录的结构体 */
+    struct Bucket
+    {
+        Node_t m_node;          /*!< 反向搜索到达的节点 */
+        unsigned int m_target;  /*!< 终点序号 */
+        Weight_t m_weight;      /*!< 节点至终点的距离 */
+
+        bool operator<(const Bucket& _bucket) const
+        {
+            return m_node < _bucket.m_node;
+        }
+    };
+
+    _table.assign(_sources.size() * _targets.size(),RfidMap::INFINITE);
+
+    if(IsReady() == false)
+    {
+        return false;
+    }
+
+    std::vector<std::pair<Weight_t,Node_t> > _settled;
+    std::vector<Bucket> _buckets;
+
+    for(unsigned int i = 0; i < _targets.size(); ++i)
+    {
+        Node_t _target = m_map.GetNode(_targets[i]);
+
+        if(_target == RfidMap::NIL)
+        {
+            continue;
+        }
+
+        Upward(_target,false,GetSearchSpace(),_settled);
+
+        for(std::vector<std::pair<Weight_t,Node_t> >::const_iterator it = _settled.begin(); it != _settled.end(); ++it)
+        {
+            Bucket _bucket;
+            _bucket.m_node = it->second;
+            _bucket.m_target = i;
+            _bucket.m_weight = it->first;
+
+            _buckets.push_back(_bucket);
+        }
+    }
+
+    std::sort(_buckets.begin(),_buckets.end());
+
+    // 各节点在桶中的起始下标
+    std::vector<unsigned int> _first(m_map.GetNodeCount(),RfidMap::NIL);
+
+    for(unsigned int i = static_cast<unsigned int>(_buckets.size()); i > 0; --i)
+    {
+        _first[_buckets[i - 1].m_node] = i - 1;
+    }
+
+    for(size_t i = 0; i < _sources.size(); ++i)
+    {
+        Node_t _source = m_map.GetNode(_sources[i]);
+
+        if(_source == RfidMap::NIL)
+        {
+            continue;
+        }
+
+        Upward(_source,true,GetSearchSpace(),_settled);
+
+        Weight_t* _row = &_table[i * _targets.size()];
+
+        for(std::vector<std::pair<Weight_t,Node_t> >::const_iterator it = _settled.begin(); it != _settled.end(); ++it)
+        {
+            for(unsigned int k = _first[it->second]; k < _buckets.size() && _buckets[k].m_node == it->second; ++k)
+            {
+                Weight_t _cost = it->first + _buckets[k].m_weight;
+
+                if(_cost < _row[_buckets[k].m_target])
+                {
+                    _row[_buckets[k].m_target] = _cost;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t ContractionHierarchy::GetArcCount() const
+{
+    return m_fwdArcs.size() + m_bwdArcs.size();
+}
+
+unsigned long long ContractionHierarchy::Fingerprint() const
+{
+    // FNV-1a
+    unsigned long long _hash = 14695981039346656037ULL;
+
+    size_t _count = m_map.GetNodeCount();
+
+    for(Node_t _node = 0; _node < _count; ++_node)
+    {
+        unsigned long long _values[2] = { m_map.GetRfid(_node), m_map.EdgeEnd(_node) - m_map.EdgeBegin(_node) };
+
+        for(size_t i = 0; i < 2; ++i)
+        {
+            _hash = (_hash ^ _values[i]) * 1099511628211ULL;
+        }
+
+        for(RfidMap::Edge_t _edge = m_map.EdgeBegin(_node); _edge < m_map.EdgeEnd(_node); ++_edge)
+        {
+            _hash = (_hash ^ m_map.GetTarget(_edge)) * 1099511628211ULL;
+            _hash = (_hash ^ m_map.GetWeight(_edge)) * 1099511628211ULL;
+        }
+    }
+
+    return _hash;
+}
+
+ContractionHierarchy::Weight_t ContractionHierarchy::Search(const Node_t &_source, const Node_t &_target, SearchSpace &_space, Node_t &_meet) const
+{
+    SearchSide& _forward = _space.m_forward;
+    SearchSide& _backward = _space.m_backward;
+    unsigned int _generation = _space.m_generation;
+
+    Weight_t _best = RfidMap::INFINITE;
+    _meet = RfidMap::NIL;
+
+    _forward.m_heap.clear();
+    _backward.m_heap.clear();
+
+    _forward.m_cost[_source] = 0;
+    _forward.m_parent[_source] = RfidMap::NIL;
+    _forward.m_stamp[_source] = _generation;
+    _forward.m_heap.push_back(HeapItem_t(0,_source));
+
+    _backward.m_cost[_target] = 0;
+    _backward.m_parent[_target] = RfidMap::NIL;
+    _backward.m_stamp[_target] = _generation;
+    _backward.m_heap.push_back(HeapItem_t(0,_target));
+
+    while(_forward.m_heap.empty() == false || _backward.m_heap.empty() == false)
+    {
+        // 两个方向交替,每次扩展距离较小的一侧
+        bool _isForward = _backward.m_heap.empty()
+                || (_forward.m_heap.empty() == false && _forward.m_heap.front().first <= _backward.m_heap.front().first);
+
+        SearchSide& _side = _isForward ? _forward : _backward;
+        SearchSide& _other = _isForward ? _backward : _forward;
+
+        if(_side.m_heap.front().first >= _best)
+        {
+            // 该方向已不可能得到更短的路线
+            _side.m_heap.clear();
+            continue;
+        }
+
+        std::pop_heap(_side.m_heap.begin(),_side.m_heap.end(),std::greater<HeapItem_t>());
+        HeapItem_t _item = _side.m_heap.back();
+        _side.m_heap.pop_back();
+
+        Node_t _node = _item.second;
+
+        if(_item.first != _side.m_cost[_node])
+        {
+            continue;
+        }
+
+        if(_other.m_stamp[_node] == _generation && _item.first + _other.m_cost[_node] < _best)
+        {
+            _best = _item.first + _other.m_cost[_node];
+            _meet = _node;
+        }
+
+        const std::vector<unsigned int>& _offset = _isForward ? m_fwdOffset : m_bwdOffset;
+        const std::vector<Arc>& _arcs = _isForward ? m_fwdArcs : m_bwdArcs;
+        const std::vector<unsigned int>& _stallOffset = _isForward ? m_bwdOffset : m_fwdOffset;
+        const std::vector<Arc>& _stallArcs = _isForward ? m_bwdArcs : m_fwdArcs;
+
+        // 按需停滞:若经由更高等级的已到达节点能更近地到达该节点,则该节点不在最短路线上,无需扩展
+        bool _stalled = false;
+
+        for(unsigned int i = _stallOffset[_node]; i < _stallOffset[_node + 1]; ++i)
+        {
+            const Arc& _arc = _stallArcs[i];
+
+            if(_side.m_stamp[_arc.m_node] == _generation && _side.m_cost[_arc.m_node] + _arc.m_weight < _item.first)
+            {
+                _stalled = true;
+                break;
+            }
+        }
+
+        if(_stalled)
+        {
+            continue;
+        }
+
+        for(unsigned int i = _offset[_node]; i < _offset[_node + 1]; ++i)
+        {
+            const Arc& _arc = _arcs[i];
+            Weight_t _cost = _item.first + _arc.m_weight;
+
+            if(_side.m_stamp[_arc.m_node] == _generation && _side.m_cost[_arc.m_node] <= _cost)
+            {
+                continue;
+            }
+
+            _side.m_stamp[_arc.m_node] = _generation;
+            _side.m_cost[_arc.m_node] = _cost;
+            _side.m_parent[_arc.m_node] = _node;
+
+            _side.m_heap.push_back(HeapItem_t(_cost,_arc.m_node));
+            std::push_heap(_side.m_heap.begin(),_side.m_heap.end(),std::greater<HeapItem_t>());
+        }
+    }
+
+    return _best;
+}
+
+void ContractionHierarchy::Upward(const Node_t &_start, const bool &_isForward, SearchSpace &_space, std::vector<std::pair<Weight_t,Node_t> > &_settled) const
+{
+    SearchSide& _side = _space.m_forward;
+    unsigned int _generation = _space.m_generation;
+
+    const std::vector<unsigned int>& _offset = _isForward ? m_fwdOffset : m_bwdOffset;
+    const std::vector<Arc>& _arcs = _isForward ? m_fwdArcs : m_bwdArcs;
+    const std::vector<unsigned int>& _stallOffset = _isForward ? m_bwdOffset : m_fwdOffset;
+    const std::vector<Arc>& _stallArcs = _isForward ? m_bwdArcs : m_fwdArcs;
+
+    _settled.clear();
+    _side.m_heap.clear();
+
+    _side.m_cost[_start] = 0;
+    _side.m_parent[_start] = RfidMap::NIL;
+    _side.m_stamp[_start] = _generation;
+    _side.m_heap.push_back(HeapItem_t(0,_start));
+
+    while(_side.m_heap.empty() == false)
+    {
+        std::pop_heap(_side.m_heap.begin(),_side.m_heap.end(),std::greater<HeapItem_t>());
+        HeapItem_t _item = _side.m_heap.back();
+        _side.m_heap.pop_back();
+
+        Node_t _node = _item.second;
+
+        if(_item.first != _side.m_cost[_node])
+        {
+            continue;
+        }
+
+        // 按需停滞,停滞的节点不在最短路线上
+        bool _stalled = false;
+
+        for(unsigned int i = _stallOffset[_node]; i < _stallOffset[_node + 1]; ++i)
+        {
+            const Arc& _arc = _stallArcs[i];
+
+            if(_side.m_stamp[_arc.m_node] == _generation && _side.m_cost[_arc.m_node] + _arc.m_weight < _item.first)
+            {
+                _stalled = true;
+                break;
+            }
+        }
+
+        if(_stalled)
+        {
+            continue;
+        }
+
+        _settled.push_back(_item);
+
+        for(unsigned int i = _offset[_node]; i < _offset[_node + 1]; ++i)
+        {
+            const Arc& _arc = _arcs[i];
+            Weight_t _cost = _item.first + _arc.m_weight;
+
+            if(_side.m_stamp[_arc.m_node] == _generation && _side.m_cost[_arc.m_node] <= _cost)
+            {
+                continue;
+            }
+
+            _side.m_stamp[_arc.m_node] = _generation;
+            _side.m_cost[_arc.m_node] = _cost;
+            _side.m_parent[_arc.m_node] = _node;
+
+            _side.m_heap.push_back(HeapItem_t(_cost,_arc.m_node));
+            std::push_heap(_side.m_heap.begin(),_side.m_heap.end(),std::greater<HeapItem_t>());
+        }
+    }
+
+    return;
+}
+
+void ContractionHierarchy::Unpack(const Node_t &_from, const Node_t &_to, SearchSpace &_space, std::vector<RfidBase::Rfid_t> &_route) const
+{
+    std::vector<Node_t>& _stack = _space.m_stack;
+
+    _stack.clear();
+    _stack.push_back(_from);
+    _stack.push_back(_to);
+
+    while(_stack.empty() == false)
+    {
+        Node_t _b = _stack.back();
+        _stack.pop_back();
+        Node_t _a = _stack.back();
+        _stack.pop_back();
+
+        Arc _arc = FindArc(_a,_b);
+
+        if(_arc.m_middle == RfidMap::NIL)
+        {
+            _route.push_back(m_map.GetRfid(_b));
+            continue;
+        }
+
+        // 先展开前半段
+        _stack.push_back(_arc.m_middle);
+        _stack.push_back(_b);
+        _stack.push_back(_a);
+        _stack.push_back(_arc.m_middle);
+    }
+
+    return;
+}
+
+ContractionHierarchy::Arc ContractionHierarchy::FindArc(const Node_t &_from, const Node_t &_to) const
+{
+    Arc _found = { _to, RfidMap::INFINITE, RfidMap::NIL };
+
+    if(m_rank[_to] > m_rank[_from])
+    {
+        for(unsigned int i = m_fwdOffset[_from]; i < m_fwdOffset[_from + 1]; ++i)
+        {
+            if(m_fwdArcs[i].m_node == _to && m_fwdArcs[i].m_weight < _found.m_weight)
+            {
+                _found = m_fwdArcs[i];
+            }
+        }
+    }
+    else
+    {
+        for(unsigned int i = m_bwdOffset[_to]; i < m_bwdOffset[_to + 1]; ++i)
+        {
+            if(m_bwdArcs[i].m_node == _from && m_bwdArcs[i].m_weight < _found.m_weight)
+            {
+                _found.m_weight = m_bwdArcs[i].m_weight;
+                _found.m_middle = m_bwdArcs[i].m_middle;
+            }
+        }
+    }
+
+    return _found;
+}
+
+ContractionHierarchy::SearchSpace &ContractionHierarchy::GetSearchSpace() const
+{
+    static thread_local SearchSpace _space = SearchSpace();
+
+    size_t _count = m_map.GetNodeCount();
+
+    if(_space.m_forward.m_stamp.size() < _count)
+    {
+        SearchSide* _sides[2] = { &_space.m_forward, &_space.m_backward };
+
+        for(size_t i = 0; i < 2; ++i)
+        {
+            _sides[i]->m_cost.resize(_count);
+            _sides[i]->m_parent.resize(_count);
+            _sides[i]->m_stamp.resize(_count,0);
+            _sides[i]->m_heap.reserve(_count);
+        }
+    }
+
+    if(++_space.m_generation == 0)
+    {
+        std::fill(_space.m_forward.m_stamp.begin(),_space.m_forward.m_stamp.end(),0);
+        std::fill(_space.m_backward.m_stamp.begin(),_space.m_backward.m_stamp.end(),0);
+        _space.m_generation = 1;
+    }
+
+    return _space;
+}
@@ -0,0 +1,212 @@
+/*!
+ * @file ContractionHierarchy
+ * @brief 描述RFID地标卡路线图收缩层次索引的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include <string>
+#include <vector>
+#include "RfidMap.h"
+
+/*!
+ * @class ContractionHierarchy
+ * @brief RFID地标卡路线图的收缩层次(Contraction Hierarchies)索引
+ *
+ * 预处理时按边差值依次收缩节点,为保持最短距离不变添加捷径路段,每条捷径记录被收缩的中间节点
+ * 查询时从起点与终点分别只沿等级升高的路段做双向搜索,搜索范围远小于A*,用于大量的距离估算
+ * 需要完整路线时按中间节点递归展开捷径
+ * 索引以本机字节序的二进制格式保存在地图文件旁(地图文件名+".ch"),并记录地图的指纹,地图改变后索引自动失效
+ */
+class ContractionHierarchy
+{
+public:
+    /*!
+     * @param const RfidMap& 已加载的路线图
+     */
+    explicit ContractionHierarchy(const RfidMap& _map);
+
+public:
+    typedef RfidMap::Node_t Node_t;
+    typedef RfidMap::Weight_t Weight_t;
+
+    static const size_t WITNESS_LIMIT = 500;    /*!< 预处理时见证路径搜索的最大节点数量 */
+    static const char FILE_MAGIC[8];            /*!< 索引文件的标识 */
+
+protected:
+    /*! @brief 描述索引路段的结构体 */
+    struct Arc
+    {
+        Node_t m_node;      /*!< 正向索引中为终点,反向索引中为起点 */
+        Weight_t m_weight;  /*!< 距离 */
+        Node_t m_middle;    /*!< 捷径的中间节点,原始路段为NIL */
+    };
+
+    /*! @brief 描述单个方向搜索状态的结构体 */
+    struct SearchSide
+    {
+        std::vector<Weight_t> m_cost;       /*!< 距离 */
+        std::vector<Node_t> m_parent;       /*!< 前一个节点 */
+        std::vector<unsigned int> m_stamp;  /*!< 搜索代数标记 */
+        std::vector<std::pair<Weight_t,Node_t> > m_heap;    /*!< 优先队列,按距离排列的小顶堆 */
+    };
+
+    /*! @brief 描述单个线程搜索空间的结构体 */
+    struct SearchSpace
+    {
+        SearchSide m_forward;               /*!< 正向搜索 */
+        SearchSide m_backward;              /*!< 反向搜索 */
+        std::vector<Node_t> m_path;         /*!< 索引中的路线 */
+        std::vector<Node_t> m_stack;        /*!< 展开捷径使用的栈 */
+        unsigned int m_generation;          /*!< 当前搜索代数 */
+    };
+
+protected:
+    const RfidMap& m_map;                   /*!< 路线图 */
+    unsigned long long m_fingerprint;       /*!< 建立索引时路线图的指纹 */
+    std::vector<unsigned int> m_rank;       /*!< 节点的收缩等级 */
+    std::vector<unsigned int> m_fwdOffset;  /*!< 节点向上出边的起始下标,共节点数量+1项 */
+    std::vector<Arc> m_fwdArcs;             /*!< 向上出边:终点等级高于起点 */
+    std::vector<unsigned int> m_bwdOffset;  /*!< 节点向上入边的起始下标,共节点数量+1项 */
+    std::vector<Arc> m_bwdArcs;             /*!< 向上入边:起点等级高于终点 */
+    std::string m_error;                    /*!< 最后一次失败的原因 */
+
+public:
+    /*!
+     * @brief 加载地图文件旁的索引,索引不存在或已失效时重新建立并保存
+     * @param const std::string& 地图文件路径
+     * @return bool 索引可用返回true,否则返回false
+     */
+    bool Prepare(const std::string& _mapFile);
+
+    /*!
+     * @brief 由路线图建立索引
+     */
+    void Build();
+
+    /*!
+     * @brief 保存索引
+     * @param const std::string& 索引文件路径
+     * @return bool 保存成功返回true,否则返回false
+     */
+    bool Save(const std::string& _file) const;
+
+    /*!
+     * @brief 加载索引
+     * @param const std::string& 索引文件路径
+     * @return bool 加载成功且与路线图一致返回true,否则返回false
+     */
+    bool Load(const std::string& _file);
+
+    /*!
+     * @brief 索引是否可用
+     * @return bool 可用返回true
+     */
+    bool IsReady() const;
+
+    /*!
+     * @brief 获取最后一次失败的原因
+     * @return std::string 失败原因
+     */
+    std::string GetError() const;
+
+    /*!
+     * @brief 查询两个RFID地标卡之间的最短距离
+     * @param const RfidBase::Rfid_t& 起点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 终点RFID地标卡编号
+     * @return Weight_t 最短距离,不可达时返回RfidMap::INFINITE
+     */
+    Weight_t Distance(const RfidBase::Rfid_t& _from,const RfidBase::Rfid_t& _to) const;
+
+    /*!
+     * @brief 查询两个RFID地标卡之间的最短路线
+     * @param const RfidBase::Rfid_t& 起点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 终点RFID地标卡编号
+     * @param std::vector<RfidBase::Rfid_t>& 展开后的路线,包含起点与终点
+     * @param Weight_t* 路线的总距离,为nullptr时不输出
+     * @return bool 查询成功返回true,否则返回false
+     */
+    bool Route(const RfidBase::Rfid_t& _from,const RfidBase::Rfid_t& _to,std::vector<RfidBase::Rfid_t>& _route,Weight_t* _cost = nullptr) const;
+
+    /*!
+     * @brief 批量查询多个起点至多个终点的最短距离
+     *
+     * 每个终点做一次反向的向上搜索并将到达的节点记入桶中,每个起点做一次正向的向上搜索并扫描经过节点的桶,
+     * 共需起点数量+终点数量次单向搜索,供调度时批量估算路线代价
+     * @param const std::vector<RfidBase::Rfid_t>& 起点RFID地标卡编号
+     * @param const std::vector<RfidBase::Rfid_t>& 终点RFID地标卡编号
+     * @param std::vector<Weight_t>& 距离矩阵,按起点逐行排列,不可达时为RfidMap::INFINITE
+     * @return bool 索引可用返回true,否则返回false
+     */
+    bool Table(const std::vector<RfidBase::Rfid_t>& _sources,const std::vector<RfidBase::Rfid_t>& _targets,std::vector<Weight_t>& _table) const;
+
+    /*!
+     * @brief 获取索引的路段数量,包括捷径
+     * @return size_t 路段数量
+     */
+    size_t GetArcCount() const;
+
+protected:
+    /*!
+     * @brief 计算路线图的指纹
+     * @return unsigned long long 指纹
+     */
+    unsigned long long Fingerprint() const;
+
+    /*!
+     * @brief 检查从索引文件读取的一个方向的索引
+     *
+     * 偏移需从0开始且不递减,路段的端点与中间节点需在范围内,中间节点的排名需低于两个端点,保证展开路线时能够结束
+     * @param const std::vector<unsigned int>& 各节点的排名
+     * @param const std::vector<unsigned int>& 各节点路段的起始下标
+     * @param const std::vector<Arc>& 路段
+     * @return bool 有效返回true
+     */
+    static bool CheckArcs(const std::vector<unsigned int>& _rank,const std::vector<unsigned int>& _offset,const std::vector<Arc>& _arcs);
+
+    /*!
+     * @brief 双向搜索
+     * @param const Node_t& 起点
+     * @param const Node_t& 终点
+     * @param SearchSpace& 搜索空间
+     * @param Node_t& 两个方向搜索的汇合节点,不可达时为NIL
+     * @return Weight_t 最短距离,不可达时返回RfidMap::INFINITE
+     */
+    Weight_t Search(const Node_t& _source,const Node_t& _target,SearchSpace& _space,Node_t& _meet) const;
+
+    /*!
+     * @brief 单向的向上搜索,不设终点
+     * @param const Node_t& 起点
+     * @param const bool& 正向搜索为true,反向搜索为false
+     * @param SearchSpace& 搜索空间
+     * @param std::vector<std::pair<Weight_t,Node_t> >& 扩展过且未停滞的节点及其距离
+     */
+    void Upward(const Node_t& _start,const bool& _isForward,SearchSpace& _space,std::vector<std::pair<Weight_t,Node_t> >& _settled) const;
+
+    /*!
+     * @brief 展开索引路段并将途经的节点(不含起点)追加到路线
+     * @param const Node_t& 起点
+     * @param const Node_t& 终点
+     * @param SearchSpace& 搜索空间
+     * @param std::vector<RfidBase::Rfid_t>& 路线
+     */
+    void Unpack(const Node_t& _from,const Node_t& _to,SearchSpace& _space,std::vector<RfidBase::Rfid_t>& _route) const;
+
+    /*!
+     * @brief 查找索引路段
+     * @param const Node_t& 起点
+     * @param const Node_t& 终点
+     * @return Arc 正向表示的路段
+     */
+    Arc FindArc(const Node_t& _from,const Node_t& _to) const;
+
+    /*!
+     * @brief 获取当前线程的搜索空间并开始新一代搜索
+     * @return SearchSpace& 搜索空间
+     */
+    SearchSpace& GetSearchSpace() const;
+};
+
+#endif // CONTRACTIONHIERARCHY_H
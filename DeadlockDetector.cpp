@@ -0,0 +1,202 @@
+#include "DeadlockDetector.h"
+
+DeadlockDetector::DeadlockDetector(RfidRegistry &_registry)
+    : m_registry(_registry)
+{
+    m_bResolve = false;
+    m_deadlocks = 0;
+    m_metric = MetricsRegistry::Instance().AddCounter("agv_deadlocks_total","Deadlocks detected in the landmark wait-for graph");
+}
+
+bool DeadlockDetector::Lock(const RfidBase::Rfid_t &_rfid, const AgvBase::AId_t &_agv)
+{
+    if(m_registry.Lock(_rfid,_agv))
+    {
+        Resume(_agv);
+
+        return true;
+    }
+
+    Wait(_agv,_rfid,false);
+
+    return false;
+}
+
+bool DeadlockDetector::PeerLock(const RfidBase::Rfid_t &_rfid, const AgvBase::AId_t &_agv)
+{
+    if(m_registry.PeerLock(_rfid,_agv))
+    {
+        Resume(_agv);
+
+        return true;
+    }
+
+    Wait(_agv,_rfid,true);
+
+    return false;
+}
+
+bool DeadlockDetector::Wait(const AgvBase::AId_t &_agv, const RfidBase::Rfid_t &_rfid, const bool &_bPeer)
+{
+    std::vector<AgvBase::AId_t> _cycle;     /*!< 环中的AGV */
+    AgvBase::AId_t _victim = RfidRegistry::NOBODY;
+    Handler _handler;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        WaitInfo& _wait = m_waits[_agv];
+        _wait.m_rfid = _rfid;
+        _wait.m_bPeer = _bPeer;
+
+        // 只有新增的出边可能形成新的环,环必然经过该AGV
+        if(FindCycle(_agv,_cycle) == false)
+        {
+            return false;
+        }
+
+        ++m_deadlocks;
+
+        _victim = Resolve(_cycle);
+        _handler = m_handler;
+    }
+
+    MetricsRegistry::Instance().Add(m_metric);
+
+    if(_handler)
+    {
+        _handler(_cycle,_victim);
+    }
+
+    return true;
+}
+
+void DeadlockDetector::Resume(const AgvBase::AId_t &_agv)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_waits.erase(_agv);
+
+    return;
+}
+
+void DeadlockDetector::SetPriority(const AgvBase::AId_t &_agv, const int &_priority)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_priorities[_agv] = _priority;
+
+    return;
+}
+
+void DeadlockDetector::SetHandler(const DeadlockDetector::Handler &_handler)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_handler = _handler;
+
+    return;
+}
+
+void DeadlockDetector::SetAutoResolve(const bool &_bResolve)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_bResolve = _bResolve;
+
+    return;
+}
+
+size_t DeadlockDetector::GetDeadlockCount()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_deadlocks;
+}
+
+AgvBase::AId_t DeadlockDetector::Blocker(const DeadlockDetector::WaitInfo &_wait) const
+{
+    if(_wait.m_bPeer)
+    {
+        return m_registry.GetPeerLocker(_wait.m_rfid);
+    }
+
+    return m_registry.GetLocker(_wait.m_rfid);
+}
+
+bool DeadlockDetector::FindCycle(const AgvBase::AId_t &_agv, std::vector<AgvBase::AId_t> &_cycle) const
+{
+    _cycle.clear();
+
+    AgvBase::AId_t _cur = _agv;
+
+    // 等待关系中可能已存在不经过该AGV的环,步数以等待的AGV数量为上限
+    for(size_t i = 0; i <= m_waits.size(); ++i)
+    {
+        std::map<AgvBase::AId_t,WaitInfo>::const_iterator it = m_waits.find(_cur);
+
+        if(it == m_waits.end())
+        {
+            // 锁定者未在等待
+            return false;
+        }
+
+        AgvBase::AId_t _next = Blocker(it->second);
+
+        if(_next == RfidRegistry::NOBODY || _next == _cur)
+        {
+            // 地标卡已被释放,等待的AGV再次尝试即可锁定
+            return false;
+        }
+
+        _cycle.push_back(_cur);
+
+        if(_next == _agv)
+        {
+            return true;
+        }
+
+        _cur = _next;
+    }
+
+    return false;
+}
+
+AgvBase::AId_t DeadlockDetector::Resolve(const std::vector<AgvBase::AId_t> &_cycle)
+{
+    AgvBase::AId_t _victim = _cycle.front();
+    int _lowest = 0;
+
+    for(std::vector<AgvBase::AId_t>::const_iterator it = _cycle.begin(); it != _cycle.end(); ++it)
+    {
+        std::map<AgvBase::AId_t,int>::const_iterator _found = m_priorities.find(*it);
+
+        int _priority = _found == m_priorities.end() ? 0 : _found->second;
+
+        if(it == _cycle.begin() || _priority < _lowest)
+        {
+            _victim = *it;
+            _lowest = _priority;
+        }
+    }
+
+    if(m_bResolve == false)
+    {
+        return _victim;
+    }
+
+    for(std::vector<AgvBase::AId_t>::const_iterator it = _cycle.begin(); it != _cycle.end(); ++it)
+    {
+        const WaitInfo& _wait = m_waits[*it];
+
+        if(_wait.m_bPeer && Blocker(_wait) == _victim)
+        {
+            // 远程锁定的地标卡AGV尚未到达,可以退让
+            m_registry.Cancel(_wait.m_rfid,_victim);
+        }
+    }
+
+    m_waits.erase(_victim);
+
+    return _victim;
+}
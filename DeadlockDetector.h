@@ -0,0 +1,144 @@
+/*!
+ * @file DeadlockDetector
+ * @brief 描述RFID地标卡锁定死锁检测功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef DEADLOCKDETECTOR_H
+#define DEADLOCKDETECTOR_H
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "RfidRegistry.h"
+
+/*!
+ * @class DeadlockDetector
+ * @brief 在AGV等待关系图上增量检测死锁的检测器
+ *
+ * AGV锁定或远程锁定RFID地标卡失败时,记录其等待的地标卡;锁定成功时删除等待
+ * 每台AGV同一时间只等待一个地标卡,等待关系图中每台AGV至多一条出边,出边的终点为地标卡的当前锁定者
+ * 因此只在新增等待时沿出边前进一次即可判断是否成环,无需周期性全图扫描
+ * 锁定者在遍历时从注册表读取,地标卡易主或被释放后等待关系自动更新
+ * TrafficController与RouteLocker设置检测器后,在登记、放行与取消等待时自动报告,直接操作注册表的调用方需自行调用Wait与Resume
+ */
+class DeadlockDetector
+{
+public:
+    /*!
+     * @param RfidRegistry& RFID地标卡注册表
+     */
+    explicit DeadlockDetector(RfidRegistry& _registry);
+
+public:
+    /*!
+     * @brief 死锁的处理函数
+     * @param const std::vector<AgvBase::AId_t>& 环中的AGV,按等待顺序排列
+     * @param const AgvBase::AId_t& 优先级最低的AGV
+     */
+    typedef std::function<void(const std::vector<AgvBase::AId_t>&,const AgvBase::AId_t&)> Handler;
+
+protected:
+    /*! @brief 描述AGV等待信息的结构体 */
+    struct WaitInfo
+    {
+        RfidBase::Rfid_t m_rfid;    /*!< 等待的RFID地标卡编号 */
+        bool m_bPeer;               /*!< 是否为远程锁定 */
+    };
+
+protected:
+    RfidRegistry& m_registry;                           /*!< RFID地标卡注册表 */
+    std::mutex m_mutex;                                 /*!< 互斥锁 */
+    std::map<AgvBase::AId_t,WaitInfo> m_waits;          /*!< 各AGV等待的地标卡 */
+    std::map<AgvBase::AId_t,int> m_priorities;          /*!< 各AGV的优先级,未设置时为0 */
+    Handler m_handler;                                  /*!< 死锁的处理函数 */
+    bool m_bResolve;                                    /*!< 是否自动解除死锁 */
+    size_t m_deadlocks;                                 /*!< 检测到的死锁数量 */
+    MetricsRegistry::MetricId m_metric;                 /*!< 死锁数量的指标 */
+
+public:
+    /*!
+     * @brief 锁定RFID地标卡,失败时记录等待并检测死锁
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool 锁定成功返回true,否则返回false
+     */
+    bool Lock(const RfidBase::Rfid_t& _rfid,const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 远程锁定RFID地标卡,失败时记录等待并检测死锁
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool 远程锁定成功返回true,否则返回false
+     */
+    bool PeerLock(const RfidBase::Rfid_t& _rfid,const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 记录AGV等待RFID地标卡并检测死锁,供直接操作注册表的调用方使用
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const bool& 是否为远程锁定
+     * @return bool 检测到死锁返回true
+     */
+    bool Wait(const AgvBase::AId_t& _agv,const RfidBase::Rfid_t& _rfid,const bool& _bPeer = false);
+
+    /*!
+     * @brief 删除AGV的等待
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Resume(const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 设置AGV的优先级,自动解除死锁时优先级最低的AGV退让
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const int& 优先级,数值越大优先级越高
+     */
+    void SetPriority(const AgvBase::AId_t& _agv,const int& _priority);
+
+    /*!
+     * @brief 设置死锁的处理函数
+     *
+     * 处理函数在检测到死锁的线程中调用,调用时不持有检测器的锁
+     * @param const Handler& 处理函数
+     */
+    void SetHandler(const Handler& _handler);
+
+    /*!
+     * @brief 设置是否自动解除死锁
+     *
+     * 自动解除时,优先级最低的AGV取消其远程锁定的、环中其他AGV等待的地标卡,并删除自身的等待
+     * AGV所在的地标卡无法自动释放,需由处理函数为其重新规划路线或令其后退
+     * @param const bool& 是否自动解除
+     */
+    void SetAutoResolve(const bool& _bResolve);
+
+    /*!
+     * @brief 获取检测到的死锁数量
+     * @return size_t 死锁数量
+     */
+    size_t GetDeadlockCount();
+
+protected:
+    /*!
+     * @brief 获取等待的地标卡的当前锁定者
+     */
+    AgvBase::AId_t Blocker(const WaitInfo& _wait) const;
+
+    /*!
+     * @brief 从AGV出发沿等待关系查找回到自身的环,调用方需持有锁
+     * @param const AgvBase::AId_t& AGV编号
+     * @param std::vector<AgvBase::AId_t>& 环中的AGV
+     * @return bool 存在环返回true
+     */
+    bool FindCycle(const AgvBase::AId_t& _agv,std::vector<AgvBase::AId_t>& _cycle) const;
+
+    /*!
+     * @brief 选出环中优先级最低的AGV并按设置退让,调用方需持有锁
+     * @param const std::vector<AgvBase::AId_t>& 环中的AGV
+     * @return AgvBase::AId_t 优先级最低的AGV
+     */
+    AgvBase::AId_t Resolve(const std::vector<AgvBase::AId_t>& _cycle);
+};
+
+#endif // DEADLOCKDETECTOR_H
@@ -0,0 +1,1213 @@
+#include "Dispatcher.h"
+
+#include <QTimer>
+#include <algorithm>
+#include <climits>
+#include <random>
+
+const Dispatcher::Cost_t Dispatcher::INFEASIBLE = 1000000000000LL;
+
+Dispatcher::Dispatcher(const ContractionHierarchy &_ch, AgvIndex &_index, TimingWheel &_wheel, const std::chrono::milliseconds &_window, QObject *parent)
+    : QObject(parent),m_ch(_ch),m_index(_index),m_wheel(_wheel)
+{
+    m_window = _window;
+    m_nextId = 1;
+    m_timer = TimingWheel::INVALID_TIMER;
+    m_bStopped = false;
+    m_minBattery = 20;
+    m_batteryCost = 1000;
+    m_pSimulator = nullptr;
+    m_variants = 16;
+    m_budget = std::chrono::milliseconds(50);
+    m_seed = 0;
+    m_batches = 0;
+    m_decision.m_plan = 0;
+    m_decision.m_evaluated = 0;
+    m_decision.m_seed = 0;
+    m_decision.m_result.m_completed = 0;
+    m_decision.m_result.m_makespan = 0.0;
+    m_decision.m_result.m_wait = 0.0;
+    m_pParking = nullptr;
+    m_pendingAbility.assign(AgvIndex::ABILITY_COUNT,0);
+    m_epoch = std::chrono::steady_clock::now();
+    m_defaultDeadline = std::chrono::minutes(30);
+    m_priorityStep = std::chrono::minutes(5);
+    m_aging = 1.0;
+    m_urgentPriority = 0;
+    m_urgentSlack = std::chrono::minutes(2);
+    m_handler = [this](const Order& _order,AgvBase* _agv){
+        LifeGuard::Token _token = m_guard.GetToken();
+
+        // 指令需在AGV所在的线程中发送
+        QTimer::singleShot(0,_agv,[this,_token,_order,_agv]{
+            LifeGuard::Scope _scope(_token);
+
+            if(_scope.IsEntered())
+            {
+                Send(_order,_agv);
+            }
+        });
+    };
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+
+    m_solveTime = _registry.AddHistogram("agv_dispatch_solve_seconds","Time spent computing one batch assignment",
+                                         {0.0005,0.001,0.002,0.005,0.01,0.02,0.05,0.1});
+    m_assigned = _registry.AddCounter("agv_orders_assigned_total","Transport orders assigned to AGVs");
+    m_pending = _registry.AddGauge("agv_orders_pending","Transport orders waiting for an AGV");
+    m_preempted = _registry.AddCounter("agv_orders_preempted_total","Assigned orders displaced by an urgent order before pickup");
+    m_rejected = _registry.AddCounter("agv_orders_rejected_total","Assigned orders put back because the AGV did not accept the move");
+
+    moveToThread(&m_thread);
+    m_thread.start();
+}
+
+Dispatcher::~Dispatcher()
+{
+    // 等待正在AGV线程中发送指令的回调返回
+    m_guard.Close();
+
+    TimingWheel::TimerId _timer = TimingWheel::INVALID_TIMER;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        m_bStopped = true;
+        _timer = m_timer;
+    }
+
+    // 等待正在投递Batch的回调返回,已投递的调用随对象删除而丢弃
+    m_wheel.CancelSync(_timer);
+
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void Dispatcher::AddAgv(AgvBase *_agv)
+{
+    if(_agv == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_agvs[_agv->GetID()] = _agv;
+
+    if(m_orders.empty() == false)
+    {
+        Schedule();
+    }
+
+    return;
+}
+
+void Dispatcher::RemoveAgv(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_agvs.erase(_id);
+    m_confirmed.erase(_id);
+
+    std::map<AgvBase::AId_t,Order>::iterator it = m_active.find(_id);
+
+    if(it != m_active.end())
+    {
+        // 订单不随AGV移出而丢失,如区域交接时刚分配、尚未执行的订单
+        Restore(it->second);
+
+        m_active.erase(it);
+        m_index.Unclaim(_id,AgvIndex::Claim_Order);
+    }
+
+    return;
+}
+
+Dispatcher::OrderId_t Dispatcher::Submit(const RfidBase::Rfid_t &_pickup, const RfidBase::Rfid_t &_drop, const float &_weight, const unsigned char &_ability,
+                                         const unsigned char &_priority, const std::chrono::milliseconds &_deadline)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    Order _order;
+    _order.m_id = m_nextId++;
+    _order.m_pickup = _pickup;
+    _order.m_drop = _drop;
+    _order.m_weight = _weight;
+    _order.m_ability = _ability;
+    _order.m_priority = _priority;
+    _order.m_created = std::chrono::steady_clock::now();
+    _order.m_deadline = _order.m_created + (_deadline.count() > 0 ? _deadline : m_defaultDeadline);
+    _order.m_key = GetKey(_order);
+
+    m_orders[_order.m_id] = _order;
+    m_queue.Push(_order.m_id,_order.m_key);
+
+    if(_ability < AgvIndex::ABILITY_COUNT)
+    {
+        ++m_pendingAbility[_ability];
+    }
+
+    if(m_pParking)
+    {
+        m_pParking->Record(_pickup,_ability);
+    }
+
+    MetricsRegistry::Instance().Set(m_pending,static_cast<long long>(m_orders.size()));
+
+    Schedule();
+
+    return _order.m_id;
+}
+
+bool Dispatcher::Cancel(const Dispatcher::OrderId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_orders.find(_id) == m_orders.end())
+    {
+        return false;
+    }
+
+    Take(_id);
+
+    return true;
+}
+
+bool Dispatcher::Reprioritize(const Dispatcher::OrderId_t &_id, const unsigned char &_priority, const std::chrono::milliseconds &_deadline)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<OrderId_t,Order>::iterator it = m_orders.find(_id);
+
+    if(it == m_orders.end())
+    {
+        return false;
+    }
+
+    it->second.m_priority = _priority;
+
+    if(_deadline.count() > 0)
+    {
+        it->second.m_deadline = std::chrono::steady_clock::now() + _deadline;
+    }
+
+    it->second.m_key = GetKey(it->second);
+
+    // 分配期间订单不在队列中,结束后按新的键值放回
+    m_queue.Update(_id,it->second.m_key);
+
+    Schedule();
+
+    return true;
+}
+
+void Dispatcher::Complete(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_confirmed.erase(_id);
+
+    if(m_active.erase(_id) > 0)
+    {
+        m_index.Unclaim(_id,AgvIndex::Claim_Order);
+    }
+
+    if(m_orders.empty() == false)
+    {
+        Schedule();
+    }
+
+    return;
+}
+
+bool Dispatcher::Reject(const AgvBase::AId_t &_id, const Dispatcher::OrderId_t &_order)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Order>::iterator it = m_active.find(_id);
+
+    if(it == m_active.end() || it->second.m_id != _order)
+    {
+        // 期间AGV完成、被移除或被改派
+        return false;
+    }
+
+    Restore(it->second);
+
+    m_active.erase(it);
+    m_confirmed.erase(_id);
+    m_index.Unclaim(_id,AgvIndex::Claim_Order);
+
+    MetricsRegistry::Instance().Add(m_rejected);
+
+    return true;
+}
+
+bool Dispatcher::IsAssigned(const AgvBase::AId_t &_id, const Dispatcher::OrderId_t &_order)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Order>::iterator it = m_active.find(_id);
+
+    return it != m_active.end() && it->second.m_id == _order;
+}
+
+bool Dispatcher::Confirm(const AgvBase::AId_t &_id, const Dispatcher::OrderId_t &_order)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Order>::iterator it = m_active.find(_id);
+
+    if(it == m_active.end() || it->second.m_id != _order)
+    {
+        return false;
+    }
+
+    m_confirmed.insert(_id);
+
+    return true;
+}
+
+void Dispatcher::Send(const Dispatcher::Order &_order, AgvBase *_agv)
+{
+    AgvBase::AId_t _id = _agv->GetID();
+
+    // 回调排队期间订单可能已被抢占改派,此时AGV会收到新订单的指令,不能再发送旧订单
+    if(IsAssigned(_id,_order.m_id) == false)
+    {
+        return;
+    }
+
+    // 未确认前订单不会被抢占,检查与发送之间不会改派
+    if(_agv->Move(_order.m_pickup) != AgvBase::Cmd_Success)
+    {
+        Reject(_id,_order.m_id);
+
+        return;
+    }
+
+    Confirm(_id,_order.m_id);
+
+    return;
+}
+
+void Dispatcher::SetHandler(const Dispatcher::Handler &_handler)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_handler = _handler;
+
+    return;
+}
+
+void Dispatcher::SetBattery(const AgvBase::ABattery_t &_minBattery, const Dispatcher::Cost_t &_cost)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_minBattery = _minBattery;
+    m_batteryCost = _cost;
+
+    return;
+}
+
+void Dispatcher::SetPriority(const std::chrono::milliseconds &_step, const double &_aging, const unsigned char &_urgentPriority, const std::chrono::milliseconds &_urgentSlack)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_priorityStep = _step;
+    m_aging = _aging;
+    m_urgentPriority = _urgentPriority;
+    m_urgentSlack = _urgentSlack;
+
+    // 键值的计算方式改变,重新建立队列
+    m_queue.Clear();
+
+    for(std::map<OrderId_t,Order>::iterator it = m_orders.begin(); it != m_orders.end(); ++it)
+    {
+        it->second.m_key = GetKey(it->second);
+
+        m_queue.Push(it->first,it->second.m_key);
+    }
+
+    return;
+}
+
+void Dispatcher::SetPreemptHandler(const Dispatcher::Handler &_handler)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_preemptHandler = _handler;
+
+    return;
+}
+
+void Dispatcher::SetSimulation(FleetSimulator *_simulator, const size_t &_variants, const std::chrono::milliseconds &_budget, const unsigned long long &_seed)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_pSimulator = _simulator;
+    m_variants = _variants;
+    m_budget = _budget;
+    m_seed = _seed;
+    m_batches = 0;
+
+    return;
+}
+
+FleetSimulator::Decision Dispatcher::GetLastDecision()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_decision;
+}
+
+void Dispatcher::SetParking(ParkingPlanner *_planner)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_pParking = _planner;
+
+    return;
+}
+
+size_t Dispatcher::GetPendingCount()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_orders.size();
+}
+
+Dispatcher::Cost_t Dispatcher::Assign(const std::vector<Cost_t> &_cost, const size_t &_rows, const size_t &_cols, std::vector<int> &_assign)
+{
+    _assign.assign(_rows,-1);
+
+    if(_rows == 0 || _rows > _cols)
+    {
+        return 0;
+    }
+
+    // 行与列均从1开始编号,第0列为虚拟列
+    std::vector<Cost_t> _u(_rows + 1,0);        /*!< 行势 */
+    std::vector<Cost_t> _v(_cols + 1,0);        /*!< 列势 */
+    std::vector<size_t> _match(_cols + 1,0);    /*!< 各列匹配的行 */
+    std::vector<size_t> _way(_cols + 1,0);      /*!< 增广路径上的前一列 */
+    std::vector<Cost_t> _minv(_cols + 1);
+    std::vector<char> _used(_cols + 1);
+
+    for(size_t i = 1; i <= _rows; ++i)
+    {
+        _match[0] = i;
+        size_t _j0 = 0;
+
+        std::fill(_minv.begin(),_minv.end(),LLONG_MAX);
+        std::fill(_used.begin(),_used.end(),0);
+
+        do
+        {
+            _used[_j0] = 1;
+
+            size_t _i0 = _match[_j0];
+            size_t _j1 = 0;
+            Cost_t _delta = LLONG_MAX;
+
+            const Cost_t* _row = &_cost[(_i0 - 1) * _cols];
+
+            for(size_t j = 1; j <= _cols; ++j)
+            {
+                if(_used[j])
+                {
+                    continue;
+                }
+
+                Cost_t _reduced = _row[j - 1] - _u[_i0] - _v[j];
+
+                if(_reduced < _minv[j])
+                {
+                    _minv[j] = _reduced;
+                    _way[j] = _j0;
+                }
+
+                if(_minv[j] < _delta)
+                {
+                    _delta = _minv[j];
+                    _j1 = j;
+                }
+            }
+
+            for(size_t j = 0; j <= _cols; ++j)
+            {
+                if(_used[j])
+                {
+                    _u[_match[j]] += _delta;
+                    _v[j] -= _delta;
+                }
+                else
+                {
+                    _minv[j] -= _delta;
+                }
+            }
+
+            _j0 = _j1;
+        }
+        while(_match[_j0] != 0);
+
+        // 沿增广路径翻转匹配
+        do
+        {
+            size_t _j1 = _way[_j0];
+            _match[_j0] = _match[_j1];
+            _j0 = _j1;
+        }
+        while(_j0 != 0);
+    }
+
+    Cost_t _total = 0;
+
+    for(size_t j = 1; j <= _cols; ++j)
+    {
+        if(_match[j] != 0)
+        {
+            _assign[_match[j] - 1] = static_cast<int>(j - 1);
+            _total += _cost[(_match[j] - 1) * _cols + j - 1];
+        }
+    }
+
+    return _total;
+}
+
+Dispatcher::Benchmark Dispatcher::Measure(const ContractionHierarchy &_ch, const RfidMap &_map, const size_t &_agvs, const size_t &_orders, const unsigned long long &_seed)
+{
+    Benchmark _result;
+    _result.m_agvs = _agvs;
+    _result.m_orders = _orders;
+    _result.m_tableTime = 0.0;
+    _result.m_assignTime = 0.0;
+    _result.m_total = 0;
+
+    if(_ch.IsReady() == false || _map.GetNodeCount() == 0 || _agvs == 0 || _orders == 0)
+    {
+        return _result;
+    }
+
+    std::mt19937_64 _random(_seed);
+    std::uniform_int_distribution<RfidMap::Node_t> _pick(0,_map.GetNodeCount() - 1);
+
+    std::vector<RfidBase::Rfid_t> _sources;
+    std::vector<RfidBase::Rfid_t> _targets;
+
+    for(size_t i = 0; i < _agvs; ++i)
+    {
+        _sources.push_back(_map.GetRfid(_pick(_random)));
+    }
+
+    for(size_t i = 0; i < _orders; ++i)
+    {
+        _targets.push_back(_map.GetRfid(_pick(_random)));
+    }
+
+    std::chrono::steady_clock::time_point _begin = std::chrono::steady_clock::now();
+
+    std::vector<ContractionHierarchy::Weight_t> _distances;
+
+    _ch.Table(_sources,_targets,_distances);
+
+    std::chrono::steady_clock::time_point _middle = std::chrono::steady_clock::now();
+
+    // 与Batch相同,行数需不大于列数
+    bool _byOrder = _orders <= _agvs;
+    size_t _rows = _byOrder ? _orders : _agvs;
+    size_t _cols = _byOrder ? _agvs : _orders;
+
+    std::vector<Cost_t> _cost(_rows * _cols);
+
+    for(size_t a = 0; a < _agvs; ++a)
+    {
+        for(size_t o = 0; o < _orders; ++o)
+        {
+            ContractionHierarchy::Weight_t _distance = _distances[a * _orders + o];
+            Cost_t _value = _distance == RfidMap::INFINITE ? INFEASIBLE : static_cast<Cost_t>(_distance);
+
+            _cost[_byOrder ? o * _cols + a : a * _cols + o] = _value;
+        }
+    }
+
+    std::vector<int> _assign;
+
+    _result.m_total = Assign(_cost,_rows,_cols,_assign);
+
+    std::chrono::steady_clock::time_point _end = std::chrono::steady_clock::now();
+
+    _result.m_tableTime = std::chrono::duration<double>(_middle - _begin).count();
+    _result.m_assignTime = std::chrono::duration<double>(_end - _middle).count();
+
+    return _result;
+}
+
+void Dispatcher::Schedule()
+{
+    if(m_timer != TimingWheel::INVALID_TIMER || m_bStopped)
+    {
+        // 本窗口已安排分配
+        return;
+    }
+
+    m_timer = m_wheel.Start(m_window,[this]{ QMetaObject::invokeMethod(this,"Batch",Qt::QueuedConnection); });
+
+    return;
+}
+
+Dispatcher::Cost_t Dispatcher::Evaluate(const Dispatcher::Candidate &_candidate, const Dispatcher::Order &_order, const ContractionHierarchy::Weight_t &_distance) const
+{
+    if(_distance == RfidMap::INFINITE)
+    {
+        return INFEASIBLE;
+    }
+
+    if(_order.m_ability != 0 && _order.m_ability != _candidate.m_ability)
+    {
+        return INFEASIBLE;
+    }
+
+    if(_candidate.m_maxWeight > 0.0f && _order.m_weight > _candidate.m_maxWeight)
+    {
+        // 最大载重量为0的类型视为未限制
+        return INFEASIBLE;
+    }
+
+    if(_candidate.m_battery < m_minBattery)
+    {
+        return INFEASIBLE;
+    }
+
+    // 电量越低代价越高,相近距离时优先分配给电量充足的AGV
+    return static_cast<Cost_t>(_distance) + static_cast<Cost_t>(100 - std::min<int>(_candidate.m_battery,100)) * m_batteryCost;
+}
+
+void Dispatcher::Batch()
+{
+    std::vector<Candidate> _candidates;
+    std::vector<Order> _orders;
+    std::vector<Order> _taken;          /*!< 从队列中取出的订单,含超出空闲AGV数量的紧急订单 */
+    std::vector<AgvIndex::Snapshot> _obstacles;
+    Handler _handler;
+    FleetSimulator* _simulator = nullptr;
+    size_t _variants = 0;
+    std::chrono::milliseconds _budget;
+    unsigned long long _seed = 0;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        m_timer = TimingWheel::INVALID_TIMER;
+
+        // 只取订单需要的功能的空闲AGV,状态读取AGV线程中采集的快照
+        std::vector<AgvIndex::Snapshot> _idle;
+
+        if(m_pendingAbility[0] > 0)
+        {
+            m_index.GetSnapshots(0,AgvIndex::Avail_Idle,_idle);
+        }
+        else
+        {
+            for(unsigned char i = 1; i < AgvIndex::ABILITY_COUNT; ++i)
+            {
+                if(m_pendingAbility[i] > 0)
+                {
+                    m_index.GetSnapshots(i,AgvIndex::Avail_Idle,_idle);
+                }
+            }
+        }
+
+        std::vector<size_t> _capacity(AgvIndex::ABILITY_COUNT,0);     /*!< 各功能的空闲AGV数量 */
+
+        for(std::vector<AgvIndex::Snapshot>::iterator it = _idle.begin(); it != _idle.end(); ++it)
+        {
+            if(m_agvs.find(it->m_id) == m_agvs.end() || m_active.find(it->m_id) != m_active.end())
+            {
+                continue;
+            }
+
+            Candidate _candidate = ToCandidate(*it);
+
+            _candidates.push_back(_candidate);
+
+            if(_candidate.m_ability < AgvIndex::ABILITY_COUNT)
+            {
+                ++_capacity[_candidate.m_ability];
+            }
+        }
+
+        // 按紧急程度取出订单,数量不超过空闲AGV数量;没有对应功能AGV的订单放回队列,紧急订单留待抢占
+        std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now();
+        std::vector<Order> _skipped;
+        size_t _remaining = _candidates.size();
+        size_t _limit = _candidates.size() * 4 + 64;
+
+        for(size_t _scan = 0; _scan < _limit && m_queue.IsEmpty() == false; ++_scan)
+        {
+            OrderQueue::Id_t _id = 0;
+            OrderQueue::Key_t _key = 0;
+
+            m_queue.Top(_id,_key);
+
+            const Order& _order = m_orders[_id];
+
+            bool _bFits = _remaining > 0 && (_order.m_ability == 0 || (_order.m_ability < AgvIndex::ABILITY_COUNT && _capacity[_order.m_ability] > 0));
+
+            if(_bFits == false && IsUrgent(_order,_now) == false)
+            {
+                if(_remaining == 0)
+                {
+                    // 队列按紧急程度排列,其后的订单通常也不紧急
+                    break;
+                }
+
+                _skipped.push_back(_order);
+                m_queue.Pop();
+                continue;
+            }
+
+            m_queue.Pop();
+
+            if(_bFits)
+            {
+                --_remaining;
+
+                if(_order.m_ability != 0)
+                {
+                    --_capacity[_order.m_ability];
+                }
+
+                _orders.push_back(_order);
+            }
+            else
+            {
+                _taken.push_back(_order);
+            }
+        }
+
+        for(std::vector<Order>::iterator it = _skipped.begin(); it != _skipped.end(); ++it)
+        {
+            m_queue.Push(it->m_id,it->m_key);
+        }
+
+        _handler = m_handler;
+
+        if(m_pSimulator && _candidates.empty() == false && _orders.empty() == false)
+        {
+            _simulator = m_pSimulator;
+            _variants = m_variants;
+            _budget = m_budget;
+            _seed = m_seed + m_batches++;
+
+            // 不参与本批分配的AGV在模拟中视为障碍
+            for(std::map<AgvBase::AId_t,AgvBase*>::iterator it = m_agvs.begin(); it != m_agvs.end(); ++it)
+            {
+                bool _bCandidate = false;
+
+                for(std::vector<Candidate>::iterator c = _candidates.begin(); c != _candidates.end(); ++c)
+                {
+                    if(c->m_id == it->first)
+                    {
+                        _bCandidate = true;
+                        break;
+                    }
+                }
+
+                AgvIndex::Snapshot _snapshot;
+
+                if(_bCandidate == false && m_index.GetSnapshot(it->first,_snapshot))
+                {
+                    _obstacles.push_back(_snapshot);
+                }
+            }
+        }
+    }
+
+    _taken.insert(_taken.end(),_orders.begin(),_orders.end());
+
+    if(_candidates.empty() || _orders.empty())
+    {
+        Settle(_taken);
+        return;
+    }
+
+    std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+
+    std::vector<RfidBase::Rfid_t> _sources;
+    std::vector<RfidBase::Rfid_t> _targets;
+
+    for(std::vector<Candidate>::iterator it = _candidates.begin(); it != _candidates.end(); ++it)
+    {
+        _sources.push_back(it->m_rfid);
+    }
+
+    for(std::vector<Order>::iterator it = _orders.begin(); it != _orders.end(); ++it)
+    {
+        _targets.push_back(it->m_pickup);
+    }
+
+    std::vector<ContractionHierarchy::Weight_t> _distances;
+
+    m_ch.Table(_sources,_targets,_distances);
+
+    // 行数需不大于列数,订单多于AGV时以AGV为行
+    bool _byOrder = _orders.size() <= _candidates.size();
+    size_t _rows = _byOrder ? _orders.size() : _candidates.size();
+    size_t _cols = _byOrder ? _candidates.size() : _orders.size();
+
+    std::vector<Cost_t> _cost(_rows * _cols);
+
+    for(size_t a = 0; a < _candidates.size(); ++a)
+    {
+        for(size_t o = 0; o < _orders.size(); ++o)
+        {
+            Cost_t _value = Evaluate(_candidates[a],_orders[o],_distances[a * _orders.size() + o]);
+
+            if(_byOrder)
+            {
+                _cost[o * _cols + a] = _value;
+            }
+            else
+            {
+                _cost[a * _cols + o] = _value;
+            }
+        }
+    }
+
+    std::vector<int> _assign;
+
+    Assign(_cost,_rows,_cols,_assign);
+
+    MetricsRegistry::Instance().Observe(m_solveTime,std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count());
+
+    // 各订单分配的AGV,-1为未分配
+    std::vector<int> _plan(_orders.size(),-1);
+
+    for(size_t r = 0; r < _rows; ++r)
+    {
+        if(_assign[r] < 0 || _cost[r * _cols + static_cast<size_t>(_assign[r])] >= INFEASIBLE)
+        {
+            continue;
+        }
+
+        if(_byOrder)
+        {
+            _plan[r] = _assign[r];
+        }
+        else
+        {
+            _plan[static_cast<size_t>(_assign[r])] = static_cast<int>(r);
+        }
+    }
+
+    if(_simulator)
+    {
+        _plan = Simulate(_simulator,_candidates,_orders,_obstacles,_cost,_byOrder,_plan,_variants,_budget,_seed);
+    }
+
+    for(size_t o = 0; o < _orders.size(); ++o)
+    {
+        if(_plan[o] < 0)
+        {
+            continue;
+        }
+
+        const Order& _order = _orders[o];
+        const Candidate& _candidate = _candidates[static_cast<size_t>(_plan[o])];
+
+        AgvBase::AId_t _id = _candidate.m_id;
+
+        {
+            std::lock_guard<std::mutex> _lock(m_mutex);
+
+            if(m_orders.find(_order.m_id) == m_orders.end() || m_agvs.find(_id) == m_agvs.end())
+            {
+                // 分配期间订单被取消或AGV被移除
+                continue;
+            }
+
+            if(m_index.Claim(_id,AgvIndex::Claim_Order) == false)
+            {
+                // 分配期间AGV已不空闲,订单留待下一批
+                continue;
+            }
+
+            Take(_order.m_id);
+
+            m_active[_id] = _order;
+            m_confirmed.erase(_id);
+        }
+
+        MetricsRegistry::Instance().Add(m_assigned);
+
+        if(_handler)
+        {
+            _handler(_order,_candidate.m_pAgv);
+        }
+    }
+
+    Settle(_taken);
+
+    return;
+}
+
+Dispatcher::Candidate Dispatcher::ToCandidate(const AgvIndex::Snapshot &_snapshot)
+{
+    Candidate _candidate;
+    _candidate.m_pAgv = _snapshot.m_pAgv;
+    _candidate.m_id = _snapshot.m_id;
+    _candidate.m_rfid = _snapshot.m_rfid;
+    _candidate.m_battery = _snapshot.m_battery;
+    _candidate.m_ability = _snapshot.m_ability;
+    _candidate.m_maxWeight = _snapshot.m_maxWeight;
+    _candidate.m_maxSpeed = _snapshot.m_maxSpeed;
+
+    return _candidate;
+}
+
+OrderQueue::Key_t Dispatcher::GetKey(const Dispatcher::Order &_order) const
+{
+    // 等待时间按系数抵扣截止时间:截止时间-优先级×间隔-系数×(当前时间-提交时间),
+    // 其中当前时间对所有订单相同,不影响先后,因此键值不随时间改变,队列无需周期性调整
+    double _deadline = std::chrono::duration<double,std::milli>(_order.m_deadline - m_epoch).count();
+    double _created = std::chrono::duration<double,std::milli>(_order.m_created - m_epoch).count();
+
+    return static_cast<OrderQueue::Key_t>(_deadline - static_cast<double>(_order.m_priority) * m_priorityStep.count() + m_aging * _created);
+}
+
+bool Dispatcher::IsUrgent(const Dispatcher::Order &_order, const std::chrono::steady_clock::time_point &_now) const
+{
+    if(m_urgentPriority != 0 && _order.m_priority >= m_urgentPriority)
+    {
+        return true;
+    }
+
+    return _order.m_deadline - _now <= m_urgentSlack;
+}
+
+void Dispatcher::Take(const Dispatcher::OrderId_t &_id)
+{
+    std::map<OrderId_t,Order>::iterator it = m_orders.find(_id);
+
+    if(it == m_orders.end())
+    {
+        return;
+    }
+
+    if(it->second.m_ability < AgvIndex::ABILITY_COUNT)
+    {
+        --m_pendingAbility[it->second.m_ability];
+    }
+
+    m_queue.Remove(_id);
+    m_orders.erase(it);
+
+    MetricsRegistry::Instance().Set(m_pending,static_cast<long long>(m_orders.size()));
+
+    return;
+}
+
+void Dispatcher::Restore(const Dispatcher::Order &_order)
+{
+    // 保留原来的键值,等待时间继续计入
+    m_orders[_order.m_id] = _order;
+
+    if(_order.m_ability < AgvIndex::ABILITY_COUNT)
+    {
+        ++m_pendingAbility[_order.m_ability];
+    }
+
+    m_queue.Push(_order.m_id,_order.m_key);
+
+    MetricsRegistry::Instance().Set(m_pending,static_cast<long long>(m_orders.size()));
+
+    Schedule();
+
+    return;
+}
+
+void Dispatcher::Settle(const std::vector<Dispatcher::Order> &_taken)
+{
+    std::vector<Order> _urgent;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now();
+
+        for(std::vector<Order>::const_iterator it = _taken.begin(); it != _taken.end(); ++it)
+        {
+            std::map<OrderId_t,Order>::iterator _found = m_orders.find(it->m_id);
+
+            if(_found != m_orders.end() && IsUrgent(_found->second,_now))
+            {
+                _urgent.push_back(_found->second);
+            }
+        }
+    }
+
+    if(_urgent.empty() == false)
+    {
+        Preempt(_urgent);
+    }
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        // 未分配且未取消的订单放回队列
+        for(std::vector<Order>::const_iterator it = _taken.begin(); it != _taken.end(); ++it)
+        {
+            std::map<OrderId_t,Order>::iterator _found = m_orders.find(it->m_id);
+
+            if(_found != m_orders.end())
+            {
+                m_queue.Push(_found->first,_found->second.m_key);
+            }
+        }
+    }
+
+    return;
+}
+
+void Dispatcher::Preempt(std::vector<Dispatcher::Order> &_urgent)
+{
+    std::vector<Candidate> _victims;
+    std::vector<Order> _displaced;
+    Handler _handler;
+    Handler _preemptHandler;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now();
+
+        for(std::map<AgvBase::AId_t,Order>::iterator it = m_active.begin(); it != m_active.end(); ++it)
+        {
+            AgvIndex::Snapshot _snapshot;
+
+            if(m_agvs.find(it->first) == m_agvs.end() || IsUrgent(it->second,_now) || m_index.GetSnapshot(it->first,_snapshot) == false)
+            {
+                continue;
+            }
+
+            // 移动指令尚未发送的订单不抢占,否则AGV会先后收到新旧两条指令
+            if(m_confirmed.find(it->first) == m_confirmed.end())
+            {
+                continue;
+            }
+
+            // 只抢占尚未取货且处于待机状态、可以直接改派的AGV
+            if(_snapshot.m_cargo != 0 || _snapshot.m_state != AgvIndex::Avail_Idle)
+            {
+                continue;
+            }
+
+            _victims.push_back(ToCandidate(_snapshot));
+            _displaced.push_back(it->second);
+        }
+
+        _handler = m_handler;
+        _preemptHandler = m_preemptHandler;
+    }
+
+    if(_victims.empty())
+    {
+        return;
+    }
+
+    std::sort(_urgent.begin(),_urgent.end(),[](const Order& _a,const Order& _b){ return _a.m_key < _b.m_key; });
+
+    std::vector<RfidBase::Rfid_t> _sources;
+    std::vector<RfidBase::Rfid_t> _targets;
+
+    for(std::vector<Candidate>::iterator it = _victims.begin(); it != _victims.end(); ++it)
+    {
+        _sources.push_back(it->m_rfid);
+    }
+
+    for(std::vector<Order>::iterator it = _urgent.begin(); it != _urgent.end(); ++it)
+    {
+        _targets.push_back(it->m_pickup);
+    }
+
+    std::vector<ContractionHierarchy::Weight_t> _distances;
+
+    if(m_ch.Table(_sources,_targets,_distances) == false)
+    {
+        return;
+    }
+
+    std::vector<bool> _used(_victims.size(),false);
+
+    // 按紧急程度依次为紧急订单抢占代价最小的、订单不如它紧急的AGV
+    for(size_t u = 0; u < _urgent.size(); ++u)
+    {
+        size_t _best = _victims.size();
+        Cost_t _bestCost = INFEASIBLE;
+
+        for(size_t v = 0; v < _victims.size(); ++v)
+        {
+            if(_used[v] || _displaced[v].m_key <= _urgent[u].m_key)
+            {
+                continue;
+            }
+
+            Cost_t _cost = Evaluate(_victims[v],_urgent[u],_distances[v * _urgent.size() + u]);
+
+            if(_cost < _bestCost)
+            {
+                _best = v;
+                _bestCost = _cost;
+            }
+        }
+
+        if(_best == _victims.size())
+        {
+            continue;
+        }
+
+        AgvBase* _agv = _victims[_best].m_pAgv;
+        AgvBase::AId_t _id = _victims[_best].m_id;
+        const Order& _order = _urgent[u];
+        const Order& _old = _displaced[_best];
+
+        {
+            std::lock_guard<std::mutex> _lock(m_mutex);
+
+            std::map<AgvBase::AId_t,Order>::iterator it = m_active.find(_id);
+
+            if(it == m_active.end() || it->second.m_id != _old.m_id || m_orders.find(_order.m_id) == m_orders.end())
+            {
+                // 期间AGV完成、被移除或订单被取消
+                continue;
+            }
+
+            Take(_order.m_id);
+
+            it->second = _order;
+            m_confirmed.erase(_id);
+
+            Restore(_old);
+        }
+
+        _used[_best] = true;
+
+        MetricsRegistry& _registry = MetricsRegistry::Instance();
+        _registry.Add(m_preempted);
+        _registry.Add(m_assigned);
+
+        if(_preemptHandler)
+        {
+            _preemptHandler(_old,_agv);
+        }
+
+        if(_handler)
+        {
+            _handler(_order,_agv);
+        }
+    }
+
+    return;
+}
+
+std::vector<int> Dispatcher::Simulate(FleetSimulator *_simulator, const std::vector<Dispatcher::Candidate> &_candidates, const std::vector<Dispatcher::Order> &_orders,
+                                      const std::vector<AgvIndex::Snapshot> &_obstacles, const std::vector<Cost_t> &_cost, const bool &_byOrder,
+                                      const std::vector<int> &_plan, const size_t &_variants, const std::chrono::milliseconds &_budget, const unsigned long long &_seed)
+{
+    size_t _cols = _byOrder ? _candidates.size() : _orders.size();
+
+    // 组合是否可行
+    std::function<bool(size_t,size_t)> _feasible = [&](size_t _a,size_t _o){
+        return (_byOrder ? _cost[_o * _cols + _a] : _cost[_a * _cols + _o]) < INFEASIBLE;
+    };
+
+    std::vector<FleetSimulator::Plan> _plans;
+    _plans.push_back(_plan);
+
+    std::mt19937_64 _random(_seed);
+
+    // 每个候选方案在第0个方案上做一次交换或替换,尝试次数有限,避免可行组合很少时空转
+    for(size_t _tries = 0; _plans.size() <= _variants && _tries < _variants * 4; ++_tries)
+    {
+        FleetSimulator::Plan _variant = _plan;
+
+        size_t _o = static_cast<size_t>(_random() % _orders.size());
+        size_t _a = static_cast<size_t>(_random() % _candidates.size());
+
+        if(_feasible(_a,_o) == false || _variant[_o] == static_cast<int>(_a))
+        {
+            continue;
+        }
+
+        std::vector<int>::iterator it = std::find(_variant.begin(),_variant.end(),static_cast<int>(_a));
+
+        if(it != _variant.end())
+        {
+            // AGV已分配给其他订单,两个订单交换AGV
+            size_t _other = static_cast<size_t>(it - _variant.begin());
+
+            if(_variant[_o] >= 0 && _feasible(static_cast<size_t>(_variant[_o]),_other) == false)
+            {
+                continue;
+            }
+
+            *it = _variant[_o];
+        }
+
+        _variant[_o] = static_cast<int>(_a);
+
+        if(std::find(_plans.begin(),_plans.end(),_variant) == _plans.end())
+        {
+            _plans.push_back(_variant);
+        }
+    }
+
+    // 只使用AGV线程中采集的快照,不在分配线程中读取AGV
+    std::vector<FleetSimulator::SimAgv> _agvs;
+
+    for(std::vector<Candidate>::const_iterator it = _candidates.begin(); it != _candidates.end(); ++it)
+    {
+        FleetSimulator::SimAgv _sim;
+        _sim.m_id = it->m_id;
+        _sim.m_rfid = it->m_rfid;
+        _sim.m_ability = it->m_ability;
+        _sim.m_speed = it->m_maxSpeed;
+        _sim.m_bStatic = false;
+
+        _agvs.push_back(_sim);
+    }
+
+    for(std::vector<AgvIndex::Snapshot>::const_iterator it = _obstacles.begin(); it != _obstacles.end(); ++it)
+    {
+        FleetSimulator::SimAgv _sim;
+        _sim.m_id = it->m_id;
+        _sim.m_rfid = it->m_rfid;
+        _sim.m_ability = it->m_ability;
+        _sim.m_speed = it->m_maxSpeed;
+        _sim.m_bStatic = true;
+
+        _agvs.push_back(_sim);
+    }
+
+    std::vector<FleetSimulator::SimOrder> _simOrders;
+
+    for(std::vector<Order>::const_iterator it = _orders.begin(); it != _orders.end(); ++it)
+    {
+        FleetSimulator::SimOrder _simOrder;
+        _simOrder.m_pickup = it->m_pickup;
+        _simOrder.m_drop = it->m_drop;
+
+        _simOrders.push_back(_simOrder);
+    }
+
+    FleetSimulator::Decision _decision = _simulator->Choose(_simulator->Capture(_agvs),_simOrders,_plans,_seed,_budget);
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        m_decision = _decision;
+    }
+
+    return _plans[_decision.m_plan];
+}
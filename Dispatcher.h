@@ -0,0 +1,397 @@
+/*!
+ * @file Dispatcher
+ * @brief 描述搬运订单批量分配功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef DISPATCHER_H
+#define DISPATCHER_H
+
+#include <QObject>
+#include <QThread>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "AgvIndex.h"
+#include "ContractionHierarchy.h"
+#include "FleetSimulator.h"
+#include "LifeGuard.h"
+#include "OrderQueue.h"
+#include "ParkingPlanner.h"
+#include "TimingWheel.h"
+
+/*!
+ * @class Dispatcher
+ * @brief 将搬运订单批量分配给AGV的调度器
+ *
+ * 订单提交后在短时间窗口内累积,窗口结束时一次性分配:
+ * 只从AGV索引的空闲分桶中取得订单所需功能的AGV,不遍历车队;
+ * 待分配的订单按截止时间、优先级与等待时间排列在优先队列中,每批只取出与空闲AGV数量相当的最紧急的订单;
+ * 以收缩层次索引批量计算各AGV至各取货点的距离,叠加电量代价,排除功能、载重或电量不满足的组合,
+ * 再以匈牙利算法求总代价最小的分配;未分配的订单留待下一批
+ * 设置模拟器后,以匈牙利算法的结果为第0个方案并生成若干交换、替换AGV的候选方案,
+ * 在时间预算内并行模拟交通冲突与等待,执行模拟完工时间最短的方案
+ * 紧急订单没有空闲AGV时,抢占订单不如它紧急、尚未取货且仍在待机的AGV,被抢占的订单以原来的键值放回队列
+ * 分配在调度器线程中进行,分配结果交由处理函数执行,默认令AGV移动至取货点;AGV未接受指令时订单以原来的键值放回队列
+ * 执行前以AGV索引认领AGV,订单的认领优先于停车点规划与充电调度,完成订单或移除AGV时撤销
+ */
+class Dispatcher : public QObject
+{
+    Q_OBJECT
+public:
+    /*!
+     * @param const ContractionHierarchy& 已就绪的收缩层次索引
+     * @param AgvIndex& AGV索引
+     * @param TimingWheel& 共用的时间轮
+     * @param const std::chrono::milliseconds& 批量分配的时间窗口
+     */
+    Dispatcher(const ContractionHierarchy& _ch,AgvIndex& _index,TimingWheel& _wheel,
+               const std::chrono::milliseconds& _window = std::chrono::milliseconds(200),QObject *parent = nullptr);
+    ~Dispatcher();
+
+public:
+    typedef unsigned int OrderId_t;
+    typedef long long Cost_t;
+
+    static const Cost_t INFEASIBLE;     /*!< 不可行组合的代价 */
+
+    /*! @brief 描述搬运订单的结构体 */
+    struct Order
+    {
+        OrderId_t m_id;                                     /*!< 编号 */
+        RfidBase::Rfid_t m_pickup;                          /*!< 取货点RFID地标卡编号 */
+        RfidBase::Rfid_t m_drop;                            /*!< 卸货点RFID地标卡编号 */
+        float m_weight;                                     /*!< 货物重量:单位(kg) */
+        unsigned char m_ability;                            /*!< 需要的AGV功能,见AgvType::AgvAbility,0为不限 */
+        unsigned char m_priority;                           /*!< 优先级,越大越优先 */
+        std::chrono::steady_clock::time_point m_created;    /*!< 提交时间 */
+        std::chrono::steady_clock::time_point m_deadline;   /*!< 截止时间 */
+        OrderQueue::Key_t m_key;                            /*!< 在队列中的键值 */
+    };
+
+    /*!
+     * @brief 执行分配结果的处理函数,在调度器线程中调用
+     *
+     * 应在AGV所在的线程中先以IsAssigned确认订单未被改派再发送指令,发送成功后调用Confirm,未能令AGV执行订单时应调用Reject放回订单
+     * @param const Order& 订单
+     * @param AgvBase* 分配的AGV
+     */
+    typedef std::function<void(const Order&,AgvBase*)> Handler;
+
+    /*! @brief 描述批量分配基准测试结果的结构体 */
+    struct Benchmark
+    {
+        size_t m_agvs;                  /*!< AGV数量 */
+        size_t m_orders;                /*!< 订单数量 */
+        double m_tableTime;             /*!< 计算距离矩阵的耗时:单位(s) */
+        double m_assignTime;            /*!< 求解分配的耗时:单位(s) */
+        Cost_t m_total;                 /*!< 分配的总代价 */
+    };
+
+protected:
+    /*! @brief 描述参与分配AGV的结构体 */
+    struct Candidate
+    {
+        AgvBase* m_pAgv;                /*!< AGV对象,只用于在其所在的线程中发送指令 */
+        AgvBase::AId_t m_id;            /*!< AGV编号 */
+        RfidBase::Rfid_t m_rfid;        /*!< 当前地标卡 */
+        AgvBase::ABattery_t m_battery;  /*!< 电量 */
+        unsigned char m_ability;        /*!< 功能 */
+        float m_maxWeight;              /*!< 最大载重量 */
+        float m_maxSpeed;               /*!< 最大速度:单位(m/min) */
+    };
+
+protected:
+    const ContractionHierarchy& m_ch;                   /*!< 收缩层次索引 */
+    AgvIndex& m_index;                                  /*!< AGV索引 */
+    TimingWheel& m_wheel;                               /*!< 时间轮 */
+    std::chrono::milliseconds m_window;                 /*!< 批量分配的时间窗口 */
+    QThread m_thread;                                   /*!< 分配线程 */
+    std::mutex m_mutex;                                 /*!< 互斥锁 */
+    std::map<AgvBase::AId_t,AgvBase*> m_agvs;           /*!< 参与调度的AGV */
+    std::map<AgvBase::AId_t,Order> m_active;            /*!< 已分配订单未完成的AGV及其订单 */
+    std::set<AgvBase::AId_t> m_confirmed;               /*!< 已接受订单移动指令的AGV,只有这些AGV的订单可被抢占 */
+    std::map<OrderId_t,Order> m_orders;                 /*!< 待分配的订单 */
+    OrderQueue m_queue;                                 /*!< 待分配订单的优先队列,分配期间取出的订单不在其中 */
+    std::vector<size_t> m_pendingAbility;               /*!< 各功能待分配的订单数量 */
+    std::chrono::steady_clock::time_point m_epoch;      /*!< 键值的基准时间 */
+    std::chrono::milliseconds m_defaultDeadline;        /*!< 未指定截止时间的订单的时限 */
+    std::chrono::milliseconds m_priorityStep;           /*!< 每级优先级相当于提前的截止时间 */
+    double m_aging;                                     /*!< 每等待1秒相当于提前的截止时间:单位(s) */
+    unsigned char m_urgentPriority;                     /*!< 视为紧急的最低优先级,0为只按截止时间判断 */
+    std::chrono::milliseconds m_urgentSlack;            /*!< 距截止时间不超过此时长的订单视为紧急 */
+    Handler m_preemptHandler;                           /*!< 通知订单被抢占的处理函数 */
+    OrderId_t m_nextId;                                 /*!< 下一个订单编号 */
+    TimingWheel::TimerId m_timer;                       /*!< 批量分配的定时器 */
+    bool m_bStopped;                                    /*!< 已开始析构,不再安排分配 */
+    Handler m_handler;                                  /*!< 执行分配结果的处理函数 */
+    AgvBase::ABattery_t m_minBattery;                   /*!< 可接受订单的最低电量:单位(%) */
+    Cost_t m_batteryCost;                               /*!< 每缺少1%电量增加的代价,与距离同单位(mm) */
+    FleetSimulator* m_pSimulator;                       /*!< 模拟候选方案的模拟器,为nullptr时直接执行匈牙利算法的结果 */
+    size_t m_variants;                                  /*!< 每批生成的候选方案数量,不含匈牙利算法的结果 */
+    std::chrono::milliseconds m_budget;                 /*!< 每批模拟的时间预算 */
+    unsigned long long m_seed;                          /*!< 模拟的基础种子 */
+    unsigned long long m_batches;                       /*!< 已模拟的批次数量 */
+    FleetSimulator::Decision m_decision;                /*!< 最近一批的选择结果 */
+    ParkingPlanner* m_pParking;                         /*!< 记录订单需求的停车点规划器 */
+    MetricsRegistry::MetricId m_solveTime;              /*!< 分配耗时的指标 */
+    MetricsRegistry::MetricId m_assigned;               /*!< 已分配订单数量的指标 */
+    MetricsRegistry::MetricId m_pending;                /*!< 待分配订单数量的指标 */
+    MetricsRegistry::MetricId m_preempted;              /*!< 被抢占订单数量的指标 */
+    MetricsRegistry::MetricId m_rejected;               /*!< AGV未接受而放回的订单数量的指标 */
+    LifeGuard m_guard;                                  /*!< 投递到AGV线程的回调的存活标记 */
+
+public:
+    /*!
+     * @brief 添加参与调度的AGV
+     *
+     * AGV还需加入AGV索引才能被分配
+     * @param AgvBase* AGV对象
+     */
+    void AddAgv(AgvBase* _agv);
+
+    /*!
+     * @brief 移除参与调度的AGV,AGV尚未完成的订单以原来的键值放回队列
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void RemoveAgv(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 提交搬运订单
+     * @param const RfidBase::Rfid_t& 取货点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 卸货点RFID地标卡编号
+     * @param const float& 货物重量:单位(kg)
+     * @param const unsigned char& 需要的AGV功能,0为不限
+     * @param const unsigned char& 优先级,越大越优先
+     * @param const std::chrono::milliseconds& 自提交起的时限,0为默认时限
+     * @return OrderId_t 订单编号
+     */
+    OrderId_t Submit(const RfidBase::Rfid_t& _pickup,const RfidBase::Rfid_t& _drop,const float& _weight = 0.0f,const unsigned char& _ability = 0,
+                     const unsigned char& _priority = 0,const std::chrono::milliseconds& _deadline = std::chrono::milliseconds(0));
+
+    /*!
+     * @brief 取消尚未分配的订单
+     * @param const OrderId_t& 订单编号
+     * @return bool 订单尚未分配返回true,否则返回false
+     */
+    bool Cancel(const OrderId_t& _id);
+
+    /*!
+     * @brief 修改尚未分配的订单的优先级与截止时间
+     * @param const OrderId_t& 订单编号
+     * @param const unsigned char& 优先级
+     * @param const std::chrono::milliseconds& 自当前起的时限,0为不修改截止时间
+     * @return bool 订单尚未分配返回true,否则返回false
+     */
+    bool Reprioritize(const OrderId_t& _id,const unsigned char& _priority,const std::chrono::milliseconds& _deadline = std::chrono::milliseconds(0));
+
+    /*!
+     * @brief AGV完成订单,重新参与分配
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Complete(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief AGV未能执行分配的订单,订单以原来的键值放回队列,AGV重新参与分配
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const OrderId_t& 订单编号
+     * @return bool AGV仍在执行该订单返回true,期间已完成、被移除或被改派返回false
+     */
+    bool Reject(const AgvBase::AId_t& _id,const OrderId_t& _order);
+
+    /*!
+     * @brief AGV是否仍在执行该订单,处理函数发送指令前调用,避免向已被改派的AGV发送旧订单
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const OrderId_t& 订单编号
+     * @return bool AGV仍在执行该订单返回true,期间已完成、被移除或被改派返回false
+     */
+    bool IsAssigned(const AgvBase::AId_t& _id,const OrderId_t& _order);
+
+    /*!
+     * @brief AGV已接受订单的移动指令,此后订单才可被抢占
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const OrderId_t& 订单编号
+     * @return bool AGV仍在执行该订单返回true,期间已完成、被移除或被改派返回false
+     */
+    bool Confirm(const AgvBase::AId_t& _id,const OrderId_t& _order);
+
+    /*!
+     * @brief 设置执行分配结果的处理函数
+     * @param const Handler& 处理函数
+     */
+    void SetHandler(const Handler& _handler);
+
+    /*!
+     * @brief 设置电量相关的分配参数
+     * @param const AgvBase::ABattery_t& 可接受订单的最低电量:单位(%)
+     * @param const Cost_t& 每缺少1%电量增加的代价:单位(mm)
+     */
+    void SetBattery(const AgvBase::ABattery_t& _minBattery,const Cost_t& _cost);
+
+    /*!
+     * @brief 设置订单排序与抢占的参数
+     * @param const std::chrono::milliseconds& 每级优先级相当于提前的截止时间
+     * @param const double& 每等待1秒相当于提前的截止时间:单位(s),防止低优先级的订单一直等待
+     * @param const unsigned char& 视为紧急的最低优先级,0为只按截止时间判断
+     * @param const std::chrono::milliseconds& 距截止时间不超过此时长的订单视为紧急
+     */
+    void SetPriority(const std::chrono::milliseconds& _step,const double& _aging,const unsigned char& _urgentPriority,const std::chrono::milliseconds& _urgentSlack);
+
+    /*!
+     * @brief 设置通知订单被抢占的处理函数,在改派的处理函数之前调用
+     * @param const Handler& 处理函数,参数为被抢占的订单与AGV
+     */
+    void SetPreemptHandler(const Handler& _handler);
+
+    /*!
+     * @brief 设置分配前模拟候选方案的参数
+     *
+     * 第n批使用的种子为基础种子+n,与最近一批的选择结果一起可复现该批的模拟
+     * @param FleetSimulator* 模拟器,为nullptr时不模拟
+     * @param const size_t& 每批生成的候选方案数量
+     * @param const std::chrono::milliseconds& 每批模拟的时间预算
+     * @param const unsigned long long& 基础种子
+     */
+    void SetSimulation(FleetSimulator* _simulator,const size_t& _variants = 16,
+                       const std::chrono::milliseconds& _budget = std::chrono::milliseconds(50),const unsigned long long& _seed = 0);
+
+    /*!
+     * @brief 获取最近一批模拟的选择结果
+     * @return FleetSimulator::Decision 选择结果
+     */
+    FleetSimulator::Decision GetLastDecision();
+
+    /*!
+     * @brief 设置记录订单需求的停车点规划器,提交的订单计入其需求
+     * @param ParkingPlanner* 规划器,为nullptr时不记录
+     */
+    void SetParking(ParkingPlanner* _planner);
+
+    /*!
+     * @brief 获取待分配的订单数量
+     * @return size_t 订单数量
+     */
+    size_t GetPendingCount();
+
+    /*!
+     * @brief 求代价最小的分配(匈牙利算法)
+     *
+     * 复杂度为O(行数^2×列数),行数需不大于列数
+     * @param const std::vector<Cost_t>& 代价矩阵,按行排列
+     * @param const size_t& 行数
+     * @param const size_t& 列数
+     * @param std::vector<int>& 各行分配的列
+     * @return Cost_t 总代价
+     */
+    static Cost_t Assign(const std::vector<Cost_t>& _cost,const size_t& _rows,const size_t& _cols,std::vector<int>& _assign);
+
+    /*!
+     * @brief 在路线图上随机放置AGV与取货点,测量一批分配中距离矩阵与匈牙利算法的耗时
+     * @param const ContractionHierarchy& 已预处理的收缩层次索引
+     * @param const RfidMap& 索引对应的路线图
+     * @param const size_t& AGV数量
+     * @param const size_t& 订单数量
+     * @param const unsigned long long& 随机数种子
+     * @return Benchmark 测试结果
+     */
+    static Benchmark Measure(const ContractionHierarchy& _ch,const RfidMap& _map,const size_t& _agvs = 200,const size_t& _orders = 200,
+                             const unsigned long long& _seed = 0);
+
+protected:
+    /*!
+     * @brief 在窗口结束时安排一次分配,调用方需持有锁
+     */
+    void Schedule();
+
+    /*!
+     * @brief 计算AGV执行订单的代价
+     * @param const Candidate& AGV
+     * @param const Order& 订单
+     * @param const ContractionHierarchy::Weight_t& AGV至取货点的距离
+     * @return Cost_t 代价,不可行时返回INFEASIBLE
+     */
+    Cost_t Evaluate(const Candidate& _candidate,const Order& _order,const ContractionHierarchy::Weight_t& _distance) const;
+
+    /*!
+     * @brief 由AGV索引的状态快照生成参与分配的AGV
+     * @param const AgvIndex::Snapshot& 快照
+     * @return Candidate 参与分配的AGV
+     */
+    static Candidate ToCandidate(const AgvIndex::Snapshot& _snapshot);
+
+    /*!
+     * @brief 计算订单在队列中的键值,调用方需持有锁
+     * @param const Order& 订单
+     * @return OrderQueue::Key_t 键值
+     */
+    OrderQueue::Key_t GetKey(const Order& _order) const;
+
+    /*!
+     * @brief 订单是否紧急,调用方需持有锁
+     * @param const Order& 订单
+     * @param const std::chrono::steady_clock::time_point& 当前时间
+     * @return bool 紧急返回true
+     */
+    bool IsUrgent(const Order& _order,const std::chrono::steady_clock::time_point& _now) const;
+
+    /*!
+     * @brief 从待分配的订单与队列中移除订单,调用方需持有锁
+     * @param const OrderId_t& 订单编号
+     */
+    void Take(const OrderId_t& _id);
+
+    /*!
+     * @brief 将已分配的订单放回待分配的订单与队列,调用方需持有锁
+     * @param const Order& 订单
+     */
+    void Restore(const Order& _order);
+
+    /*!
+     * @brief 为本批取出后仍未分配的紧急订单抢占AGV,并将其余未分配的订单放回队列
+     * @param const std::vector<Order>& 本批取出的订单
+     */
+    void Settle(const std::vector<Order>& _taken);
+
+    /*!
+     * @brief 默认的处理函数,在AGV所在的线程中发送订单的移动指令
+     * @param const Order& 订单
+     * @param AgvBase* 分配的AGV
+     */
+    void Send(const Order& _order,AgvBase* _agv);
+
+    /*!
+     * @brief 为紧急订单抢占尚未取货的AGV
+     * @param std::vector<Order>& 紧急订单
+     */
+    void Preempt(std::vector<Order>& _urgent);
+
+    /*!
+     * @brief 生成候选方案并模拟,选择结果最好的方案
+     * @param FleetSimulator* 模拟器
+     * @param const std::vector<Candidate>& 参与分配的AGV
+     * @param const std::vector<Order>& 订单
+     * @param const std::vector<AgvIndex::Snapshot>& 不参与分配的AGV的快照
+     * @param const std::vector<Cost_t>& 代价矩阵
+     * @param const bool& 代价矩阵是否以订单为行
+     * @param const std::vector<int>& 匈牙利算法的结果,各订单分配的AGV下标,-1为未分配
+     * @param const size_t& 候选方案数量
+     * @param const std::chrono::milliseconds& 时间预算
+     * @param const unsigned long long& 本批的种子
+     * @return std::vector<int> 选中的方案
+     */
+    std::vector<int> Simulate(FleetSimulator* _simulator,const std::vector<Candidate>& _candidates,const std::vector<Order>& _orders,
+                              const std::vector<AgvIndex::Snapshot>& _obstacles,const std::vector<Cost_t>& _cost,const bool& _byOrder,
+                              const std::vector<int>& _plan,const size_t& _variants,const std::chrono::milliseconds& _budget,
+                              const unsigned long long& _seed);
+
+protected slots:
+    /*!
+     * @brief 分配当前待分配的订单
+     */
+    void Batch();
+};
+
+#endif // DISPATCHER_H
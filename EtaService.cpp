@@ -0,0 +1,278 @@
+#include "EtaService.h"
+#include "AgvIndex.h"
+
+#include <algorithm>
+
+const EtaService::Seconds_t EtaService::UNREACHABLE = 1e9;
+const float EtaService::ALPHA = 0.2f;
+const float EtaService::MAX_RATIO = 5.0f;
+const float EtaService::DEFAULT_SPEED = 30.0f;
+
+EtaService::EtaService(const RfidMap &_map)
+    : m_map(_map),m_times(AgvIndex::ABILITY_COUNT * _map.GetEdgeCount()),m_speeds(AgvIndex::ABILITY_COUNT)
+{
+    for(std::vector<std::atomic<float> >::iterator it = m_times.begin(); it != m_times.end(); ++it)
+    {
+        it->store(0.0f,std::memory_order_relaxed);
+    }
+
+    for(std::vector<std::atomic<float> >::iterator it = m_speeds.begin(); it != m_speeds.end(); ++it)
+    {
+        it->store(DEFAULT_SPEED,std::memory_order_relaxed);
+    }
+
+    m_samples = MetricsRegistry::Instance().AddCounter("agv_eta_samples_total","Edge traversal times learned from landmark changes");
+}
+
+EtaService::~EtaService()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    for(std::map<AgvBase::AId_t,Track>::iterator it = m_tracks.begin(); it != m_tracks.end(); ++it)
+    {
+        QObject::disconnect(it->second.m_rfidChanged);
+        QObject::disconnect(it->second.m_update);
+    }
+}
+
+void EtaService::Watch(AgvBase *_agv)
+{
+    if(_agv == nullptr)
+    {
+        return;
+    }
+
+    AgvBase::AId_t _id = _agv->GetID();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_tracks.find(_id) != m_tracks.end())
+    {
+        // 已在跟踪
+        return;
+    }
+
+    Track& _track = m_tracks[_id];
+    _track.m_pAgv = _agv;
+    _track.m_ability = _agv->GetAbility() < AgvIndex::ABILITY_COUNT ? _agv->GetAbility() : 0;
+    _track.m_rfid = _agv->GetCurRfid();
+    _track.m_departed = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration::zero());
+
+    if(_agv->GetMaxSpeed() > 0.0f)
+    {
+        m_speeds[_track.m_ability].store(_agv->GetMaxSpeed(),std::memory_order_relaxed);
+    }
+
+    _track.m_rfidChanged = QObject::connect(_agv,&AgvBase::RfidChanged,[this,_id]{ Arrived(_id); });
+    _track.m_update = QObject::connect(_agv,&AgvBase::Update,[this,_id]{ Departed(_id); });
+
+    return;
+}
+
+void EtaService::Unwatch(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Track>::iterator it = m_tracks.find(_id);
+
+    if(it == m_tracks.end())
+    {
+        return;
+    }
+
+    QObject::disconnect(it->second.m_rfidChanged);
+    QObject::disconnect(it->second.m_update);
+
+    m_tracks.erase(it);
+
+    return;
+}
+
+void EtaService::Observe(const unsigned char &_ability, const RfidMap::Edge_t &_edge, const EtaService::Seconds_t &_time)
+{
+    if(_ability >= AgvIndex::ABILITY_COUNT || _edge >= m_map.GetEdgeCount() || _time <= 0.0)
+    {
+        return;
+    }
+
+    std::atomic<float>& _value = m_times[_ability * m_map.GetEdgeCount() + _edge];
+
+    float _old = _value.load(std::memory_order_relaxed);
+
+    while(true)
+    {
+        float _current = _old > 0.0f ? _old : static_cast<float>(Prior(_ability,_edge));
+
+        // 限制单次观测的影响,避免一次长时间停车使估计失真
+        float _sample = std::min(static_cast<float>(_time),_current * MAX_RATIO);
+
+        float _new = _old > 0.0f ? _old + ALPHA * (_sample - _old) : _sample;
+
+        if(_value.compare_exchange_weak(_old,_new,std::memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    MetricsRegistry::Instance().Add(m_samples);
+
+    return;
+}
+
+EtaService::Seconds_t EtaService::GetTravelTime(const unsigned char &_ability, const RfidMap::Edge_t &_edge) const
+{
+    if(_ability >= AgvIndex::ABILITY_COUNT || _edge >= m_map.GetEdgeCount())
+    {
+        return UNREACHABLE;
+    }
+
+    float _time = m_times[_ability * m_map.GetEdgeCount() + _edge].load(std::memory_order_relaxed);
+
+    if(_time > 0.0f)
+    {
+        return _time;
+    }
+
+    return Prior(_ability,_edge);
+}
+
+EtaService::Seconds_t EtaService::Estimate(const unsigned char &_ability, const std::vector<RfidBase::Rfid_t> &_route) const
+{
+    Seconds_t _total = 0.0;
+
+    for(size_t i = 1; i < _route.size(); ++i)
+    {
+        RfidMap::Node_t _from = m_map.GetNode(_route[i - 1]);
+        RfidMap::Node_t _to = m_map.GetNode(_route[i]);
+
+        if(_from == RfidMap::NIL || _to == RfidMap::NIL)
+        {
+            return UNREACHABLE;
+        }
+
+        RfidMap::Edge_t _edge = m_map.FindEdge(_from,_to);
+
+        if(_edge == RfidMap::NIL)
+        {
+            return UNREACHABLE;
+        }
+
+        _total += GetTravelTime(_ability,_edge);
+    }
+
+    return _total;
+}
+
+EtaService::Seconds_t EtaService::Estimate(const unsigned char &_ability, const std::vector<RfidMap::Edge_t> &_edges) const
+{
+    Seconds_t _total = 0.0;
+
+    for(std::vector<RfidMap::Edge_t>::const_iterator it = _edges.begin(); it != _edges.end(); ++it)
+    {
+        _total += GetTravelTime(_ability,*it);
+    }
+
+    return _total;
+}
+
+void EtaService::Arrived(const AgvBase::AId_t &_id)
+{
+    unsigned char _ability = 0;
+    RfidMap::Edge_t _edge = RfidMap::NIL;
+    Seconds_t _time = 0.0;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,Track>::iterator it = m_tracks.find(_id);
+
+        if(it == m_tracks.end())
+        {
+            return;
+        }
+
+        Track& _track = it->second;
+
+        std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now();
+        RfidBase::Rfid_t _rfid = _track.m_pAgv->GetCurRfid();
+
+        if(_track.m_departed.time_since_epoch().count() != 0)
+        {
+            RfidMap::Node_t _from = m_map.GetNode(_track.m_rfid);
+            RfidMap::Node_t _to = m_map.GetNode(_rfid);
+
+            if(_from != RfidMap::NIL && _to != RfidMap::NIL)
+            {
+                // 跳过地标卡时两者之间没有路段,不作观测
+                _edge = m_map.FindEdge(_from,_to);
+            }
+
+            _ability = _track.m_ability;
+            _time = std::chrono::duration<double>(_now - _track.m_departed).count();
+        }
+
+        _track.m_rfid = _rfid;
+
+        // 状态在地标卡之前更新,仍在行驶则以到达时间作为下一路段的出发时间
+        _track.m_departed = IsMoving(_track.m_pAgv->GetStatus()) ? _now :
+                                                                   std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration::zero());
+    }
+
+    if(_edge != RfidMap::NIL)
+    {
+        Observe(_ability,_edge,_time);
+    }
+
+    return;
+}
+
+void EtaService::Departed(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Track>::iterator it = m_tracks.find(_id);
+
+    if(it == m_tracks.end() || it->second.m_departed.time_since_epoch().count() != 0)
+    {
+        return;
+    }
+
+    if(IsMoving(it->second.m_pAgv->GetStatus()))
+    {
+        it->second.m_departed = std::chrono::steady_clock::now();
+    }
+
+    return;
+}
+
+EtaService::Seconds_t EtaService::Prior(const unsigned char &_ability, const RfidMap::Edge_t &_edge) const
+{
+    float _speed = m_speeds[_ability].load(std::memory_order_relaxed);
+
+    float _limit = m_map.GetMaxSpeed(_edge);
+
+    if(_limit > 0.0f)
+    {
+        _speed = std::min(_speed,_limit);
+    }
+
+    // 距离单位(mm),速度单位(m/min)
+    return m_map.GetWeight(_edge) * 0.06 / _speed;
+}
+
+bool EtaService::IsMoving(const AgvBase::AStatus_t &_status)
+{
+    switch(_status)
+    {
+    case AgvBase::Sta_Run:
+    case AgvBase::Sta_Find:
+    case AgvBase::Sta_ObsDonw:
+    case AgvBase::Sta_SpeedUp:
+    case AgvBase::Sta_SpeedDown:
+        return true;
+    default:
+        break;
+    }
+
+    return false;
+}
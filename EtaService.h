@@ -0,0 +1,139 @@
+/*!
+ * @file EtaService
+ * @brief 描述在线学习路段通行时间并预测到达时间功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef ETASERVICE_H
+#define ETASERVICE_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "AgvBase.h"
+#include "RfidMap.h"
+
+/*!
+ * @class EtaService
+ * @brief 按AGV功能学习各路段通行时间的到达时间预测服务
+ *
+ * AGV的当前地标卡改变时,以离开上一个地标卡至到达当前地标卡的时间作为该路段的一次观测,
+ * 按指数加权更新该AGV功能对应的通行时间;在地标卡上停车等待(含交通管制停止)的时间不计入
+ * 通行时间储存在与路线图路段下标对齐的连续数组中,每项为原子变量,查询不加锁
+ * 尚未观测过的路段按距离与路段最大速度、AGV最大速度中较小者估算
+ */
+class EtaService
+{
+public:
+    /*!
+     * @param const RfidMap& 路线图,服务存在期间不可改变
+     */
+    explicit EtaService(const RfidMap& _map);
+    ~EtaService();
+
+public:
+    typedef double Seconds_t;
+
+    static const Seconds_t UNREACHABLE;     /*!< 路线中存在不相连的地标卡时返回的时间 */
+
+protected:
+    /*! @brief 描述被跟踪AGV的结构体 */
+    struct Track
+    {
+        AgvBase* m_pAgv;                                /*!< AGV对象 */
+        unsigned char m_ability;                        /*!< 功能 */
+        RfidBase::Rfid_t m_rfid;                        /*!< 上一个地标卡 */
+        std::chrono::steady_clock::time_point m_departed;   /*!< 离开上一个地标卡的时间,未出发时为0 */
+        QMetaObject::Connection m_rfidChanged;          /*!< RfidChanged信号的连接 */
+        QMetaObject::Connection m_update;               /*!< Update信号的连接 */
+    };
+
+protected:
+    static const float ALPHA;                       /*!< 指数加权的系数 */
+    static const float MAX_RATIO;                   /*!< 单次观测相对当前估计的最大倍数 */
+    static const float DEFAULT_SPEED;               /*!< 尚未设置速度的功能使用的速度:单位(m/min) */
+
+    const RfidMap& m_map;                           /*!< 路线图 */
+    std::vector<std::atomic<float> > m_times;       /*!< 各功能各路段学习到的通行时间:单位(s),0为尚未观测 */
+    std::vector<std::atomic<float> > m_speeds;      /*!< 各功能的最大速度:单位(m/min) */
+    std::mutex m_mutex;                             /*!< 互斥锁 */
+    std::map<AgvBase::AId_t,Track> m_tracks;        /*!< 被跟踪的AGV */
+    MetricsRegistry::MetricId m_samples;            /*!< 观测次数的指标 */
+
+public:
+    /*!
+     * @brief 开始从AGV的地标卡变化学习通行时间
+     * @param AgvBase* AGV对象
+     */
+    void Watch(AgvBase* _agv);
+
+    /*!
+     * @brief 停止跟踪AGV
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Unwatch(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 记录一次路段通行时间的观测
+     * @param const unsigned char& AGV功能
+     * @param const RfidMap::Edge_t& 路段下标
+     * @param const Seconds_t& 通行时间:单位(s)
+     */
+    void Observe(const unsigned char& _ability,const RfidMap::Edge_t& _edge,const Seconds_t& _time);
+
+    /*!
+     * @brief 获取路段的通行时间
+     * @param const unsigned char& AGV功能
+     * @param const RfidMap::Edge_t& 路段下标
+     * @return Seconds_t 通行时间:单位(s)
+     */
+    Seconds_t GetTravelTime(const unsigned char& _ability,const RfidMap::Edge_t& _edge) const;
+
+    /*!
+     * @brief 预测沿路线行驶的时间
+     * @param const unsigned char& AGV功能
+     * @param const std::vector<RfidBase::Rfid_t>& 路线,依次经过的RFID地标卡
+     * @return Seconds_t 行驶时间:单位(s),相邻地标卡之间没有路段时返回UNREACHABLE
+     */
+    Seconds_t Estimate(const unsigned char& _ability,const std::vector<RfidBase::Rfid_t>& _route) const;
+
+    /*!
+     * @brief 预测沿路段行驶的时间
+     * @param const unsigned char& AGV功能
+     * @param const std::vector<RfidMap::Edge_t>& 依次经过的路段下标
+     * @return Seconds_t 行驶时间:单位(s)
+     */
+    Seconds_t Estimate(const unsigned char& _ability,const std::vector<RfidMap::Edge_t>& _edges) const;
+
+    /*!
+     * @brief 按距离与速度估算路段的通行时间,即未拥堵时的通行时间
+     * @param const unsigned char& AGV功能
+     * @param const RfidMap::Edge_t& 路段下标
+     * @return Seconds_t 通行时间:单位(s)
+     */
+    Seconds_t Prior(const unsigned char& _ability,const RfidMap::Edge_t& _edge) const;
+
+protected:
+    /*!
+     * @brief AGV当前地标卡改变,在AGV所在的线程中调用
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Arrived(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief AGV更新,记录出发时间,在AGV所在的线程中调用
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Departed(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief AGV状态是否为行驶中
+     * @param const AgvBase::AStatus_t& 状态
+     * @return bool 行驶中返回true
+     */
+    static bool IsMoving(const AgvBase::AStatus_t& _status);
+};
+
+#endif // ETASERVICE_H
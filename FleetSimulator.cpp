@@ -0,0 +1,530 @@
+#include "FleetSimulator.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+#include <thread>
+
+FleetSimulator::FleetSimulator(const RfidMap &_map, const ContractionHierarchy &_ch)
+    : m_map(_map),m_ch(_ch)
+{
+    m_parameters.m_horizon = 600.0;
+    m_parameters.m_actionTime = 10.0;
+    m_parameters.m_lockHold = 10.0;
+    m_parameters.m_jitter = 0.1;
+    m_parameters.m_threads = 0;
+    m_pEta = nullptr;
+    m_pRegistry = nullptr;
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+
+    m_runs = _registry.AddCounter("agv_whatif_plans_total","Candidate plans simulated");
+    m_time = _registry.AddHistogram("agv_whatif_choose_seconds","Time spent simulating and choosing among candidate plans",
+                                    {0.001,0.005,0.01,0.02,0.05,0.1,0.2,0.5});
+}
+
+void FleetSimulator::SetParameters(const FleetSimulator::Parameters &_parameters)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_parameters = _parameters;
+
+    return;
+}
+
+FleetSimulator::Parameters FleetSimulator::GetParameters()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_parameters;
+}
+
+void FleetSimulator::SetEta(EtaService *_eta)
+{
+    m_pEta.store(_eta);
+
+    return;
+}
+
+void FleetSimulator::SetRegistry(RfidRegistry *_registry)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_pRegistry = _registry;
+
+    return;
+}
+
+FleetSimulator::Snapshot FleetSimulator::Capture(const std::vector<FleetSimulator::SimAgv> &_agvs)
+{
+    Snapshot _snapshot;
+    _snapshot.m_agvs = _agvs;
+
+    std::vector<bool> _inside(RfidRegistry::RFID_COUNT,false);     /*!< 快照中的AGV编号 */
+
+    for(std::vector<SimAgv>::const_iterator it = _agvs.begin(); it != _agvs.end(); ++it)
+    {
+        _inside[it->m_id] = true;
+    }
+
+    RfidRegistry* _registry = nullptr;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        _registry = m_pRegistry;
+    }
+
+    EtaService* _eta = m_pEta.load();
+
+    if(_eta)
+    {
+        // 通行时间随观测不断更新,复制一份使同一快照的各方案使用相同的通行时间
+        for(std::vector<SimAgv>::const_iterator it = _agvs.begin(); it != _agvs.end(); ++it)
+        {
+            if(_snapshot.m_times.find(it->m_ability) != _snapshot.m_times.end())
+            {
+                continue;
+            }
+
+            std::vector<Seconds_t>& _times = _snapshot.m_times[it->m_ability];
+            _times.resize(m_map.GetEdgeCount());
+
+            for(RfidMap::Edge_t _edge = 0; _edge < _times.size(); ++_edge)
+            {
+                _times[_edge] = _eta->GetTravelTime(it->m_ability,_edge);
+            }
+        }
+    }
+
+    if(_registry)
+    {
+        for(size_t i = 0; i < RfidRegistry::RFID_COUNT; ++i)
+        {
+            AgvBase::AId_t _locker = _registry->GetLocker(static_cast<RfidBase::Rfid_t>(i));
+
+            if(_locker != RfidRegistry::NOBODY && _inside[_locker] == false)
+            {
+                _snapshot.m_locked.push_back(static_cast<RfidBase::Rfid_t>(i));
+            }
+        }
+    }
+
+    return _snapshot;
+}
+
+FleetSimulator::Result FleetSimulator::Simulate(const FleetSimulator::Snapshot &_snapshot, const std::vector<FleetSimulator::SimOrder> &_orders, const FleetSimulator::Plan &_plan, const unsigned long long &_seed)
+{
+    MetricsRegistry::Instance().Add(m_runs);
+
+    return Run(GetParameters(),_snapshot,_orders,_plan,_seed);
+}
+
+FleetSimulator::Decision FleetSimulator::Choose(const FleetSimulator::Snapshot &_snapshot, const std::vector<FleetSimulator::SimOrder> &_orders, const std::vector<FleetSimulator::Plan> &_plans, const unsigned long long &_seed, const std::chrono::milliseconds &_budget)
+{
+    Decision _decision;
+    _decision.m_plan = 0;
+    _decision.m_evaluated = 0;
+    _decision.m_seed = _seed;
+    _decision.m_result.m_completed = 0;
+    _decision.m_result.m_makespan = 0.0;
+    _decision.m_result.m_wait = 0.0;
+
+    if(_plans.empty())
+    {
+        return _decision;
+    }
+
+    std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point _deadline = _start + _budget;
+
+    Parameters _parameters = GetParameters();
+
+    size_t _threads = _parameters.m_threads == 0 ? std::thread::hardware_concurrency() : _parameters.m_threads;
+    _threads = std::max<size_t>(1,std::min(_threads,_plans.size())) - 1;
+
+    std::vector<Result> _results(_plans.size());
+    std::vector<char> _done(_plans.size(),0);
+    std::atomic<size_t> _next(1);
+
+    // 每个线程按下标顺序领取方案,预算用尽后不再领取
+    std::function<void()> _worker = [&]{
+        while(std::chrono::steady_clock::now() < _deadline)
+        {
+            size_t i = _next.fetch_add(1);
+
+            if(i >= _plans.size())
+            {
+                break;
+            }
+
+            _results[i] = Run(_parameters,_snapshot,_orders,_plans[i],PlanSeed(_seed,i));
+            _done[i] = 1;
+        }
+    };
+
+    std::vector<std::thread> _pool;
+
+    for(size_t i = 0; i < _threads; ++i)
+    {
+        _pool.push_back(std::thread(_worker));
+    }
+
+    // 第0个方案在调用线程中模拟,保证至少有一个结果
+    _results[0] = Run(_parameters,_snapshot,_orders,_plans[0],PlanSeed(_seed,0));
+    _done[0] = 1;
+
+    _worker();
+
+    for(std::vector<std::thread>::iterator it = _pool.begin(); it != _pool.end(); ++it)
+    {
+        it->join();
+    }
+
+    while(_decision.m_evaluated < _plans.size() && _done[_decision.m_evaluated])
+    {
+        ++_decision.m_evaluated;
+    }
+
+    _decision.m_result = _results[0];
+
+    for(size_t i = 1; i < _decision.m_evaluated; ++i)
+    {
+        if(IsBetter(_results[i],_decision.m_result))
+        {
+            _decision.m_plan = i;
+            _decision.m_result = _results[i];
+        }
+    }
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+    _registry.Add(m_runs,_decision.m_evaluated);
+    _registry.Observe(m_time,std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count());
+
+    return _decision;
+}
+
+bool FleetSimulator::IsBetter(const FleetSimulator::Result &_a, const FleetSimulator::Result &_b)
+{
+    if(_a.m_completed != _b.m_completed)
+    {
+        return _a.m_completed > _b.m_completed;
+    }
+
+    if(_a.m_makespan != _b.m_makespan)
+    {
+        return _a.m_makespan < _b.m_makespan;
+    }
+
+    return _a.m_wait < _b.m_wait;
+}
+
+FleetSimulator::Result FleetSimulator::Run(const FleetSimulator::Parameters &_parameters, const FleetSimulator::Snapshot &_snapshot, const std::vector<FleetSimulator::SimOrder> &_orders, const FleetSimulator::Plan &_plan, const unsigned long long &_seed) const
+{
+    /*! @brief 描述AGV执行阶段的枚举 */
+    enum Phase
+    {
+        Phase_Idle,         /*!< 等待下一个订单 */
+        Phase_ToPickup,     /*!< 前往取货点 */
+        Phase_Load,         /*!< 取货 */
+        Phase_ToDrop,       /*!< 前往卸货点 */
+        Phase_Unload,       /*!< 卸货 */
+    };
+
+    /*! @brief 描述模拟中AGV的结构体 */
+    struct Agent
+    {
+        std::vector<size_t> m_orders;               /*!< 分配的订单 */
+        size_t m_next;                              /*!< 下一个订单 */
+        Phase m_phase;                              /*!< 阶段 */
+        std::vector<RfidMap::Node_t> m_route;       /*!< 当前路线 */
+        size_t m_pos;                               /*!< 在路线中的位置 */
+        bool m_bMoving;                             /*!< 是否正在驶向路线中的下一个地标卡 */
+        Seconds_t m_waitSince;                      /*!< 开始等待的时间,未等待时小于0 */
+    };
+
+    /*! @brief 描述事件的结构体 */
+    struct Event
+    {
+        Seconds_t m_time;
+        unsigned long long m_seq;
+        size_t m_agent;
+
+        bool operator<(const Event& _event) const
+        {
+            // 时间早、序号小的事件先出队
+            if(m_time != _event.m_time)
+            {
+                return m_time > _event.m_time;
+            }
+
+            return m_seq > _event.m_seq;
+        }
+    };
+
+    static const int FREE = -1;         /*!< 地标卡空闲 */
+    static const int STATIC = -2;       /*!< 地标卡被障碍一直占用 */
+
+    Result _result;
+    _result.m_completed = 0;
+    _result.m_makespan = 0.0;
+    _result.m_wait = 0.0;
+
+    std::mt19937_64 _random(_seed);
+    std::uniform_real_distribution<double> _noise(1.0 - _parameters.m_jitter,1.0 + _parameters.m_jitter);
+
+    std::vector<int> _owner(m_map.GetNodeCount(),FREE);
+    std::vector<Seconds_t> _lockUntil(m_map.GetNodeCount(),0.0);
+    std::vector<std::vector<size_t> > _waiters(m_map.GetNodeCount());
+
+    for(std::vector<RfidBase::Rfid_t>::const_iterator it = _snapshot.m_locked.begin(); it != _snapshot.m_locked.end(); ++it)
+    {
+        RfidMap::Node_t _node = m_map.GetNode(*it);
+
+        if(_node != RfidMap::NIL)
+        {
+            _lockUntil[_node] = _parameters.m_lockHold;
+        }
+    }
+
+    std::vector<Agent> _agents(_snapshot.m_agvs.size());
+
+    size_t _assigned = 0;
+
+    for(size_t o = 0; o < _plan.size() && o < _orders.size(); ++o)
+    {
+        if(_plan[o] >= 0 && static_cast<size_t>(_plan[o]) < _agents.size() && _snapshot.m_agvs[_plan[o]].m_bStatic == false)
+        {
+            _agents[_plan[o]].m_orders.push_back(o);
+            ++_assigned;
+        }
+    }
+
+    std::priority_queue<Event> _events;
+    unsigned long long _seq = 0;
+
+    for(size_t a = 0; a < _agents.size(); ++a)
+    {
+        Agent& _agent = _agents[a];
+        _agent.m_next = 0;
+        _agent.m_phase = Phase_Idle;
+        _agent.m_pos = 0;
+        _agent.m_bMoving = false;
+        _agent.m_waitSince = -1.0;
+
+        RfidMap::Node_t _node = m_map.GetNode(_snapshot.m_agvs[a].m_rfid);
+
+        if(_node != RfidMap::NIL && _owner[_node] == FREE)
+        {
+            _owner[_node] = _snapshot.m_agvs[a].m_bStatic ? STATIC : static_cast<int>(a);
+        }
+
+        _agent.m_route.push_back(_node);
+
+        if(_agent.m_orders.empty() == false)
+        {
+            Event _event = {0.0,_seq++,a};
+            _events.push(_event);
+        }
+    }
+
+    std::vector<RfidBase::Rfid_t> _rfids;
+
+    while(_events.empty() == false)
+    {
+        Event _event = _events.top();
+        _events.pop();
+
+        if(_event.m_time > _parameters.m_horizon)
+        {
+            break;
+        }
+
+        Seconds_t _now = _event.m_time;
+        size_t a = _event.m_agent;
+        Agent& _agent = _agents[a];
+
+        if(_agent.m_bMoving)
+        {
+            // 到达下一个地标卡,释放上一个地标卡并唤醒等待者
+            _agent.m_bMoving = false;
+
+            RfidMap::Node_t _left = _agent.m_route[_agent.m_pos++];
+
+            if(_owner[_left] == static_cast<int>(a))
+            {
+                _owner[_left] = FREE;
+
+                for(std::vector<size_t>::iterator it = _waiters[_left].begin(); it != _waiters[_left].end(); ++it)
+                {
+                    Event _wake = {_now,_seq++,*it};
+                    _events.push(_wake);
+                }
+
+                _waiters[_left].clear();
+            }
+        }
+
+        while(true)
+        {
+            if(_agent.m_pos + 1 < _agent.m_route.size())
+            {
+                RfidMap::Node_t _from = _agent.m_route[_agent.m_pos];
+                RfidMap::Node_t _to = _agent.m_route[_agent.m_pos + 1];
+
+                if(_owner[_to] != FREE)
+                {
+                    if(_agent.m_waitSince < 0.0)
+                    {
+                        _agent.m_waitSince = _now;
+                    }
+
+                    _waiters[_to].push_back(a);
+                    break;
+                }
+
+                if(_lockUntil[_to] > _now)
+                {
+                    if(_agent.m_waitSince < 0.0)
+                    {
+                        _agent.m_waitSince = _now;
+                    }
+
+                    Event _retry = {_lockUntil[_to],_seq++,a};
+                    _events.push(_retry);
+                    break;
+                }
+
+                if(_agent.m_waitSince >= 0.0)
+                {
+                    _result.m_wait += _now - _agent.m_waitSince;
+                    _agent.m_waitSince = -1.0;
+                }
+
+                _owner[_to] = static_cast<int>(a);
+                _agent.m_bMoving = true;
+
+                Event _arrive = {_now + TravelTime(_snapshot,_snapshot.m_agvs[a],_from,_to) * _noise(_random),_seq++,a};
+                _events.push(_arrive);
+                break;
+            }
+
+            if(_agent.m_phase == Phase_ToPickup || _agent.m_phase == Phase_ToDrop)
+            {
+                // 到达取货点或卸货点,停留一个动作时间
+                _agent.m_phase = _agent.m_phase == Phase_ToPickup ? Phase_Load : Phase_Unload;
+
+                Event _act = {_now + _parameters.m_actionTime,_seq++,a};
+                _events.push(_act);
+                break;
+            }
+
+            if(_agent.m_phase == Phase_Unload)
+            {
+                ++_result.m_completed;
+                _result.m_makespan = std::max(_result.m_makespan,_now);
+            }
+
+            const RfidMap::Node_t _here = _agent.m_route[_agent.m_pos];
+            RfidBase::Rfid_t _target = 0;
+
+            if(_agent.m_phase == Phase_Load)
+            {
+                _target = _orders[_agent.m_orders[_agent.m_next]].m_drop;
+                _agent.m_phase = Phase_ToDrop;
+            }
+            else if(_agent.m_next < _agent.m_orders.size())
+            {
+                if(_agent.m_phase == Phase_Unload)
+                {
+                    ++_agent.m_next;
+                }
+
+                if(_agent.m_next >= _agent.m_orders.size())
+                {
+                    _agent.m_phase = Phase_Idle;
+                    break;
+                }
+
+                _target = _orders[_agent.m_orders[_agent.m_next]].m_pickup;
+                _agent.m_phase = Phase_ToPickup;
+            }
+            else
+            {
+                _agent.m_phase = Phase_Idle;
+                break;
+            }
+
+            _agent.m_route.clear();
+            _agent.m_route.push_back(_here);
+            _agent.m_pos = 0;
+
+            if(_here != RfidMap::NIL && m_ch.Route(m_map.GetRfid(_here),_target,_rfids))
+            {
+                for(size_t i = 1; i < _rfids.size(); ++i)
+                {
+                    _agent.m_route.push_back(m_map.GetNode(_rfids[i]));
+                }
+            }
+            else
+            {
+                // 不可达的订单视为未完成,继续下一个订单
+                _agent.m_phase = Phase_Idle;
+                ++_agent.m_next;
+            }
+        }
+    }
+
+    for(std::vector<Agent>::iterator it = _agents.begin(); it != _agents.end(); ++it)
+    {
+        if(it->m_waitSince >= 0.0)
+        {
+            _result.m_wait += _parameters.m_horizon - it->m_waitSince;
+        }
+    }
+
+    if(_result.m_completed < _assigned)
+    {
+        _result.m_makespan = _parameters.m_horizon;
+    }
+
+    return _result;
+}
+
+FleetSimulator::Seconds_t FleetSimulator::TravelTime(const FleetSimulator::Snapshot &_snapshot, const FleetSimulator::SimAgv &_agv, const RfidMap::Node_t &_from, const RfidMap::Node_t &_to) const
+{
+    RfidMap::Edge_t _edge = m_map.FindEdge(_from,_to);
+
+    if(_edge == RfidMap::NIL)
+    {
+        return 0.0;
+    }
+
+    std::map<unsigned char,std::vector<Seconds_t> >::const_iterator it = _snapshot.m_times.find(_agv.m_ability);
+
+    if(it != _snapshot.m_times.end() && _edge < it->second.size())
+    {
+        return it->second[_edge];
+    }
+
+    float _speed = _agv.m_speed > 0.0f ? _agv.m_speed : 30.0f;
+
+    if(m_map.GetMaxSpeed(_edge) > 0.0f)
+    {
+        _speed = std::min(_speed,m_map.GetMaxSpeed(_edge));
+    }
+
+    // 距离单位(mm),速度单位(m/min)
+    return m_map.GetWeight(_edge) * 0.06 / _speed;
+}
+
+unsigned long long FleetSimulator::PlanSeed(const unsigned long long &_seed, const size_t &_plan)
+{
+    // splitmix64,使相邻方案的种子互不相关
+    unsigned long long _z = _seed + 0x9E3779B97F4A7C15ULL * (_plan + 1);
+    _z = (_z ^ (_z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    _z = (_z ^ (_z >> 27)) * 0x94D049BB133111EBULL;
+
+    return _z ^ (_z >> 31);
+}
@@ -0,0 +1,206 @@
+/*!
+ * @file FleetSimulator
+ * @brief 描述并行模拟候选分配方案功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef FLEETSIMULATOR_H
+#define FLEETSIMULATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "AgvBase.h"
+#include "ContractionHierarchy.h"
+#include "EtaService.h"
+#include "RfidRegistry.h"
+
+/*!
+ * @class FleetSimulator
+ * @brief 从车队快照出发模拟候选分配方案,按模拟的完工时间选择方案的模拟器
+ *
+ * 每个方案以离散事件的方式模拟:AGV沿收缩层次索引给出的最短路线逐个地标卡行驶,进入下一个地标卡前需占用它,
+ * 被其他AGV占用时在原地等待(即交通管制停止),快照中被其他对象锁定的地标卡在一段时间后才释放;
+ * 到达取货点、卸货点后各停留一个动作时间
+ * 多个方案在多个线程中并行模拟,每个方案的行驶时间扰动只由种子与方案下标决定,结果与线程调度无关;
+ * 超出时间预算时只在从第0个开始连续模拟完成的方案中选择,决策记录模拟完成的数量以便复现
+ */
+class FleetSimulator
+{
+public:
+    /*!
+     * @param const RfidMap& 路线图
+     * @param const ContractionHierarchy& 已就绪的收缩层次索引
+     */
+    FleetSimulator(const RfidMap& _map,const ContractionHierarchy& _ch);
+
+public:
+    typedef double Seconds_t;
+
+    /*! @brief 分配方案,下标为订单,值为AGV在快照中的下标,-1为不分配 */
+    typedef std::vector<int> Plan;
+
+    /*! @brief 描述快照中AGV的结构体 */
+    struct SimAgv
+    {
+        AgvBase::AId_t m_id;            /*!< 编号 */
+        RfidBase::Rfid_t m_rfid;        /*!< 当前地标卡 */
+        unsigned char m_ability;        /*!< 功能 */
+        float m_speed;                  /*!< 最大速度:单位(m/min) */
+        bool m_bStatic;                 /*!< 不参与分配,在模拟期间一直占用当前地标卡 */
+    };
+
+    /*! @brief 描述模拟订单的结构体 */
+    struct SimOrder
+    {
+        RfidBase::Rfid_t m_pickup;      /*!< 取货点 */
+        RfidBase::Rfid_t m_drop;        /*!< 卸货点 */
+    };
+
+    /*! @brief 描述车队快照的结构体 */
+    struct Snapshot
+    {
+        std::vector<SimAgv> m_agvs;                 /*!< AGV */
+        std::vector<RfidBase::Rfid_t> m_locked;     /*!< 被快照以外的对象锁定的地标卡 */
+        std::map<unsigned char,std::vector<Seconds_t> > m_times;   /*!< 快照中各功能各路段的通行时间,未设置通行时间服务时为空 */
+    };
+
+    /*! @brief 描述模拟参数的结构体 */
+    struct Parameters
+    {
+        Seconds_t m_horizon;            /*!< 模拟的时长:单位(s) */
+        Seconds_t m_actionTime;         /*!< 取货、卸货各停留的时间:单位(s) */
+        Seconds_t m_lockHold;           /*!< 快照中被锁定的地标卡释放前的时间:单位(s) */
+        double m_jitter;                /*!< 行驶时间随机扰动的比例 */
+        size_t m_threads;               /*!< 线程数量,0为CPU核心数量 */
+    };
+
+    /*! @brief 描述方案模拟结果的结构体 */
+    struct Result
+    {
+        size_t m_completed;             /*!< 完成的订单数量 */
+        Seconds_t m_makespan;           /*!< 最后一个订单完成的时间,有订单未完成时为模拟时长:单位(s) */
+        Seconds_t m_wait;               /*!< 等待地标卡的累计时间:单位(s) */
+    };
+
+    /*! @brief 描述选择结果的结构体 */
+    struct Decision
+    {
+        size_t m_plan;                  /*!< 选中的方案下标 */
+        size_t m_evaluated;             /*!< 从第0个开始连续模拟完成的方案数量 */
+        unsigned long long m_seed;      /*!< 种子 */
+        Result m_result;                /*!< 选中方案的模拟结果 */
+    };
+
+protected:
+    const RfidMap& m_map;                       /*!< 路线图 */
+    const ContractionHierarchy& m_ch;           /*!< 收缩层次索引 */
+    std::mutex m_mutex;                         /*!< 互斥锁 */
+    Parameters m_parameters;                    /*!< 模拟参数 */
+    std::atomic<EtaService*> m_pEta;            /*!< 提供路段通行时间的服务,为nullptr时按距离与速度估算 */
+    RfidRegistry* m_pRegistry;                  /*!< 生成快照时读取锁定状态的注册表 */
+    MetricsRegistry::MetricId m_runs;           /*!< 模拟方案数量的指标 */
+    MetricsRegistry::MetricId m_time;           /*!< 选择耗时的指标 */
+
+public:
+    /*!
+     * @brief 设置模拟参数
+     * @param const Parameters& 模拟参数
+     */
+    void SetParameters(const Parameters& _parameters);
+
+    /*!
+     * @brief 获取模拟参数
+     * @return Parameters 模拟参数
+     */
+    Parameters GetParameters();
+
+    /*!
+     * @brief 设置提供路段通行时间的服务,生成快照时复制各路段的通行时间
+     * @param EtaService* 服务,为nullptr时按距离与速度估算
+     */
+    void SetEta(EtaService* _eta);
+
+    /*!
+     * @brief 设置生成快照时读取锁定状态的注册表
+     * @param RfidRegistry* 注册表,为nullptr时快照不含锁定的地标卡
+     */
+    void SetRegistry(RfidRegistry* _registry);
+
+    /*!
+     * @brief 生成车队快照,可在任意线程中调用
+     *
+     * AGV的状态由调用方提供,应取自在AGV线程中采集的状态快照,如AgvIndex::Snapshot;
+     * 锁定的地标卡与各路段的通行时间在此时复制,模拟期间不再读取注册表与通行时间服务
+     * @param const std::vector<SimAgv>& AGV,m_bStatic为true的不参与分配,模拟时视为障碍
+     * @return Snapshot 快照
+     */
+    Snapshot Capture(const std::vector<SimAgv>& _agvs);
+
+    /*!
+     * @brief 模拟一个方案
+     * @param const Snapshot& 快照
+     * @param const std::vector<SimOrder>& 订单
+     * @param const Plan& 方案,同一AGV的多个订单按订单下标依次执行
+     * @param const unsigned long long& 种子
+     * @return Result 模拟结果
+     */
+    Result Simulate(const Snapshot& _snapshot,const std::vector<SimOrder>& _orders,const Plan& _plan,const unsigned long long& _seed);
+
+    /*!
+     * @brief 并行模拟多个方案并选择结果最好的方案
+     *
+     * 第0个方案一定会模拟;完成订单多者优先,其次完工时间短者、等待时间短者,最后下标小者
+     * @param const Snapshot& 快照
+     * @param const std::vector<SimOrder>& 订单
+     * @param const std::vector<Plan>& 方案
+     * @param const unsigned long long& 种子
+     * @param const std::chrono::milliseconds& 时间预算
+     * @return Decision 选择结果
+     */
+    Decision Choose(const Snapshot& _snapshot,const std::vector<SimOrder>& _orders,const std::vector<Plan>& _plans,
+                    const unsigned long long& _seed,const std::chrono::milliseconds& _budget);
+
+    /*!
+     * @brief 比较两个模拟结果
+     * @param const Result& 结果
+     * @param const Result& 结果
+     * @return bool 前者更好返回true
+     */
+    static bool IsBetter(const Result& _a,const Result& _b);
+
+protected:
+    /*!
+     * @brief 以给定的参数模拟一个方案,可在多个线程中同时调用
+     * @param const Parameters& 模拟参数
+     * @param const Snapshot& 快照
+     * @param const std::vector<SimOrder>& 订单
+     * @param const Plan& 方案
+     * @param const unsigned long long& 本方案的种子
+     * @return Result 模拟结果
+     */
+    Result Run(const Parameters& _parameters,const Snapshot& _snapshot,const std::vector<SimOrder>& _orders,
+               const Plan& _plan,const unsigned long long& _seed) const;
+
+    /*!
+     * @brief 计算路段的通行时间,优先使用快照中的通行时间
+     * @param const Snapshot& 快照
+     * @param const SimAgv& AGV
+     * @param const RfidMap::Node_t& 起点
+     * @param const RfidMap::Node_t& 终点
+     * @return Seconds_t 通行时间:单位(s)
+     */
+    Seconds_t TravelTime(const Snapshot& _snapshot,const SimAgv& _agv,const RfidMap::Node_t& _from,const RfidMap::Node_t& _to) const;
+
+    /*!
+     * @brief 方案的种子
+     * @param const unsigned long long& 种子
+     * @param const size_t& 方案下标
+     * @return unsigned long long 本方案的种子
+     */
+    static unsigned long long PlanSeed(const unsigned long long& _seed,const size_t& _plan);
+};
+
+#endif // FLEETSIMULATOR_H
@@ -0,0 +1,163 @@
+#include "HeartbeatWatchdog.h"
+
+HeartbeatWatchdog::HeartbeatWatchdog(TimingWheel &_wheel, const std::chrono::milliseconds &_deadline)
+    : m_wheel(_wheel)
+{
+    m_deadline = _deadline;
+    m_pRegistry = nullptr;
+}
+
+HeartbeatWatchdog::~HeartbeatWatchdog()
+{
+    std::vector<TimingWheel::TimerId> _timers;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        for(std::map<AgvBase::AId_t,WatchEntry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+        {
+            _timers.push_back(it->second.m_timer);
+        }
+
+        m_entries.clear();
+    }
+
+    // 不持有锁等待正在执行的Check返回,监视项已清空,Check不再启动定时器
+    for(std::vector<TimingWheel::TimerId>::iterator it = _timers.begin(); it != _timers.end(); ++it)
+    {
+        m_wheel.CancelSync(*it);
+    }
+}
+
+void HeartbeatWatchdog::SetDeadline(const std::chrono::milliseconds &_deadline)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_deadline = _deadline;
+
+    return;
+}
+
+void HeartbeatWatchdog::SetRegistry(RfidRegistry *_registry)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_pRegistry = _registry;
+
+    return;
+}
+
+void HeartbeatWatchdog::Watch(AgvBase *_agv)
+{
+    if(_agv == nullptr)
+    {
+        return;
+    }
+
+    AgvBase::AId_t _id = _agv->GetID();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,WatchEntry>::iterator it = m_entries.find(_id);
+
+    if(it != m_entries.end())
+    {
+        // 已在监视
+        it->second.m_pAgv = _agv;
+        return;
+    }
+
+    WatchEntry& _entry = m_entries[_id];
+    _entry.m_pAgv = _agv;
+    _entry.m_bLost = false;
+    _entry.m_timer = m_wheel.Start(m_deadline,[this,_id]{ Check(_id); });
+
+    return;
+}
+
+void HeartbeatWatchdog::Unwatch(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,WatchEntry>::iterator it = m_entries.find(_id);
+
+    if(it == m_entries.end())
+    {
+        return;
+    }
+
+    m_wheel.Cancel(it->second.m_timer);
+
+    m_entries.erase(it);
+
+    return;
+}
+
+void HeartbeatWatchdog::Check(const AgvBase::AId_t &_id)
+{
+    AgvBase* _lost = nullptr;  /*!< 本次判定为离线的AGV */
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,WatchEntry>::iterator it = m_entries.find(_id);
+
+        if(it == m_entries.end())
+        {
+            // 已停止监视
+            return;
+        }
+
+        WatchEntry& _entry = it->second;
+
+        std::chrono::milliseconds _elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - _entry.m_pAgv->GetLastHeartbeat());
+
+        if(_elapsed < m_deadline)
+        {
+            // 期限内收到过心跳回复,从最后一次回复开始重新计时
+            _entry.m_bLost = false;
+            _entry.m_timer = m_wheel.Start(m_deadline - _elapsed,[this,_id]{ Check(_id); });
+
+            return;
+        }
+
+        if(_entry.m_bLost == false)
+        {
+            _entry.m_bLost = true;
+            _lost = _entry.m_pAgv;
+        }
+
+        // 离线后继续按期限检测,等待AGV恢复
+        _entry.m_timer = m_wheel.Start(m_deadline,[this,_id]{ Check(_id); });
+    }
+
+    if(_lost)
+    {
+        FreeRfids(_lost);
+
+        // 异常设置与重新连接需在AGV所在的线程中执行
+        QMetaObject::invokeMethod(_lost,"HeartbeatLost",Qt::QueuedConnection);
+    }
+
+    return;
+}
+
+void HeartbeatWatchdog::FreeRfids(AgvBase *_agv)
+{
+    RfidRegistry* _registry = nullptr;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        _registry = m_pRegistry;
+    }
+
+    if(_registry)
+    {
+        // 注册表的操作无需加锁
+        _registry->FreeAll(_agv->GetID());
+    }
+
+    return;
+}
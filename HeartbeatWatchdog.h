@@ -0,0 +1,94 @@
+/*!
+ * @file HeartbeatWatchdog
+ * @brief 描述心跳回复超时检测功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef HEARTBEATWATCHDOG_H
+#define HEARTBEATWATCHDOG_H
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include "AgvBase.h"
+#include "RfidRegistry.h"
+#include "TimingWheel.h"
+
+/*!
+ * @class HeartbeatWatchdog
+ * @brief 检测AGV心跳回复超时的看门狗
+ *
+ * 半开的TCP连接可能使IsConnected()长时间返回true,看门狗不依赖TCP状态,
+ * 超过期限未收到心跳回复的AGV被视为离线:设置Err_Net异常、释放其锁定的RFID地标卡并重新连接
+ * 每台AGV只占用一个定时器,定时器到期时才比较最后一次心跳回复的时间,收到心跳回复时无需操作时间轮
+ */
+class HeartbeatWatchdog
+{
+public:
+    /*!
+     * @param TimingWheel& 共用的时间轮
+     * @param const std::chrono::milliseconds& 心跳回复的期限
+     */
+    HeartbeatWatchdog(TimingWheel& _wheel,const std::chrono::milliseconds& _deadline = std::chrono::milliseconds(3000));
+    ~HeartbeatWatchdog();
+
+protected:
+    /*! @brief 描述被监视AGV的结构体 */
+    struct WatchEntry
+    {
+        AgvBase* m_pAgv;                    /*!< AGV对象 */
+        TimingWheel::TimerId m_timer;       /*!< 检测定时器 */
+        bool m_bLost;                       /*!< 是否已判定为离线 */
+    };
+
+protected:
+    TimingWheel& m_wheel;                           /*!< 时间轮 */
+    std::chrono::milliseconds m_deadline;           /*!< 心跳回复的期限 */
+    std::mutex m_mutex;                             /*!< 互斥锁 */
+    std::map<AgvBase::AId_t,WatchEntry> m_entries;  /*!< 被监视的AGV */
+    RfidRegistry* m_pRegistry;                      /*!< 离线时释放RFID地标卡的注册表 */
+
+public:
+    /*!
+     * @brief 设置心跳回复的期限
+     *
+     * 新的期限在各AGV下一次检测时生效
+     * @param const std::chrono::milliseconds& 期限
+     */
+    void SetDeadline(const std::chrono::milliseconds& _deadline);
+
+    /*!
+     * @brief 设置AGV离线时释放RFID地标卡的注册表
+     * @param RfidRegistry* 注册表,为nullptr时不释放
+     */
+    void SetRegistry(RfidRegistry* _registry);
+
+    /*!
+     * @brief 开始监视AGV
+     * @param AgvBase* AGV对象
+     */
+    void Watch(AgvBase* _agv);
+
+    /*!
+     * @brief 停止监视AGV
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Unwatch(const AgvBase::AId_t& _id);
+
+protected:
+    /*!
+     * @brief 检测AGV的心跳回复
+     *
+     * 在时间轮的推进线程中执行
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Check(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 释放AGV锁定的RFID地标卡
+     * @param AgvBase* AGV对象
+     */
+    void FreeRfids(AgvBase* _agv);
+};
+
+#endif // HEARTBEATWATCHDOG_H
@@ -0,0 +1,610 @@
+#include "IncrementalPlanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <random>
+
+/*!
+ * @brief 距离相加,任一距离不可达或结果溢出时返回不可达
+ */
+static inline RfidMap::Weight_t AddWeight(const RfidMap::Weight_t& _left,const RfidMap::Weight_t& _right)
+{
+    if(_left == RfidMap::INFINITE || _right == RfidMap::INFINITE)
+    {
+        return RfidMap::INFINITE;
+    }
+
+    unsigned long long _sum = static_cast<unsigned long long>(_left) + _right;
+
+    return _sum >= RfidMap::INFINITE ? RfidMap::INFINITE : static_cast<RfidMap::Weight_t>(_sum);
+}
+
+IncrementalPlanner::IncrementalPlanner(const RoutePlanner &_planner)
+    : m_planner(_planner),m_map(_planner.GetMap())
+{
+    m_blocked.assign(m_map.GetNodeCount(),false);
+    m_penalty.assign(m_map.GetEdgeCount(),0);
+}
+
+bool IncrementalPlanner::Plan(const AgvBase::AId_t &_id, const RfidBase::Rfid_t &_start, const RfidBase::Rfid_t &_goal, std::vector<RfidBase::Rfid_t> &_route, Weight_t *_cost)
+{
+    _route.clear();
+
+    Node_t _source = m_map.GetNode(_start);
+    Node_t _target = m_map.GetNode(_goal);
+
+    if(_source == RfidMap::NIL || _target == RfidMap::NIL)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    SearchState& _state = m_states[_id];
+
+    if(_state.m_g.size() != m_map.GetNodeCount() || _state.m_goal != _target)
+    {
+        Initialize(_state,_source,_target);
+    }
+    else if(_state.m_start != _source)
+    {
+        // AGV已前进,以起点移动距离的下界修正此后计算的优先级
+        Weight_t _moved = m_planner.Heuristic(_state.m_last,_source);
+
+        _state.m_km += _moved == RfidMap::INFINITE ? 0 : _moved;
+        _state.m_last = _source;
+        _state.m_start = _source;
+    }
+
+    ComputeShortestPath(_state);
+
+    if(_state.m_g[_source] == RfidMap::INFINITE)
+    {
+        return false;
+    }
+
+    // 沿代价最小的后继节点前进至终点
+    Node_t _node = _source;
+
+    _route.push_back(m_map.GetRfid(_node));
+
+    while(_node != _target)
+    {
+        Weight_t _best = RfidMap::INFINITE;
+        Node_t _next = RfidMap::NIL;
+
+        for(RfidMap::Edge_t _edge = m_map.EdgeBegin(_node); _edge < m_map.EdgeEnd(_node); ++_edge)
+        {
+            Weight_t _through = AddWeight(Cost(_edge),_state.m_g[m_map.GetTarget(_edge)]);
+
+            if(_through < _best)
+            {
+                _best = _through;
+                _next = m_map.GetTarget(_edge);
+            }
+        }
+
+        if(_next == RfidMap::NIL || _route.size() > m_map.GetNodeCount())
+        {
+            _route.clear();
+            return false;
+        }
+
+        _node = _next;
+        _route.push_back(m_map.GetRfid(_node));
+    }
+
+    if(_cost)
+    {
+        *_cost = _state.m_g[_source];
+    }
+
+    return true;
+}
+
+void IncrementalPlanner::Remove(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_states.erase(_id);
+
+    return;
+}
+
+void IncrementalPlanner::Block(const RfidBase::Rfid_t &_rfid)
+{
+    Node_t _node = m_map.GetNode(_rfid);
+
+    if(_node == RfidMap::NIL)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_blocked[_node])
+    {
+        return;
+    }
+
+    m_blocked[_node] = true;
+
+    // 进入该节点的路段代价改变
+    for(RfidMap::Edge_t _in = m_map.InEdgeBegin(_node); _in < m_map.InEdgeEnd(_node); ++_in)
+    {
+        NotifyChanged(m_map.GetInSource(_in));
+    }
+
+    return;
+}
+
+void IncrementalPlanner::Unblock(const RfidBase::Rfid_t &_rfid)
+{
+    Node_t _node = m_map.GetNode(_rfid);
+
+    if(_node == RfidMap::NIL)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_blocked[_node] == false)
+    {
+        return;
+    }
+
+    m_blocked[_node] = false;
+
+    for(RfidMap::Edge_t _in = m_map.InEdgeBegin(_node); _in < m_map.InEdgeEnd(_node); ++_in)
+    {
+        NotifyChanged(m_map.GetInSource(_in));
+    }
+
+    return;
+}
+
+bool IncrementalPlanner::IsBlocked(const RfidBase::Rfid_t &_rfid)
+{
+    Node_t _node = m_map.GetNode(_rfid);
+
+    if(_node == RfidMap::NIL)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_blocked[_node];
+}
+
+bool IncrementalPlanner::SetPenalty(const RfidBase::Rfid_t &_from, const RfidBase::Rfid_t &_to, const Weight_t &_penalty)
+{
+    Node_t _source = m_map.GetNode(_from);
+    Node_t _target = m_map.GetNode(_to);
+
+    if(_source == RfidMap::NIL || _target == RfidMap::NIL)
+    {
+        return false;
+    }
+
+    RfidMap::Edge_t _edge = m_map.FindEdge(_source,_target);
+
+    if(_edge == RfidMap::NIL)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_penalty[_edge] != _penalty)
+    {
+        m_penalty[_edge] = _penalty;
+
+        NotifyChanged(_source);
+    }
+
+    return true;
+}
+
+size_t IncrementalPlanner::GetExpanded(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,SearchState>::iterator it = m_states.find(_id);
+
+    if(it == m_states.end())
+    {
+        return 0;
+    }
+
+    return it->second.m_expanded;
+}
+
+IncrementalPlanner::Benchmark IncrementalPlanner::Measure(const RoutePlanner &_planner, const size_t &_routes, const size_t &_blocks, const unsigned long long &_seed)
+{
+    Benchmark _result;
+    _result.m_replans = 0;
+    _result.m_incremental = 0;
+    _result.m_full = 0;
+    _result.m_incrementalTime = 0.0;
+    _result.m_fullTime = 0.0;
+    _result.m_mismatch = 0;
+
+    const RfidMap& _map = _planner.GetMap();
+
+    if(_map.GetNodeCount() < 3)
+    {
+        return _result;
+    }
+
+    IncrementalPlanner _incremental(_planner);
+    IncrementalPlanner _full(_planner);
+
+    std::mt19937_64 _random(_seed);
+    std::uniform_int_distribution<Node_t> _pick(0,_map.GetNodeCount() - 1);
+
+    const AgvBase::AId_t _id = 0;
+    std::vector<RfidBase::Rfid_t> _route;
+    std::vector<RfidBase::Rfid_t> _check;
+
+    for(size_t r = 0; r < _routes; ++r)
+    {
+        RfidBase::Rfid_t _start = _map.GetRfid(_pick(_random));
+        RfidBase::Rfid_t _goal = _map.GetRfid(_pick(_random));
+
+        if(_start == _goal || _incremental.Plan(_id,_start,_goal,_route) == false)
+        {
+            continue;
+        }
+
+        std::vector<RfidBase::Rfid_t> _blocked;
+
+        for(size_t b = 0; b < _blocks && _route.size() > 2; ++b)
+        {
+            // 阻塞当前路线中间的地标卡,迫使路线改变
+            std::uniform_int_distribution<size_t> _inner(1,_route.size() - 2);
+
+            RfidBase::Rfid_t _rfid = _route[_inner(_random)];
+
+            _incremental.Block(_rfid);
+            _full.Block(_rfid);
+            _blocked.push_back(_rfid);
+
+            Weight_t _cost = RfidMap::INFINITE;
+            Weight_t _expected = RfidMap::INFINITE;
+
+            std::chrono::steady_clock::time_point _begin = std::chrono::steady_clock::now();
+
+            bool _bFound = _incremental.Plan(_id,_start,_goal,_route,&_cost);
+
+            std::chrono::steady_clock::time_point _middle = std::chrono::steady_clock::now();
+
+            _full.Remove(_id);
+
+            bool _bExpected = _full.Plan(_id,_start,_goal,_check,&_expected);
+
+            std::chrono::steady_clock::time_point _end = std::chrono::steady_clock::now();
+
+            ++_result.m_replans;
+            _result.m_incremental += _incremental.GetExpanded(_id);
+            _result.m_full += _full.GetExpanded(_id);
+            _result.m_incrementalTime += std::chrono::duration<double>(_middle - _begin).count();
+            _result.m_fullTime += std::chrono::duration<double>(_end - _middle).count();
+
+            if(_bFound != _bExpected || (_bFound && _cost != _expected))
+            {
+                ++_result.m_mismatch;
+            }
+
+            if(_bFound == false)
+            {
+                break;
+            }
+        }
+
+        // 先删除搜索状态,解除阻塞时不再修复
+        _incremental.Remove(_id);
+        _full.Remove(_id);
+
+        for(std::vector<RfidBase::Rfid_t>::iterator it = _blocked.begin(); it != _blocked.end(); ++it)
+        {
+            _incremental.Unblock(*it);
+            _full.Unblock(*it);
+        }
+    }
+
+    return _result;
+}
+
+IncrementalPlanner::Weight_t IncrementalPlanner::Cost(const RfidMap::Edge_t &_edge) const
+{
+    if(m_blocked[m_map.GetTarget(_edge)])
+    {
+        return RfidMap::INFINITE;
+    }
+
+    return AddWeight(m_map.GetWeight(_edge),m_penalty[_edge]);
+}
+
+void IncrementalPlanner::Initialize(SearchState &_state, const Node_t &_start, const Node_t &_goal)
+{
+    size_t _count = m_map.GetNodeCount();
+
+    _state.m_g.assign(_count,RfidMap::INFINITE);
+    _state.m_rhs.assign(_count,RfidMap::INFINITE);
+    _state.m_key.resize(_count);
+    _state.m_pos.assign(_count,RfidMap::NIL);
+    _state.m_heap.clear();
+    _state.m_start = _start;
+    _state.m_last = _start;
+    _state.m_goal = _goal;
+    _state.m_km = 0;
+    _state.m_expanded = 0;
+
+    _state.m_rhs[_goal] = 0;
+
+    HeapPush(_state,_goal,CalculateKey(_state,_goal));
+
+    return;
+}
+
+IncrementalPlanner::Key IncrementalPlanner::CalculateKey(const SearchState &_state, const Node_t &_node) const
+{
+    Key _key;
+
+    Weight_t _min = std::min(_state.m_g[_node],_state.m_rhs[_node]);
+    Weight_t _h = m_planner.Heuristic(_state.m_start,_node);
+
+    _key.m_second = _min;
+
+    if(_min == RfidMap::INFINITE || _h == RfidMap::INFINITE)
+    {
+        _key.m_first = std::numeric_limits<unsigned long long>::max();
+    }
+    else
+    {
+        _key.m_first = static_cast<unsigned long long>(_min) + _h + _state.m_km;
+    }
+
+    return _key;
+}
+
+void IncrementalPlanner::UpdateRhs(SearchState &_state, const Node_t &_node)
+{
+    if(_node == _state.m_goal)
+    {
+        return;
+    }
+
+    Weight_t _best = RfidMap::INFINITE;
+
+    for(RfidMap::Edge_t _edge = m_map.EdgeBegin(_node); _edge < m_map.EdgeEnd(_node); ++_edge)
+    {
+        _best = std::min(_best,AddWeight(Cost(_edge),_state.m_g[m_map.GetTarget(_edge)]));
+    }
+
+    _state.m_rhs[_node] = _best;
+
+    return;
+}
+
+void IncrementalPlanner::UpdateVertex(SearchState &_state, const Node_t &_node)
+{
+    if(_state.m_g[_node] != _state.m_rhs[_node])
+    {
+        HeapPush(_state,_node,CalculateKey(_state,_node));
+    }
+    else if(_state.m_pos[_node] != RfidMap::NIL)
+    {
+        HeapRemove(_state,_node);
+    }
+
+    return;
+}
+
+void IncrementalPlanner::ComputeShortestPath(SearchState &_state)
+{
+    Node_t _start = _state.m_start;
+
+    _state.m_expanded = 0;
+
+    while(_state.m_heap.empty() == false
+          && (_state.m_key[_state.m_heap.front()] < CalculateKey(_state,_start) || _state.m_rhs[_start] != _state.m_g[_start]))
+    {
+        Node_t _node = _state.m_heap.front();
+        Key _old = _state.m_key[_node];
+        Key _new = CalculateKey(_state,_node);
+
+        if(_old < _new)
+        {
+            // 优先级因起点移动而过期
+            HeapPush(_state,_node,_new);
+            continue;
+        }
+
+        ++_state.m_expanded;
+
+        if(_state.m_g[_node] > _state.m_rhs[_node])
+        {
+            // 距离缩短
+            _state.m_g[_node] = _state.m_rhs[_node];
+            HeapRemove(_state,_node);
+
+            for(RfidMap::Edge_t _in = m_map.InEdgeBegin(_node); _in < m_map.InEdgeEnd(_node); ++_in)
+            {
+                Node_t _pred = m_map.GetInSource(_in);
+
+                if(_pred != _state.m_goal)
+                {
+                    _state.m_rhs[_pred] = std::min(_state.m_rhs[_pred],AddWeight(Cost(m_map.GetInEdge(_in)),_state.m_g[_node]));
+                }
+
+                UpdateVertex(_state,_pred);
+            }
+        }
+        else
+        {
+            // 距离增加,依赖该节点的前驱节点需要重新计算
+            Weight_t _oldG = _state.m_g[_node];
+
+            _state.m_g[_node] = RfidMap::INFINITE;
+
+            for(RfidMap::Edge_t _in = m_map.InEdgeBegin(_node); _in < m_map.InEdgeEnd(_node); ++_in)
+            {
+                Node_t _pred = m_map.GetInSource(_in);
+
+                if(_state.m_rhs[_pred] == AddWeight(Cost(m_map.GetInEdge(_in)),_oldG))
+                {
+                    UpdateRhs(_state,_pred);
+                }
+
+                UpdateVertex(_state,_pred);
+            }
+
+            UpdateRhs(_state,_node);
+            UpdateVertex(_state,_node);
+        }
+    }
+
+    return;
+}
+
+void IncrementalPlanner::NotifyChanged(const Node_t &_node)
+{
+    for(std::map<AgvBase::AId_t,SearchState>::iterator it = m_states.begin(); it != m_states.end(); ++it)
+    {
+        SearchState& _state = it->second;
+
+        if(_state.m_g.empty())
+        {
+            continue;
+        }
+
+        UpdateRhs(_state,_node);
+        UpdateVertex(_state,_node);
+    }
+
+    return;
+}
+
+void IncrementalPlanner::HeapPush(SearchState &_state, const Node_t &_node, const Key &_key)
+{
+    unsigned int _pos = _state.m_pos[_node];
+
+    if(_pos == RfidMap::NIL)
+    {
+        _pos = static_cast<unsigned int>(_state.m_heap.size());
+
+        _state.m_heap.push_back(_node);
+        _state.m_pos[_node] = _pos;
+        _state.m_key[_node] = _key;
+
+        HeapUp(_state,_pos);
+
+        return;
+    }
+
+    bool _decrease = _key < _state.m_key[_node];
+
+    _state.m_key[_node] = _key;
+
+    if(_decrease)
+    {
+        HeapUp(_state,_pos);
+    }
+    else
+    {
+        HeapDown(_state,_pos);
+    }
+
+    return;
+}
+
+void IncrementalPlanner::HeapRemove(SearchState &_state, const Node_t &_node)
+{
+    unsigned int _pos = _state.m_pos[_node];
+
+    if(_pos == RfidMap::NIL)
+    {
+        return;
+    }
+
+    Node_t _last = _state.m_heap.back();
+
+    _state.m_heap.pop_back();
+    _state.m_pos[_node] = RfidMap::NIL;
+
+    if(_last == _node)
+    {
+        return;
+    }
+
+    _state.m_heap[_pos] = _last;
+    _state.m_pos[_last] = _pos;
+
+    HeapUp(_state,_pos);
+    HeapDown(_state,_state.m_pos[_last]);
+
+    return;
+}
+
+void IncrementalPlanner::HeapUp(SearchState &_state, unsigned int _pos)
+{
+    Node_t _node = _state.m_heap[_pos];
+
+    while(_pos > 0)
+    {
+        unsigned int _parent = (_pos - 1) / 2;
+
+        if((_state.m_key[_node] < _state.m_key[_state.m_heap[_parent]]) == false)
+        {
+            break;
+        }
+
+        _state.m_heap[_pos] = _state.m_heap[_parent];
+        _state.m_pos[_state.m_heap[_pos]] = _pos;
+        _pos = _parent;
+    }
+
+    _state.m_heap[_pos] = _node;
+    _state.m_pos[_node] = _pos;
+
+    return;
+}
+
+void IncrementalPlanner::HeapDown(SearchState &_state, unsigned int _pos)
+{
+    Node_t _node = _state.m_heap[_pos];
+    unsigned int _size = static_cast<unsigned int>(_state.m_heap.size());
+
+    while(true)
+    {
+        unsigned int _child = _pos * 2 + 1;
+
+        if(_child >= _size)
+        {
+            break;
+        }
+
+        if(_child + 1 < _size && _state.m_key[_state.m_heap[_child + 1]] < _state.m_key[_state.m_heap[_child]])
+        {
+            ++_child;
+        }
+
+        if((_state.m_key[_state.m_heap[_child]] < _state.m_key[_node]) == false)
+        {
+            break;
+        }
+
+        _state.m_heap[_pos] = _state.m_heap[_child];
+        _state.m_pos[_state.m_heap[_pos]] = _pos;
+        _pos = _child;
+    }
+
+    _state.m_heap[_pos] = _node;
+    _state.m_pos[_node] = _pos;
+
+    return;
+}
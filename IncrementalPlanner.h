@@ -0,0 +1,202 @@
+/*!
+ * @file IncrementalPlanner
+ * @brief 描述RFID地标卡路线增量重规划功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef INCREMENTALPLANNER_H
+#define INCREMENTALPLANNER_H
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include "AgvBase.h"
+#include "RoutePlanner.h"
+
+/*!
+ * @class IncrementalPlanner
+ * @brief 基于D* Lite为每台AGV保存搜索状态的增量路线规划器
+ *
+ * 每台AGV的搜索从终点反向进行,保存各节点至终点的距离
+ * RFID地标卡被阻塞(如异常AGV停在地标卡上)或路段附加代价改变时,只将受影响的节点重新放入队列,
+ * 下一次规划时仅修复受影响的部分;AGV前进时通过km修正优先级,无需重新搜索
+ * 启发值使用RoutePlanner的地标距离下界,因此路段代价只能在原始距离之上增加
+ */
+class IncrementalPlanner
+{
+public:
+    /*!
+     * @param const RoutePlanner& 提供路线图与启发值的规划器
+     */
+    explicit IncrementalPlanner(const RoutePlanner& _planner);
+
+public:
+    typedef RfidMap::Node_t Node_t;
+    typedef RfidMap::Weight_t Weight_t;
+
+    /*! @brief 描述增量重规划基准测试结果的结构体 */
+    struct Benchmark
+    {
+        size_t m_replans;               /*!< 重规划次数 */
+        size_t m_incremental;           /*!< 增量重规划扩展的节点总数 */
+        size_t m_full;                  /*!< 丢弃搜索状态重新搜索扩展的节点总数 */
+        double m_incrementalTime;       /*!< 增量重规划的总耗时:单位(s) */
+        double m_fullTime;              /*!< 重新搜索的总耗时:单位(s) */
+        size_t m_mismatch;              /*!< 两者代价或可达性不一致的次数 */
+    };
+
+protected:
+    /*! @brief 描述优先级的结构体 */
+    struct Key
+    {
+        unsigned long long m_first;     /*!< min(g,rhs)+h+km */
+        unsigned long long m_second;    /*!< min(g,rhs) */
+
+        bool operator<(const Key& _key) const
+        {
+            return m_first < _key.m_first || (m_first == _key.m_first && m_second < _key.m_second);
+        }
+    };
+
+    /*! @brief 描述单台AGV搜索状态的结构体 */
+    struct SearchState
+    {
+        std::vector<Weight_t> m_g;          /*!< 节点至终点的距离 */
+        std::vector<Weight_t> m_rhs;        /*!< 由后继节点计算的单步前瞻距离 */
+        std::vector<Key> m_key;             /*!< 节点在队列中的优先级 */
+        std::vector<unsigned int> m_pos;    /*!< 节点在队列中的位置,不在队列中时为NIL */
+        std::vector<Node_t> m_heap;         /*!< 优先队列,按优先级排列的小顶堆 */
+        Node_t m_start;                     /*!< 当前起点 */
+        Node_t m_last;                      /*!< 上一次修正km时的起点 */
+        Node_t m_goal;                      /*!< 终点 */
+        unsigned long long m_km;            /*!< 起点移动累计的优先级修正值 */
+        size_t m_expanded;                  /*!< 最近一次规划扩展的节点数量 */
+    };
+
+protected:
+    const RoutePlanner& m_planner;          /*!< 规划器 */
+    const RfidMap& m_map;                   /*!< 路线图 */
+    std::mutex m_mutex;                     /*!< 互斥锁 */
+    std::vector<bool> m_blocked;            /*!< 被阻塞的节点 */
+    std::vector<Weight_t> m_penalty;        /*!< 路段的附加代价 */
+    std::map<AgvBase::AId_t,SearchState> m_states;  /*!< 各AGV的搜索状态 */
+
+public:
+    /*!
+     * @brief 规划AGV从起点至终点的路线
+     *
+     * 终点与上一次相同时复用已有的搜索状态,只修复阻塞与代价变化影响的部分
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const RfidBase::Rfid_t& 起点RFID地标卡编号,通常为AGV的当前地标卡
+     * @param const RfidBase::Rfid_t& 终点RFID地标卡编号
+     * @param std::vector<RfidBase::Rfid_t>& 规划结果,包含起点与终点
+     * @param Weight_t* 路线的总代价,为nullptr时不输出
+     * @return bool 规划成功返回true,不可达时返回false
+     */
+    bool Plan(const AgvBase::AId_t& _id,const RfidBase::Rfid_t& _start,const RfidBase::Rfid_t& _goal,
+              std::vector<RfidBase::Rfid_t>& _route,Weight_t* _cost = nullptr);
+
+    /*!
+     * @brief 删除AGV的搜索状态
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Remove(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 阻塞RFID地标卡,规划的路线不再经过该地标卡
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Block(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 解除RFID地标卡的阻塞
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Unblock(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief RFID地标卡是否被阻塞
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @return bool 被阻塞返回true
+     */
+    bool IsBlocked(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 设置路段的附加代价
+     * @param const RfidBase::Rfid_t& 起点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 终点RFID地标卡编号
+     * @param const Weight_t& 在原始距离之上增加的代价,0为恢复原始距离
+     * @return bool 路段存在返回true
+     */
+    bool SetPenalty(const RfidBase::Rfid_t& _from,const RfidBase::Rfid_t& _to,const Weight_t& _penalty);
+
+    /*!
+     * @brief 获取AGV最近一次规划扩展的节点数量
+     * @param const AgvBase::AId_t& AGV编号
+     * @return size_t 节点数量
+     */
+    size_t GetExpanded(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 在路线图上比较增量重规划与重新搜索
+     *
+     * 以种子随机选取起终点,沿当前路线依次阻塞中间的地标卡,每次阻塞后分别增量重规划与丢弃搜索状态重新搜索
+     * 种子与路线图相同时阻塞序列与扩展节点数量相同,耗时随机器变化;使用独立的规划器,不影响已有的搜索状态
+     * @param const RoutePlanner& 提供路线图与启发值的规划器
+     * @param const size_t& 起终点对的数量
+     * @param const size_t& 每条路线依次阻塞的地标卡数量
+     * @param const unsigned long long& 随机数种子
+     * @return Benchmark 测试结果
+     */
+    static Benchmark Measure(const RoutePlanner& _planner,const size_t& _routes = 100,const size_t& _blocks = 5,
+                             const unsigned long long& _seed = 0);
+
+protected:
+    /*!
+     * @brief 路段的当前代价
+     * @param const RfidMap::Edge_t& 路段下标
+     * @return Weight_t 代价,终点被阻塞时返回RfidMap::INFINITE
+     */
+    Weight_t Cost(const RfidMap::Edge_t& _edge) const;
+
+    /*!
+     * @brief 以新的终点初始化搜索状态
+     */
+    void Initialize(SearchState& _state,const Node_t& _start,const Node_t& _goal);
+
+    /*!
+     * @brief 计算节点的优先级
+     */
+    Key CalculateKey(const SearchState& _state,const Node_t& _node) const;
+
+    /*!
+     * @brief 由后继节点重新计算节点的rhs值
+     */
+    void UpdateRhs(SearchState& _state,const Node_t& _node);
+
+    /*!
+     * @brief 根据g值与rhs值是否一致更新节点在队列中的状态
+     */
+    void UpdateVertex(SearchState& _state,const Node_t& _node);
+
+    /*!
+     * @brief 扩展节点直至起点的距离确定
+     */
+    void ComputeShortestPath(SearchState& _state);
+
+    /*!
+     * @brief 节点的出边代价改变时更新所有搜索状态
+     * @param const Node_t& 出边改变的节点
+     */
+    void NotifyChanged(const Node_t& _node);
+
+    /*!
+     * @brief 优先队列操作
+     */
+    void HeapPush(SearchState& _state,const Node_t& _node,const Key& _key);
+    void HeapRemove(SearchState& _state,const Node_t& _node);
+    void HeapUp(SearchState& _state,unsigned int _pos);
+    void HeapDown(SearchState& _state,unsigned int _pos);
+};
+
+#endif // INCREMENTALPLANNER_H
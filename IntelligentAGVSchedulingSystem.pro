@@ -17,31 +17,83 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
     AgvBase.cpp \
+    AgvIndex.cpp \
     ArmAgv.cpp \
+    ChargeScheduler.cpp \
+    CongestionMonitor.cpp \
+    ContractionHierarchy.cpp \
+    DeadlockDetector.cpp \
+    Dispatcher.cpp \
+    EtaService.cpp \
+    FleetSimulator.cpp \
     ForkAgv.cpp \
+    HeartbeatWatchdog.cpp \
+    IncrementalPlanner.cpp \
+    JobPipeline.cpp \
+    LifeGuard.cpp \
     LiftingAgv.cpp \
+    LinkQuality.cpp \
+    LockLease.cpp \
+    Metrics.cpp \
+    OrderQueue.cpp \
+    ParkingPlanner.cpp \
     ProtocolBase.cpp \
     ProtocolPlc.cpp \
     ProtocolStm32.cpp \
     PullAgv.cpp \
+    ReservationTable.cpp \
     RfidBase.cpp \
+    RfidMap.cpp \
+    RfidRegistry.cpp \
+    RouteLocker.cpp \
+    RoutePlanner.cpp \
     SubmersibleAgv.cpp \
+    TimingWheel.cpp \
+    TrafficController.cpp \
     TransferAgv.cpp \
+    WireRecorder.cpp \
+    ZoneScheduler.cpp \
     main.cpp \
     mainwindow.cpp
 
 HEADERS += \
     AgvBase.h \
+    AgvIndex.h \
     ArmAgv.h \
+    ChargeScheduler.h \
+    CongestionMonitor.h \
+    ContractionHierarchy.h \
+    DeadlockDetector.h \
+    Dispatcher.h \
+    EtaService.h \
+    FleetSimulator.h \
     ForkAgv.h \
+    HeartbeatWatchdog.h \
+    IncrementalPlanner.h \
+    JobPipeline.h \
+    LifeGuard.h \
     LiftingAgv.h \
+    LinkQuality.h \
+    LockLease.h \
+    Metrics.h \
+    OrderQueue.h \
+    ParkingPlanner.h \
     ProtocolBase.h \
     ProtocolPlc.h \
     ProtocolStm32.h \
     PullAgv.h \
+    ReservationTable.h \
     RfidBase.h \
+    RfidMap.h \
+    RfidRegistry.h \
+    RouteLocker.h \
+    RoutePlanner.h \
     SubmersibleAgv.h \
+    TimingWheel.h \
+    TrafficController.h \
     TransferAgv.h \
+    WireRecorder.h \
+    ZoneScheduler.h \
     mainwindow.h
 
 FORMS += \
@@ -0,0 +1,303 @@
+#include "JobPipeline.h"
+
+#include <QTimer>
+
+JobPipeline::JobPipeline()
+{
+    m_nextId = 1;
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+
+    m_completed = _registry.AddCounter("agv_jobs_completed_total","Jobs whose last step completed");
+    m_failed = _registry.AddCounter("agv_jobs_failed_total","Jobs aborted by an AGV error or mode change");
+    m_reencoded = _registry.AddCounter("agv_job_frames_reencoded_total","Pre-encoded command frames rebuilt because the AGV was elsewhere");
+}
+
+JobPipeline::~JobPipeline()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    for(std::map<AgvBase::AId_t,Job>::iterator it = m_jobs.begin(); it != m_jobs.end(); ++it)
+    {
+        QObject::disconnect(it->second.m_connection);
+    }
+}
+
+std::vector<JobPipeline::Step> JobPipeline::Compile(const AgvBase *_agv, const RfidBase::Rfid_t &_pickup, const RfidBase::Rfid_t &_drop)
+{
+    std::vector<Step> _steps;
+
+    Step _step;
+    _step.m_action = 0;
+    _step.m_from = 0;
+    _step.m_bSent = false;
+    _step.m_bStarted = false;
+
+    _step.m_type = Step_Move;
+    _step.m_target = _pickup;
+    _steps.push_back(_step);
+
+    if(_agv->GetLoadAction() != 0)
+    {
+        _step.m_type = Step_Action;
+        _step.m_action = _agv->GetLoadAction();
+        _steps.push_back(_step);
+    }
+
+    _step.m_type = Step_Move;
+    _step.m_target = _drop;
+    _step.m_action = 0;
+    _steps.push_back(_step);
+
+    if(_agv->GetUnloadAction() != 0)
+    {
+        _step.m_type = Step_Action;
+        _step.m_action = _agv->GetUnloadAction();
+        _steps.push_back(_step);
+    }
+
+    return _steps;
+}
+
+JobPipeline::JobId_t JobPipeline::Submit(AgvBase *_agv, const RfidBase::Rfid_t &_pickup, const RfidBase::Rfid_t &_drop)
+{
+    if(_agv == nullptr)
+    {
+        return 0;
+    }
+
+    return Submit(_agv,Compile(_agv,_pickup,_drop));
+}
+
+JobPipeline::JobId_t JobPipeline::Submit(AgvBase *_agv, const std::vector<JobPipeline::Step> &_steps)
+{
+    if(_agv == nullptr || _steps.empty())
+    {
+        return 0;
+    }
+
+    AgvBase::AId_t _id = _agv->GetID();
+    JobId_t _jobId = 0;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        if(m_jobs.find(_id) != m_jobs.end())
+        {
+            // 上一个作业尚未结束
+            return 0;
+        }
+
+        Job& _job = m_jobs[_id];
+        _job.m_id = m_nextId++;
+        _job.m_pAgv = _agv;
+        _job.m_steps = _steps;
+        _job.m_current = 0;
+
+        for(std::vector<Step>::iterator it = _job.m_steps.begin(); it != _job.m_steps.end(); ++it)
+        {
+            it->m_frame.clear();
+            it->m_bSent = false;
+            it->m_bStarted = false;
+        }
+
+        _job.m_connection = QObject::connect(_agv,&AgvBase::Update,[this,_id]{ Advance(_id); });
+
+        _jobId = _job.m_id;
+    }
+
+    // 第一个步骤同样需在AGV所在的线程中发送
+    QTimer::singleShot(0,_agv,[this,_id]{ Advance(_id); });
+
+    return _jobId;
+}
+
+bool JobPipeline::Cancel(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Job>::iterator it = m_jobs.find(_id);
+
+    if(it == m_jobs.end())
+    {
+        return false;
+    }
+
+    QObject::disconnect(it->second.m_connection);
+
+    m_jobs.erase(it);
+
+    return true;
+}
+
+void JobPipeline::SetHandler(const JobPipeline::Handler &_handler)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_handler = _handler;
+
+    return;
+}
+
+bool JobPipeline::GetProgress(const AgvBase::AId_t &_id, size_t &_step)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Job>::const_iterator it = m_jobs.find(_id);
+
+    if(it == m_jobs.end())
+    {
+        return false;
+    }
+
+    _step = it->second.m_current;
+
+    return true;
+}
+
+void JobPipeline::Advance(const AgvBase::AId_t &_id)
+{
+    JobId_t _finished = 0;      /*!< 本次结束的作业 */
+    bool _bSuccess = false;
+    Handler _handler;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,Job>::iterator it = m_jobs.find(_id);
+
+        if(it == m_jobs.end())
+        {
+            return;
+        }
+
+        Job& _job = it->second;
+        AgvBase* _agv = _job.m_pAgv;
+
+        bool _bFailed = _agv->GetError() != AgvBase::Err_None || _agv->GetMode() != AgvBase::Mode_Auto;
+
+        while(_bFailed == false && _job.m_current < _job.m_steps.size())
+        {
+            Step& _step = _job.m_steps[_job.m_current];
+
+            if(_step.m_bSent)
+            {
+                if(IsDone(_agv,_step) == false)
+                {
+                    _step.m_bStarted = true;
+                    break;
+                }
+
+                if(_step.m_bStarted == false)
+                {
+                    // 仍是发送前的状态,如上一步骤相同动作的完成状态,等待AGV开始执行本步骤
+                    break;
+                }
+
+                // 当前步骤完成,立即发送下一步骤
+                ++_job.m_current;
+                continue;
+            }
+
+            if(_step.m_type == Step_Move && IsDone(_agv,_step))
+            {
+                // 已在目的地;动作的完成状态可能属于之前的动作,不能据此跳过
+                ++_job.m_current;
+                continue;
+            }
+
+            RfidBase::Rfid_t _rfid = _agv->GetCurRfid();
+
+            if(_step.m_frame.isEmpty() || _step.m_from != _rfid)
+            {
+                if(_step.m_frame.isEmpty() == false)
+                {
+                    MetricsRegistry::Instance().Add(m_reencoded);
+                }
+
+                Encode(_agv,_step,_rfid);
+            }
+
+            AgvBase::CmdErr _err = _agv->SendCommand(_step.m_frame);
+
+            if(_err == AgvBase::Cmd_StatusErr)
+            {
+                // 等待AGV回到待机状态
+                break;
+            }
+
+            if(_err != AgvBase::Cmd_Success)
+            {
+                _bFailed = true;
+                break;
+            }
+
+            _step.m_bSent = true;
+            _step.m_bStarted = false;
+
+            if(_job.m_current + 1 < _job.m_steps.size())
+            {
+                // 以本步骤完成时的位置预先生成下一步骤的报文
+                Encode(_agv,_job.m_steps[_job.m_current + 1],_step.m_target);
+            }
+
+            break;
+        }
+
+        if(_bFailed || _job.m_current >= _job.m_steps.size())
+        {
+            _finished = _job.m_id;
+            _bSuccess = _bFailed == false;
+            _handler = m_handler;
+
+            QObject::disconnect(_job.m_connection);
+
+            m_jobs.erase(it);
+        }
+    }
+
+    if(_finished == 0)
+    {
+        return;
+    }
+
+    MetricsRegistry::Instance().Add(_bSuccess ? m_completed : m_failed);
+
+    if(_handler)
+    {
+        _handler(_id,_finished,_bSuccess);
+    }
+
+    return;
+}
+
+bool JobPipeline::IsDone(const AgvBase *_agv, const JobPipeline::Step &_step)
+{
+    if(_agv->GetStatus() != AgvBase::Sta_Wait)
+    {
+        return false;
+    }
+
+    if(_step.m_type == Step_Move)
+    {
+        return _agv->GetCurRfid() == _step.m_target;
+    }
+
+    return _agv->GetAction() == _step.m_action && _agv->GetActionStatus() == AgvBase::ActSta_Fin;
+}
+
+void JobPipeline::Encode(const AgvBase *_agv, JobPipeline::Step &_step, const RfidBase::Rfid_t &_from)
+{
+    _step.m_from = _from;
+
+    if(_step.m_type == Step_Move)
+    {
+        _step.m_frame = _agv->CreateMovePacket(_from,_step.m_target);
+    }
+    else
+    {
+        _step.m_frame = _agv->CreateActionPacket(_from,_step.m_action);
+    }
+
+    return;
+}
@@ -0,0 +1,155 @@
+/*!
+ * @file JobPipeline
+ * @brief 描述以状态机执行多步搬运作业功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef JOBPIPELINE_H
+#define JOBPIPELINE_H
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "AgvBase.h"
+
+/*!
+ * @class JobPipeline
+ * @brief 将搬运作业编译为步骤序列并由AGV更新事件推进的作业流水线
+ *
+ * 作业按AGV的子类编译:移动至取货点 → 取货动作 → 移动至卸货点 → 卸货动作,
+ * 取货与卸货的动作码由AgvBase::GetLoadAction、GetUnloadAction提供,无需动作的类型省略该步骤
+ * 流水线在AGV所在的线程中响应Update信号,当前步骤完成时立即发送下一步骤的报文,不需要外部轮询
+ * 发送一个步骤后即以该步骤完成时的位置预先生成下一步骤的报文,实际位置不同时再重新生成
+ */
+class JobPipeline
+{
+public:
+    JobPipeline();
+    ~JobPipeline();
+
+public:
+    typedef unsigned int JobId_t;
+
+    /*! @brief 描述作业步骤类型的枚举 */
+    enum StepType
+    {
+        Step_Move,      /*!< 移动至地标卡 */
+        Step_Action,    /*!< 在地标卡执行动作 */
+    };
+
+    /*! @brief 描述作业步骤的结构体 */
+    struct Step
+    {
+        StepType m_type;                /*!< 类型 */
+        RfidBase::Rfid_t m_target;      /*!< 步骤完成时AGV所在的地标卡 */
+        AgvBase::AAction_t m_action;    /*!< 动作码,仅用于动作步骤 */
+        RfidBase::Rfid_t m_from;        /*!< 生成报文时假定的起始地标卡,由流水线填写 */
+        QByteArray m_frame;             /*!< 预先生成的报文,由流水线填写 */
+        bool m_bSent;                   /*!< 是否已发送,由流水线填写 */
+        bool m_bStarted;                /*!< 发送后是否已看到AGV处于未完成本步骤的状态,由流水线填写 */
+    };
+
+    /*!
+     * @brief 作业结束的处理函数,在AGV所在的线程中调用
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const JobId_t& 作业编号
+     * @param const bool& 完成返回true,因异常或离开自动模式中止返回false
+     */
+    typedef std::function<void(const AgvBase::AId_t&,const JobId_t&,const bool&)> Handler;
+
+protected:
+    /*! @brief 描述执行中作业的结构体 */
+    struct Job
+    {
+        JobId_t m_id;                           /*!< 编号 */
+        AgvBase* m_pAgv;                        /*!< AGV对象 */
+        std::vector<Step> m_steps;              /*!< 步骤 */
+        size_t m_current;                       /*!< 当前步骤 */
+        QMetaObject::Connection m_connection;   /*!< Update信号的连接 */
+    };
+
+protected:
+    std::mutex m_mutex;                                 /*!< 互斥锁 */
+    std::map<AgvBase::AId_t,Job> m_jobs;                /*!< 各AGV执行中的作业 */
+    JobId_t m_nextId;                                   /*!< 下一个作业编号 */
+    Handler m_handler;                                  /*!< 作业结束的处理函数 */
+    MetricsRegistry::MetricId m_completed;              /*!< 完成作业数量的指标 */
+    MetricsRegistry::MetricId m_failed;                 /*!< 中止作业数量的指标 */
+    MetricsRegistry::MetricId m_reencoded;              /*!< 重新生成报文次数的指标 */
+
+public:
+    /*!
+     * @brief 按AGV的类型编译搬运作业
+     * @param const AgvBase* AGV对象
+     * @param const RfidBase::Rfid_t& 取货点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 卸货点RFID地标卡编号
+     * @return std::vector<Step> 作业步骤
+     */
+    static std::vector<Step> Compile(const AgvBase* _agv,const RfidBase::Rfid_t& _pickup,const RfidBase::Rfid_t& _drop);
+
+    /*!
+     * @brief 提交搬运作业
+     * @param AgvBase* AGV对象
+     * @param const RfidBase::Rfid_t& 取货点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 卸货点RFID地标卡编号
+     * @return JobId_t 作业编号,AGV已有执行中的作业时返回0
+     */
+    JobId_t Submit(AgvBase* _agv,const RfidBase::Rfid_t& _pickup,const RfidBase::Rfid_t& _drop);
+
+    /*!
+     * @brief 提交自定义步骤的作业
+     * @param AgvBase* AGV对象
+     * @param const std::vector<Step>& 作业步骤,只需填写类型、地标卡与动作码
+     * @return JobId_t 作业编号,AGV已有执行中的作业或步骤为空时返回0
+     */
+    JobId_t Submit(AgvBase* _agv,const std::vector<Step>& _steps);
+
+    /*!
+     * @brief 取消AGV执行中的作业,已发送的报文不撤回
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool AGV有执行中的作业时返回true
+     */
+    bool Cancel(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 设置作业结束的处理函数
+     * @param const Handler& 处理函数
+     */
+    void SetHandler(const Handler& _handler);
+
+    /*!
+     * @brief 获取AGV执行中作业的当前步骤
+     * @param const AgvBase::AId_t& AGV编号
+     * @param size_t& 当前步骤的下标
+     * @return bool AGV有执行中的作业时返回true
+     */
+    bool GetProgress(const AgvBase::AId_t& _id,size_t& _step);
+
+protected:
+    /*!
+     * @brief 推进AGV的作业,在AGV所在的线程中调用
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Advance(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief AGV的当前状态是否满足步骤完成的条件
+     *
+     * 动作的完成状态可能属于之前的相同动作,调用方需先看到不满足的状态才能认定本步骤完成
+     * @param const AgvBase* AGV对象
+     * @param const Step& 步骤
+     * @return bool 已完成返回true
+     */
+    static bool IsDone(const AgvBase* _agv,const Step& _step);
+
+    /*!
+     * @brief 生成步骤的报文
+     * @param const AgvBase* AGV对象
+     * @param Step& 步骤
+     * @param const RfidBase::Rfid_t& 假定的起始地标卡
+     */
+    static void Encode(const AgvBase* _agv,Step& _step,const RfidBase::Rfid_t& _from);
+};
+
+#endif // JOBPIPELINE_H
@@ -0,0 +1,58 @@
+#include "LifeGuard.h"
+
+LifeGuard::LifeGuard()
+    : m_token(std::make_shared<State>())
+{
+    m_token->m_bAlive = true;
+    m_token->m_users = 0;
+}
+
+LifeGuard::~LifeGuard()
+{
+    Close();
+}
+
+LifeGuard::Scope::Scope(const LifeGuard::Token &_token)
+    : m_token(_token)
+{
+    std::lock_guard<std::mutex> _lock(m_token->m_mutex);
+
+    m_bEntered = m_token->m_bAlive;
+
+    if(m_bEntered)
+    {
+        ++m_token->m_users;
+    }
+}
+
+LifeGuard::Scope::~Scope()
+{
+    if(m_bEntered == false)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> _lock(m_token->m_mutex);
+
+        --m_token->m_users;
+    }
+
+    m_token->m_done.notify_all();
+}
+
+LifeGuard::Token LifeGuard::GetToken() const
+{
+    return m_token;
+}
+
+void LifeGuard::Close()
+{
+    std::unique_lock<std::mutex> _lock(m_token->m_mutex);
+
+    m_token->m_bAlive = false;
+
+    m_token->m_done.wait(_lock,[this]{ return m_token->m_users == 0; });
+
+    return;
+}
@@ -0,0 +1,89 @@
+/*!
+ * @file LifeGuard
+ * @brief 描述跨线程回调存活标记功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef LIFEGUARD_H
+#define LIFEGUARD_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+/*!
+ * @class LifeGuard
+ * @brief 投递到其他线程的回调访问所属对象前的存活标记
+ *
+ * 对象将Token随回调投递,回调以Scope进入后才访问对象,进入失败说明对象已开始析构
+ * 对象析构前调用Close,此后Scope不能进入,并等待已进入的Scope退出,因此回调不会访问已释放的对象
+ * Close不能在Scope内或持有回调需要的锁时调用,否则会死锁
+ */
+class LifeGuard
+{
+public:
+    LifeGuard();
+    ~LifeGuard();
+
+    LifeGuard(const LifeGuard&) = delete;
+    void operator=(const LifeGuard&) = delete;
+
+protected:
+    /*! @brief 描述存活状态的结构体 */
+    struct State
+    {
+        std::mutex m_mutex;                 /*!< 互斥锁 */
+        std::condition_variable m_done;     /*!< Scope退出的条件变量 */
+        bool m_bAlive;                      /*!< 对象是否存活 */
+        size_t m_users;                     /*!< 已进入的Scope数量 */
+    };
+
+public:
+    typedef std::shared_ptr<State> Token;
+
+    /*!
+     * @class Scope
+     * @brief 回调访问对象期间持有的进入标记,存在期间对象不会完成析构
+     */
+    class Scope
+    {
+    public:
+        /*!
+         * @param const Token& 存活标记
+         */
+        explicit Scope(const Token& _token);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        void operator=(const Scope&) = delete;
+
+    protected:
+        Token m_token;          /*!< 存活标记 */
+        bool m_bEntered;        /*!< 是否已进入 */
+
+    public:
+        /*!
+         * @brief 是否已进入,未进入时不能访问对象
+         * @return bool 对象存活返回true
+         */
+        bool IsEntered() const { return m_bEntered; }
+    };
+
+protected:
+    Token m_token;      /*!< 存活标记 */
+
+public:
+    /*!
+     * @brief 获取随回调投递的存活标记
+     * @return Token 存活标记
+     */
+    Token GetToken() const;
+
+    /*!
+     * @brief 标记对象开始析构,并等待已进入的Scope退出,可重复调用
+     */
+    void Close();
+};
+
+#endif // LIFEGUARD_H
@@ -0,0 +1,205 @@
+#include "LinkQuality.h"
+
+#include <cmath>
+
+const double LinkQuality::RTT_BOUNDS[LinkQuality::RTT_BUCKETS - 1] = {5.0,10.0,20.0,50.0,100.0,200.0,500.0};
+
+static const double RTT_GOOD = 50.0;        /*!< 不影响评分的往返时间:单位(ms) */
+static const double RTT_BAD = 1000.0;       /*!< 评分降为0的往返时间:单位(ms) */
+static const double JITTER_GOOD = 20.0;     /*!< 不影响评分的抖动:单位(ms) */
+static const double JITTER_BAD = 500.0;     /*!< 评分降为0的抖动:单位(ms) */
+
+LinkQuality::LinkQuality()
+{
+    m_timeout = std::chrono::milliseconds(3000);
+
+    Reset();
+}
+
+void LinkQuality::SetTimeout(const std::chrono::milliseconds &_timeout)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_timeout = _timeout;
+
+    return;
+}
+
+void LinkQuality::Sent(const Time_t &_time)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_count == MAX_PENDING)
+    {
+        // 队列已满,最早的心跳报文记为丢失
+        m_head = (m_head + 1) % MAX_PENDING;
+        --m_count;
+
+        ++m_stat.m_lost;
+        Push(true);
+    }
+
+    m_pending[(m_head + m_count) % MAX_PENDING] = _time;
+    ++m_count;
+
+    ++m_stat.m_sent;
+
+    return;
+}
+
+bool LinkQuality::Received(const Time_t &_time, double &_rtt)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_count == 0)
+    {
+        // 没有待回复的心跳报文
+        return false;
+    }
+
+    _rtt = std::chrono::duration<double,std::milli>(_time - m_pending[m_head]).count();
+
+    m_head = (m_head + 1) % MAX_PENDING;
+    --m_count;
+
+    if(m_stat.m_received == 0)
+    {
+        m_stat.m_srtt = _rtt;
+        m_stat.m_jitter = 0.0;
+    }
+    else
+    {
+        // 参照RFC3550与RFC6298计算抖动与平滑往返时间
+        m_stat.m_jitter += (std::fabs(_rtt - m_stat.m_rtt) - m_stat.m_jitter) / 16.0;
+        m_stat.m_srtt += (_rtt - m_stat.m_srtt) / 8.0;
+    }
+
+    m_stat.m_rtt = _rtt;
+
+    size_t _bucket = 0;
+
+    while(_bucket < RTT_BUCKETS - 1 && _rtt > RTT_BOUNDS[_bucket])
+    {
+        ++_bucket;
+    }
+
+    ++m_stat.m_histogram[_bucket];
+    ++m_stat.m_received;
+
+    Push(false);
+
+    return true;
+}
+
+size_t LinkQuality::Expire(const Time_t &_time)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    size_t _expired = 0;
+
+    while(m_count > 0 && _time - m_pending[m_head] > m_timeout)
+    {
+        m_head = (m_head + 1) % MAX_PENDING;
+        --m_count;
+
+        ++m_stat.m_lost;
+        ++_expired;
+
+        Push(true);
+    }
+
+    return _expired;
+}
+
+void LinkQuality::Reset()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_head = 0;
+    m_count = 0;
+    m_window = 0;
+    m_windowSize = 0;
+
+    m_stat.m_rtt = 0.0;
+    m_stat.m_srtt = 0.0;
+    m_stat.m_jitter = 0.0;
+    m_stat.m_loss = 0.0;
+    m_stat.m_sent = 0;
+    m_stat.m_received = 0;
+    m_stat.m_lost = 0;
+    m_stat.m_score = 0;
+
+    for(size_t i = 0; i < RTT_BUCKETS; ++i)
+    {
+        m_stat.m_histogram[i] = 0;
+    }
+
+    m_score.store(0);
+
+    return;
+}
+
+LinkQuality::LinkStat LinkQuality::GetStat() const
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_stat;
+}
+
+int LinkQuality::GetScore() const
+{
+    return m_score.load(std::memory_order_relaxed);
+}
+
+void LinkQuality::Push(const bool &_lost)
+{
+    m_window = (m_window << 1) | (_lost ? 1 : 0);
+
+    if(m_windowSize < LOSS_WINDOW)
+    {
+        ++m_windowSize;
+    }
+
+    unsigned long long _mask = m_windowSize >= 64 ? ~0ULL : ((1ULL << m_windowSize) - 1);
+    unsigned long long _bits = m_window & _mask;
+
+    size_t _lostCount = 0;
+
+    for(; _bits; _bits &= _bits - 1)
+    {
+        ++_lostCount;
+    }
+
+    m_stat.m_loss = static_cast<double>(_lostCount) / static_cast<double>(m_windowSize);
+
+    UpdateScore();
+
+    return;
+}
+
+void LinkQuality::UpdateScore()
+{
+    if(m_stat.m_received == 0)
+    {
+        // 未收到任何回复
+        m_stat.m_score = 0;
+        m_score.store(0,std::memory_order_relaxed);
+
+        return;
+    }
+
+    double _rttFactor = 1.0 - (m_stat.m_srtt - RTT_GOOD) / (RTT_BAD - RTT_GOOD);
+    double _jitterFactor = 1.0 - (m_stat.m_jitter - JITTER_GOOD) / (JITTER_BAD - JITTER_GOOD);
+    double _lossFactor = 1.0 - m_stat.m_loss;
+
+    _rttFactor = std::fmin(1.0,std::fmax(0.0,_rttFactor));
+    _jitterFactor = std::fmin(1.0,std::fmax(0.0,_jitterFactor));
+
+    // 丢包对实时任务的影响最大,按平方计入
+    double _score = 100.0 * _lossFactor * _lossFactor * _rttFactor * _jitterFactor;
+
+    m_stat.m_score = static_cast<int>(_score + 0.5);
+    m_score.store(m_stat.m_score,std::memory_order_relaxed);
+
+    return;
+}
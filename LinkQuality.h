@@ -0,0 +1,119 @@
+/*!
+ * @file LinkQuality
+ * @brief 描述AGV通信链路质量统计功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef LINKQUALITY_H
+#define LINKQUALITY_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+/*!
+ * @class LinkQuality
+ * @brief 统计心跳报文往返时间并评估链路质量的类
+ *
+ * 心跳报文没有序号,回复按发送顺序与未回复的心跳报文配对
+ * 超过超时时间未回复的心跳报文视为丢失,发送与接收前应先调用Expire,避免与过期的心跳报文配对
+ */
+class LinkQuality
+{
+public:
+    LinkQuality();
+
+public:
+    typedef std::chrono::steady_clock::time_point Time_t;
+
+    static const size_t MAX_PENDING = 32;   /*!< 未回复心跳报文的最大数量 */
+    static const size_t LOSS_WINDOW = 64;   /*!< 计算丢包率的心跳报文数量 */
+    static const size_t RTT_BUCKETS = 8;    /*!< 往返时间直方图的桶数量 */
+    static const double RTT_BOUNDS[RTT_BUCKETS - 1];   /*!< 往返时间直方图的桶上限:单位(ms) */
+
+    /*! @brief 描述链路统计信息的结构体 */
+    struct LinkStat
+    {
+        double m_rtt;                               /*!< 最近一次往返时间:单位(ms) */
+        double m_srtt;                              /*!< 平滑往返时间:单位(ms) */
+        double m_jitter;                            /*!< 往返时间抖动:单位(ms) */
+        double m_loss;                              /*!< 丢包率:0~1 */
+        unsigned long long m_sent;                  /*!< 发送的心跳报文数量 */
+        unsigned long long m_received;              /*!< 收到回复的心跳报文数量 */
+        unsigned long long m_lost;                  /*!< 丢失的心跳报文数量 */
+        unsigned long long m_histogram[RTT_BUCKETS];/*!< 往返时间直方图 */
+        int m_score;                                /*!< 链路质量评分:0~100 */
+    };
+
+protected:
+    mutable std::mutex m_mutex;             /*!< 互斥锁 */
+    Time_t m_pending[MAX_PENDING];          /*!< 未回复心跳报文的发送时间,环形队列 */
+    size_t m_head;                          /*!< 环形队列的队首 */
+    size_t m_count;                         /*!< 环形队列的元素数量 */
+    unsigned long long m_window;            /*!< 最近的心跳报文是否丢失,按位储存 */
+    size_t m_windowSize;                    /*!< 窗口内有效的位数 */
+    std::chrono::milliseconds m_timeout;    /*!< 心跳报文超时时间 */
+    LinkStat m_stat;                        /*!< 统计信息 */
+    std::atomic<int> m_score;               /*!< 链路质量评分,可在任意线程读取 */
+
+public:
+    /*!
+     * @brief 设置心跳报文超时时间
+     * @param const std::chrono::milliseconds& 超时时间
+     */
+    void SetTimeout(const std::chrono::milliseconds& _timeout);
+
+    /*!
+     * @brief 记录心跳报文的发送
+     * @param const Time_t& 发送时间
+     */
+    void Sent(const Time_t& _time);
+
+    /*!
+     * @brief 记录心跳报文的回复
+     * @param const Time_t& 接收时间
+     * @param double& 往返时间:单位(ms)
+     * @return bool 配对成功返回true,无未回复的心跳报文时返回false
+     */
+    bool Received(const Time_t& _time,double& _rtt);
+
+    /*!
+     * @brief 将超时未回复的心跳报文记为丢失
+     * @param const Time_t& 当前时间
+     * @return size_t 本次记为丢失的心跳报文数量
+     */
+    size_t Expire(const Time_t& _time);
+
+    /*!
+     * @brief 清除未回复的心跳报文与统计信息
+     */
+    void Reset();
+
+    /*!
+     * @brief 获取统计信息
+     * @return LinkStat 统计信息
+     */
+    LinkStat GetStat() const;
+
+    /*!
+     * @brief 获取链路质量评分
+     *
+     * 综合丢包率、平滑往返时间与抖动计算,100为最佳,0为链路不可用
+     * @return int 链路质量评分
+     */
+    int GetScore() const;
+
+protected:
+    /*!
+     * @brief 记录一次心跳报文的结果
+     * @param const bool& 是否丢失
+     */
+    void Push(const bool& _lost);
+
+    /*!
+     * @brief 重新计算链路质量评分
+     */
+    void UpdateScore();
+};
+
+#endif // LINKQUALITY_H
@@ -0,0 +1,267 @@
+#include "LockLease.h"
+
+LockLease::LockLease(RfidRegistry &_registry, TimingWheel &_wheel, const std::chrono::milliseconds &_ttl)
+    : m_registry(_registry),m_wheel(_wheel),m_timers(RfidRegistry::RFID_COUNT,TimingWheel::INVALID_TIMER)
+{
+    m_ttl = _ttl;
+    m_pMap = nullptr;
+    m_radius = 0.0f;
+    m_count = 0;
+    m_expired = 0;
+    m_bStopped = false;
+    m_metric = MetricsRegistry::Instance().AddCounter("agv_lock_leases_expired_total","Landmark locks reclaimed after their lease expired");
+}
+
+LockLease::~LockLease()
+{
+    std::vector<TimingWheel::TimerId> _timers;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        m_bStopped = true;
+
+        for(std::map<AgvBase::AId_t,Holder>::iterator it = m_holders.begin(); it != m_holders.end(); ++it)
+        {
+            QObject::disconnect(it->second.m_connection);
+        }
+
+        for(std::vector<TimingWheel::TimerId>::iterator it = m_timers.begin(); it != m_timers.end(); ++it)
+        {
+            if(*it != TimingWheel::INVALID_TIMER)
+            {
+                _timers.push_back(*it);
+            }
+        }
+
+        m_holders.clear();
+    }
+
+    // 不持有锁等待正在执行的Check返回,Check看到m_bStopped后不再启动定时器
+    for(std::vector<TimingWheel::TimerId>::iterator it = _timers.begin(); it != _timers.end(); ++it)
+    {
+        m_wheel.CancelSync(*it);
+    }
+}
+
+void LockLease::SetTtl(const std::chrono::milliseconds &_ttl)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_ttl = _ttl;
+
+    return;
+}
+
+void LockLease::SetMap(const RfidMap *_map, const float &_radius)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_pMap = _map;
+    m_radius = _radius;
+
+    return;
+}
+
+void LockLease::Watch(AgvBase *_agv)
+{
+    if(_agv == nullptr)
+    {
+        return;
+    }
+
+    AgvBase::AId_t _id = _agv->GetID();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    Holder& _holder = m_holders[_id];
+
+    QObject::disconnect(_holder.m_connection);
+
+    _holder.m_pAgv = _agv;
+    _holder.m_rfid = _agv->GetCurRfid();
+
+    // 在AGV所在的线程中记录当前地标卡,到期检查时无需访问AGV对象
+    _holder.m_connection = QObject::connect(_agv,&AgvBase::RfidChanged,[this,_agv,_id]{
+        RfidBase::Rfid_t _rfid = _agv->GetCurRfid();
+
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,Holder>::iterator it = m_holders.find(_id);
+
+        if(it != m_holders.end())
+        {
+            it->second.m_rfid = _rfid;
+        }
+    });
+
+    return;
+}
+
+void LockLease::Unwatch(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Holder>::iterator it = m_holders.find(_id);
+
+    if(it == m_holders.end())
+    {
+        return;
+    }
+
+    QObject::disconnect(it->second.m_connection);
+
+    m_holders.erase(it);
+
+    return;
+}
+
+bool LockLease::Lock(const RfidBase::Rfid_t &_rfid, const AgvBase::AId_t &_agv)
+{
+    if(m_registry.Lock(_rfid,_agv) == false)
+    {
+        return false;
+    }
+
+    Grant(_rfid);
+
+    return true;
+}
+
+void LockLease::Grant(const RfidBase::Rfid_t &_rfid)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_timers[_rfid] != TimingWheel::INVALID_TIMER)
+    {
+        // 已有租约,到期时按锁定者重新检查
+        return;
+    }
+
+    m_timers[_rfid] = m_wheel.Start(m_ttl,[this,_rfid]{ Check(_rfid); });
+
+    ++m_count;
+
+    return;
+}
+
+bool LockLease::Free(const RfidBase::Rfid_t &_rfid, const AgvBase::AId_t &_agv)
+{
+    if(m_registry.Free(_rfid,_agv) == false)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_timers[_rfid] != TimingWheel::INVALID_TIMER && m_registry.IsLocked(_rfid) == false)
+    {
+        m_wheel.Cancel(m_timers[_rfid]);
+        m_timers[_rfid] = TimingWheel::INVALID_TIMER;
+
+        --m_count;
+    }
+
+    return true;
+}
+
+size_t LockLease::GetCount()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_count;
+}
+
+size_t LockLease::GetExpiredCount()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_expired;
+}
+
+void LockLease::Check(const RfidBase::Rfid_t &_rfid)
+{
+    bool _bExpired = false;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        if(m_bStopped)
+        {
+            return;
+        }
+
+        m_timers[_rfid] = TimingWheel::INVALID_TIMER;
+
+        AgvBase::AId_t _locker = m_registry.GetLocker(_rfid);
+
+        if(_locker == RfidRegistry::NOBODY)
+        {
+            // 已被直接释放
+            --m_count;
+            return;
+        }
+
+        // 锁定时间视为第一次续约
+        std::chrono::steady_clock::time_point _renewed = m_registry.GetLockTime(_rfid);
+
+        std::map<AgvBase::AId_t,Holder>::const_iterator it = m_holders.find(_locker);
+
+        if(it != m_holders.end() && IsNear(it->second.m_rfid,_rfid))
+        {
+            std::chrono::steady_clock::time_point _heartbeat = it->second.m_pAgv->GetLastHeartbeat();
+
+            if(_heartbeat > _renewed)
+            {
+                _renewed = _heartbeat;
+            }
+        }
+
+        std::chrono::milliseconds _elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - _renewed);
+
+        if(_elapsed < m_ttl)
+        {
+            // 期限内已续约,从最后一次续约开始重新计时
+            m_timers[_rfid] = m_wheel.Start(m_ttl - _elapsed,[this,_rfid]{ Check(_rfid); });
+
+            return;
+        }
+
+        // 只释放到期时的锁定者,期间易主的锁定不受影响
+        m_registry.Free(_rfid,_locker);
+
+        --m_count;
+        ++m_expired;
+
+        _bExpired = true;
+    }
+
+    if(_bExpired)
+    {
+        MetricsRegistry::Instance().Add(m_metric);
+    }
+
+    return;
+}
+
+bool LockLease::IsNear(const RfidBase::Rfid_t &_cur, const RfidBase::Rfid_t &_rfid) const
+{
+    if(m_pMap == nullptr || _cur == _rfid)
+    {
+        return true;
+    }
+
+    RfidMap::Node_t _from = m_pMap->GetNode(_cur);
+    RfidMap::Node_t _to = m_pMap->GetNode(_rfid);
+
+    if(_from == RfidMap::NIL || _to == RfidMap::NIL)
+    {
+        return false;
+    }
+
+    float _dx = m_pMap->GetX(_from) - m_pMap->GetX(_to);
+    float _dy = m_pMap->GetY(_from) - m_pMap->GetY(_to);
+
+    return _dx * _dx + _dy * _dy <= m_radius * m_radius;
+}
@@ -0,0 +1,142 @@
+/*!
+ * @file LockLease
+ * @brief 描述RFID地标卡锁定租约功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef LOCKLEASE_H
+#define LOCKLEASE_H
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "RfidMap.h"
+#include "RfidRegistry.h"
+#include "TimingWheel.h"
+
+/*!
+ * @class LockLease
+ * @brief 为RFID地标卡的锁定附加有效期的租约管理器
+ *
+ * 每个租约占用时间轮中的一个定时器,到期时才检查锁定者在期限内是否有心跳回复且位于地标卡上或附近:
+ * 满足时从最后一次心跳回复开始重新计时,否则由注册表释放锁定;收到心跳回复时无需任何操作
+ * 到期处理只涉及到期的租约,与地标卡总数无关
+ */
+class LockLease
+{
+public:
+    /*!
+     * @param RfidRegistry& RFID地标卡注册表
+     * @param TimingWheel& 共用的时间轮
+     * @param const std::chrono::milliseconds& 租约的有效期
+     */
+    LockLease(RfidRegistry& _registry,TimingWheel& _wheel,const std::chrono::milliseconds& _ttl = std::chrono::milliseconds(5000));
+    ~LockLease();
+
+protected:
+    /*! @brief 描述锁定者的结构体 */
+    struct Holder
+    {
+        AgvBase* m_pAgv;                        /*!< AGV对象 */
+        RfidBase::Rfid_t m_rfid;                /*!< AGV的当前地标卡 */
+        QMetaObject::Connection m_connection;   /*!< 当前地标卡改变信号的连接 */
+    };
+
+protected:
+    RfidRegistry& m_registry;                           /*!< RFID地标卡注册表 */
+    TimingWheel& m_wheel;                               /*!< 时间轮 */
+    std::chrono::milliseconds m_ttl;                    /*!< 租约的有效期 */
+    const RfidMap* m_pMap;                              /*!< 判断锁定者是否在地标卡附近的路线图 */
+    float m_radius;                                     /*!< 附近的范围:单位(mm) */
+    std::mutex m_mutex;                                 /*!< 互斥锁 */
+    std::vector<TimingWheel::TimerId> m_timers;         /*!< 各地标卡租约的定时器,无租约时为INVALID_TIMER */
+    std::map<AgvBase::AId_t,Holder> m_holders;          /*!< 可续约的AGV */
+    size_t m_count;                                     /*!< 租约数量 */
+    size_t m_expired;                                   /*!< 到期释放的租约数量 */
+    MetricsRegistry::MetricId m_metric;                 /*!< 到期释放数量的指标 */
+    bool m_bStopped;                                    /*!< 已开始析构,不再重新启动定时器 */
+
+public:
+    /*!
+     * @brief 设置租约的有效期
+     *
+     * 新的有效期在各租约下一次检查时生效
+     * @param const std::chrono::milliseconds& 有效期
+     */
+    void SetTtl(const std::chrono::milliseconds& _ttl);
+
+    /*!
+     * @brief 设置判断锁定者是否在地标卡附近的路线图与范围
+     *
+     * 未设置时,锁定者的任意心跳回复均可续约
+     * @param const RfidMap* 路线图,为nullptr时不判断位置
+     * @param const float& 范围:单位(mm),0为只允许位于地标卡上
+     */
+    void SetMap(const RfidMap* _map,const float& _radius);
+
+    /*!
+     * @brief 以AGV的心跳回复与当前地标卡为其租约续约
+     * @param AgvBase* AGV对象
+     */
+    void Watch(AgvBase* _agv);
+
+    /*!
+     * @brief 停止为AGV的租约续约,其租约在有效期后到期
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Unwatch(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 锁定RFID地标卡并附加租约
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool 锁定成功返回true,否则返回false
+     */
+    bool Lock(const RfidBase::Rfid_t& _rfid,const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 为已锁定的RFID地标卡附加租约,供直接操作注册表的调用方使用
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Grant(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 释放RFID地标卡并取消租约
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool 未被其他AGV锁定返回true,否则返回false
+     */
+    bool Free(const RfidBase::Rfid_t& _rfid,const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 获取租约数量
+     * @return size_t 租约数量
+     */
+    size_t GetCount();
+
+    /*!
+     * @brief 获取到期释放的租约数量
+     * @return size_t 租约数量
+     */
+    size_t GetExpiredCount();
+
+protected:
+    /*!
+     * @brief 检查租约是否到期
+     *
+     * 在时间轮的推进线程中执行
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Check(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 锁定者是否位于地标卡上或附近,调用方需持有锁
+     * @param const RfidBase::Rfid_t& 锁定者的当前地标卡
+     * @param const RfidBase::Rfid_t& 租约的地标卡
+     * @return bool 位于地标卡上或附近返回true
+     */
+    bool IsNear(const RfidBase::Rfid_t& _cur,const RfidBase::Rfid_t& _rfid) const;
+};
+
+#endif // LOCKLEASE_H
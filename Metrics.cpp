@@ -0,0 +1,478 @@
+#include "Metrics.h"
+
+#include <QTcpSocket>
+#include <map>
+#include <sstream>
+
+const MetricsRegistry::MetricId MetricsRegistry::INVALID_ID = static_cast<MetricsRegistry::MetricId>(-1);
+
+MetricsRegistry::MetricsRegistry()
+{
+    m_used = 0;
+    m_failures = INVALID_ID;
+
+    for(size_t i = 0; i < MAX_SERIES; ++i)
+    {
+        // 未注册的指标序列指向最后两个计数单元(计数与直方图的观测值之和),这两个计数单元不会被分配
+        m_slots[i].m_slot = MAX_SLOTS - 2;
+        m_slots[i].m_size = 0;
+        m_slots[i].m_pBounds = nullptr;
+    }
+
+    for(size_t i = 0; i < MAX_SLOTS; ++i)
+    {
+        m_gauges[i].store(0,std::memory_order_relaxed);
+    }
+
+    m_failures = AddCounter("agv_metrics_register_failures_total","Metric series not registered because the registry was full");
+}
+
+MetricsRegistry::~MetricsRegistry()
+{
+    for(std::vector<ThreadBlock*>::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+    {
+        for(size_t i = 0; i < MAX_PAGES; ++i)
+        {
+            delete (*it)->m_pages[i].load();
+        }
+
+        delete *it;
+    }
+}
+
+MetricsRegistry &MetricsRegistry::Instance()
+{
+    static MetricsRegistry _registry;
+
+    return _registry;
+}
+
+MetricsRegistry::MetricId MetricsRegistry::AddCounter(const std::string &_name, const std::string &_help, const std::string &_labels)
+{
+    Series _series;
+    _series.m_name = _name;
+    _series.m_help = _help;
+    _series.m_labels = _labels;
+    _series.m_type = Metric_Counter;
+    _series.m_bRemoved = false;
+
+    return Register(_series,1);
+}
+
+MetricsRegistry::MetricId MetricsRegistry::AddGauge(const std::string &_name, const std::string &_help, const std::string &_labels)
+{
+    Series _series;
+    _series.m_name = _name;
+    _series.m_help = _help;
+    _series.m_labels = _labels;
+    _series.m_type = Metric_Gauge;
+    _series.m_bRemoved = false;
+
+    return Register(_series,1);
+}
+
+MetricsRegistry::MetricId MetricsRegistry::AddHistogram(const std::string &_name, const std::string &_help, const std::vector<double> &_bounds, const std::string &_labels)
+{
+    Series _series;
+    _series.m_name = _name;
+    _series.m_help = _help;
+    _series.m_labels = _labels;
+    _series.m_type = Metric_Histogram;
+    _series.m_bounds = _bounds;
+    _series.m_bRemoved = false;
+
+    // 桶 + 正无穷桶 + 观测值之和
+    return Register(_series,_bounds.size() + 2);
+}
+
+MetricsRegistry::MetricId MetricsRegistry::Register(const Series &_series, const size_t &_slots)
+{
+    MetricId _id = INVALID_ID;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        size_t _begin = m_used;
+        std::map<size_t,std::vector<size_t> >::iterator _free = m_freeSlots.find(_slots);
+
+        if(_free != m_freeSlots.end() && _free->second.empty() == false)
+        {
+            // 重用已删除的同样大小的序列的计数单元
+            _begin = _free->second.back();
+        }
+        else if(_begin / PAGE_SLOTS != (_begin + _slots - 1) / PAGE_SLOTS)
+        {
+            // 同一指标的计数单元不跨页,采集时只需访问一页
+            _begin = (_begin / PAGE_SLOTS + 1) * PAGE_SLOTS;
+        }
+
+        if(_slots > PAGE_SLOTS || _begin + _slots > MAX_SLOTS - 2 || (m_freeIds.empty() && m_series.size() >= MAX_SERIES))
+        {
+            // 序列数量或计数单元不足
+            _id = INVALID_ID;
+        }
+        else
+        {
+            if(_free != m_freeSlots.end() && _free->second.empty() == false)
+            {
+                _free->second.pop_back();
+            }
+            else
+            {
+                m_used = _begin + _slots;
+            }
+
+            if(m_freeIds.empty())
+            {
+                m_series.push_back(_series);
+                _id = m_series.size() - 1;
+            }
+            else
+            {
+                _id = m_freeIds.back();
+                m_freeIds.pop_back();
+                m_series[_id] = _series;
+            }
+
+            m_series[_id].m_slot = _begin;
+
+            m_slots[_id].m_slot = _begin;
+            m_slots[_id].m_size = m_series[_id].m_bounds.size();
+            m_slots[_id].m_pBounds = m_series[_id].m_bounds.data();
+        }
+    }
+
+    if(_id == INVALID_ID)
+    {
+        // 累加时可能首次分配本线程的计数区,需在锁外进行
+        Add(m_failures);
+    }
+
+    return _id;
+}
+
+void MetricsRegistry::Remove(const MetricId &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(_id >= m_series.size() || m_series[_id].m_bRemoved)
+    {
+        return;
+    }
+
+    Series& _series = m_series[_id];
+
+    size_t _slots = _series.m_type == Metric_Histogram ? _series.m_bounds.size() + 2 : 1;
+
+    // 误用的编号写入不会被分配的计数单元
+    m_slots[_id].m_slot = MAX_SLOTS - 2;
+    m_slots[_id].m_size = 0;
+    m_slots[_id].m_pBounds = nullptr;
+
+    // 重用时从0开始计数
+    Clear(_series.m_slot,_slots);
+
+    _series.m_bRemoved = true;
+
+    m_freeSlots[_slots].push_back(_series.m_slot);
+    m_freeIds.push_back(_id);
+
+    return;
+}
+
+void MetricsRegistry::Clear(const size_t &_slot, const size_t &_slots)
+{
+    for(std::vector<ThreadBlock*>::const_iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+    {
+        SlotPage* _page = (*it)->m_pages[_slot / PAGE_SLOTS].load(std::memory_order_acquire);
+
+        if(_page == nullptr)
+        {
+            continue;
+        }
+
+        for(size_t i = 0; i < _slots; ++i)
+        {
+            _page->m_slots[(_slot + i) % PAGE_SLOTS].store(0,std::memory_order_relaxed);
+        }
+    }
+
+    for(size_t i = 0; i < _slots; ++i)
+    {
+        m_gauges[_slot + i].store(0,std::memory_order_relaxed);
+    }
+
+    return;
+}
+
+MetricsRegistry::ThreadBlock *MetricsRegistry::GetBlock()
+{
+    static thread_local ThreadBlock* _block = nullptr;
+
+    if(_block == nullptr)
+    {
+        _block = new ThreadBlock();
+
+        for(size_t i = 0; i < MAX_PAGES; ++i)
+        {
+            _block->m_pages[i].store(nullptr,std::memory_order_relaxed);
+        }
+
+        // 线程退出后计数区仍然保留,保证计数器单调递增
+        std::lock_guard<std::mutex> _lock(m_mutex);
+        m_blocks.push_back(_block);
+    }
+
+    return _block;
+}
+
+std::atomic<unsigned long long> &MetricsRegistry::GetSlot(const size_t &_slot)
+{
+    ThreadBlock* _block = GetBlock();
+    std::atomic<SlotPage*>& _ptr = _block->m_pages[_slot / PAGE_SLOTS];
+    SlotPage* _page = _ptr.load(std::memory_order_relaxed);
+
+    if(_page == nullptr)
+    {
+        _page = new SlotPage();
+
+        for(size_t i = 0; i < PAGE_SLOTS; ++i)
+        {
+            _page->m_slots[i].store(0,std::memory_order_relaxed);
+        }
+
+        _ptr.store(_page,std::memory_order_release);
+    }
+
+    return _page->m_slots[_slot % PAGE_SLOTS];
+}
+
+void MetricsRegistry::Add(const MetricId &_id, const unsigned long long &_value)
+{
+    if(_id >= MAX_SERIES)
+    {
+        return;
+    }
+
+    // 计数单元仅由本线程写入,无需原子累加指令
+    std::atomic<unsigned long long>& _slot = GetSlot(m_slots[_id].m_slot);
+    _slot.store(_slot.load(std::memory_order_relaxed) + _value,std::memory_order_relaxed);
+
+    return;
+}
+
+void MetricsRegistry::Set(const MetricId &_id, const long long &_value)
+{
+    if(_id >= MAX_SERIES)
+    {
+        return;
+    }
+
+    m_gauges[m_slots[_id].m_slot].store(_value,std::memory_order_relaxed);
+
+    return;
+}
+
+void MetricsRegistry::Observe(const MetricId &_id, const double &_value)
+{
+    if(_id >= MAX_SERIES)
+    {
+        return;
+    }
+
+    const SeriesSlot& _series = m_slots[_id];
+
+    size_t _bucket = 0;
+
+    while(_bucket < _series.m_size && _value > _series.m_pBounds[_bucket])
+    {
+        ++_bucket;
+    }
+
+    std::atomic<unsigned long long>& _count = GetSlot(_series.m_slot + _bucket);
+    _count.store(_count.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+
+    // 观测值之和以百万分之一为单位储存
+    std::atomic<unsigned long long>& _sum = GetSlot(_series.m_slot + _series.m_size + 1);
+    _sum.store(_sum.load(std::memory_order_relaxed) + static_cast<unsigned long long>(_value * 1000000.0),std::memory_order_relaxed);
+
+    return;
+}
+
+unsigned long long MetricsRegistry::Sum(const size_t &_slot) const
+{
+    unsigned long long _sum = 0;
+
+    for(std::vector<ThreadBlock*>::const_iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+    {
+        SlotPage* _page = (*it)->m_pages[_slot / PAGE_SLOTS].load(std::memory_order_acquire);
+
+        if(_page)
+        {
+            _sum += _page->m_slots[_slot % PAGE_SLOTS].load(std::memory_order_relaxed);
+        }
+    }
+
+    return _sum;
+}
+
+std::string MetricsRegistry::Scrape() const
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    // 同名的指标序列输出在一起
+    std::map<std::string,std::vector<size_t> > _families;
+
+    for(size_t i = 0; i < m_series.size(); ++i)
+    {
+        if(m_series[i].m_bRemoved == false)
+        {
+            _families[m_series[i].m_name].push_back(i);
+        }
+    }
+
+    std::ostringstream _out;
+
+    for(std::map<std::string,std::vector<size_t> >::const_iterator it = _families.begin(); it != _families.end(); ++it)
+    {
+        const Series& _first = m_series[it->second.front()];
+
+        _out << "# HELP " << _first.m_name << " " << _first.m_help << "\n";
+
+        switch(_first.m_type)
+        {
+        case Metric_Counter:
+            _out << "# TYPE " << _first.m_name << " counter\n";
+            break;
+        case Metric_Gauge:
+            _out << "# TYPE " << _first.m_name << " gauge\n";
+            break;
+        case Metric_Histogram:
+            _out << "# TYPE " << _first.m_name << " histogram\n";
+            break;
+        }
+
+        for(std::vector<size_t>::const_iterator _index = it->second.begin(); _index != it->second.end(); ++_index)
+        {
+            const Series& _series = m_series[*_index];
+            std::string _labels = _series.m_labels.empty() ? "" : "{" + _series.m_labels + "}";
+
+            switch(_series.m_type)
+            {
+            case Metric_Counter:
+                _out << _series.m_name << _labels << " " << Sum(_series.m_slot) << "\n";
+                break;
+            case Metric_Gauge:
+                _out << _series.m_name << _labels << " " << m_gauges[_series.m_slot].load(std::memory_order_relaxed) << "\n";
+                break;
+            case Metric_Histogram:
+            {
+                std::string _prefix = _series.m_labels.empty() ? "" : _series.m_labels + ",";
+                unsigned long long _count = 0;
+
+                for(size_t i = 0; i <= _series.m_bounds.size(); ++i)
+                {
+                    _count += Sum(_series.m_slot + i);
+
+                    _out << _series.m_name << "_bucket{" << _prefix << "le=\"";
+
+                    if(i < _series.m_bounds.size())
+                    {
+                        _out << _series.m_bounds[i];
+                    }
+                    else
+                    {
+                        _out << "+Inf";
+                    }
+
+                    _out << "\"} " << _count << "\n";
+                }
+
+                _out << _series.m_name << "_sum" << _labels << " " << Sum(_series.m_slot + _series.m_bounds.size() + 1) / 1000000.0 << "\n";
+                _out << _series.m_name << "_count" << _labels << " " << _count << "\n";
+                break;
+            }
+            }
+        }
+    }
+
+    return _out.str();
+}
+
+MetricsServer::MetricsServer(QObject *parent) : QObject(parent)
+{
+    connect(&m_server,SIGNAL(newConnection()),this,SLOT(NewConnection()));
+}
+
+MetricsServer::~MetricsServer()
+{
+    Close();
+}
+
+bool MetricsServer::Listen(const unsigned short &_port)
+{
+    if(m_server.isListening())
+    {
+        return true;
+    }
+
+    // 指标数据仅对本机开放
+    return m_server.listen(QHostAddress::LocalHost,_port);
+}
+
+void MetricsServer::Close()
+{
+    m_server.close();
+
+    return;
+}
+
+void MetricsServer::NewConnection()
+{
+    while(m_server.hasPendingConnections())
+    {
+        QTcpSocket* _socket = m_server.nextPendingConnection();
+
+        connect(_socket,SIGNAL(readyRead()),this,SLOT(ReadRequest()));
+        connect(_socket,SIGNAL(disconnected()),_socket,SLOT(deleteLater()));
+    }
+
+    return;
+}
+
+void MetricsServer::ReadRequest()
+{
+    QTcpSocket* _socket = qobject_cast<QTcpSocket*>(sender());
+
+    if(_socket == nullptr)
+    {
+        return;
+    }
+
+    QByteArray _request = _socket->readAll();
+
+    std::ostringstream _response;
+
+    if(_request.startsWith("GET "))
+    {
+        std::string _body = MetricsRegistry::Instance().Scrape();
+
+
+        _response << "HTTP/1.0 200 OK\r\n"
+                  << "Content-Type: text/plain; version=0.0.4\r\n"
+                  << "Content-Length: " << _body.size() << "\r\n"
+                  << "Connection: close\r\n\r\n"
+                  << _body;
+    }
+    else
+    {
+        _response << "HTTP/1.0 405 Method Not Allowed\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    }
+
+    std::string _data = _response.str();
+
+    _socket->write(_data.data(),static_cast<qint64>(_data.size()));
+    _socket->disconnectFromHost();
+
+    return;
+}
@@ -0,0 +1,250 @@
+/*!
+ * @file Metrics
+ * @brief 描述系统运行指标的统计与发布功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*!
+ * @class MetricsRegistry
+ * @brief 运行指标的注册表
+ *
+ * 计数器与直方图按线程分别累加,各线程只写入自己的计数区,互不竞争缓存行
+ * 采集时汇总所有线程的计数区,并以Prometheus文本格式输出
+ * 序列数量或计数单元不足时注册失败,失败次数计入agv_metrics_register_failures_total;
+ * 按对象建立的序列应在对象销毁时删除,释放的编号与计数单元由之后注册的序列重用
+ */
+class MetricsRegistry
+{
+public:
+    typedef size_t MetricId;
+
+    static const MetricId INVALID_ID;       /*!< 无效的指标编号 */
+    static const size_t PAGE_SLOTS = 256;   /*!< 每页计数单元的数量 */
+    static const size_t MAX_PAGES = 256;    /*!< 计数区的最大页数 */
+    static const size_t MAX_SLOTS = PAGE_SLOTS * MAX_PAGES;    /*!< 计数区的最大计数单元数量 */
+    static const size_t MAX_SERIES = 16384; /*!< 指标序列的最大数量 */
+
+    /*! @brief 描述指标类型的枚举 */
+    enum MetricType
+    {
+        Metric_Counter,     /*!< 计数器 */
+        Metric_Gauge,       /*!< 仪表 */
+        Metric_Histogram,   /*!< 直方图 */
+    };
+
+protected:
+    /*! @brief 描述指标序列的结构体 */
+    struct Series
+    {
+        std::string m_name;             /*!< 名称 */
+        std::string m_help;             /*!< 说明 */
+        std::string m_labels;           /*!< 标签,如 agv="1" */
+        MetricType m_type;              /*!< 类型 */
+        MetricId m_slot;                /*!< 起始计数单元 */
+        std::vector<double> m_bounds;   /*!< 直方图的桶上限 */
+        bool m_bRemoved;                /*!< 是否已删除 */
+    };
+
+    /*! @brief 描述累加指标时所需信息的结构体,注册后不再改变 */
+    struct SeriesSlot
+    {
+        size_t m_slot;                  /*!< 起始计数单元 */
+        size_t m_size;                  /*!< 直方图的桶数量 */
+        const double* m_pBounds;        /*!< 直方图的桶上限 */
+    };
+
+    /*! @brief 描述计数区中一页计数单元的结构体 */
+    struct SlotPage
+    {
+        std::atomic<unsigned long long> m_slots[PAGE_SLOTS];   /*!< 计数单元 */
+    };
+
+    /*!
+     * @brief 描述线程计数区的结构体
+     *
+     * 计数页在线程首次写入时才分配,每个线程通常只会写入少数几页
+     */
+    struct ThreadBlock
+    {
+        std::atomic<SlotPage*> m_pages[MAX_PAGES];  /*!< 计数页 */
+    };
+
+protected:
+    MetricsRegistry();
+    ~MetricsRegistry();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    void operator=(const MetricsRegistry&) = delete;
+
+protected:
+    mutable std::mutex m_mutex;                         /*!< 注册表互斥锁 */
+    std::deque<Series> m_series;                        /*!< 已注册的指标序列 */
+    SeriesSlot m_slots[MAX_SERIES];                     /*!< 指标序列的计数单元信息 */
+    std::vector<ThreadBlock*> m_blocks;                 /*!< 各线程的计数区 */
+    std::atomic<long long> m_gauges[MAX_SLOTS];         /*!< 仪表的当前值 */
+    size_t m_used;                                      /*!< 已分配的计数单元数量 */
+    std::vector<MetricId> m_freeIds;                    /*!< 已删除可重用的指标编号 */
+    std::map<size_t,std::vector<size_t> > m_freeSlots;  /*!< 已删除可重用的起始计数单元,按计数单元数量分组 */
+    MetricId m_failures;                                /*!< 注册失败次数的指标 */
+
+public:
+    /*!
+     * @brief 获取全局注册表
+     * @return MetricsRegistry& 全局注册表
+     */
+    static MetricsRegistry& Instance();
+
+public:
+    /*!
+     * @brief 注册计数器
+     * @param const std::string& 名称
+     * @param const std::string& 说明
+     * @param const std::string& 标签
+     * @return MetricId 指标编号,序列数量或计数单元不足时返回INVALID_ID
+     */
+    MetricId AddCounter(const std::string& _name,const std::string& _help,const std::string& _labels = "");
+
+    /*!
+     * @brief 注册仪表
+     * @param const std::string& 名称
+     * @param const std::string& 说明
+     * @param const std::string& 标签
+     * @return MetricId 指标编号,序列数量或计数单元不足时返回INVALID_ID
+     */
+    MetricId AddGauge(const std::string& _name,const std::string& _help,const std::string& _labels = "");
+
+    /*!
+     * @brief 注册直方图
+     * @param const std::string& 名称
+     * @param const std::string& 说明
+     * @param const std::vector<double>& 桶上限,需按升序排列
+     * @param const std::string& 标签
+     * @return MetricId 指标编号,序列数量或计数单元不足时返回INVALID_ID
+     */
+    MetricId AddHistogram(const std::string& _name,const std::string& _help,const std::vector<double>& _bounds,const std::string& _labels = "");
+
+    /*!
+     * @brief 删除指标序列,不再输出
+     *
+     * 编号会被之后注册的序列重用,删除后不可再以该编号累加、设置或记录
+     * @param const MetricId& 指标编号,INVALID_ID或已删除时不做处理
+     */
+    void Remove(const MetricId& _id);
+
+public:
+    /*!
+     * @brief 计数器累加
+     * @param const MetricId& 指标编号
+     * @param const unsigned long long& 累加值
+     */
+    void Add(const MetricId& _id,const unsigned long long& _value = 1);
+
+    /*!
+     * @brief 设置仪表的值
+     * @param const MetricId& 指标编号
+     * @param const long long& 新的值
+     */
+    void Set(const MetricId& _id,const long long& _value);
+
+    /*!
+     * @brief 记录直方图的观测值
+     * @param const MetricId& 指标编号
+     * @param const double& 观测值
+     */
+    void Observe(const MetricId& _id,const double& _value);
+
+    /*!
+     * @brief 汇总所有线程的计数区
+     * @return std::string Prometheus文本格式的指标数据
+     */
+    std::string Scrape() const;
+
+protected:
+    /*!
+     * @brief 注册指标序列
+     * @return MetricId 指标编号
+     */
+    MetricId Register(const Series& _series,const size_t& _slots);
+
+    /*!
+     * @brief 将所有线程的计数单元与仪表的值清零,调用方需持有锁
+     * @param const size_t& 起始计数单元
+     * @param const size_t& 计数单元数量
+     */
+    void Clear(const size_t& _slot,const size_t& _slots);
+
+    /*!
+     * @brief 获取当前线程的计数区
+     * @return ThreadBlock* 当前线程的计数区
+     */
+    ThreadBlock* GetBlock();
+
+    /*!
+     * @brief 获取当前线程的计数单元
+     * @param const size_t& 计数单元编号
+     * @return std::atomic<unsigned long long>& 计数单元
+     */
+    std::atomic<unsigned long long>& GetSlot(const size_t& _slot);
+
+    /*!
+     * @brief 汇总计数单元
+     * @param const size_t& 计数单元
+     * @return unsigned long long 所有线程中此计数单元之和
+     */
+    unsigned long long Sum(const size_t& _slot) const;
+};
+
+/*!
+ * @class MetricsServer
+ * @brief 通过HTTP发布运行指标的服务
+ *
+ * 仅监听本地地址,任意GET请求均返回全部指标
+ */
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsServer(QObject *parent = nullptr);
+    ~MetricsServer();
+
+protected:
+    QTcpServer m_server;    /*!< HTTP服务端 */
+
+public:
+    /*!
+     * @brief 开始监听
+     * @param const unsigned short& 监听端口
+     * @return bool 监听成功返回true,否则返回false
+     */
+    bool Listen(const unsigned short& _port = 9464);
+
+    /*!
+     * @brief 停止监听
+     */
+    void Close();
+
+protected slots:
+    /*!
+     * @brief 有新的连接时触发的槽函数
+     */
+    void NewConnection();
+
+    /*!
+     * @brief 有请求数据读取时触发的槽函数
+     */
+    void ReadRequest();
+};
+
+#endif // METRICS_H
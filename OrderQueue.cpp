@@ -0,0 +1,289 @@
+#include "OrderQueue.h"
+
+const size_t OrderQueue::NONE = static_cast<size_t>(-1);
+
+OrderQueue::OrderQueue()
+{
+    m_root = NONE;
+}
+
+bool OrderQueue::Push(const OrderQueue::Id_t &_id, const OrderQueue::Key_t &_key)
+{
+    if(m_handles.find(_id) != m_handles.end())
+    {
+        return false;
+    }
+
+    size_t _node = 0;
+
+    if(m_free.empty())
+    {
+        _node = m_nodes.size();
+        m_nodes.push_back(Node());
+    }
+    else
+    {
+        _node = m_free.back();
+        m_free.pop_back();
+    }
+
+    Node& _item = m_nodes[_node];
+    _item.m_key = _key;
+    _item.m_id = _id;
+    _item.m_child = NONE;
+    _item.m_sibling = NONE;
+    _item.m_prev = NONE;
+
+    m_handles[_id] = _node;
+
+    m_root = Meld(m_root,_node);
+
+    return true;
+}
+
+bool OrderQueue::Top(OrderQueue::Id_t &_id, OrderQueue::Key_t &_key) const
+{
+    if(m_root == NONE)
+    {
+        return false;
+    }
+
+    _id = m_nodes[m_root].m_id;
+    _key = m_nodes[m_root].m_key;
+
+    return true;
+}
+
+bool OrderQueue::Pop()
+{
+    if(m_root == NONE)
+    {
+        return false;
+    }
+
+    size_t _old = m_root;
+
+    m_root = MergePairs(m_nodes[_old].m_child);
+
+    if(m_root != NONE)
+    {
+        m_nodes[m_root].m_prev = NONE;
+    }
+
+    Release(_old);
+
+    return true;
+}
+
+bool OrderQueue::Update(const OrderQueue::Id_t &_id, const OrderQueue::Key_t &_key)
+{
+    std::map<Id_t,size_t>::iterator it = m_handles.find(_id);
+
+    if(it == m_handles.end())
+    {
+        return false;
+    }
+
+    size_t _node = it->second;
+
+    if(_key > m_nodes[_node].m_key)
+    {
+        // 键值升高时子节点可能先于它出队,删除后重新插入
+        Remove(_id);
+        Push(_id,_key);
+
+        return true;
+    }
+
+    m_nodes[_node].m_key = _key;
+
+    if(_node != m_root)
+    {
+        Cut(_node);
+
+        m_root = Meld(m_root,_node);
+    }
+
+    return true;
+}
+
+bool OrderQueue::Remove(const OrderQueue::Id_t &_id)
+{
+    std::map<Id_t,size_t>::iterator it = m_handles.find(_id);
+
+    if(it == m_handles.end())
+    {
+        return false;
+    }
+
+    size_t _node = it->second;
+
+    if(_node == m_root)
+    {
+        return Pop();
+    }
+
+    Cut(_node);
+
+    size_t _children = MergePairs(m_nodes[_node].m_child);
+
+    if(_children != NONE)
+    {
+        m_nodes[_children].m_prev = NONE;
+    }
+
+    m_root = Meld(m_root,_children);
+
+    Release(_node);
+
+    return true;
+}
+
+bool OrderQueue::GetKey(const OrderQueue::Id_t &_id, OrderQueue::Key_t &_key) const
+{
+    std::map<Id_t,size_t>::const_iterator it = m_handles.find(_id);
+
+    if(it == m_handles.end())
+    {
+        return false;
+    }
+
+    _key = m_nodes[it->second].m_key;
+
+    return true;
+}
+
+void OrderQueue::Clear()
+{
+    m_nodes.clear();
+    m_free.clear();
+    m_handles.clear();
+    m_root = NONE;
+
+    return;
+}
+
+bool OrderQueue::IsBefore(const size_t &_a, const size_t &_b) const
+{
+    if(m_nodes[_a].m_key != m_nodes[_b].m_key)
+    {
+        return m_nodes[_a].m_key < m_nodes[_b].m_key;
+    }
+
+    return m_nodes[_a].m_id < m_nodes[_b].m_id;
+}
+
+size_t OrderQueue::Meld(const size_t &_a, const size_t &_b)
+{
+    if(_a == NONE)
+    {
+        return _b;
+    }
+
+    if(_b == NONE)
+    {
+        return _a;
+    }
+
+    size_t _parent = IsBefore(_b,_a) ? _b : _a;
+    size_t _child = _parent == _a ? _b : _a;
+
+    // 后出队的根成为先出队的根的第一个子节点
+    Node& _p = m_nodes[_parent];
+    Node& _c = m_nodes[_child];
+
+    _c.m_sibling = _p.m_child;
+
+    if(_p.m_child != NONE)
+    {
+        m_nodes[_p.m_child].m_prev = _child;
+    }
+
+    _c.m_prev = _parent;
+    _p.m_child = _child;
+    _p.m_sibling = NONE;
+    _p.m_prev = NONE;
+
+    return _parent;
+}
+
+size_t OrderQueue::MergePairs(const size_t &_first)
+{
+    if(_first == NONE)
+    {
+        return NONE;
+    }
+
+    m_pairs.clear();
+
+    // 第一趟:从左至右两两合并
+    size_t _node = _first;
+
+    while(_node != NONE)
+    {
+        size_t _a = _node;
+        size_t _b = m_nodes[_a].m_sibling;
+
+        _node = _b == NONE ? NONE : m_nodes[_b].m_sibling;
+
+        m_nodes[_a].m_sibling = NONE;
+        m_nodes[_a].m_prev = NONE;
+
+        if(_b != NONE)
+        {
+            m_nodes[_b].m_sibling = NONE;
+            m_nodes[_b].m_prev = NONE;
+        }
+
+        m_pairs.push_back(Meld(_a,_b));
+    }
+
+    // 第二趟:从右至左依次合并
+    size_t _root = m_pairs.back();
+
+    for(size_t i = m_pairs.size() - 1; i > 0; --i)
+    {
+        _root = Meld(m_pairs[i - 1],_root);
+    }
+
+    return _root;
+}
+
+void OrderQueue::Cut(const size_t &_node)
+{
+    Node& _item = m_nodes[_node];
+
+    if(_item.m_prev != NONE)
+    {
+        Node& _prev = m_nodes[_item.m_prev];
+
+        if(_prev.m_child == _node)
+        {
+            _prev.m_child = _item.m_sibling;
+        }
+        else
+        {
+            _prev.m_sibling = _item.m_sibling;
+        }
+    }
+
+    if(_item.m_sibling != NONE)
+    {
+        m_nodes[_item.m_sibling].m_prev = _item.m_prev;
+    }
+
+    _item.m_prev = NONE;
+    _item.m_sibling = NONE;
+
+    return;
+}
+
+void OrderQueue::Release(const size_t &_node)
+{
+    m_handles.erase(m_nodes[_node].m_id);
+
+    m_nodes[_node].m_child = NONE;
+    m_free.push_back(_node);
+
+    return;
+}
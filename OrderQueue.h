@@ -0,0 +1,151 @@
+/*!
+ * @file OrderQueue
+ * @brief 描述按紧急程度排列订单的优先队列功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef ORDERQUEUE_H
+#define ORDERQUEUE_H
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+/*!
+ * @class OrderQueue
+ * @brief 以配对堆实现的可修改键值的订单优先队列
+ *
+ * 键值越小越先出队,键值相同时编号小者先出队;节点储存在连续数组中,以下标相连,释放的节点复用
+ * 插入与降低键值为O(1),出队与删除为均摊O(log n),以编号查找节点为O(log n)
+ * 非线程安全,由调用方加锁
+ */
+class OrderQueue
+{
+public:
+    OrderQueue();
+
+public:
+    typedef unsigned int Id_t;
+    typedef long long Key_t;
+
+protected:
+    /*! @brief 描述堆节点的结构体 */
+    struct Node
+    {
+        Key_t m_key;            /*!< 键值 */
+        Id_t m_id;              /*!< 订单编号 */
+        size_t m_child;         /*!< 第一个子节点 */
+        size_t m_sibling;       /*!< 下一个兄弟节点 */
+        size_t m_prev;          /*!< 第一个子节点为父节点,其余为上一个兄弟节点 */
+    };
+
+protected:
+    static const size_t NONE;               /*!< 无效的节点下标 */
+
+    std::vector<Node> m_nodes;              /*!< 节点 */
+    std::vector<size_t> m_free;             /*!< 已释放的节点 */
+    std::map<Id_t,size_t> m_handles;        /*!< 各订单的节点 */
+    size_t m_root;                          /*!< 根节点 */
+    std::vector<size_t> m_pairs;            /*!< 合并子节点时使用的临时数组 */
+
+public:
+    /*!
+     * @brief 插入订单
+     * @param const Id_t& 订单编号
+     * @param const Key_t& 键值
+     * @return bool 订单已在队列中返回false
+     */
+    bool Push(const Id_t& _id,const Key_t& _key);
+
+    /*!
+     * @brief 获取键值最小的订单
+     * @param Id_t& 订单编号
+     * @param Key_t& 键值
+     * @return bool 队列为空返回false
+     */
+    bool Top(Id_t& _id,Key_t& _key) const;
+
+    /*!
+     * @brief 移除键值最小的订单
+     * @return bool 队列为空返回false
+     */
+    bool Pop();
+
+    /*!
+     * @brief 修改订单的键值,键值降低时不调整其他节点
+     * @param const Id_t& 订单编号
+     * @param const Key_t& 新的键值
+     * @return bool 订单不在队列中返回false
+     */
+    bool Update(const Id_t& _id,const Key_t& _key);
+
+    /*!
+     * @brief 删除订单
+     * @param const Id_t& 订单编号
+     * @return bool 订单不在队列中返回false
+     */
+    bool Remove(const Id_t& _id);
+
+    /*!
+     * @brief 获取订单的键值
+     * @param const Id_t& 订单编号
+     * @param Key_t& 键值
+     * @return bool 订单不在队列中返回false
+     */
+    bool GetKey(const Id_t& _id,Key_t& _key) const;
+
+    /*!
+     * @brief 获取订单数量
+     * @return size_t 订单数量
+     */
+    size_t GetCount() const { return m_handles.size(); }
+
+    /*!
+     * @brief 队列是否为空
+     * @return bool 为空返回true
+     */
+    bool IsEmpty() const { return m_root == NONE; }
+
+    /*!
+     * @brief 清空队列
+     */
+    void Clear();
+
+protected:
+    /*!
+     * @brief 前者是否先于后者出队
+     * @param const size_t& 节点
+     * @param const size_t& 节点
+     * @return bool 先出队返回true
+     */
+    bool IsBefore(const size_t& _a,const size_t& _b) const;
+
+    /*!
+     * @brief 合并两个堆
+     * @param const size_t& 根节点
+     * @param const size_t& 根节点
+     * @return size_t 合并后的根节点
+     */
+    size_t Meld(const size_t& _a,const size_t& _b);
+
+    /*!
+     * @brief 两趟合并兄弟节点组成的链表
+     * @param const size_t& 第一个节点
+     * @return size_t 合并后的根节点
+     */
+    size_t MergePairs(const size_t& _first);
+
+    /*!
+     * @brief 将以节点为根的子树从父节点上断开
+     * @param const size_t& 节点
+     */
+    void Cut(const size_t& _node);
+
+    /*!
+     * @brief 释放节点
+     * @param const size_t& 节点
+     */
+    void Release(const size_t& _node);
+};
+
+#endif // ORDERQUEUE_H
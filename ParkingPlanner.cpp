@@ -0,0 +1,646 @@
+#include "ParkingPlanner.h"
+#include "Dispatcher.h"
+
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+
+const double ParkingPlanner::RESCALE = 1e12;
+const ContractionHierarchy::Weight_t ParkingPlanner::UNREACHABLE = 100000000;
+
+ParkingPlanner::ParkingPlanner(const ContractionHierarchy &_ch, AgvIndex &_index, TimingWheel &_wheel, const std::chrono::milliseconds &_period)
+    : m_ch(_ch),m_index(_index),m_wheel(_wheel),m_demand(AgvIndex::ABILITY_COUNT)
+{
+    m_period = _period;
+    m_epoch = std::chrono::steady_clock::now();
+    m_halfLife = std::chrono::minutes(60);
+    m_maxDemand = 256;
+    m_threshold = 0.1;
+    m_settle = std::chrono::seconds(30);
+    m_chargeWeight = 2.0;
+    m_bDirty = true;
+    m_bStopped = false;
+    // 投递到AGV线程的调用只访问索引,不访问本对象,本对象析构后仍可安全执行
+    AgvIndex* _pIndex = &_index;
+    m_handler = [_pIndex](AgvBase* _agv,const RfidBase::Rfid_t& _parking){
+        // 指令需在AGV所在的线程中发送,发送前确认未被订单分配取代
+        QTimer::singleShot(0,_agv,[_pIndex,_agv,_parking]{
+            if(_pIndex->GetClaim(_agv->GetID()) != AgvIndex::Claim_Parking)
+            {
+                return;
+            }
+
+            if(_agv->Move(_parking) != AgvBase::Cmd_Success)
+            {
+                _pIndex->Unclaim(_agv->GetID(),AgvIndex::Claim_Parking);
+            }
+        });
+    };
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+
+    m_moves = _registry.AddCounter("agv_parking_moves_total","Idle AGVs sent to a parking landmark");
+    m_expected = _registry.AddGauge("agv_parking_expected_distance","Demand-weighted distance from the chosen parking landmarks to pickups, in mm");
+    m_planTime = _registry.AddHistogram("agv_parking_plan_seconds","Time spent choosing parking landmarks for idle AGVs",
+                                        {0.001,0.002,0.005,0.01,0.02,0.05,0.1,0.2});
+
+    m_timer = m_wheel.Start(m_period,[this]{ Plan(); });
+}
+
+ParkingPlanner::~ParkingPlanner()
+{
+    TimingWheel::TimerId _timer = TimingWheel::INVALID_TIMER;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        m_bStopped = true;
+        _timer = m_timer;
+    }
+
+    // 不持有锁等待正在执行的Plan返回,Plan看到m_bStopped后不再启动定时器
+    m_wheel.CancelSync(_timer);
+}
+
+void ParkingPlanner::AddParking(const RfidBase::Rfid_t &_rfid)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(std::find(m_parkings.begin(),m_parkings.end(),_rfid) != m_parkings.end())
+    {
+        return;
+    }
+
+    m_parkings.push_back(_rfid);
+
+    // 缓存的距离按停车点排列,需全部重新计算
+    m_columns.clear();
+    m_chargerDistance.clear();
+    m_bDirty = true;
+
+    return;
+}
+
+void ParkingPlanner::AddCharger(const RfidBase::Rfid_t &_rfid)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(std::find(m_chargers.begin(),m_chargers.end(),_rfid) != m_chargers.end())
+    {
+        return;
+    }
+
+    m_chargers.push_back(_rfid);
+    m_chargerDistance.clear();
+    m_bDirty = true;
+
+    return;
+}
+
+void ParkingPlanner::Record(const RfidBase::Rfid_t &_pickup, const unsigned char &_ability)
+{
+    unsigned char _index = _ability < AgvIndex::ABILITY_COUNT ? _ability : 0;
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    Time_t _now = std::chrono::steady_clock::now();
+
+    // 不衰减已有的需求,而是放大新的需求,记录的代价与取货点数量无关
+    double _tau = std::chrono::duration<double>(m_halfLife).count() / std::log(2.0);
+    double _scale = std::exp(std::chrono::duration<double>(_now - m_epoch).count() / _tau);
+
+    if(_scale > RESCALE)
+    {
+        for(std::vector<std::map<RfidBase::Rfid_t,double> >::iterator it = m_demand.begin(); it != m_demand.end(); ++it)
+        {
+            for(std::map<RfidBase::Rfid_t,double>::iterator d = it->begin(); d != it->end();)
+            {
+                d->second /= _scale;
+
+                if(d->second < 1e-9)
+                {
+                    // 衰减至可以忽略
+                    d = it->erase(d);
+                    continue;
+                }
+
+                ++d;
+            }
+        }
+
+        m_epoch = _now;
+        _scale = 1.0;
+    }
+
+    m_demand[_index][_pickup] += _scale;
+
+    return;
+}
+
+void ParkingPlanner::SetDemand(const std::chrono::minutes &_halfLife, const size_t &_maxDemand, const double &_threshold)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_halfLife = _halfLife.count() > 0 ? _halfLife : std::chrono::minutes(1);
+    m_maxDemand = std::max<size_t>(1,_maxDemand);
+    m_threshold = _threshold;
+    m_bDirty = true;
+
+    return;
+}
+
+void ParkingPlanner::SetSettle(const std::chrono::seconds &_settle)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_settle = _settle;
+
+    return;
+}
+
+void ParkingPlanner::SetChargeWeight(const double &_weight)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_chargeWeight = _weight;
+    m_bDirty = true;
+
+    return;
+}
+
+void ParkingPlanner::SetHandler(const ParkingPlanner::Handler &_handler)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_handler = _handler;
+
+    return;
+}
+
+bool ParkingPlanner::GetTarget(const AgvBase::AId_t &_id, RfidBase::Rfid_t &_rfid)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,RfidBase::Rfid_t>::const_iterator it = m_targets.find(_id);
+
+    if(it == m_targets.end())
+    {
+        return false;
+    }
+
+    _rfid = it->second;
+
+    return true;
+}
+
+void ParkingPlanner::Plan()
+{
+    std::vector<std::pair<AgvIndex::Snapshot,RfidBase::Rfid_t> > _send;
+    Handler _handler;
+
+    // 状态读取AGV线程中采集的快照,不在时间轮线程中读取AGV对象
+    std::vector<AgvIndex::Snapshot> _idle;
+
+    m_index.GetSnapshots(0,AgvIndex::Avail_Idle,_idle);
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        if(m_bStopped)
+        {
+            return;
+        }
+
+        m_timer = m_wheel.Start(m_period,[this]{ Plan(); });
+
+        Time_t _now = std::chrono::steady_clock::now();
+
+        // 只规划空闲足够久的AGV,刚完成订单的AGV可能很快接到下一个订单
+        std::map<AgvBase::AId_t,Time_t> _since;
+        std::map<unsigned char,std::vector<AgvIndex::Snapshot> > _groups;
+        std::set<AgvBase::AId_t> _ids;
+
+        for(std::vector<AgvIndex::Snapshot>::iterator it = _idle.begin(); it != _idle.end(); ++it)
+        {
+            AgvBase::AId_t _id = it->m_id;
+
+            std::map<AgvBase::AId_t,Time_t>::iterator _found = m_idleSince.find(_id);
+
+            Time_t _start = _found == m_idleSince.end() ? _now : _found->second;
+
+            _since[_id] = _start;
+
+            if(_now - _start < m_settle || m_index.GetClaim(_id) != AgvIndex::Claim_None)
+            {
+                // 已被派往取货点或充电桩的AGV同样不参与规划
+                continue;
+            }
+
+            unsigned char _ability = it->m_ability < AgvIndex::ABILITY_COUNT ? it->m_ability : 0;
+
+            _groups[_ability].push_back(*it);
+            _ids.insert(_id);
+        }
+
+        m_idleSince.swap(_since);
+
+        if(m_parkings.empty() || _ids.empty())
+        {
+            m_plannedAgvs = _ids;
+            return;
+        }
+
+        std::vector<std::vector<Demand> > _demand(AgvIndex::ABILITY_COUNT);
+        std::vector<double> _totals(AgvIndex::ABILITY_COUNT,0.0);
+        double _drift = 0.0;
+
+        for(unsigned char i = 0; i < AgvIndex::ABILITY_COUNT; ++i)
+        {
+            _demand[i] = GetDemand(i,_totals[i]);
+
+            _drift = std::max(_drift,Drift(_demand[i],i < m_planned.size() ? m_planned[i] : std::vector<Demand>()));
+        }
+
+        if(m_bDirty == false && _ids == m_plannedAgvs && _drift < m_threshold)
+        {
+            // 需求与AGV均未明显变化,保持上一次的规划
+            return;
+        }
+
+        std::chrono::steady_clock::time_point _start = _now;
+
+        if(m_chargerDistance.empty())
+        {
+            m_chargerDistance.assign(m_parkings.size(),0);
+
+            std::vector<ContractionHierarchy::Weight_t> _table;
+
+            if(m_chargers.empty() == false && m_ch.Table(m_parkings,m_chargers,_table))
+            {
+                for(size_t p = 0; p < m_parkings.size(); ++p)
+                {
+                    ContractionHierarchy::Weight_t _min = UNREACHABLE;
+
+                    for(size_t c = 0; c < m_chargers.size(); ++c)
+                    {
+                        _min = std::min(_min,_table[p * m_chargers.size() + c]);
+                    }
+
+                    m_chargerDistance[p] = _min;
+                }
+            }
+        }
+
+        // 需求多的功能优先选择停车点
+        std::vector<std::pair<double,unsigned char> > _order;
+
+        for(std::map<unsigned char,std::vector<AgvIndex::Snapshot> >::iterator it = _groups.begin(); it != _groups.end(); ++it)
+        {
+            _order.push_back(std::make_pair(-_totals[it->first],it->first));
+        }
+
+        std::sort(_order.begin(),_order.end());
+
+        std::vector<size_t> _available;
+
+        for(size_t p = 0; p < m_parkings.size(); ++p)
+        {
+            _available.push_back(p);
+        }
+
+        std::set<RfidBase::Rfid_t> _used;       /*!< 本次规划用到的取货点 */
+        double _expected = 0.0;
+        double _weight = 0.0;
+
+        for(std::vector<std::pair<double,unsigned char> >::iterator it = _order.begin(); it != _order.end(); ++it)
+        {
+            const std::vector<Demand>& _groupDemand = _demand[it->second];
+            std::vector<AgvIndex::Snapshot>& _agvs = _groups[it->second];
+
+            for(std::vector<AgvIndex::Snapshot>::iterator a = _agvs.begin(); a != _agvs.end(); ++a)
+            {
+                m_targets.erase(a->m_id);
+            }
+
+            if(_groupDemand.empty() || _available.empty())
+            {
+                // 没有需求的功能停在原地
+                continue;
+            }
+
+            for(std::vector<Demand>::const_iterator d = _groupDemand.begin(); d != _groupDemand.end(); ++d)
+            {
+                _used.insert(d->m_rfid);
+            }
+
+            Fill(_groupDemand);
+
+            std::vector<size_t> _selected;
+
+            _expected += Select(_groupDemand,_available,std::min(_agvs.size(),_available.size()),_selected) * _totals[it->second];
+            _weight += _totals[it->second];
+
+            for(std::vector<size_t>::iterator s = _selected.begin(); s != _selected.end(); ++s)
+            {
+                _available.erase(std::find(_available.begin(),_available.end(),*s));
+            }
+
+            std::vector<RfidBase::Rfid_t> _sources;
+            std::vector<RfidBase::Rfid_t> _targets;
+
+            for(std::vector<AgvIndex::Snapshot>::iterator a = _agvs.begin(); a != _agvs.end(); ++a)
+            {
+                _sources.push_back(a->m_rfid);
+            }
+
+            for(std::vector<size_t>::iterator s = _selected.begin(); s != _selected.end(); ++s)
+            {
+                _targets.push_back(m_parkings[*s]);
+            }
+
+            std::vector<ContractionHierarchy::Weight_t> _distances;
+
+            if(m_ch.Table(_sources,_targets,_distances) == false)
+            {
+                continue;
+            }
+
+            // 停车点数量不多于AGV数量,以停车点为行
+            size_t _rows = _selected.size();
+            size_t _cols = _agvs.size();
+
+            std::vector<Dispatcher::Cost_t> _cost(_rows * _cols);
+
+            for(size_t p = 0; p < _rows; ++p)
+            {
+                for(size_t a = 0; a < _cols; ++a)
+                {
+                    ContractionHierarchy::Weight_t _distance = _distances[a * _rows + p];
+
+                    if(_distance == RfidMap::INFINITE)
+                    {
+                        _cost[p * _cols + a] = Dispatcher::INFEASIBLE;
+                        continue;
+                    }
+
+                    double _deficit = (100 - std::min<int>(_agvs[a].m_battery,100)) / 100.0;
+
+                    _cost[p * _cols + a] = static_cast<Dispatcher::Cost_t>(_distance)
+                            + static_cast<Dispatcher::Cost_t>(m_chargeWeight * _deficit * m_chargerDistance[_selected[p]]);
+                }
+            }
+
+            std::vector<int> _assign;
+
+            Dispatcher::Assign(_cost,_rows,_cols,_assign);
+
+            for(size_t p = 0; p < _rows; ++p)
+            {
+                if(_assign[p] < 0 || _cost[p * _cols + static_cast<size_t>(_assign[p])] >= Dispatcher::INFEASIBLE)
+                {
+                    continue;
+                }
+
+                const AgvIndex::Snapshot& _agv = _agvs[static_cast<size_t>(_assign[p])];
+                RfidBase::Rfid_t _parking = m_parkings[_selected[p]];
+
+                m_targets[_agv.m_id] = _parking;
+
+                if(_agv.m_rfid != _parking)
+                {
+                    _send.push_back(std::make_pair(_agv,_parking));
+                }
+            }
+        }
+
+        // 只保留仍在需求分布中的取货点的距离
+        for(std::map<RfidBase::Rfid_t,std::vector<ContractionHierarchy::Weight_t> >::iterator it = m_columns.begin(); it != m_columns.end();)
+        {
+            if(_used.find(it->first) == _used.end())
+            {
+                it = m_columns.erase(it);
+                continue;
+            }
+
+            ++it;
+        }
+
+        m_planned.swap(_demand);
+        m_plannedAgvs.swap(_ids);
+        m_bDirty = false;
+
+        _handler = m_handler;
+
+        MetricsRegistry& _registry = MetricsRegistry::Instance();
+
+        if(_weight > 0.0)
+        {
+            _registry.Set(m_expected,static_cast<long long>(_expected / _weight));
+        }
+
+        _registry.Observe(m_planTime,std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count());
+    }
+
+    for(std::vector<std::pair<AgvIndex::Snapshot,RfidBase::Rfid_t> >::iterator it = _send.begin(); it != _send.end(); ++it)
+    {
+        if(m_index.Claim(it->first.m_id,AgvIndex::Claim_Parking) == false)
+        {
+            // 规划期间已被订单分配或充电调度认领
+            continue;
+        }
+
+        MetricsRegistry::Instance().Add(m_moves);
+
+        if(_handler)
+        {
+            _handler(it->first.m_pAgv,it->second);
+        }
+    }
+
+    return;
+}
+
+std::vector<ParkingPlanner::Demand> ParkingPlanner::GetDemand(const unsigned char &_ability, double &_total) const
+{
+    std::map<RfidBase::Rfid_t,double> _merged = m_demand[0];
+
+    if(_ability != 0)
+    {
+        for(std::map<RfidBase::Rfid_t,double>::const_iterator it = m_demand[_ability].begin(); it != m_demand[_ability].end(); ++it)
+        {
+            _merged[it->first] += it->second;
+        }
+    }
+
+    std::vector<Demand> _demand;
+
+    _total = 0.0;
+
+    for(std::map<RfidBase::Rfid_t,double>::iterator it = _merged.begin(); it != _merged.end(); ++it)
+    {
+        Demand _item;
+        _item.m_rfid = it->first;
+        _item.m_weight = it->second;
+
+        _demand.push_back(_item);
+
+        _total += it->second;
+    }
+
+    if(_demand.size() > m_maxDemand)
+    {
+        // 只保留需求最多的取货点
+        std::nth_element(_demand.begin(),_demand.begin() + m_maxDemand,_demand.end(),[](const Demand& _a,const Demand& _b){
+            return _a.m_weight > _b.m_weight;
+        });
+
+        _demand.resize(m_maxDemand);
+    }
+
+    double _sum = 0.0;
+
+    for(std::vector<Demand>::iterator it = _demand.begin(); it != _demand.end(); ++it)
+    {
+        _sum += it->m_weight;
+    }
+
+    for(std::vector<Demand>::iterator it = _demand.begin(); it != _demand.end(); ++it)
+    {
+        it->m_weight /= _sum;
+    }
+
+    std::sort(_demand.begin(),_demand.end(),[](const Demand& _a,const Demand& _b){ return _a.m_rfid < _b.m_rfid; });
+
+    return _demand;
+}
+
+void ParkingPlanner::Fill(const std::vector<ParkingPlanner::Demand> &_demand)
+{
+    std::vector<RfidBase::Rfid_t> _missing;
+
+    for(std::vector<Demand>::const_iterator it = _demand.begin(); it != _demand.end(); ++it)
+    {
+        if(m_columns.find(it->m_rfid) == m_columns.end())
+        {
+            _missing.push_back(it->m_rfid);
+        }
+    }
+
+    if(_missing.empty())
+    {
+        return;
+    }
+
+    std::vector<ContractionHierarchy::Weight_t> _table;
+
+    if(m_ch.Table(m_parkings,_missing,_table) == false)
+    {
+        _table.assign(m_parkings.size() * _missing.size(),RfidMap::INFINITE);
+    }
+
+    for(size_t j = 0; j < _missing.size(); ++j)
+    {
+        std::vector<ContractionHierarchy::Weight_t>& _column = m_columns[_missing[j]];
+
+        _column.resize(m_parkings.size());
+
+        for(size_t p = 0; p < m_parkings.size(); ++p)
+        {
+            ContractionHierarchy::Weight_t _distance = _table[p * _missing.size() + j];
+
+            _column[p] = _distance == RfidMap::INFINITE ? UNREACHABLE : _distance;
+        }
+    }
+
+    return;
+}
+
+double ParkingPlanner::Select(const std::vector<ParkingPlanner::Demand> &_demand, const std::vector<size_t> &_available, const size_t &_count, std::vector<size_t> &_selected) const
+{
+    std::vector<const std::vector<ContractionHierarchy::Weight_t>*> _columns;
+
+    for(std::vector<Demand>::const_iterator it = _demand.begin(); it != _demand.end(); ++it)
+    {
+        _columns.push_back(&m_columns.at(it->m_rfid));
+    }
+
+    std::vector<double> _nearest(_demand.size(),UNREACHABLE);     /*!< 各取货点至最近已选停车点的距离 */
+    std::vector<char> _chosen(m_parkings.size(),0);
+
+    double _current = UNREACHABLE;
+
+    // 每次加入使加权距离下降最多的停车点
+    for(size_t k = 0; k < _count; ++k)
+    {
+        size_t _best = m_parkings.size();
+        double _bestCost = 0.0;
+
+        for(std::vector<size_t>::const_iterator it = _available.begin(); it != _available.end(); ++it)
+        {
+            if(_chosen[*it])
+            {
+                continue;
+            }
+
+            double _cost = 0.0;
+
+            for(size_t d = 0; d < _demand.size(); ++d)
+            {
+                _cost += _demand[d].m_weight * std::min<double>(_nearest[d],(*_columns[d])[*it]);
+            }
+
+            if(_best == m_parkings.size() || _cost < _bestCost)
+            {
+                _best = *it;
+                _bestCost = _cost;
+            }
+        }
+
+        if(_best == m_parkings.size())
+        {
+            break;
+        }
+
+        _chosen[_best] = 1;
+        _selected.push_back(_best);
+        _current = _bestCost;
+
+        for(size_t d = 0; d < _demand.size(); ++d)
+        {
+            _nearest[d] = std::min<double>(_nearest[d],(*_columns[d])[_best]);
+        }
+    }
+
+    return _current;
+}
+
+double ParkingPlanner::Drift(const std::vector<ParkingPlanner::Demand> &_a, const std::vector<ParkingPlanner::Demand> &_b)
+{
+    if(_a.empty() != _b.empty())
+    {
+        return 1.0;
+    }
+
+    // 两者均按取货点排序,归并求差
+    double _sum = 0.0;
+    size_t i = 0;
+    size_t j = 0;
+
+    while(i < _a.size() || j < _b.size())
+    {
+        if(j >= _b.size() || (i < _a.size() && _a[i].m_rfid < _b[j].m_rfid))
+        {
+            _sum += _a[i++].m_weight;
+        }
+        else if(i >= _a.size() || _b[j].m_rfid < _a[i].m_rfid)
+        {
+            _sum += _b[j++].m_weight;
+        }
+        else
+        {
+            _sum += std::fabs(_a[i++].m_weight - _b[j++].m_weight);
+        }
+    }
+
+    return _sum / 2.0;
+}
@@ -0,0 +1,191 @@
+/*!
+ * @file ParkingPlanner
+ * @brief 描述按订单需求将空闲AGV预先调度至停车点功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef PARKINGPLANNER_H
+#define PARKINGPLANNER_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "AgvIndex.h"
+#include "ContractionHierarchy.h"
+#include "TimingWheel.h"
+
+/*!
+ * @class ParkingPlanner
+ * @brief 按历史订单取货点分布为空闲AGV选择停车点,使预期响应距离最小的规划器
+ *
+ * 各取货点的需求按AGV功能分别记录,并按半衰期指数衰减,近期的订单权重更高;不限功能的订单计入所有功能
+ * 规划器按周期为空闲一段时间以上的AGV规划:按功能分组,需求多的功能先选,
+ * 以贪心的p-中位数方法从尚未被选中的停车点中为每组选出与组内AGV数量相同的停车点,使按需求加权的至取货点距离最小;
+ * 再以匈牙利算法将组内AGV分配至选中的停车点,代价为行驶距离叠加按缺电比例放大的停车点至最近充电桩的距离,
+ * 电量低的AGV倾向于停在充电桩附近
+ * 停车点至取货点的距离按取货点缓存,需求出现新的取货点时只计算新的一列;
+ * 需求分布变化小于阈值且参与规划的AGV不变时不重新规划
+ * 已被订单分配或充电调度认领的AGV不参与规划,派出前以AGV索引认领,指令发送前被订单取代时不再发送
+ */
+class ParkingPlanner
+{
+public:
+    /*!
+     * @param const ContractionHierarchy& 已就绪的收缩层次索引
+     * @param AgvIndex& AGV索引
+     * @param TimingWheel& 共用的时间轮
+     * @param const std::chrono::milliseconds& 规划的周期
+     */
+    ParkingPlanner(const ContractionHierarchy& _ch,AgvIndex& _index,TimingWheel& _wheel,
+                   const std::chrono::milliseconds& _period = std::chrono::milliseconds(15000));
+    ~ParkingPlanner();
+
+public:
+    typedef std::chrono::steady_clock::time_point Time_t;
+
+    /*!
+     * @brief 派AGV前往停车点的处理函数,在时间轮线程中调用
+     *
+     * 调用前AGV已以AgvIndex::Claim_Parking认领,指令未能发送时应以AgvIndex::Unclaim撤销
+     * @param AgvBase* AGV对象
+     * @param const RfidBase::Rfid_t& 停车点所在的RFID地标卡编号
+     */
+    typedef std::function<void(AgvBase*,const RfidBase::Rfid_t&)> Handler;
+
+protected:
+    /*! @brief 描述一个取货点需求的结构体 */
+    struct Demand
+    {
+        RfidBase::Rfid_t m_rfid;        /*!< 取货点 */
+        double m_weight;                /*!< 归一化的需求 */
+    };
+
+protected:
+    static const double RESCALE;                            /*!< 需求的缩放系数超过此值时重新归一化 */
+    static const ContractionHierarchy::Weight_t UNREACHABLE;    /*!< 不可达时计入的距离:单位(mm) */
+
+    const ContractionHierarchy& m_ch;                       /*!< 收缩层次索引 */
+    AgvIndex& m_index;                                      /*!< AGV索引 */
+    TimingWheel& m_wheel;                                   /*!< 时间轮 */
+    std::chrono::milliseconds m_period;                     /*!< 规划的周期 */
+    std::mutex m_mutex;                                     /*!< 互斥锁 */
+    std::vector<RfidBase::Rfid_t> m_parkings;               /*!< 停车点 */
+    std::vector<RfidBase::Rfid_t> m_chargers;               /*!< 充电桩 */
+    std::vector<ContractionHierarchy::Weight_t> m_chargerDistance;  /*!< 各停车点至最近充电桩的距离,为空时需重新计算 */
+    std::map<RfidBase::Rfid_t,std::vector<ContractionHierarchy::Weight_t> > m_columns;  /*!< 各停车点至取货点的距离 */
+    std::vector<std::map<RfidBase::Rfid_t,double> > m_demand;   /*!< 各功能各取货点的需求,按m_epoch时的权重缩放 */
+    Time_t m_epoch;                                         /*!< 需求缩放的基准时间 */
+    std::chrono::minutes m_halfLife;                        /*!< 需求的半衰期 */
+    size_t m_maxDemand;                                     /*!< 每个功能参与规划的取货点数量上限 */
+    double m_threshold;                                     /*!< 触发重新规划的需求分布变化 */
+    std::chrono::seconds m_settle;                          /*!< AGV空闲多久后参与规划 */
+    double m_chargeWeight;                                  /*!< 电量耗尽时停车点至充电桩距离的倍数 */
+    std::map<AgvBase::AId_t,Time_t> m_idleSince;            /*!< 各空闲AGV开始空闲的时间 */
+    std::map<AgvBase::AId_t,RfidBase::Rfid_t> m_targets;    /*!< 最近一次规划的停车点 */
+    std::vector<std::vector<Demand> > m_planned;            /*!< 最近一次规划使用的需求分布 */
+    std::set<AgvBase::AId_t> m_plannedAgvs;                 /*!< 最近一次规划的AGV */
+    bool m_bDirty;                                          /*!< 停车点或充电桩改变,需要重新规划 */
+    Handler m_handler;                                      /*!< 派AGV前往停车点的处理函数 */
+    TimingWheel::TimerId m_timer;                           /*!< 规划的定时器 */
+    bool m_bStopped;                                        /*!< 已开始析构,不再重新启动定时器 */
+    MetricsRegistry::MetricId m_moves;                      /*!< 派往停车点次数的指标 */
+    MetricsRegistry::MetricId m_expected;                   /*!< 预期响应距离的指标 */
+    MetricsRegistry::MetricId m_planTime;                   /*!< 规划耗时的指标 */
+
+public:
+    /*!
+     * @brief 添加停车点,每个停车点只停放一台AGV
+     * @param const RfidBase::Rfid_t& 停车点所在的RFID地标卡编号
+     */
+    void AddParking(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 添加充电桩
+     * @param const RfidBase::Rfid_t& 充电桩所在的RFID地标卡编号
+     */
+    void AddCharger(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 记录一次订单需求,可在任意线程中调用
+     * @param const RfidBase::Rfid_t& 取货点RFID地标卡编号
+     * @param const unsigned char& 需要的AGV功能,0为不限
+     */
+    void Record(const RfidBase::Rfid_t& _pickup,const unsigned char& _ability = 0);
+
+    /*!
+     * @brief 设置需求的参数
+     * @param const std::chrono::minutes& 半衰期
+     * @param const size_t& 每个功能参与规划的取货点数量上限
+     * @param const double& 触发重新规划的需求分布变化,为两次分布之差的绝对值之和的一半
+     */
+    void SetDemand(const std::chrono::minutes& _halfLife,const size_t& _maxDemand,const double& _threshold);
+
+    /*!
+     * @brief 设置AGV空闲多久后参与规划
+     * @param const std::chrono::seconds& 时长
+     */
+    void SetSettle(const std::chrono::seconds& _settle);
+
+    /*!
+     * @brief 设置充电桩距离的权重
+     * @param const double& 电量耗尽时停车点至充电桩距离的倍数,按缺电比例线性减小
+     */
+    void SetChargeWeight(const double& _weight);
+
+    /*!
+     * @brief 设置派AGV前往停车点的处理函数
+     * @param const Handler& 处理函数
+     */
+    void SetHandler(const Handler& _handler);
+
+    /*!
+     * @brief 获取最近一次规划为AGV选择的停车点
+     * @param const AgvBase::AId_t& AGV编号
+     * @param RfidBase::Rfid_t& 停车点
+     * @return bool 未为AGV选择停车点时返回false
+     */
+    bool GetTarget(const AgvBase::AId_t& _id,RfidBase::Rfid_t& _rfid);
+
+protected:
+    /*!
+     * @brief 规划并派出AGV,在时间轮线程中调用
+     */
+    void Plan();
+
+    /*!
+     * @brief 获取功能的需求分布,含不限功能的需求,调用方需持有锁
+     * @param const unsigned char& AGV功能
+     * @param double& 需求总量,按m_epoch时的权重缩放
+     * @return std::vector<Demand> 需求最多的若干取货点,权重之和为1
+     */
+    std::vector<Demand> GetDemand(const unsigned char& _ability,double& _total) const;
+
+    /*!
+     * @brief 计算缺少的停车点至取货点的距离,调用方需持有锁
+     * @param const std::vector<Demand>& 取货点
+     */
+    void Fill(const std::vector<Demand>& _demand);
+
+    /*!
+     * @brief 以贪心的p-中位数方法选择停车点,调用方需持有锁
+     * @param const std::vector<Demand>& 需求分布
+     * @param const std::vector<size_t>& 可选的停车点下标
+     * @param const size_t& 选择的数量
+     * @param std::vector<size_t>& 选中的停车点下标
+     * @return double 按需求加权的至最近选中停车点的距离:单位(mm)
+     */
+    double Select(const std::vector<Demand>& _demand,const std::vector<size_t>& _available,const size_t& _count,std::vector<size_t>& _selected) const;
+
+    /*!
+     * @brief 两次需求分布的差异
+     * @param const std::vector<Demand>& 分布
+     * @param const std::vector<Demand>& 分布
+     * @return double 差的绝对值之和的一半,0至1
+     */
+    static double Drift(const std::vector<Demand>& _a,const std::vector<Demand>& _b);
+};
+
+#endif // PARKINGPLANNER_H
@@ -113,6 +113,23 @@ unsigned char ProtocolBase::auchCRCLo[] =
 ProtocolBase::ProtocolBase(const unsigned char& _type)
 {
     m_type = _type;
+
+    std::string _labels = "protocol=\"unknown\"";
+
+    switch(m_type)
+    {
+    case Protocol_PLC:
+        _labels = "protocol=\"plc\"";
+        break;
+    case Protocol_STM32:
+        _labels = "protocol=\"stm32\"";
+        break;
+    }
+
+    MetricsRegistry& _registry = MetricsRegistry::Instance();
+
+    m_metricPacket = _registry.AddCounter("agv_protocol_packets_total","Packets decoded successfully",_labels);
+    m_metricCrcErr = _registry.AddCounter("agv_protocol_crc_errors_total","Packets dropped because of length or CRC mismatch",_labels);
 }
 
 short ProtocolBase::CRC16(const char *puchMsg,unsigned int _len)
@@ -9,6 +9,7 @@
 #define PROTOCOLBASE_H
 
 #include <QObject>
+#include "Metrics.h"
 
 /*!
  * @class ProtocolBase
@@ -25,6 +26,8 @@ public:
 
 protected:
     unsigned char m_type;
+    MetricsRegistry::MetricId m_metricPacket;   /*!< 解析成功的报文数量 */
+    MetricsRegistry::MetricId m_metricCrcErr;   /*!< 长度或校验码错误而丢弃的报文数量 */
 
 protected:
     static unsigned char auchCRCHi[];
@@ -83,6 +83,12 @@ QByteArrayList ProtocolPlc::ProcessData(QByteArray &_data)
         {
             // 长度与校验码校验通过校验
             _list.push_back(QByteArray(_srcData,static_cast<int>(_srcSize - _sizeCrc)));
+
+            MetricsRegistry::Instance().Add(m_metricPacket);
+        }
+        else
+        {
+            MetricsRegistry::Instance().Add(m_metricCrcErr);
         }
 
         _last = _tail + sizeof(PACKET_TAIL);
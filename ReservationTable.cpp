@@ -0,0 +1,505 @@
+#include "ReservationTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+
+const ReservationTable::Time_t ReservationTable::FOREVER = std::numeric_limits<long long>::max();
+
+/*!
+ * @brief 按开始时间比较预约
+ */
+static bool BeginLess(const ReservationTable::Reservation& _reservation,const ReservationTable::Time_t& _time)
+{
+    return _reservation.m_begin < _time;
+}
+
+ReservationTable::ReservationTable(const RfidMap &_map)
+    : m_map(_map)
+{
+    m_nodes.resize(m_map.GetNodeCount());
+    m_count = 0;
+}
+
+bool ReservationTable::Reserve(const AgvBase::AId_t &_agv, const RfidBase::Rfid_t &_rfid, const Time_t &_begin, const Time_t &_end)
+{
+    Node_t _node = m_map.GetNode(_rfid);
+
+    if(_node == RfidMap::NIL || _begin >= _end)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(Overlaps(_node,_begin,_end,_agv))
+    {
+        return false;
+    }
+
+    Reservation _reservation;
+    _reservation.m_begin = _begin;
+    _reservation.m_end = _end;
+    _reservation.m_agv = _agv;
+
+    Insert(_node,_reservation);
+
+    return true;
+}
+
+bool ReservationTable::ReservePath(const AgvBase::AId_t &_agv, const std::vector<Step> &_path, const Time_t &_clearance)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(CanReserve(_agv,_path,_clearance) == false)
+    {
+        return false;
+    }
+
+    InsertPath(_agv,_path,_clearance);
+
+    return true;
+}
+
+bool ReservationTable::ReplacePath(const AgvBase::AId_t &_agv, const std::vector<Step> &_path, const Time_t &_clearance)
+{
+    if(CanReserve(_agv,_path,_clearance) == false)
+    {
+        // 保留原有的预约
+        return false;
+    }
+
+    Erase(_agv);
+    InsertPath(_agv,_path,_clearance);
+
+    return true;
+}
+
+void ReservationTable::Release(const AgvBase::AId_t &_agv)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    Erase(_agv);
+
+    return;
+}
+
+size_t ReservationTable::ReleaseBefore(const Time_t &_now)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    size_t _released = 0;
+
+    for(std::map<AgvBase::AId_t,std::vector<Node_t> >::iterator it = m_owned.begin(); it != m_owned.end();)
+    {
+        std::vector<Node_t>& _owned = it->second;
+        std::vector<Node_t> _remain;
+
+        for(std::vector<Node_t>::iterator node = _owned.begin(); node != _owned.end(); ++node)
+        {
+            std::vector<Reservation>& _list = m_nodes[*node];
+            bool _keep = false;
+
+            for(size_t i = 0; i < _list.size();)
+            {
+                if(_list[i].m_agv != it->first)
+                {
+                    ++i;
+                    continue;
+                }
+
+                if(_list[i].m_end <= _now)
+                {
+                    _list.erase(_list.begin() + i);
+                    ++_released;
+                    continue;
+                }
+
+                _keep = true;
+                ++i;
+            }
+
+            if(_keep)
+            {
+                _remain.push_back(*node);
+            }
+        }
+
+        if(_remain.empty())
+        {
+            m_owned.erase(it++);
+            continue;
+        }
+
+        _owned.swap(_remain);
+        ++it;
+    }
+
+    m_count -= _released;
+
+    return _released;
+}
+
+bool ReservationTable::IsFree(const RfidBase::Rfid_t &_rfid, const Time_t &_begin, const Time_t &_end, const AgvBase::AId_t &_agv) const
+{
+    Node_t _node = m_map.GetNode(_rfid);
+
+    if(_node == RfidMap::NIL)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return Overlaps(_node,_begin,_end,_agv) == false;
+}
+
+size_t ReservationTable::GetCount() const
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_count;
+}
+
+void ReservationTable::GetSafeIntervals(const Node_t &_node, const AgvBase::AId_t &_agv, std::vector<SafeInterval> &_intervals) const
+{
+    _intervals.clear();
+
+    SafeInterval _interval;
+    _interval.m_begin = std::numeric_limits<long long>::min();
+
+    const std::vector<Reservation>& _list = m_nodes[_node];
+
+    for(std::vector<Reservation>::const_iterator it = _list.begin(); it != _list.end(); ++it)
+    {
+        if(it->m_agv == _agv)
+        {
+            continue;
+        }
+
+        if(it->m_begin > _interval.m_begin)
+        {
+            _interval.m_end = it->m_begin;
+            _intervals.push_back(_interval);
+        }
+
+        _interval.m_begin = it->m_end;
+
+        if(_interval.m_begin == FOREVER)
+        {
+            return;
+        }
+    }
+
+    _interval.m_end = FOREVER;
+    _intervals.push_back(_interval);
+
+    return;
+}
+
+std::mutex &ReservationTable::GetMutex() const
+{
+    return m_mutex;
+}
+
+bool ReservationTable::Overlaps(const Node_t &_node, const Time_t &_begin, const Time_t &_end, const AgvBase::AId_t &_agv) const
+{
+    const std::vector<Reservation>& _list = m_nodes[_node];
+
+    // 预约互不重叠,与[_begin,_end)重叠的预约在开始时间排序后是连续的一段
+    std::vector<Reservation>::const_iterator it = std::lower_bound(_list.begin(),_list.end(),_begin,BeginLess);
+
+    if(it != _list.begin() && (it - 1)->m_end > _begin)
+    {
+        --it;
+    }
+
+    for(; it != _list.end() && it->m_begin < _end; ++it)
+    {
+        if(it->m_agv != _agv)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ReservationTable::Insert(const Node_t &_node, const Reservation &_reservation)
+{
+    std::vector<Reservation>& _list = m_nodes[_node];
+
+    Reservation _merged = _reservation;
+
+    // 与同一AGV自身的预约重叠时合并
+    std::vector<Reservation>::iterator it = std::lower_bound(_list.begin(),_list.end(),_merged.m_begin,BeginLess);
+
+    if(it != _list.begin() && (it - 1)->m_end >= _merged.m_begin && (it - 1)->m_agv == _merged.m_agv)
+    {
+        --it;
+    }
+
+    std::vector<Reservation>::iterator _first = it;
+
+    // 其他AGV的预约最多与新预约首尾相接,不参与合并
+    for(; it != _list.end() && (it->m_begin < _merged.m_end || (it->m_begin == _merged.m_end && it->m_agv == _merged.m_agv)); ++it)
+    {
+        _merged.m_begin = std::min(_merged.m_begin,it->m_begin);
+        _merged.m_end = std::max(_merged.m_end,it->m_end);
+        --m_count;
+    }
+
+    it = _list.erase(_first,it);
+    _list.insert(it,_merged);
+    ++m_count;
+
+    std::vector<Node_t>& _owned = m_owned[_reservation.m_agv];
+
+    if(std::find(_owned.begin(),_owned.end(),_node) == _owned.end())
+    {
+        _owned.push_back(_node);
+    }
+
+    return;
+}
+
+bool ReservationTable::CanReserve(const AgvBase::AId_t &_agv, const std::vector<Step> &_path, const Time_t &_clearance) const
+{
+    for(std::vector<Step>::const_iterator it = _path.begin(); it != _path.end(); ++it)
+    {
+        Node_t _node = m_map.GetNode(it->m_rfid);
+        Time_t _end = it->m_leave == FOREVER ? FOREVER : it->m_leave + _clearance;
+
+        if(_node == RfidMap::NIL || Overlaps(_node,it->m_enter,_end,_agv))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ReservationTable::InsertPath(const AgvBase::AId_t &_agv, const std::vector<Step> &_path, const Time_t &_clearance)
+{
+    for(std::vector<Step>::const_iterator it = _path.begin(); it != _path.end(); ++it)
+    {
+        Reservation _reservation;
+        _reservation.m_begin = it->m_enter;
+        _reservation.m_end = it->m_leave == FOREVER ? FOREVER : it->m_leave + _clearance;
+        _reservation.m_agv = _agv;
+
+        Insert(m_map.GetNode(it->m_rfid),_reservation);
+    }
+
+    return;
+}
+
+void ReservationTable::Erase(const AgvBase::AId_t &_agv)
+{
+    std::map<AgvBase::AId_t,std::vector<Node_t> >::iterator it = m_owned.find(_agv);
+
+    if(it == m_owned.end())
+    {
+        return;
+    }
+
+    for(std::vector<Node_t>::iterator node = it->second.begin(); node != it->second.end(); ++node)
+    {
+        std::vector<Reservation>& _list = m_nodes[*node];
+
+        for(size_t i = 0; i < _list.size();)
+        {
+            if(_list[i].m_agv == _agv)
+            {
+                _list.erase(_list.begin() + i);
+                --m_count;
+                continue;
+            }
+
+            ++i;
+        }
+    }
+
+    m_owned.erase(it);
+
+    return;
+}
+
+SpaceTimePlanner::SpaceTimePlanner(const RoutePlanner &_planner, ReservationTable &_table)
+    : m_planner(_planner),m_map(_planner.GetMap()),m_table(_table)
+{
+}
+
+bool SpaceTimePlanner::Plan(const AgvBase::AId_t &_agv, const RfidBase::Rfid_t &_from, const RfidBase::Rfid_t &_to, const Time_t &_start,
+                            const float &_speed, std::vector<Step> &_path, const Time_t &_clearance, const size_t &_limit)
+{
+    _path.clear();
+
+    RfidMap::Node_t _source = m_map.GetNode(_from);
+    RfidMap::Node_t _target = m_map.GetNode(_to);
+
+    if(_source == RfidMap::NIL || _target == RfidMap::NIL || _speed <= 0.0f)
+    {
+        return false;
+    }
+
+    typedef std::pair<Time_t,unsigned int> HeapItem_t;
+
+    std::vector<State> _states;                                     /*!< 所有生成的状态 */
+    std::vector<HeapItem_t> _heap;                                  /*!< 按到达时间加启发值排列的小顶堆 */
+    std::unordered_map<unsigned long long,Time_t> _best;            /*!< 各(节点,窗口)的最早到达时间 */
+    std::vector<ReservationTable::SafeInterval> _intervals;
+
+    unsigned int _found = RfidMap::NIL;
+
+    std::lock_guard<std::mutex> _lock(m_table.GetMutex());
+
+    m_table.GetSafeIntervals(_source,_agv,_intervals);
+
+    for(unsigned int i = 0; i < _intervals.size(); ++i)
+    {
+        if(_intervals[i].m_begin <= _start && _start < _intervals[i].m_end)
+        {
+            State _state;
+            _state.m_node = _source;
+            _state.m_interval = i;
+            _state.m_enter = _start;
+            _state.m_arrive = _start;
+            _state.m_end = _intervals[i].m_end;
+            _state.m_parent = RfidMap::NIL;
+
+            _states.push_back(_state);
+            _heap.push_back(HeapItem_t(_start,0));
+            _best[static_cast<unsigned long long>(_source) << 32 | i] = _start;
+
+            break;
+        }
+    }
+
+    size_t _expanded = 0;
+
+    while(_heap.empty() == false)
+    {
+        std::pop_heap(_heap.begin(),_heap.end(),std::greater<HeapItem_t>());
+        unsigned int _index = _heap.back().second;
+        _heap.pop_back();
+
+        State _state = _states[_index];
+
+        if(_best[static_cast<unsigned long long>(_state.m_node) << 32 | _state.m_interval] < _state.m_arrive)
+        {
+            continue;
+        }
+
+        if(_state.m_node == _target && _state.m_end == ReservationTable::FOREVER)
+        {
+            _found = _index;
+            break;
+        }
+
+        if(++_expanded > _limit)
+        {
+            break;
+        }
+
+        for(RfidMap::Edge_t _edge = m_map.EdgeBegin(_state.m_node); _edge < m_map.EdgeEnd(_state.m_node); ++_edge)
+        {
+            RfidMap::Node_t _next = m_map.GetTarget(_edge);
+            Time_t _travel = TravelTime(_edge,_speed);
+
+            RfidMap::Weight_t _rest = m_planner.Heuristic(_next,_target);
+
+            if(_rest == RfidMap::INFINITE)
+            {
+                continue;
+            }
+
+            Time_t _h = static_cast<Time_t>(_rest * 60.0 / _speed);
+
+            m_table.GetSafeIntervals(_next,_agv,_intervals);
+
+            for(unsigned int i = 0; i < _intervals.size(); ++i)
+            {
+                const ReservationTable::SafeInterval& _interval = _intervals[i];
+
+                // 在当前节点等待至下一节点的窗口开始后出发
+                Time_t _depart = std::max(_state.m_arrive,_interval.m_begin);
+
+                if(_state.m_end != ReservationTable::FOREVER && _depart + _travel + _clearance > _state.m_end)
+                {
+                    // 当前节点的窗口内来不及离开,之后的窗口出发更晚
+                    break;
+                }
+
+                Time_t _arrive = _depart + _travel;
+
+                if(_interval.m_end != ReservationTable::FOREVER && _arrive + _clearance > _interval.m_end)
+                {
+                    continue;
+                }
+
+                unsigned long long _key = static_cast<unsigned long long>(_next) << 32 | i;
+                std::unordered_map<unsigned long long,Time_t>::iterator it = _best.find(_key);
+
+                if(it != _best.end() && it->second <= _arrive)
+                {
+                    continue;
+                }
+
+                _best[_key] = _arrive;
+
+                State _push;
+                _push.m_node = _next;
+                _push.m_interval = i;
+                _push.m_enter = _depart;
+                _push.m_arrive = _arrive;
+                _push.m_end = _interval.m_end;
+                _push.m_parent = _index;
+
+                _states.push_back(_push);
+                _heap.push_back(HeapItem_t(_arrive + _h,static_cast<unsigned int>(_states.size() - 1)));
+                std::push_heap(_heap.begin(),_heap.end(),std::greater<HeapItem_t>());
+            }
+        }
+    }
+
+    if(_found == RfidMap::NIL)
+    {
+        return false;
+    }
+
+    for(unsigned int _index = _found; _index != RfidMap::NIL; _index = _states[_index].m_parent)
+    {
+        const State& _state = _states[_index];
+
+        Step _step;
+        _step.m_rfid = m_map.GetRfid(_state.m_node);
+        _step.m_enter = _state.m_enter;
+        _step.m_arrive = _state.m_arrive;
+        _step.m_leave = _path.empty() ? ReservationTable::FOREVER : _path.back().m_arrive;
+
+        _path.push_back(_step);
+    }
+
+    std::reverse(_path.begin(),_path.end());
+
+    // 与搜索在同一次加锁内以新路线取代旧的预约,其他AGV无法在两者之间插入预约
+    if(m_table.ReplacePath(_agv,_path,_clearance) == false)
+    {
+        _path.clear();
+        return false;
+    }
+
+    return true;
+}
+
+SpaceTimePlanner::Time_t SpaceTimePlanner::TravelTime(const RfidMap::Edge_t &_edge, const float &_speed) const
+{
+    float _limit = m_map.GetMaxSpeed(_edge);
+    float _actual = _limit > 0.0f && _limit < _speed ? _limit : _speed;
+
+    // 距离(mm) / 速度(m/min) = 距离 * 60 / 速度 (ms),向上取整使预约偏保守
+    return static_cast<Time_t>(std::ceil(m_map.GetWeight(_edge) * 60.0 / _actual));
+}
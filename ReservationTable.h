@@ -0,0 +1,237 @@
+/*!
+ * @file ReservationTable
+ * @brief 描述RFID地标卡时空预约与无冲突路线规划功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef RESERVATIONTABLE_H
+#define RESERVATIONTABLE_H
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include "AgvBase.h"
+#include "RoutePlanner.h"
+
+/*!
+ * @class ReservationTable
+ * @brief 以时间窗口记录RFID地标卡占用的预约表
+ *
+ * 每个节点的预约按开始时间排序且互不重叠,冲突检测为二分查找
+ * AGV从节点u驶向节点v时,v从出发时刻起被占用,u占用至到达v的时刻,因此对向交换与追尾都表现为节点预约的重叠
+ * 时间单位为ms,时钟由调用方统一选定
+ */
+class ReservationTable
+{
+public:
+    /*!
+     * @param const RfidMap& 路线图
+     */
+    explicit ReservationTable(const RfidMap& _map);
+
+public:
+    typedef RfidMap::Node_t Node_t;
+    typedef long long Time_t;
+
+    static const Time_t FOREVER;    /*!< 无结束时间 */
+
+    /*! @brief 描述节点预约的结构体 */
+    struct Reservation
+    {
+        Time_t m_begin;             /*!< 开始时间 */
+        Time_t m_end;               /*!< 结束时间,不包含 */
+        AgvBase::AId_t m_agv;       /*!< 预约的AGV */
+    };
+
+    /*! @brief 描述路线中一步的结构体 */
+    struct Step
+    {
+        RfidBase::Rfid_t m_rfid;    /*!< RFID地标卡编号 */
+        Time_t m_enter;             /*!< 开始占用的时间,即从上一节点出发的时间 */
+        Time_t m_arrive;            /*!< 到达的时间 */
+        Time_t m_leave;             /*!< 结束占用的时间,即到达下一节点的时间,终点为FOREVER */
+    };
+
+    /*! @brief 描述安全时间窗口的结构体 */
+    struct SafeInterval
+    {
+        Time_t m_begin;             /*!< 开始时间 */
+        Time_t m_end;               /*!< 结束时间,不包含 */
+    };
+
+protected:
+    const RfidMap& m_map;                                           /*!< 路线图 */
+    mutable std::mutex m_mutex;                                     /*!< 互斥锁 */
+    std::vector<std::vector<Reservation> > m_nodes;                 /*!< 各节点的预约,按开始时间排序 */
+    std::map<AgvBase::AId_t,std::vector<Node_t> > m_owned;          /*!< 各AGV预约过的节点 */
+    size_t m_count;                                                 /*!< 预约数量 */
+
+public:
+    /*!
+     * @brief 预约节点
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const Time_t& 开始时间
+     * @param const Time_t& 结束时间
+     * @return bool 与其他AGV的预约不重叠时预约成功返回true,否则返回false
+     */
+    bool Reserve(const AgvBase::AId_t& _agv,const RfidBase::Rfid_t& _rfid,const Time_t& _begin,const Time_t& _end);
+
+    /*!
+     * @brief 预约整条路线,任一节点冲突时不做任何预约
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const std::vector<Step>& 路线
+     * @param const Time_t& 每个节点在占用时间后额外保留的安全时间
+     * @return bool 预约成功返回true,否则返回false
+     */
+    bool ReservePath(const AgvBase::AId_t& _agv,const std::vector<Step>& _path,const Time_t& _clearance = 0);
+
+    /*!
+     * @brief 释放AGV的所有预约
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Release(const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 释放结束时间早于指定时间的预约
+     * @param const Time_t& 当前时间
+     * @return size_t 释放的预约数量
+     */
+    size_t ReleaseBefore(const Time_t& _now);
+
+    /*!
+     * @brief 节点在时间段内是否未被其他AGV预约
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const Time_t& 开始时间
+     * @param const Time_t& 结束时间
+     * @param const AgvBase::AId_t& 忽略该AGV自身的预约
+     * @return bool 未被预约返回true
+     */
+    bool IsFree(const RfidBase::Rfid_t& _rfid,const Time_t& _begin,const Time_t& _end,const AgvBase::AId_t& _agv) const;
+
+    /*!
+     * @brief 获取预约数量
+     * @return size_t 预约数量
+     */
+    size_t GetCount() const;
+
+    /*!
+     * @brief 获取节点对AGV的安全时间窗口,即其他AGV预约之间的空隙
+     *
+     * 调用方需持有锁,供规划器使用
+     * @param const Node_t& 节点
+     * @param const AgvBase::AId_t& AGV编号
+     * @param std::vector<SafeInterval>& 按时间排序的安全时间窗口
+     */
+    void GetSafeIntervals(const Node_t& _node,const AgvBase::AId_t& _agv,std::vector<SafeInterval>& _intervals) const;
+
+    /*!
+     * @brief 以新路线取代AGV的所有预约,与其他AGV的预约冲突时保留原有的预约
+     *
+     * 调用方需持有锁,供规划器在搜索的同一次加锁内完成预约
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const std::vector<Step>& 路线
+     * @param const Time_t& 每个节点在占用时间后额外保留的安全时间
+     * @return bool 预约成功返回true,否则返回false
+     */
+    bool ReplacePath(const AgvBase::AId_t& _agv,const std::vector<Step>& _path,const Time_t& _clearance = 0);
+
+    /*!
+     * @brief 获取互斥锁,规划与预约需在同一次加锁内完成时使用
+     * @return std::mutex& 互斥锁
+     */
+    std::mutex& GetMutex() const;
+
+protected:
+    /*!
+     * @brief 检查重叠,调用方需持有锁
+     */
+    bool Overlaps(const Node_t& _node,const Time_t& _begin,const Time_t& _end,const AgvBase::AId_t& _agv) const;
+
+    /*!
+     * @brief 插入预约,调用方需持有锁并已检查重叠
+     */
+    void Insert(const Node_t& _node,const Reservation& _reservation);
+
+    /*!
+     * @brief 路线是否与其他AGV的预约不重叠,调用方需持有锁
+     */
+    bool CanReserve(const AgvBase::AId_t& _agv,const std::vector<Step>& _path,const Time_t& _clearance) const;
+
+    /*!
+     * @brief 预约整条路线,调用方需持有锁并已检查重叠
+     */
+    void InsertPath(const AgvBase::AId_t& _agv,const std::vector<Step>& _path,const Time_t& _clearance);
+
+    /*!
+     * @brief 删除AGV的所有预约,调用方需持有锁
+     */
+    void Erase(const AgvBase::AId_t& _agv);
+};
+
+/*!
+ * @class SpaceTimePlanner
+ * @brief 在预约表上规划无冲突路线的时空A*规划器
+ *
+ * 采用安全时间窗口(SIPP)表示时空状态:每个节点按其他AGV预约之间的空隙划分为若干窗口,
+ * 状态为(节点,窗口),同一窗口内只保留最早到达时间,等待隐含在出发时间中,避免按时间步展开
+ * 代价为到达时间,启发值为RoutePlanner的距离下界除以最大速度
+ * 终点须落在无结束时间的窗口内,保证AGV到达后可以停留
+ */
+class SpaceTimePlanner
+{
+public:
+    /*!
+     * @param const RoutePlanner& 提供路线图与启发值的规划器
+     * @param ReservationTable& 预约表
+     */
+    SpaceTimePlanner(const RoutePlanner& _planner,ReservationTable& _table);
+
+public:
+    typedef ReservationTable::Time_t Time_t;
+    typedef ReservationTable::Step Step;
+
+protected:
+    /*! @brief 描述搜索状态的结构体 */
+    struct State
+    {
+        RfidMap::Node_t m_node;     /*!< 节点 */
+        unsigned int m_interval;    /*!< 安全时间窗口序号 */
+        Time_t m_enter;             /*!< 开始占用节点的时间 */
+        Time_t m_arrive;            /*!< 到达节点的时间 */
+        Time_t m_end;               /*!< 所在窗口的结束时间 */
+        unsigned int m_parent;      /*!< 前一个状态 */
+    };
+
+protected:
+    const RoutePlanner& m_planner;  /*!< 路线规划器 */
+    const RfidMap& m_map;           /*!< 路线图 */
+    ReservationTable& m_table;      /*!< 预约表 */
+
+public:
+    /*!
+     * @brief 规划无冲突路线并预约
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const RfidBase::Rfid_t& 起点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 终点RFID地标卡编号
+     * @param const Time_t& 出发时间
+     * @param const float& AGV的速度:单位(m/min)
+     * @param std::vector<Step>& 规划结果
+     * @param const Time_t& 每个节点额外保留的安全时间
+     * @param const size_t& 最多扩展的状态数量,超过时规划失败
+     * @return bool 规划并预约成功返回true,否则返回false
+     */
+    bool Plan(const AgvBase::AId_t& _agv,const RfidBase::Rfid_t& _from,const RfidBase::Rfid_t& _to,const Time_t& _start,
+              const float& _speed,std::vector<Step>& _path,const Time_t& _clearance = 0,const size_t& _limit = 100000);
+
+protected:
+    /*!
+     * @brief 路段的行驶时间
+     * @param const RfidMap::Edge_t& 路段
+     * @param const float& AGV的速度:单位(m/min)
+     * @return Time_t 行驶时间:单位(ms)
+     */
+    Time_t TravelTime(const RfidMap::Edge_t& _edge,const float& _speed) const;
+};
+
+#endif // RESERVATIONTABLE_H
@@ -2,6 +2,13 @@
 #define RFIDBASE_H
 #include <chrono>
 
+/*!
+ * @class RfidBase
+ * @brief RFID地标卡
+ *
+ * 本类的锁定状态只供单线程使用,不是原子操作,也不与RfidRegistry同步;
+ * 跨线程的锁定、释放与查询(交通管制、路线锁定、死锁检测、心跳超时等)均使用RfidRegistry,不要混用两者的锁定状态
+ */
 class RfidBase
 {
 public:
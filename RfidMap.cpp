@@ -0,0 +1,358 @@
+#include "RfidMap.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+
+const RfidMap::Node_t RfidMap::NIL;
+const RfidMap::Weight_t RfidMap::INFINITE;
+const size_t RfidMap::RFID_COUNT;
+
+/*!
+ * @brief 记录的剩余部分是否只有空白
+ * @param const char* 最后一个字段之后的位置
+ * @return bool 只有空白返回true
+ */
+static bool IsBlank(const char* _text)
+{
+    while(*_text == ' ' || *_text == '\t' || *_text == '\r')
+    {
+        ++_text;
+    }
+
+    return *_text == '\0';
+}
+
+RfidMap::RfidMap()
+{
+}
+
+bool RfidMap::Load(const std::string &_file)
+{
+    std::ifstream _in(_file.c_str(),std::ios::in | std::ios::binary);
+
+    if(_in.is_open() == false)
+    {
+        m_error = "Cannot open map file: " + _file;
+        return false;
+    }
+
+    // 一次性读入整个文件,避免逐行读取的开销
+    _in.seekg(0,std::ios::end);
+    std::streamoff _size = _in.tellg();
+    _in.seekg(0,std::ios::beg);
+
+    std::vector<char> _text(static_cast<size_t>(_size) + 1,'\0');
+
+    if(_size > 0 && !_in.read(_text.data(),_size))
+    {
+        m_error = "Cannot read map file: " + _file;
+        return false;
+    }
+
+    return Parse(_text.data(),static_cast<size_t>(_size));
+}
+
+bool RfidMap::Parse(const char *_text, const size_t &_size)
+{
+    std::vector<NodeInfo> _nodes;
+    std::vector<EdgeInfo> _edges;
+
+    const char* _ptr = _text;               /*!< 当前解析位置 */
+    const char* _end = _text + _size;       /*!< 文本结束位置 */
+    size_t _line = 0;                       /*!< 当前行号 */
+    bool _bValid = true;                    /*!< 所有记录是否有效 */
+
+    while(_ptr < _end)
+    {
+        ++_line;
+
+        const char* _eol = static_cast<const char*>(memchr(_ptr,'\n',static_cast<size_t>(_end - _ptr)));
+
+        if(_eol == nullptr)
+        {
+            _eol = _end;
+        }
+
+        // 截取本行并去除注释
+        std::string _record(_ptr,static_cast<size_t>(_eol - _ptr));
+        std::string::size_type _comment = _record.find('#');
+
+        if(_comment != std::string::npos)
+        {
+            _record.erase(_comment);
+        }
+
+        _ptr = _eol + 1;
+
+        const char* _field = _record.c_str();
+        char* _next = nullptr;
+
+        while(*_field == ' ' || *_field == '\t' || *_field == '\r')
+        {
+            ++_field;
+        }
+
+        if(*_field == '\0')
+        {
+            // 空行
+            continue;
+        }
+
+        if(strncmp(_field,"node",4) == 0 && (_field[4] == ' ' || _field[4] == '\t'))
+        {
+            NodeInfo _node;
+
+            long _rfid = strtol(_field + 4,&_next,10);
+            _field = _next;
+            _node.m_x = strtof(_field,&_next);
+
+            if(_next == _field)
+            {
+                _bValid = false;
+                break;
+            }
+
+            _field = _next;
+            _node.m_y = strtof(_field,&_next);
+
+            if(_next == _field)
+            {
+                _bValid = false;
+                break;
+            }
+
+            _field = _next;
+            long _zone = strtol(_field,&_next,10);
+
+            // strtof可解析出nan与inf,坐标需为有限值
+            if(_rfid <= 0 || _rfid >= static_cast<long>(RFID_COUNT) || _zone < 0 || _zone > 255 || IsBlank(_next) == false
+                    || std::isfinite(_node.m_x) == false || std::isfinite(_node.m_y) == false)
+            {
+                _bValid = false;
+                break;
+            }
+
+            _node.m_rfid = static_cast<RfidBase::Rfid_t>(_rfid);
+            _node.m_zone = static_cast<Zone_t>(_zone);
+
+            _nodes.push_back(_node);
+            continue;
+        }
+
+        bool _bi = strncmp(_field,"biedge",6) == 0 && (_field[6] == ' ' || _field[6] == '\t');
+
+        if(_bi || (strncmp(_field,"edge",4) == 0 && (_field[4] == ' ' || _field[4] == '\t')))
+        {
+            EdgeInfo _edge;
+
+            _field += _bi ? 6 : 4;
+
+            long _from = strtol(_field,&_next,10);
+            _field = _next;
+            long _to = strtol(_field,&_next,10);
+            _field = _next;
+            long long _weight = strtoll(_field,&_next,10);
+
+            if(_next == _field)
+            {
+                _bValid = false;
+                break;
+            }
+
+            _field = _next;
+            _edge.m_maxSpeed = strtof(_field,&_next);
+            _field = _next;
+            long _turn = strtol(_field,&_next,10);
+
+            // 距离需小于表示不可达的INFINITE,速度需为有限值
+            if(_from <= 0 || _from >= static_cast<long>(RFID_COUNT) || _to <= 0 || _to >= static_cast<long>(RFID_COUNT)
+                    || _weight < 0 || _weight >= static_cast<long long>(INFINITE)
+                    || std::isfinite(_edge.m_maxSpeed) == false || _edge.m_maxSpeed < 0.0f
+                    || _turn < Turn_Straight || _turn > Turn_Back || IsBlank(_next) == false)
+            {
+                _bValid = false;
+                break;
+            }
+
+            _edge.m_from = static_cast<RfidBase::Rfid_t>(_from);
+            _edge.m_to = static_cast<RfidBase::Rfid_t>(_to);
+            _edge.m_weight = static_cast<Weight_t>(_weight);
+            _edge.m_turn = static_cast<unsigned char>(_turn);
+
+            _edges.push_back(_edge);
+
+            if(_bi)
+            {
+                std::swap(_edge.m_from,_edge.m_to);
+                _edges.push_back(_edge);
+            }
+
+            continue;
+        }
+
+        _bValid = false;
+        break;
+    }
+
+    if(_bValid == false)
+    {
+        std::ostringstream _err;
+        _err << "Invalid map record at line " << _line;
+
+        Clear();
+        m_error = _err.str();
+
+        return false;
+    }
+
+    return Build(_nodes,_edges);
+}
+
+bool RfidMap::Build(const std::vector<NodeInfo> &_nodes, const std::vector<EdgeInfo> &_edges)
+{
+    Clear();
+
+    m_index.assign(RFID_COUNT,NIL);
+
+    size_t _nodeCount = _nodes.size();
+
+    m_rfids.resize(_nodeCount);
+    m_x.resize(_nodeCount);
+    m_y.resize(_nodeCount);
+    m_zones.resize(_nodeCount);
+
+    for(size_t i = 0; i < _nodeCount; ++i)
+    {
+        const NodeInfo& _node = _nodes[i];
+
+        if(_node.m_rfid == 0 || m_index[_node.m_rfid] != NIL)
+        {
+            std::ostringstream _err;
+            _err << "Invalid or duplicate node " << _node.m_rfid;
+
+            Clear();
+            m_error = _err.str();
+
+            return false;
+        }
+
+        m_index[_node.m_rfid] = static_cast<Node_t>(i);
+        m_rfids[i] = _node.m_rfid;
+        m_x[i] = _node.m_x;
+        m_y[i] = _node.m_y;
+        m_zones[i] = _node.m_zone;
+    }
+
+    size_t _edgeCount = _edges.size();
+
+    // 按起点与终点计数,用计数排序生成正向与反向的邻接数组
+    m_offset.assign(_nodeCount + 1,0);
+    m_rOffset.assign(_nodeCount + 1,0);
+
+    for(size_t i = 0; i < _edgeCount; ++i)
+    {
+        Node_t _from = m_index[_edges[i].m_from];
+        Node_t _to = m_index[_edges[i].m_to];
+
+        if(_from == NIL || _to == NIL)
+        {
+            std::ostringstream _err;
+            _err << "Edge " << _edges[i].m_from << "->" << _edges[i].m_to << " references an unknown node";
+
+            Clear();
+            m_error = _err.str();
+
+            return false;
+        }
+
+        ++m_offset[_from + 1];
+        ++m_rOffset[_to + 1];
+    }
+
+    for(size_t i = 0; i < _nodeCount; ++i)
+    {
+        m_offset[i + 1] += m_offset[i];
+        m_rOffset[i + 1] += m_rOffset[i];
+    }
+
+    m_target.resize(_edgeCount);
+    m_weight.resize(_edgeCount);
+    m_maxSpeed.resize(_edgeCount);
+    m_turn.resize(_edgeCount);
+
+    std::vector<Edge_t> _fill(m_offset.begin(),m_offset.end() - 1);    /*!< 各节点出边的写入位置 */
+
+    for(size_t i = 0; i < _edgeCount; ++i)
+    {
+        const EdgeInfo& _edge = _edges[i];
+
+        Edge_t _index = _fill[m_index[_edge.m_from]]++;
+
+        m_target[_index] = m_index[_edge.m_to];
+        m_weight[_index] = _edge.m_weight;
+        m_maxSpeed[_index] = _edge.m_maxSpeed;
+        m_turn[_index] = _edge.m_turn;
+    }
+
+    m_rSource.resize(_edgeCount);
+    m_rEdge.resize(_edgeCount);
+
+    _fill.assign(m_rOffset.begin(),m_rOffset.end() - 1);
+
+    for(Node_t _from = 0; _from < _nodeCount; ++_from)
+    {
+        for(Edge_t _edge = m_offset[_from]; _edge < m_offset[_from + 1]; ++_edge)
+        {
+            Edge_t _index = _fill[m_target[_edge]]++;
+
+            m_rSource[_index] = _from;
+            m_rEdge[_index] = _edge;
+        }
+    }
+
+    m_error.clear();
+
+    return true;
+}
+
+void RfidMap::Clear()
+{
+    m_index.clear();
+    m_rfids.clear();
+    m_x.clear();
+    m_y.clear();
+    m_zones.clear();
+    m_offset.clear();
+    m_target.clear();
+    m_weight.clear();
+    m_maxSpeed.clear();
+    m_turn.clear();
+    m_rOffset.clear();
+    m_rSource.clear();
+    m_rEdge.clear();
+
+    return;
+}
+
+std::string RfidMap::GetError() const
+{
+    return m_error;
+}
+
+RfidMap::Edge_t RfidMap::FindEdge(const Node_t &_from, const Node_t &_to) const
+{
+    Edge_t _found = NIL;
+
+    for(Edge_t _edge = m_offset[_from]; _edge < m_offset[_from + 1]; ++_edge)
+    {
+        if(m_target[_edge] == _to && (_found == NIL || m_weight[_edge] < m_weight[_found]))
+        {
+            _found = _edge;
+        }
+    }
+
+    return _found;
+}
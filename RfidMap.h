@@ -0,0 +1,189 @@
+/*!
+ * @file RfidMap
+ * @brief 描述RFID地标卡路线图的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef RFIDMAP_H
+#define RFIDMAP_H
+
+#include <string>
+#include <vector>
+#include "RfidBase.h"
+
+/*!
+ * @class RfidMap
+ * @brief 以压缩稀疏行(CSR)方式储存的RFID地标卡有向路线图
+ *
+ * 地标卡编号通过65536项的数组直接映射为连续的节点下标,节点与路段的属性按列分别储存在连续数组中
+ * 同时储存反向的邻接关系,供反向搜索使用
+ *
+ * 地图文件为文本格式,每行一条记录,#之后为注释:
+ * node <RFID> <X> <Y> [区域]                   X、Y单位(mm),区域默认为0
+ * edge <起点RFID> <终点RFID> <距离> [最大速度] [转向]   单向路段,距离单位(mm),最大速度单位(m/min),0为不限速
+ * biedge <RFID> <RFID> <距离> [最大速度] [转向]        双向路段
+ */
+class RfidMap
+{
+public:
+    RfidMap();
+
+public:
+    typedef unsigned int Node_t;        /*!< 节点下标 */
+    typedef unsigned int Edge_t;        /*!< 路段下标 */
+    typedef unsigned int Weight_t;      /*!< 路段距离:单位(mm) */
+    typedef unsigned char Zone_t;       /*!< 区域编号 */
+
+    static const Node_t NIL = 0xFFFFFFFF;               /*!< 无效的节点或路段下标 */
+    static const Weight_t INFINITE = 0xFFFFFFFF;        /*!< 不可达的距离 */
+    static const size_t RFID_COUNT = 65536;             /*!< RFID地标卡编号的数量 */
+
+    /*! @brief 描述路段转向类型的枚举 */
+    enum TurnType
+    {
+        Turn_Straight,  /*!< 直行 */
+        Turn_Left,      /*!< 左转 */
+        Turn_Right,     /*!< 右转 */
+        Turn_Back,      /*!< 掉头 */
+    };
+
+    /*! @brief 描述节点的结构体,用于构建地图 */
+    struct NodeInfo
+    {
+        RfidBase::Rfid_t m_rfid;    /*!< RFID地标卡编号 */
+        float m_x;                  /*!< X坐标:单位(mm) */
+        float m_y;                  /*!< Y坐标:单位(mm) */
+        Zone_t m_zone;              /*!< 区域编号 */
+    };
+
+    /*! @brief 描述路段的结构体,用于构建地图 */
+    struct EdgeInfo
+    {
+        RfidBase::Rfid_t m_from;    /*!< 起点RFID地标卡编号 */
+        RfidBase::Rfid_t m_to;      /*!< 终点RFID地标卡编号 */
+        Weight_t m_weight;          /*!< 距离:单位(mm) */
+        float m_maxSpeed;           /*!< 最大速度:单位(m/min) */
+        unsigned char m_turn;       /*!< 转向类型 */
+    };
+
+protected:
+    std::vector<Node_t> m_index;            /*!< RFID地标卡编号至节点下标的映射 */
+    std::vector<RfidBase::Rfid_t> m_rfids;  /*!< 节点的RFID地标卡编号 */
+    std::vector<float> m_x;                 /*!< 节点的X坐标 */
+    std::vector<float> m_y;                 /*!< 节点的Y坐标 */
+    std::vector<Zone_t> m_zones;            /*!< 节点的区域编号 */
+
+    std::vector<Edge_t> m_offset;           /*!< 节点出边的起始下标,共节点数量+1项 */
+    std::vector<Node_t> m_target;           /*!< 路段的终点 */
+    std::vector<Weight_t> m_weight;         /*!< 路段的距离 */
+    std::vector<float> m_maxSpeed;          /*!< 路段的最大速度 */
+    std::vector<unsigned char> m_turn;      /*!< 路段的转向类型 */
+
+    std::vector<Edge_t> m_rOffset;          /*!< 节点入边的起始下标,共节点数量+1项 */
+    std::vector<Node_t> m_rSource;          /*!< 入边的起点 */
+    std::vector<Edge_t> m_rEdge;            /*!< 入边对应的路段下标 */
+
+    std::string m_error;                    /*!< 最后一次加载失败的原因 */
+
+public:
+    /*!
+     * @brief 从地图文件加载路线图
+     * @param const std::string& 地图文件路径
+     * @return bool 加载成功返回true,否则返回false,失败原因通过GetError获取
+     */
+    bool Load(const std::string& _file);
+
+    /*!
+     * @brief 从文本加载路线图
+     * @param const char* 文本内容
+     * @param const size_t& 文本大小
+     * @return bool 加载成功返回true,否则返回false
+     */
+    bool Parse(const char* _text,const size_t& _size);
+
+    /*!
+     * @brief 由节点与路段构建路线图
+     * @param const std::vector<NodeInfo>& 节点
+     * @param const std::vector<EdgeInfo>& 路段
+     * @return bool 构建成功返回true,节点重复或路段的端点不存在时返回false
+     */
+    bool Build(const std::vector<NodeInfo>& _nodes,const std::vector<EdgeInfo>& _edges);
+
+    /*!
+     * @brief 清空路线图
+     */
+    void Clear();
+
+    /*!
+     * @brief 获取最后一次加载失败的原因
+     * @return std::string 失败原因
+     */
+    std::string GetError() const;
+
+public:
+    /*!
+     * @brief 获取节点数量
+     * @return size_t 节点数量
+     */
+    size_t GetNodeCount() const { return m_rfids.size(); }
+
+    /*!
+     * @brief 获取路段数量
+     * @return size_t 路段数量
+     */
+    size_t GetEdgeCount() const { return m_target.size(); }
+
+    /*!
+     * @brief 获取RFID地标卡对应的节点下标
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @return Node_t 节点下标,地标卡不在路线图中时返回NIL
+     */
+    Node_t GetNode(const RfidBase::Rfid_t& _rfid) const { return m_index.empty() ? NIL : m_index[_rfid]; }
+
+    /*!
+     * @brief 获取节点对应的RFID地标卡编号
+     * @param const Node_t& 节点下标
+     * @return RfidBase::Rfid_t RFID地标卡编号
+     */
+    RfidBase::Rfid_t GetRfid(const Node_t& _node) const { return m_rfids[_node]; }
+
+    float GetX(const Node_t& _node) const { return m_x[_node]; }
+    float GetY(const Node_t& _node) const { return m_y[_node]; }
+    Zone_t GetZone(const Node_t& _node) const { return m_zones[_node]; }
+
+    /*!
+     * @brief 获取节点出边的下标范围[begin,end)
+     */
+    Edge_t EdgeBegin(const Node_t& _node) const { return m_offset[_node]; }
+    Edge_t EdgeEnd(const Node_t& _node) const { return m_offset[_node + 1]; }
+
+    Node_t GetTarget(const Edge_t& _edge) const { return m_target[_edge]; }
+    Weight_t GetWeight(const Edge_t& _edge) const { return m_weight[_edge]; }
+    float GetMaxSpeed(const Edge_t& _edge) const { return m_maxSpeed[_edge]; }
+    unsigned char GetTurn(const Edge_t& _edge) const { return m_turn[_edge]; }
+
+    /*!
+     * @brief 获取节点入边的下标范围[begin,end)
+     */
+    Edge_t InEdgeBegin(const Node_t& _node) const { return m_rOffset[_node]; }
+    Edge_t InEdgeEnd(const Node_t& _node) const { return m_rOffset[_node + 1]; }
+
+    Node_t GetInSource(const Edge_t& _in) const { return m_rSource[_in]; }
+    Edge_t GetInEdge(const Edge_t& _in) const { return m_rEdge[_in]; }
+
+    /*!
+     * @brief 查找两个节点之间的路段
+     * @param const Node_t& 起点
+     * @param const Node_t& 终点
+     * @return Edge_t 距离最短的路段下标,不存在时返回NIL
+     */
+    Edge_t FindEdge(const Node_t& _from,const Node_t& _to) const;
+
+    /*!
+     * @brief 获取路段数组,下标与路段下标一致,供按路段储存数据的模块对齐使用
+     * @return const std::vector<Weight_t>& 路段的距离
+     */
+    const std::vector<Weight_t>& GetWeights() const { return m_weight; }
+};
+
+#endif // RFIDMAP_H
@@ -0,0 +1,356 @@
+#include "RfidRegistry.h"
+
+const AgvBase::AId_t RfidRegistry::NOBODY = 0xFFFF;
+const size_t RfidRegistry::RFID_COUNT = 65536;
+const RfidRegistry::HandlerId_t RfidRegistry::NO_HANDLER = 0;
+
+RfidRegistry::RfidRegistry()
+    : m_words(RFID_COUNT)
+{
+    m_start = std::chrono::steady_clock::now();
+    m_nextHandler = 1;
+    m_pHandlers = std::make_shared<const HandlerList>();
+
+    ClearAll();
+}
+
+RfidRegistry::~RfidRegistry()
+{
+}
+
+RfidRegistry &RfidRegistry::Instance()
+{
+    static RfidRegistry _registry;
+
+    return _registry;
+}
+
+bool RfidRegistry::Lock(const RfidBase::Rfid_t &_rfid, const AgvBase::AId_t &_agv)
+{
+    std::atomic<Word_t>& _word = m_words[_rfid];
+
+    Word_t _old = _word.load(std::memory_order_acquire);
+
+    while(true)
+    {
+        AgvBase::AId_t _locker = Locker(_old);
+
+        if(_locker == _agv)
+        {
+            return true;
+        }
+
+        if(_locker != NOBODY)
+        {
+            return false;
+        }
+
+        AgvBase::AId_t _peer = Peer(_old);
+
+        if(_peer == _agv)
+        {
+            // 锁定后不再需要自身的远程锁定
+            _peer = NOBODY;
+        }
+
+        if(_word.compare_exchange_weak(_old,Pack(_agv,_peer,Now()),std::memory_order_acq_rel,std::memory_order_acquire))
+        {
+            return true;
+        }
+    }
+}
+
+bool RfidRegistry::Free(const RfidBase::Rfid_t &_rfid, const AgvBase::AId_t &_agv)
+{
+    std::atomic<Word_t>& _word = m_words[_rfid];
+
+    Word_t _old = _word.load(std::memory_order_acquire);
+
+    while(true)
+    {
+        AgvBase::AId_t _locker = Locker(_old);
+
+        if(_locker == NOBODY)
+        {
+            return true;
+        }
+
+        if(_locker != _agv)
+        {
+            return false;
+        }
+
+        if(_word.compare_exchange_weak(_old,Pack(NOBODY,Peer(_old),0),std::memory_order_acq_rel,std::memory_order_acquire))
+        {
+            Freed(_rfid);
+
+            return true;
+        }
+    }
+}
+
+void RfidRegistry::Free(const RfidBase::Rfid_t &_rfid)
+{
+    std::atomic<Word_t>& _word = m_words[_rfid];
+
+    Word_t _old = _word.load(std::memory_order_acquire);
+
+    while(_word.compare_exchange_weak(_old,Pack(NOBODY,Peer(_old),0),std::memory_order_acq_rel,std::memory_order_acquire) == false)
+    {
+    }
+
+    if(Locker(_old) != NOBODY)
+    {
+        Freed(_rfid);
+    }
+
+    return;
+}
+
+bool RfidRegistry::PeerLock(const RfidBase::Rfid_t &_rfid, const AgvBase::AId_t &_agv)
+{
+    std::atomic<Word_t>& _word = m_words[_rfid];
+
+    Word_t _old = _word.load(std::memory_order_acquire);
+
+    while(true)
+    {
+        AgvBase::AId_t _peer = Peer(_old);
+
+        if(_peer == _agv)
+        {
+            return true;
+        }
+
+        if(_peer != NOBODY)
+        {
+            return false;
+        }
+
+        if(_word.compare_exchange_weak(_old,Pack(Locker(_old),_agv,Time(_old)),std::memory_order_acq_rel,std::memory_order_acquire))
+        {
+            return true;
+        }
+    }
+}
+
+bool RfidRegistry::Cancel(const RfidBase::Rfid_t &_rfid, const AgvBase::AId_t &_agv)
+{
+    std::atomic<Word_t>& _word = m_words[_rfid];
+
+    Word_t _old = _word.load(std::memory_order_acquire);
+
+    while(true)
+    {
+        AgvBase::AId_t _peer = Peer(_old);
+
+        if(_peer == NOBODY)
+        {
+            return true;
+        }
+
+        if(_peer != _agv)
+        {
+            return false;
+        }
+
+        if(_word.compare_exchange_weak(_old,Pack(Locker(_old),NOBODY,Time(_old)),std::memory_order_acq_rel,std::memory_order_acquire))
+        {
+            return true;
+        }
+    }
+}
+
+void RfidRegistry::Cancel(const RfidBase::Rfid_t &_rfid)
+{
+    std::atomic<Word_t>& _word = m_words[_rfid];
+
+    Word_t _old = _word.load(std::memory_order_acquire);
+
+    while(_word.compare_exchange_weak(_old,Pack(Locker(_old),NOBODY,Time(_old)),std::memory_order_acq_rel,std::memory_order_acquire) == false)
+    {
+    }
+
+    return;
+}
+
+void RfidRegistry::Clear(const RfidBase::Rfid_t &_rfid)
+{
+    Word_t _old = m_words[_rfid].exchange(Pack(NOBODY,NOBODY,0),std::memory_order_acq_rel);
+
+    if(Locker(_old) != NOBODY)
+    {
+        Freed(_rfid);
+    }
+
+    return;
+}
+
+void RfidRegistry::ClearAll()
+{
+    for(std::vector<std::atomic<Word_t> >::iterator it = m_words.begin(); it != m_words.end(); ++it)
+    {
+        it->store(Pack(NOBODY,NOBODY,0),std::memory_order_release);
+    }
+
+    return;
+}
+
+size_t RfidRegistry::FreeAll(const AgvBase::AId_t &_agv)
+{
+    size_t _count = 0;
+
+    for(size_t i = 0; i < RFID_COUNT; ++i)
+    {
+        Word_t _old = m_words[i].load(std::memory_order_relaxed);
+
+        if(Locker(_old) != _agv && Peer(_old) != _agv)
+        {
+            continue;
+        }
+
+        RfidBase::Rfid_t _rfid = static_cast<RfidBase::Rfid_t>(i);
+
+        if(Locker(_old) == _agv && Free(_rfid,_agv))
+        {
+            ++_count;
+        }
+
+        if(Peer(_old) == _agv && Cancel(_rfid,_agv))
+        {
+            ++_count;
+        }
+    }
+
+    return _count;
+}
+
+RfidRegistry::HandlerId_t RfidRegistry::Subscribe(const RfidRegistry::FreeHandler &_handler)
+{
+    if(_handler == nullptr)
+    {
+        return NO_HANDLER;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    HandlerId_t _id = m_nextHandler++;
+
+    std::shared_ptr<HandlerList> _list = std::make_shared<HandlerList>(*m_pHandlers);
+    _list->m_entries.push_back(std::make_pair(_id,_handler));
+
+    Publish(_list);
+
+    return _id;
+}
+
+void RfidRegistry::Unsubscribe(const RfidRegistry::HandlerId_t &_id)
+{
+    if(_id == NO_HANDLER)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::shared_ptr<HandlerList> _list = std::make_shared<HandlerList>();
+
+    // 只有持有锁的线程替换列表,可直接读取;不另外持有当前列表,否则发布时会等待自己
+    const std::vector<std::pair<HandlerId_t,FreeHandler> >& _entries = m_pHandlers->m_entries;
+
+    for(std::vector<std::pair<HandlerId_t,FreeHandler> >::const_iterator it = _entries.begin(); it != _entries.end(); ++it)
+    {
+        if(it->first != _id)
+        {
+            _list->m_entries.push_back(*it);
+        }
+    }
+
+    Publish(_list);
+
+    return;
+}
+
+AgvBase::AId_t RfidRegistry::GetLocker(const RfidBase::Rfid_t &_rfid) const
+{
+    return Locker(m_words[_rfid].load(std::memory_order_acquire));
+}
+
+AgvBase::AId_t RfidRegistry::GetPeerLocker(const RfidBase::Rfid_t &_rfid) const
+{
+    return Peer(m_words[_rfid].load(std::memory_order_acquire));
+}
+
+bool RfidRegistry::IsLocked(const RfidBase::Rfid_t &_rfid) const
+{
+    return GetLocker(_rfid) != NOBODY;
+}
+
+std::chrono::steady_clock::time_point RfidRegistry::GetLockTime(const RfidBase::Rfid_t &_rfid) const
+{
+    Word_t _word = m_words[_rfid].load(std::memory_order_acquire);
+
+    if(Locker(_word) == NOBODY)
+    {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration::zero());
+    }
+
+    // 按32位回绕计算锁定至今的时长
+    unsigned int _age = Now() - Time(_word);
+
+    return std::chrono::steady_clock::now() - std::chrono::milliseconds(_age);
+}
+
+void RfidRegistry::Freed(const RfidBase::Rfid_t &_rfid) const
+{
+    // 持有列表期间列表不会被释放,取消订阅会等待本线程释放持有
+    std::shared_ptr<const HandlerList> _list = std::atomic_load(&m_pHandlers);
+
+    for(std::vector<std::pair<HandlerId_t,FreeHandler> >::const_iterator it = _list->m_entries.begin(); it != _list->m_entries.end(); ++it)
+    {
+        it->second(_rfid);
+    }
+
+    return;
+}
+
+void RfidRegistry::Publish(const std::shared_ptr<const RfidRegistry::HandlerList> &_list)
+{
+    std::shared_ptr<const HandlerList> _old = std::atomic_load(&m_pHandlers);
+
+    std::atomic_store(&m_pHandlers,_list);
+
+    // 替换后新的读者只能取得新列表,旧列表的引用计数降为1时只剩本线程持有,不会再调用其中的处理函数
+    while(_old.use_count() > 1)
+    {
+        std::this_thread::yield();
+    }
+
+    return;
+}
+
+RfidRegistry::Word_t RfidRegistry::Pack(const AgvBase::AId_t &_locker, const AgvBase::AId_t &_peer, const unsigned int &_time)
+{
+    return static_cast<Word_t>(_locker) | (static_cast<Word_t>(_peer) << 16) | (static_cast<Word_t>(_time) << 32);
+}
+
+AgvBase::AId_t RfidRegistry::Locker(const RfidRegistry::Word_t &_word)
+{
+    return static_cast<AgvBase::AId_t>(_word & 0xFFFF);
+}
+
+AgvBase::AId_t RfidRegistry::Peer(const RfidRegistry::Word_t &_word)
+{
+    return static_cast<AgvBase::AId_t>((_word >> 16) & 0xFFFF);
+}
+
+unsigned int RfidRegistry::Time(const RfidRegistry::Word_t &_word)
+{
+    return static_cast<unsigned int>(_word >> 32);
+}
+
+unsigned int RfidRegistry::Now() const
+{
+    return static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         std::chrono::steady_clock::now() - m_start).count());
+}
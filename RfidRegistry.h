@@ -0,0 +1,217 @@
+/*!
+ * @file RfidRegistry
+ * @brief 描述RFID地标卡锁定状态注册表功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef RFIDREGISTRY_H
+#define RFIDREGISTRY_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AgvBase.h"
+
+/*!
+ * @class RfidRegistry
+ * @brief 以RFID地标卡编号直接索引的锁定状态注册表
+ *
+ * 每个地标卡的锁定状态压缩为一个64位原子字:低16位为锁定的AGV编号,中16位为远程锁定的AGV编号,高32位为锁定时间
+ * 锁定、释放、远程锁定与取消均为对单个字的CAS操作,可在任意线程中调用,无需互斥锁
+ * 锁定语义与RfidBase一致,锁定者以AGV编号表示,编号NOBODY保留为无锁定;RfidBase自身的锁定状态不经过注册表,只能在单线程中使用
+ * 地标卡由锁定变为未锁定时依次调用订阅的释放处理函数,供交通管制等功能以事件方式响应
+ * 处理函数列表整体替换发布,调用方以共享指针的原子读取持有列表,调用处理函数不加锁;取消订阅在旧列表的持有者全部退出后返回
+ */
+class RfidRegistry
+{
+public:
+    RfidRegistry();
+    ~RfidRegistry();
+
+    RfidRegistry(const RfidRegistry&) = delete;
+    void operator=(const RfidRegistry&) = delete;
+
+public:
+    typedef unsigned long long Word_t;
+
+    /*!
+     * @brief 地标卡释放的处理函数,在释放地标卡的线程中调用
+     * @param const RfidBase::Rfid_t& 被释放的RFID地标卡编号
+     */
+    typedef std::function<void(const RfidBase::Rfid_t&)> FreeHandler;
+
+    typedef unsigned int HandlerId_t;       /*!< 订阅编号 */
+
+    static const AgvBase::AId_t NOBODY;     /*!< 无锁定者 */
+    static const size_t RFID_COUNT;         /*!< RFID地标卡编号的数量 */
+    static const HandlerId_t NO_HANDLER;    /*!< 无效的订阅编号 */
+
+protected:
+    /*! @brief 描述一份释放处理函数列表的结构体,发布后不再修改 */
+    struct HandlerList
+    {
+        std::vector<std::pair<HandlerId_t,FreeHandler> > m_entries;     /*!< 订阅编号与处理函数 */
+    };
+
+protected:
+    std::chrono::steady_clock::time_point m_start;  /*!< 锁定时间的起点 */
+    std::vector<std::atomic<Word_t> > m_words;      /*!< 各RFID地标卡的锁定状态 */
+    std::shared_ptr<const HandlerList> m_pHandlers; /*!< 当前的释放处理函数列表,只以std::atomic_load与std::atomic_store访问 */
+    std::mutex m_mutex;                             /*!< 订阅与取消订阅的互斥锁 */
+    HandlerId_t m_nextHandler;                      /*!< 下一个订阅编号 */
+
+public:
+    /*!
+     * @brief 获取全局注册表
+     * @return RfidRegistry& 全局注册表
+     */
+    static RfidRegistry& Instance();
+
+public:
+    /*!
+     * @brief 锁定RFID地标卡
+     *
+     * 锁定成功时记录锁定时间,并取消该AGV自身的远程锁定
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool 未被锁定或已被该AGV锁定返回true,否则返回false
+     */
+    bool Lock(const RfidBase::Rfid_t& _rfid,const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 释放AGV对RFID地标卡的锁定
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool 未被其他AGV锁定返回true,否则返回false
+     */
+    bool Free(const RfidBase::Rfid_t& _rfid,const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 强制释放RFID地标卡的锁定
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Free(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 远程锁定RFID地标卡,即AGV不在地标卡上,提前锁定
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool 未被远程锁定或已被该AGV远程锁定返回true,否则返回false
+     */
+    bool PeerLock(const RfidBase::Rfid_t& _rfid,const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 取消AGV对RFID地标卡的远程锁定
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool 未被其他AGV远程锁定返回true,否则返回false
+     */
+    bool Cancel(const RfidBase::Rfid_t& _rfid,const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 强制取消RFID地标卡的远程锁定
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Cancel(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 清除RFID地标卡的锁定与远程锁定
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Clear(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 清除所有RFID地标卡的锁定与远程锁定
+     */
+    void ClearAll();
+
+    /*!
+     * @brief 释放并取消AGV对所有RFID地标卡的锁定与远程锁定
+     *
+     * 遍历全部地标卡,用于AGV离线等不频繁的场合
+     * @param const AgvBase::AId_t& AGV编号
+     * @return size_t 释放与取消的数量
+     */
+    size_t FreeAll(const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 订阅地标卡释放的处理函数
+     *
+     * 等待正在调用处理函数的线程退出,不能在释放处理函数中调用
+     * @param const FreeHandler& 处理函数
+     * @return HandlerId_t 订阅编号,处理函数为空时返回NO_HANDLER
+     */
+    HandlerId_t Subscribe(const FreeHandler& _handler);
+
+    /*!
+     * @brief 取消订阅,返回后该处理函数不会再被调用
+     *
+     * 等待正在调用处理函数的线程退出,不能在释放处理函数中调用
+     * @param const HandlerId_t& 订阅编号
+     */
+    void Unsubscribe(const HandlerId_t& _id);
+
+    /*!
+     * @brief 获取锁定RFID地标卡的AGV
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @return AgvBase::AId_t AGV编号,未被锁定时返回NOBODY
+     */
+    AgvBase::AId_t GetLocker(const RfidBase::Rfid_t& _rfid) const;
+
+    /*!
+     * @brief 获取远程锁定RFID地标卡的AGV
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @return AgvBase::AId_t AGV编号,未被远程锁定时返回NOBODY
+     */
+    AgvBase::AId_t GetPeerLocker(const RfidBase::Rfid_t& _rfid) const;
+
+    /*!
+     * @brief RFID地标卡是否被锁定
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @return bool 被锁定返回true
+     */
+    bool IsLocked(const RfidBase::Rfid_t& _rfid) const;
+
+    /*!
+     * @brief 获取RFID地标卡的锁定时间
+     *
+     * 锁定时间以32位毫秒数保存,锁定超过约49天后不再准确
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @return std::chrono::steady_clock::time_point 锁定时间,未被锁定时返回零时间
+     */
+    std::chrono::steady_clock::time_point GetLockTime(const RfidBase::Rfid_t& _rfid) const;
+
+protected:
+    /*!
+     * @brief 组合锁定状态
+     */
+    static Word_t Pack(const AgvBase::AId_t& _locker,const AgvBase::AId_t& _peer,const unsigned int& _time);
+
+    static AgvBase::AId_t Locker(const Word_t& _word);
+    static AgvBase::AId_t Peer(const Word_t& _word);
+    static unsigned int Time(const Word_t& _word);
+
+    /*!
+     * @brief 地标卡被释放时依次调用订阅的处理函数
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Freed(const RfidBase::Rfid_t& _rfid) const;
+
+    /*!
+     * @brief 发布新的处理函数列表,等待持有旧列表的读者退出,调用方需持有锁
+     * @param const std::shared_ptr<const HandlerList>& 新的列表
+     */
+    void Publish(const std::shared_ptr<const HandlerList>& _list);
+
+    /*!
+     * @brief 当前时间相对起点的毫秒数
+     * @return unsigned int 毫秒数,按32位回绕
+     */
+    unsigned int Now() const;
+};
+
+#endif // RFIDREGISTRY_H
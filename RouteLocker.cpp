@@ -0,0 +1,383 @@
+#include "RouteLocker.h"
+
+#include <algorithm>
+#include <iterator>
+
+RouteLocker::RouteLocker(RfidRegistry &_registry, const size_t &_window)
+    : m_registry(_registry),m_blocked(RfidRegistry::RFID_COUNT)
+{
+    m_pDetector = nullptr;
+    m_pPlanner = nullptr;
+    m_window = _window == 0 ? 1 : _window;
+
+    for(size_t i = 0; i < m_blocked.size(); ++i)
+    {
+        m_blocked[i].store(false);
+    }
+
+    m_freeHandler = m_registry.Subscribe([this](const RfidBase::Rfid_t& _rfid){ Freed(_rfid); });
+
+    MetricsRegistry& _metrics = MetricsRegistry::Instance();
+
+    m_acquired = _metrics.AddCounter("agv_route_locks_total","Route prefixes locked as a whole");
+    m_rollbacks = _metrics.AddCounter("agv_route_lock_rollbacks_total","Route prefix locks rolled back because a landmark was busy");
+}
+
+RouteLocker::~RouteLocker()
+{
+    // 返回后不会再有线程进入Freed
+    m_registry.Unsubscribe(m_freeHandler);
+
+    // 等待正在AGV线程中前进的回调返回
+    m_guard.Close();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    for(std::map<AgvBase::AId_t,QMetaObject::Connection>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+    {
+        QObject::disconnect(it->second);
+    }
+
+    m_connections.clear();
+}
+
+void RouteLocker::SetDetector(DeadlockDetector *_detector)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_pDetector = _detector;
+
+    return;
+}
+
+void RouteLocker::SetPlanner(IncrementalPlanner *_planner)
+{
+    m_pPlanner.store(_planner);
+
+    return;
+}
+
+void RouteLocker::Watch(AgvBase *_agv)
+{
+    if(_agv == nullptr)
+    {
+        return;
+    }
+
+    LifeGuard::Token _token = m_guard.GetToken();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    QMetaObject::Connection& _connection = m_connections[_agv->GetID()];
+
+    // 重复监视时只保留一个连接
+    QObject::disconnect(_connection);
+
+    // 在AGV所在的线程中直接调用
+    _connection = QObject::connect(_agv,&AgvBase::RfidChanged,[this,_token,_agv]{
+        LifeGuard::Scope _scope(_token);
+
+        if(_scope.IsEntered())
+        {
+            Advance(_agv->GetID(),_agv->GetCurRfid());
+        }
+    });
+
+    return;
+}
+
+void RouteLocker::Unwatch(const AgvBase::AId_t &_agv)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,QMetaObject::Connection>::iterator it = m_connections.find(_agv);
+
+    if(it == m_connections.end())
+    {
+        return;
+    }
+
+    QObject::disconnect(it->second);
+
+    m_connections.erase(it);
+
+    return;
+}
+
+bool RouteLocker::SetRoute(const AgvBase::AId_t &_agv, const std::vector<RfidBase::Rfid_t> &_route)
+{
+    bool _bLocked = false;
+    RfidBase::Rfid_t _busy = 0;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        RouteState& _state = m_states[_agv];
+        _state.m_route = _route;
+        _state.m_pos = 0;
+
+        if(_route.empty())
+        {
+            FreeBehind(_agv,_state);
+            m_states.erase(_agv);
+
+            return true;
+        }
+
+        // 原路线的地标卡不在新窗口内时释放
+        FreeBehind(_agv,_state);
+
+        _bLocked = LockWindow(_agv,_state,_busy);
+    }
+
+    Report(_agv,_bLocked,_busy);
+
+    return _bLocked;
+}
+
+bool RouteLocker::Acquire(const AgvBase::AId_t &_agv, RfidBase::Rfid_t *_busy)
+{
+    bool _bLocked = false;
+    RfidBase::Rfid_t _blocker = 0;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,RouteState>::iterator it = m_states.find(_agv);
+
+        if(it == m_states.end())
+        {
+            return false;
+        }
+
+        _bLocked = LockWindow(_agv,it->second,_blocker);
+    }
+
+    Report(_agv,_bLocked,_blocker);
+
+    if(_bLocked == false && _busy)
+    {
+        *_busy = _blocker;
+    }
+
+    return _bLocked;
+}
+
+bool RouteLocker::Advance(const AgvBase::AId_t &_agv, const RfidBase::Rfid_t &_rfid)
+{
+    bool _bLocked = false;
+    RfidBase::Rfid_t _busy = 0;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,RouteState>::iterator it = m_states.find(_agv);
+
+        if(it == m_states.end())
+        {
+            return false;
+        }
+
+        RouteState& _state = it->second;
+
+        std::vector<RfidBase::Rfid_t>::const_iterator _found = std::find(_state.m_route.begin() + static_cast<long>(_state.m_pos),
+                                                                         _state.m_route.end(),_rfid);
+
+        if(_found == _state.m_route.end())
+        {
+            // 不在剩余路线中,等待重新设置路线
+            return false;
+        }
+
+        _state.m_pos = static_cast<size_t>(_found - _state.m_route.begin());
+
+        FreeBehind(_agv,_state);
+
+        _bLocked = LockWindow(_agv,_state,_busy);
+    }
+
+    Report(_agv,_bLocked,_busy);
+
+    return _bLocked;
+}
+
+void RouteLocker::Release(const AgvBase::AId_t &_agv)
+{
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,RouteState>::iterator it = m_states.find(_agv);
+
+        if(it == m_states.end())
+        {
+            return;
+        }
+
+        for(std::vector<RfidBase::Rfid_t>::iterator _held = it->second.m_held.begin(); _held != it->second.m_held.end(); ++_held)
+        {
+            m_registry.Free(*_held,_agv);
+        }
+
+        m_states.erase(it);
+    }
+
+    Report(_agv,true,0);
+
+    return;
+}
+
+std::vector<RfidBase::Rfid_t> RouteLocker::GetHeld(const AgvBase::AId_t &_agv)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,RouteState>::const_iterator it = m_states.find(_agv);
+
+    if(it == m_states.end())
+    {
+        return std::vector<RfidBase::Rfid_t>();
+    }
+
+    return it->second.m_held;
+}
+
+bool RouteLocker::LockWindow(const AgvBase::AId_t &_agv, RouteLocker::RouteState &_state, RfidBase::Rfid_t &_busy)
+{
+    std::vector<RfidBase::Rfid_t> _window = Window(_state);
+    std::vector<RfidBase::Rfid_t> _locked;  /*!< 本次新锁定的地标卡 */
+
+    // 按编号升序锁定,各AGV的锁定顺序一致
+    for(std::vector<RfidBase::Rfid_t>::iterator it = _window.begin(); it != _window.end(); ++it)
+    {
+        if(std::binary_search(_state.m_held.begin(),_state.m_held.end(),*it))
+        {
+            continue;
+        }
+
+        if(m_registry.GetLocker(*it) == _agv)
+        {
+            // 已由其他途径(交通管制、租约等)锁定,锁定可重入,不视为本次新锁定,失败时也不回滚
+            continue;
+        }
+
+        if(m_registry.Lock(*it,_agv) == false)
+        {
+            _busy = *it;
+
+            // 回滚本次新锁定的地标卡,已持有的地标卡保持不变
+            for(std::vector<RfidBase::Rfid_t>::reverse_iterator _undo = _locked.rbegin(); _undo != _locked.rend(); ++_undo)
+            {
+                m_registry.Free(*_undo,_agv);
+            }
+
+            MetricsRegistry::Instance().Add(m_rollbacks);
+
+            return false;
+        }
+
+        _locked.push_back(*it);
+    }
+
+    if(_locked.empty() == false)
+    {
+        std::vector<RfidBase::Rfid_t> _held;
+
+        std::set_union(_state.m_held.begin(),_state.m_held.end(),_locked.begin(),_locked.end(),std::back_inserter(_held));
+
+        _state.m_held.swap(_held);
+
+        MetricsRegistry::Instance().Add(m_acquired);
+    }
+
+    return true;
+}
+
+void RouteLocker::FreeBehind(const AgvBase::AId_t &_agv, RouteLocker::RouteState &_state)
+{
+    std::vector<RfidBase::Rfid_t> _window = Window(_state);
+    std::vector<RfidBase::Rfid_t> _kept;
+
+    for(std::vector<RfidBase::Rfid_t>::iterator it = _state.m_held.begin(); it != _state.m_held.end(); ++it)
+    {
+        if(std::binary_search(_window.begin(),_window.end(),*it))
+        {
+            _kept.push_back(*it);
+            continue;
+        }
+
+        m_registry.Free(*it,_agv);
+    }
+
+    _state.m_held.swap(_kept);
+
+    return;
+}
+
+std::vector<RfidBase::Rfid_t> RouteLocker::Window(const RouteLocker::RouteState &_state) const
+{
+    size_t _begin = std::min(_state.m_pos,_state.m_route.size());
+    size_t _end = std::min(_begin + m_window,_state.m_route.size());
+
+    std::vector<RfidBase::Rfid_t> _window(_state.m_route.begin() + static_cast<long>(_begin),_state.m_route.begin() + static_cast<long>(_end));
+
+    std::sort(_window.begin(),_window.end());
+    _window.erase(std::unique(_window.begin(),_window.end()),_window.end());
+
+    return _window;
+}
+
+void RouteLocker::Report(const AgvBase::AId_t &_agv, const bool &_bLocked, const RfidBase::Rfid_t &_busy)
+{
+    DeadlockDetector* _detector = nullptr;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        _detector = m_pDetector;
+    }
+
+    if(_detector && _bLocked)
+    {
+        _detector->Resume(_agv);
+    }
+    else if(_detector)
+    {
+        _detector->Wait(_agv,_busy);
+    }
+
+    IncrementalPlanner* _planner = m_pPlanner.load();
+
+    if(_planner == nullptr || _bLocked)
+    {
+        return;
+    }
+
+    // 先阻塞再标记,释放处理函数看到标记时阻塞已生效
+    _planner->Block(_busy);
+    m_blocked[_busy].store(true);
+
+    if(m_registry.IsLocked(_busy) == false && m_blocked[_busy].exchange(false))
+    {
+        // 标记前地标卡已被释放,不会再收到释放事件
+        _planner->Unblock(_busy);
+    }
+
+    return;
+}
+
+void RouteLocker::Freed(const RfidBase::Rfid_t &_rfid)
+{
+    // 绝大多数地标卡未被阻塞,只读取原子标记
+    if(m_blocked[_rfid].load() == false || m_blocked[_rfid].exchange(false) == false)
+    {
+        return;
+    }
+
+    IncrementalPlanner* _planner = m_pPlanner.load();
+
+    if(_planner)
+    {
+        _planner->Unblock(_rfid);
+    }
+
+    return;
+}
@@ -0,0 +1,160 @@
+/*!
+ * @file RouteLocker
+ * @brief 描述AGV路线前方RFID地标卡整体锁定功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef ROUTELOCKER_H
+#define ROUTELOCKER_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "DeadlockDetector.h"
+#include "IncrementalPlanner.h"
+#include "LifeGuard.h"
+
+/*!
+ * @class RouteLocker
+ * @brief 整体锁定AGV路线前方若干RFID地标卡的锁定器
+ *
+ * 每次锁定AGV当前地标卡起的前N个地标卡,全部锁定成功才保留,任一失败则回滚本次新锁定的地标卡,
+ * 避免AGV持有部分地标卡而阻塞其他AGV;锁定按地标卡编号升序进行,各AGV的锁定顺序一致
+ * AGV前进时释放身后的地标卡并锁定新的前方地标卡
+ * 设置增量规划器后,锁定失败时在规划器中阻塞被占用的地标卡,使重规划绕开它,地标卡被释放时解除阻塞
+ */
+class RouteLocker
+{
+public:
+    /*!
+     * @param RfidRegistry& RFID地标卡注册表
+     * @param const size_t& 每次锁定的地标卡数量,包含AGV的当前地标卡
+     */
+    RouteLocker(RfidRegistry& _registry,const size_t& _window = 3);
+    ~RouteLocker();
+
+protected:
+    /*! @brief 描述AGV路线锁定状态的结构体 */
+    struct RouteState
+    {
+        std::vector<RfidBase::Rfid_t> m_route;  /*!< 路线 */
+        size_t m_pos;                           /*!< 当前地标卡在路线中的下标 */
+        std::vector<RfidBase::Rfid_t> m_held;   /*!< 已锁定的地标卡,按编号升序排列 */
+    };
+
+protected:
+    RfidRegistry& m_registry;                           /*!< RFID地标卡注册表 */
+    DeadlockDetector* m_pDetector;                      /*!< 死锁检测器 */
+    std::atomic<IncrementalPlanner*> m_pPlanner;        /*!< 增量规划器,释放处理函数中不加锁读取 */
+    std::vector<std::atomic<bool> > m_blocked;          /*!< 各地标卡是否由本锁定器在规划器中阻塞 */
+    RfidRegistry::HandlerId_t m_freeHandler;            /*!< 释放处理函数的订阅编号 */
+    size_t m_window;                                    /*!< 每次锁定的地标卡数量 */
+    std::mutex m_mutex;                                 /*!< 互斥锁 */
+    std::map<AgvBase::AId_t,RouteState> m_states;       /*!< 各AGV的路线锁定状态 */
+    std::map<AgvBase::AId_t,QMetaObject::Connection> m_connections; /*!< 被监视AGV的当前地标卡改变信号的连接 */
+    LifeGuard m_guard;                                  /*!< 在AGV线程中调用的回调的存活标记 */
+    MetricsRegistry::MetricId m_acquired;               /*!< 整体锁定成功次数的指标 */
+    MetricsRegistry::MetricId m_rollbacks;              /*!< 整体锁定回滚次数的指标 */
+
+public:
+    /*!
+     * @brief 设置死锁检测器,整体锁定失败时报告AGV等待的地标卡
+     * @param DeadlockDetector* 死锁检测器,为nullptr时不报告
+     */
+    void SetDetector(DeadlockDetector* _detector);
+
+    /*!
+     * @brief 设置增量规划器,整体锁定失败时阻塞被占用的地标卡,地标卡被释放后解除阻塞
+     *
+     * 应在开始锁定前设置,更换规划器时不解除原规划器中的阻塞
+     * @param IncrementalPlanner* 增量规划器,为nullptr时不阻塞
+     */
+    void SetPlanner(IncrementalPlanner* _planner);
+
+    /*!
+     * @brief 监视AGV的当前地标卡,改变时自动前进
+     * @param AgvBase* AGV对象
+     */
+    void Watch(AgvBase* _agv);
+
+    /*!
+     * @brief 停止监视AGV,已锁定的地标卡由Release释放
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Unwatch(const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 设置AGV的路线并锁定前方的地标卡
+     *
+     * 释放AGV在原路线上锁定的地标卡
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const std::vector<RfidBase::Rfid_t>& 路线,第一个地标卡为AGV的当前地标卡
+     * @return bool 前方的地标卡全部锁定返回true,否则返回false
+     */
+    bool SetRoute(const AgvBase::AId_t& _agv,const std::vector<RfidBase::Rfid_t>& _route);
+
+    /*!
+     * @brief 重新尝试锁定AGV前方的地标卡
+     * @param const AgvBase::AId_t& AGV编号
+     * @param RfidBase::Rfid_t* 锁定失败时被占用的地标卡,为nullptr时不输出
+     * @return bool 前方的地标卡全部锁定返回true,否则返回false
+     */
+    bool Acquire(const AgvBase::AId_t& _agv,RfidBase::Rfid_t* _busy = nullptr);
+
+    /*!
+     * @brief AGV到达新的地标卡,释放身后的地标卡并锁定前方的地标卡
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const RfidBase::Rfid_t& AGV的当前地标卡
+     * @return bool 前方的地标卡全部锁定返回true,地标卡不在剩余路线中或锁定失败返回false
+     */
+    bool Advance(const AgvBase::AId_t& _agv,const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 释放AGV锁定的所有地标卡并删除其路线
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Release(const AgvBase::AId_t& _agv);
+
+    /*!
+     * @brief 获取AGV已锁定的地标卡
+     * @param const AgvBase::AId_t& AGV编号
+     * @return std::vector<RfidBase::Rfid_t> 已锁定的地标卡,按编号升序排列
+     */
+    std::vector<RfidBase::Rfid_t> GetHeld(const AgvBase::AId_t& _agv);
+
+protected:
+    /*!
+     * @brief 整体锁定当前窗口内的地标卡,调用方需持有锁
+     * @param const AgvBase::AId_t& AGV编号
+     * @param RouteState& 路线锁定状态
+     * @param RfidBase::Rfid_t& 锁定失败时返回被占用的地标卡
+     * @return bool 全部锁定返回true
+     */
+    bool LockWindow(const AgvBase::AId_t& _agv,RouteState& _state,RfidBase::Rfid_t& _busy);
+
+    /*!
+     * @brief 释放不在当前窗口内的地标卡,调用方需持有锁
+     */
+    void FreeBehind(const AgvBase::AId_t& _agv,RouteState& _state);
+
+    /*!
+     * @brief 获取当前窗口内的地标卡,按编号升序排列且不重复
+     */
+    std::vector<RfidBase::Rfid_t> Window(const RouteState& _state) const;
+
+    /*!
+     * @brief 向死锁检测器与增量规划器报告锁定结果,调用时不持有锁
+     */
+    void Report(const AgvBase::AId_t& _agv,const bool& _bLocked,const RfidBase::Rfid_t& _busy);
+
+    /*!
+     * @brief 地标卡被释放,解除本锁定器在规划器中的阻塞,在释放地标卡的线程中调用
+     *
+     * 释放可能发生在持有锁定器锁的线程中,因此不加锁
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Freed(const RfidBase::Rfid_t& _rfid);
+};
+
+#endif // ROUTELOCKER_H
@@ -0,0 +1,356 @@
+#include "RoutePlanner.h"
+
+#include <algorithm>
+#include "AgvBase.h"
+
+const size_t RoutePlanner::DEFAULT_LANDMARKS;
+
+RoutePlanner::RoutePlanner(const RfidMap &_map, const size_t &_landmarks)
+    : m_map(_map)
+{
+    m_nodeCount = m_map.GetNodeCount();
+
+    Prepare(_landmarks);
+}
+
+bool RoutePlanner::Plan(const RfidBase::Rfid_t &_from, const RfidBase::Rfid_t &_to, std::vector<RfidBase::Rfid_t> &_route, Weight_t *_cost, const Weight_t *_penalty) const
+{
+    _route.clear();
+
+    Node_t _source = m_map.GetNode(_from);
+    Node_t _target = m_map.GetNode(_to);
+
+    if(_source == RfidMap::NIL || _target == RfidMap::NIL)
+    {
+        return false;
+    }
+
+    SearchSpace& _space = GetSearchSpace();
+
+    _space.m_cost[_source] = 0;
+    _space.m_parent[_source] = RfidMap::NIL;
+    _space.m_stamp[_source] = _space.m_generation;
+
+    HeapItem _start;
+    _start.m_cost = 0;
+    _start.m_key = Heuristic(_source,_target);
+    _start.m_node = _source;
+
+    _space.m_heap.push_back(_start);
+
+    bool _found = false;
+
+    while(_space.m_heap.empty() == false)
+    {
+        std::pop_heap(_space.m_heap.begin(),_space.m_heap.end());
+        HeapItem _item = _space.m_heap.back();
+        _space.m_heap.pop_back();
+
+        if(_item.m_cost != _space.m_cost[_item.m_node])
+        {
+            // 节点已以更短的距离出队
+            continue;
+        }
+
+        if(_item.m_node == _target)
+        {
+            _found = true;
+            break;
+        }
+
+        for(RfidMap::Edge_t _edge = m_map.EdgeBegin(_item.m_node); _edge < m_map.EdgeEnd(_item.m_node); ++_edge)
+        {
+            Node_t _next = m_map.GetTarget(_edge);
+            Weight_t _nextCost = _item.m_cost + m_map.GetWeight(_edge);
+
+            if(_penalty)
+            {
+                _nextCost += _penalty[_edge];
+            }
+
+            if(_space.m_stamp[_next] == _space.m_generation && _space.m_cost[_next] <= _nextCost)
+            {
+                continue;
+            }
+
+            Weight_t _h = Heuristic(_next,_target);
+
+            if(_h == RfidMap::INFINITE)
+            {
+                // 由地标距离可知该节点无法到达终点
+                continue;
+            }
+
+            _space.m_stamp[_next] = _space.m_generation;
+            _space.m_cost[_next] = _nextCost;
+            _space.m_parent[_next] = _item.m_node;
+
+            HeapItem _push;
+            _push.m_cost = _nextCost;
+            _push.m_key = _nextCost + _h;
+            _push.m_node = _next;
+
+            _space.m_heap.push_back(_push);
+            std::push_heap(_space.m_heap.begin(),_space.m_heap.end());
+        }
+    }
+
+    _space.m_heap.clear();
+
+    if(_found == false)
+    {
+        return false;
+    }
+
+    for(Node_t _node = _target; _node != RfidMap::NIL; _node = _space.m_parent[_node])
+    {
+        _route.push_back(m_map.GetRfid(_node));
+    }
+
+    std::reverse(_route.begin(),_route.end());
+
+    if(_cost)
+    {
+        *_cost = _space.m_cost[_target];
+    }
+
+    return true;
+}
+
+bool RoutePlanner::Plan(const AgvBase *_agv, const RfidBase::Rfid_t &_to, std::vector<RfidBase::Rfid_t> &_route, Weight_t *_cost, const Weight_t *_penalty) const
+{
+    if(_agv == nullptr)
+    {
+        _route.clear();
+        return false;
+    }
+
+    return Plan(_agv->GetCurRfid(),_to,_route,_cost,_penalty);
+}
+
+RoutePlanner::Weight_t RoutePlanner::Heuristic(const Node_t &_node, const Node_t &_target) const
+{
+    long long _best = 0;
+
+    for(size_t i = 0; i < m_landmarks.size(); ++i)
+    {
+        const Weight_t* _from = &m_fromLandmark[i * m_nodeCount];
+        const Weight_t* _to = &m_toLandmark[i * m_nodeCount];
+
+        // d(L,t) <= d(L,v) + d(v,t)
+        if(_from[_node] != RfidMap::INFINITE)
+        {
+            if(_from[_target] == RfidMap::INFINITE)
+            {
+                // 地标可达节点而不可达终点,则节点不可达终点
+                return RfidMap::INFINITE;
+            }
+
+            _best = std::max(_best,static_cast<long long>(_from[_target]) - static_cast<long long>(_from[_node]));
+        }
+
+        // d(v,L) <= d(v,t) + d(t,L)
+        if(_to[_target] != RfidMap::INFINITE)
+        {
+            if(_to[_node] == RfidMap::INFINITE)
+            {
+                // 终点可达地标而节点不可达地标,则节点不可达终点
+                return RfidMap::INFINITE;
+            }
+
+            _best = std::max(_best,static_cast<long long>(_to[_node]) - static_cast<long long>(_to[_target]));
+        }
+    }
+
+    return static_cast<Weight_t>(_best);
+}
+
+const std::vector<RoutePlanner::Node_t> &RoutePlanner::GetLandmarks() const
+{
+    return m_landmarks;
+}
+
+const RfidMap &RoutePlanner::GetMap() const
+{
+    return m_map;
+}
+
+size_t RoutePlanner::Verify(const size_t &_sources) const
+{
+    size_t _count = _sources == 0 ? m_nodeCount : std::min(_sources,m_nodeCount);
+    size_t _mismatch = 0;
+
+    std::vector<Weight_t> _dist(m_nodeCount);
+    std::vector<RfidBase::Rfid_t> _route;
+
+    for(size_t i = 0; i < _count; ++i)
+    {
+        Node_t _source = static_cast<Node_t>(i * m_nodeCount / _count);
+
+        Dijkstra(_source,false,_dist.data());
+
+        for(Node_t _target = 0; _target < m_nodeCount; ++_target)
+        {
+            Weight_t _cost = RfidMap::INFINITE;
+
+            bool _found = Plan(m_map.GetRfid(_source),m_map.GetRfid(_target),_route,&_cost);
+
+            if(_found != (_dist[_target] != RfidMap::INFINITE) || (_found && _cost != _dist[_target]))
+            {
+                ++_mismatch;
+            }
+        }
+    }
+
+    return _mismatch;
+}
+
+void RoutePlanner::Prepare(const size_t &_landmarks)
+{
+    m_landmarks.clear();
+    m_fromLandmark.clear();
+    m_toLandmark.clear();
+
+    if(m_nodeCount == 0)
+    {
+        return;
+    }
+
+    size_t _count = std::min(_landmarks,m_nodeCount);
+
+    m_fromLandmark.resize(_count * m_nodeCount);
+    m_toLandmark.resize(_count * m_nodeCount);
+
+    std::vector<Weight_t> _nearest(m_nodeCount,RfidMap::INFINITE);   /*!< 各节点至已选地标节点的最小距离 */
+
+    // 第一个地标节点取距节点0最远的节点
+    Dijkstra(0,false,m_fromLandmark.data());
+
+    Node_t _next = 0;
+
+    for(Node_t i = 0; i < m_nodeCount; ++i)
+    {
+        if(m_fromLandmark[i] != RfidMap::INFINITE && m_fromLandmark[i] > m_fromLandmark[_next])
+        {
+            _next = i;
+        }
+    }
+
+    while(m_landmarks.size() < _count)
+    {
+        size_t _index = m_landmarks.size();
+
+        m_landmarks.push_back(_next);
+
+        Weight_t* _from = &m_fromLandmark[_index * m_nodeCount];
+        Weight_t* _to = &m_toLandmark[_index * m_nodeCount];
+
+        Dijkstra(_next,false,_from);
+        Dijkstra(_next,true,_to);
+
+        // 下一个地标节点取与已选地标节点最小距离最大的节点,不连通的节点优先
+        Weight_t _farthest = 0;
+
+        for(Node_t i = 0; i < m_nodeCount; ++i)
+        {
+            Weight_t _dist = std::min(_from[i],_to[i]);
+
+            _nearest[i] = std::min(_nearest[i],_dist);
+
+            if(_nearest[i] > _farthest)
+            {
+                _farthest = _nearest[i];
+                _next = i;
+            }
+        }
+
+        if(_farthest == 0)
+        {
+            // 所有节点均已是地标节点
+            break;
+        }
+    }
+
+    m_fromLandmark.resize(m_landmarks.size() * m_nodeCount);
+    m_toLandmark.resize(m_landmarks.size() * m_nodeCount);
+
+    return;
+}
+
+void RoutePlanner::Dijkstra(const Node_t &_source, bool _reverse, Weight_t *_dist) const
+{
+    std::fill(_dist,_dist + m_nodeCount,RfidMap::INFINITE);
+
+    std::vector<HeapItem> _heap;
+
+    _dist[_source] = 0;
+
+    HeapItem _start;
+    _start.m_key = 0;
+    _start.m_cost = 0;
+    _start.m_node = _source;
+
+    _heap.push_back(_start);
+
+    while(_heap.empty() == false)
+    {
+        std::pop_heap(_heap.begin(),_heap.end());
+        HeapItem _item = _heap.back();
+        _heap.pop_back();
+
+        if(_item.m_cost != _dist[_item.m_node])
+        {
+            continue;
+        }
+
+        RfidMap::Edge_t _begin = _reverse ? m_map.InEdgeBegin(_item.m_node) : m_map.EdgeBegin(_item.m_node);
+        RfidMap::Edge_t _end = _reverse ? m_map.InEdgeEnd(_item.m_node) : m_map.EdgeEnd(_item.m_node);
+
+        for(RfidMap::Edge_t _edge = _begin; _edge < _end; ++_edge)
+        {
+            Node_t _next = _reverse ? m_map.GetInSource(_edge) : m_map.GetTarget(_edge);
+            Weight_t _weight = m_map.GetWeight(_reverse ? m_map.GetInEdge(_edge) : _edge);
+            Weight_t _nextCost = _item.m_cost + _weight;
+
+            if(_nextCost >= _dist[_next])
+            {
+                continue;
+            }
+
+            _dist[_next] = _nextCost;
+
+            HeapItem _push;
+            _push.m_key = _nextCost;
+            _push.m_cost = _nextCost;
+            _push.m_node = _next;
+
+            _heap.push_back(_push);
+            std::push_heap(_heap.begin(),_heap.end());
+        }
+    }
+
+    return;
+}
+
+RoutePlanner::SearchSpace &RoutePlanner::GetSearchSpace() const
+{
+    static thread_local SearchSpace _space = SearchSpace();
+
+    if(_space.m_stamp.size() < m_nodeCount || _space.m_heap.capacity() < m_map.GetEdgeCount() + 1)
+    {
+        // 首次使用或路线图变大时扩容,此后的查询不再分配内存
+        _space.m_cost.resize(m_nodeCount);
+        _space.m_parent.resize(m_nodeCount);
+        _space.m_stamp.resize(m_nodeCount,0);
+        _space.m_heap.reserve(m_map.GetEdgeCount() + 1);
+    }
+
+    if(++_space.m_generation == 0)
+    {
+        // 代数回绕,清除所有标记
+        std::fill(_space.m_stamp.begin(),_space.m_stamp.end(),0);
+        _space.m_generation = 1;
+    }
+
+    return _space;
+}
@@ -0,0 +1,146 @@
+/*!
+ * @file RoutePlanner
+ * @brief 描述RFID地标卡路线规划功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef ROUTEPLANNER_H
+#define ROUTEPLANNER_H
+
+#include <vector>
+#include "RfidMap.h"
+
+class AgvBase;
+
+/*!
+ * @class RoutePlanner
+ * @brief 在RFID地标卡路线图上规划最短路线的类
+ *
+ * 使用ALT(A*、地标、三角不等式)启发式搜索:构造时选取若干地标节点,预先计算各节点与地标节点之间的双向距离,
+ * 查询时以三角不等式得到的下界作为启发值
+ * 搜索所需的空间按线程分配并以代数标记复用,查询过程不分配内存
+ * 路线图在规划器的生命周期内不可修改,修改后应重新构造规划器
+ */
+class RoutePlanner
+{
+public:
+    /*!
+     * @param const RfidMap& 已加载的路线图
+     * @param const size_t& 地标节点的数量
+     */
+    explicit RoutePlanner(const RfidMap& _map,const size_t& _landmarks = DEFAULT_LANDMARKS);
+
+public:
+    typedef RfidMap::Node_t Node_t;
+    typedef RfidMap::Weight_t Weight_t;
+
+    static const size_t DEFAULT_LANDMARKS = 16;     /*!< 默认的地标节点数量 */
+
+protected:
+    /*! @brief 描述优先队列元素的结构体 */
+    struct HeapItem
+    {
+        Weight_t m_key;     /*!< 已走距离与启发值之和 */
+        Weight_t m_cost;    /*!< 入队时的已走距离 */
+        Node_t m_node;      /*!< 节点 */
+
+        bool operator<(const HeapItem& _item) const { return m_key > _item.m_key; }
+    };
+
+    /*! @brief 描述单个线程搜索空间的结构体 */
+    struct SearchSpace
+    {
+        std::vector<Weight_t> m_cost;       /*!< 起点至节点的已知最短距离 */
+        std::vector<Node_t> m_parent;       /*!< 最短路线上的前一个节点 */
+        std::vector<unsigned int> m_stamp;  /*!< 节点数据所属的搜索代数,与当前代数不同时视为未访问 */
+        std::vector<HeapItem> m_heap;       /*!< 优先队列 */
+        unsigned int m_generation;          /*!< 当前搜索代数 */
+    };
+
+protected:
+    const RfidMap& m_map;                   /*!< 路线图 */
+    size_t m_nodeCount;                     /*!< 节点数量 */
+    std::vector<Node_t> m_landmarks;        /*!< 地标节点 */
+    std::vector<Weight_t> m_fromLandmark;   /*!< 地标节点至各节点的距离,按地标节点分段储存 */
+    std::vector<Weight_t> m_toLandmark;     /*!< 各节点至地标节点的距离,按地标节点分段储存 */
+
+public:
+    /*!
+     * @brief 规划两个RFID地标卡之间的最短路线
+     * @param const RfidBase::Rfid_t& 起点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 终点RFID地标卡编号
+     * @param std::vector<RfidBase::Rfid_t>& 规划结果,包含起点与终点;容量足够时不分配内存
+     * @param Weight_t* 路线的总代价,为nullptr时不输出
+     * @param const Weight_t* 与路段下标对齐的附加代价,叠加在距离上;附加代价非负,启发值仍为下界;为nullptr时只按距离规划
+     * @return bool 规划成功返回true,地标卡不在路线图中或不可达时返回false
+     */
+    bool Plan(const RfidBase::Rfid_t& _from,const RfidBase::Rfid_t& _to,std::vector<RfidBase::Rfid_t>& _route,Weight_t* _cost = nullptr,
+              const Weight_t* _penalty = nullptr) const;
+
+    /*!
+     * @brief 规划AGV从当前RFID地标卡至目标RFID地标卡的最短路线
+     * @param const AgvBase* AGV对象
+     * @param const RfidBase::Rfid_t& 目标RFID地标卡编号
+     * @param std::vector<RfidBase::Rfid_t>& 规划结果
+     * @param Weight_t* 路线的总代价,为nullptr时不输出
+     * @param const Weight_t* 与路段下标对齐的附加代价,为nullptr时只按距离规划
+     * @return bool 规划成功返回true,否则返回false
+     */
+    bool Plan(const AgvBase* _agv,const RfidBase::Rfid_t& _to,std::vector<RfidBase::Rfid_t>& _route,Weight_t* _cost = nullptr,
+              const Weight_t* _penalty = nullptr) const;
+
+    /*!
+     * @brief 计算两个节点之间最短距离的下界
+     * @param const Node_t& 节点
+     * @param const Node_t& 终点
+     * @return Weight_t 距离下界
+     */
+    Weight_t Heuristic(const Node_t& _node,const Node_t& _target) const;
+
+    /*!
+     * @brief 获取地标节点
+     * @return const std::vector<Node_t>& 地标节点
+     */
+    const std::vector<Node_t>& GetLandmarks() const;
+
+    /*!
+     * @brief 获取路线图
+     * @return const RfidMap& 路线图
+     */
+    const RfidMap& GetMap() const;
+
+    /*!
+     * @brief 以逐点Dijkstra搜索校验规划结果
+     *
+     * 含单向路段或不连通部分的路线图加载后可调用,检查启发值的不可达剪枝没有误判
+     * 每个起点校验至所有节点的路线,耗时与起点数量乘以节点数量成正比
+     * @param const size_t& 均匀抽样的起点数量,0为全部节点
+     * @return size_t 规划结果与Dijkstra搜索不一致的起终点对数量
+     */
+    size_t Verify(const size_t& _sources = 0) const;
+
+protected:
+    /*!
+     * @brief 选取地标节点并计算各节点与地标节点之间的距离
+     *
+     * 依次选取与已选地标节点距离最远的节点作为新的地标节点
+     * @param const size_t& 地标节点的数量
+     */
+    void Prepare(const size_t& _landmarks);
+
+    /*!
+     * @brief 计算单个源点至所有节点的最短距离
+     * @param const Node_t& 源点
+     * @param bool 为true时沿入边反向搜索,得到各节点至源点的距离
+     * @param Weight_t* 距离结果,共节点数量项
+     */
+    void Dijkstra(const Node_t& _source,bool _reverse,Weight_t* _dist) const;
+
+    /*!
+     * @brief 获取当前线程的搜索空间并开始新一代搜索
+     * @return SearchSpace& 搜索空间
+     */
+    SearchSpace& GetSearchSpace() const;
+};
+
+#endif // ROUTEPLANNER_H
@@ -57,3 +57,13 @@ std::string SubmersibleAgv::GetActionName() const
 
     return _act + _actStatus;
 }
+
+AgvBase::AAction_t SubmersibleAgv::GetLoadAction() const
+{
+    return 1;
+}
+
+AgvBase::AAction_t SubmersibleAgv::GetUnloadAction() const
+{
+    return 2;
+}
@@ -0,0 +1,398 @@
+#include "TimingWheel.h"
+
+#include <algorithm>
+
+TimingWheel::TimingWheel(const std::chrono::milliseconds &_tick)
+{
+    m_tick = _tick.count() > 0 ? _tick : std::chrono::milliseconds(1);
+    m_start = std::chrono::steady_clock::now();
+    m_now = 0;
+    m_count = 0;
+
+    for(unsigned int i = 0; i < SLOTS; ++i)
+    {
+        m_slots[i] = NIL;
+    }
+}
+
+TimingWheel::TimerId TimingWheel::Start(const std::chrono::milliseconds &_delay, const Callback &_callback)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    unsigned int _index = NIL;
+
+    if(m_free.empty())
+    {
+        _index = static_cast<unsigned int>(m_nodes.size());
+
+        TimerNode _node;
+        _node.m_generation = 0;
+        m_nodes.push_back(_node);
+    }
+    else
+    {
+        _index = m_free.back();
+        m_free.pop_back();
+    }
+
+    TimerNode& _node = m_nodes[_index];
+
+    _node.m_expire = ToExpire(std::chrono::steady_clock::now(),_delay);
+    _node.m_callback = _callback;
+
+    Link(_index);
+
+    ++m_count;
+
+    return (static_cast<TimerId>(_node.m_generation) << 32) | (_index + 1);
+}
+
+bool TimingWheel::Restart(const TimerId &_id, const std::chrono::milliseconds &_delay)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    unsigned int _index = Find(_id);
+
+    if(_index == NIL)
+    {
+        return false;
+    }
+
+    Unlink(_index);
+
+    m_nodes[_index].m_expire = ToExpire(std::chrono::steady_clock::now(),_delay);
+
+    Link(_index);
+
+    return true;
+}
+
+bool TimingWheel::Cancel(const TimerId &_id)
+{
+    Callback _callback;     /*!< 在锁外释放回调函数捕获的资源 */
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    unsigned int _index = Find(_id);
+
+    if(_index == NIL)
+    {
+        std::vector<TimerId>::iterator _pending = std::find(m_pending.begin(),m_pending.end(),_id);
+
+        if(_pending == m_pending.end())
+        {
+            return false;
+        }
+
+        // 已到期尚未执行,由Advance跳过
+        m_pending.erase(_pending);
+
+        return true;
+    }
+
+    Unlink(_index);
+
+    TimerNode& _node = m_nodes[_index];
+    _callback.swap(_node.m_callback);
+    ++_node.m_generation;
+
+    m_free.push_back(_index);
+    --m_count;
+
+    return true;
+}
+
+bool TimingWheel::CancelSync(const TimerId &_id)
+{
+    bool _bCancelled = Cancel(_id);
+
+    std::thread::id _self = std::this_thread::get_id();
+
+    std::unique_lock<std::mutex> _lock(m_mutex);
+
+    m_done.wait(_lock,[this,&_id,&_self]{
+        for(std::vector<std::pair<TimerId,std::thread::id> >::const_iterator it = m_running.begin(); it != m_running.end(); ++it)
+        {
+            if(it->first == _id && it->second != _self)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    });
+
+    return _bCancelled;
+}
+
+size_t TimingWheel::Advance(const Time_t &_now)
+{
+    std::vector<std::pair<TimerId,Callback> > _expired;     /*!< 到期的定时器与回调函数 */
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        unsigned long long _target = ToTick(_now);
+
+        while(m_now <= _target)
+        {
+            unsigned int _root = static_cast<unsigned int>(m_now & (ROOT_SIZE - 1));
+
+            if(_root == 0)
+            {
+                // 第0层转完一圈,依次将上层的定时器分配到下层
+                for(unsigned int _level = 1; _level < LEVELS; ++_level)
+                {
+                    Cascade(_level);
+
+                    unsigned int _shift = ROOT_BITS + LEVEL_BITS * (_level - 1);
+
+                    if(((m_now >> _shift) & (LEVEL_SIZE - 1)) != 0)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            while(m_slots[_root] != NIL)
+            {
+                unsigned int _index = m_slots[_root];
+
+                Unlink(_index);
+
+                TimerNode& _node = m_nodes[_index];
+
+                if(_node.m_expire > m_now)
+                {
+                    // 超出时间轮范围的定时器,重新分配
+                    Link(_index);
+                    continue;
+                }
+
+                TimerId _id = (static_cast<TimerId>(_node.m_generation) << 32) | (_index + 1);
+
+                _expired.push_back(std::make_pair(_id,Callback()));
+                _expired.back().second.swap(_node.m_callback);
+                ++_node.m_generation;
+
+                m_pending.push_back(_id);
+
+                m_free.push_back(_index);
+                --m_count;
+            }
+
+            ++m_now;
+        }
+    }
+
+    std::thread::id _self = std::this_thread::get_id();
+    size_t _count = 0;
+
+    for(std::vector<std::pair<TimerId,Callback> >::iterator it = _expired.begin(); it != _expired.end(); ++it)
+    {
+        {
+            std::lock_guard<std::mutex> _lock(m_mutex);
+
+            std::vector<TimerId>::iterator _pending = std::find(m_pending.begin(),m_pending.end(),it->first);
+
+            if(_pending == m_pending.end())
+            {
+                // 到期后已被取消
+                continue;
+            }
+
+            m_pending.erase(_pending);
+            m_running.push_back(std::make_pair(it->first,_self));
+        }
+
+        if(it->second)
+        {
+            it->second();
+        }
+
+        ++_count;
+
+        {
+            std::lock_guard<std::mutex> _lock(m_mutex);
+
+            m_running.erase(std::find(m_running.begin(),m_running.end(),std::make_pair(it->first,_self)));
+        }
+
+        m_done.notify_all();
+    }
+
+    return _count;
+}
+
+size_t TimingWheel::GetCount()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_count;
+}
+
+void TimingWheel::Link(const unsigned int &_index)
+{
+    TimerNode& _node = m_nodes[_index];
+
+    unsigned long long _expire = _node.m_expire < m_now ? m_now : _node.m_expire;
+    unsigned long long _delta = _expire - m_now;
+    unsigned int _slot = 0;
+
+    if(_delta < ROOT_SIZE)
+    {
+        _slot = static_cast<unsigned int>(_expire & (ROOT_SIZE - 1));
+    }
+    else
+    {
+        unsigned int _level = 1;
+        unsigned int _shift = ROOT_BITS;
+
+        while(_level < LEVELS - 1 && _delta >= (1ULL << (_shift + LEVEL_BITS)))
+        {
+            ++_level;
+            _shift += LEVEL_BITS;
+        }
+
+        if(_delta >= (1ULL << (_shift + LEVEL_BITS)))
+        {
+            // 超出时间轮范围,先挂在最高层的最远处,到时再重新分配
+            _expire = m_now + (1ULL << (_shift + LEVEL_BITS)) - 1;
+        }
+
+        _slot = ROOT_SIZE + LEVEL_SIZE * (_level - 1) + static_cast<unsigned int>((_expire >> _shift) & (LEVEL_SIZE - 1));
+    }
+
+    _node.m_slot = _slot;
+    _node.m_prev = NIL;
+    _node.m_next = m_slots[_slot];
+
+    if(_node.m_next != NIL)
+    {
+        m_nodes[_node.m_next].m_prev = _index;
+    }
+
+    m_slots[_slot] = _index;
+
+    return;
+}
+
+void TimingWheel::Unlink(const unsigned int &_index)
+{
+    TimerNode& _node = m_nodes[_index];
+
+    if(_node.m_prev != NIL)
+    {
+        m_nodes[_node.m_prev].m_next = _node.m_next;
+    }
+    else
+    {
+        m_slots[_node.m_slot] = _node.m_next;
+    }
+
+    if(_node.m_next != NIL)
+    {
+        m_nodes[_node.m_next].m_prev = _node.m_prev;
+    }
+
+    _node.m_prev = NIL;
+    _node.m_next = NIL;
+    _node.m_slot = NIL;
+
+    return;
+}
+
+void TimingWheel::Cascade(const unsigned int &_level)
+{
+    unsigned int _shift = ROOT_BITS + LEVEL_BITS * (_level - 1);
+    unsigned int _slot = ROOT_SIZE + LEVEL_SIZE * (_level - 1) + static_cast<unsigned int>((m_now >> _shift) & (LEVEL_SIZE - 1));
+
+    unsigned int _index = m_slots[_slot];
+
+    m_slots[_slot] = NIL;
+
+    while(_index != NIL)
+    {
+        unsigned int _next = m_nodes[_index].m_next;
+
+        Link(_index);
+
+        _index = _next;
+    }
+
+    return;
+}
+
+unsigned int TimingWheel::Find(const TimerId &_id) const
+{
+    unsigned long long _low = _id & 0xFFFFFFFFULL;
+
+    if(_low == 0 || _low > m_nodes.size())
+    {
+        return NIL;
+    }
+
+    unsigned int _index = static_cast<unsigned int>(_low - 1);
+    const TimerNode& _node = m_nodes[_index];
+
+    if(_node.m_generation != static_cast<unsigned int>(_id >> 32) || _node.m_slot == NIL)
+    {
+        // 定时器已到期或已取消
+        return NIL;
+    }
+
+    return _index;
+}
+
+unsigned long long TimingWheel::ToTick(const Time_t &_time) const
+{
+    if(_time <= m_start)
+    {
+        return 0;
+    }
+
+    return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::milliseconds>(_time - m_start).count() / m_tick.count());
+}
+
+unsigned long long TimingWheel::ToExpire(const Time_t &_time, const std::chrono::milliseconds &_delay) const
+{
+    // 刻度k在时间达到m_start+k*m_tick后才处理,到期时间按未取整的经过时间向上取整到刻度,保证不会提前到期
+    Time_t::duration _tick = std::chrono::duration_cast<Time_t::duration>(m_tick);
+    Time_t::duration _elapsed = (_time > m_start ? _time - m_start : Time_t::duration::zero()) + _delay;
+
+    return static_cast<unsigned long long>((_elapsed.count() + _tick.count() - 1) / _tick.count());
+}
+
+TimerService::TimerService(const std::chrono::milliseconds &_tick, QObject *parent) : QObject(parent), m_wheel(_tick)
+{
+    m_timer.setInterval(static_cast<int>(_tick.count()));
+    m_timer.setTimerType(Qt::PreciseTimer);
+
+    connect(&m_timer,SIGNAL(timeout()),this,SLOT(Tick()));
+
+    // 计时器随服务一同移至推进线程,在线程启动后开始计时
+    m_timer.moveToThread(&m_thread);
+    connect(&m_thread,SIGNAL(started()),&m_timer,SLOT(start()));
+    connect(&m_thread,SIGNAL(finished()),&m_timer,SLOT(stop()));
+
+    moveToThread(&m_thread);
+    m_thread.start();
+}
+
+TimerService::~TimerService()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+TimingWheel &TimerService::GetWheel()
+{
+    return m_wheel;
+}
+
+void TimerService::Tick()
+{
+    m_wheel.Advance(std::chrono::steady_clock::now());
+
+    return;
+}
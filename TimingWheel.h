@@ -0,0 +1,200 @@
+/*!
+ * @file TimingWheel
+ * @brief 描述分层时间轮定时器的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*!
+ * @class TimingWheel
+ * @brief 分层时间轮
+ *
+ * 第0层256个槽,第1~3层各64个槽,每层的一个槽对应下一层的一整圈
+ * 定时器以侵入式双向链表挂在槽上,启动、取消与重新设置均为O(1)
+ * 到期的回调函数在调用Advance的线程中执行,执行时不持有内部锁,可在回调中启动或取消定时器
+ * 已到期但尚未执行的回调函数被取消后不再执行;CancelSync还会等待正在执行的回调函数返回,用于析构前取消定时器
+ */
+class TimingWheel
+{
+public:
+    typedef unsigned long long TimerId;
+    typedef std::function<void()> Callback;
+    typedef std::chrono::steady_clock::time_point Time_t;
+
+    static const TimerId INVALID_TIMER = 0;     /*!< 无效的定时器编号 */
+
+public:
+    /*!
+     * @param const std::chrono::milliseconds& 时间轮的精度,即每个槽代表的时间
+     */
+    explicit TimingWheel(const std::chrono::milliseconds& _tick = std::chrono::milliseconds(10));
+
+protected:
+    static const unsigned int ROOT_BITS = 8;                        /*!< 第0层槽数量的位数 */
+    static const unsigned int LEVEL_BITS = 6;                       /*!< 第1~3层槽数量的位数 */
+    static const unsigned int LEVELS = 4;                           /*!< 层数 */
+    static const unsigned int ROOT_SIZE = 1 << ROOT_BITS;           /*!< 第0层槽数量 */
+    static const unsigned int LEVEL_SIZE = 1 << LEVEL_BITS;         /*!< 第1~3层槽数量 */
+    static const unsigned int SLOTS = ROOT_SIZE + LEVEL_SIZE * (LEVELS - 1);    /*!< 槽总数 */
+    static const unsigned int NIL = 0xFFFFFFFF;                     /*!< 空链表 */
+
+    /*! @brief 描述定时器的结构体 */
+    struct TimerNode
+    {
+        unsigned long long m_expire;    /*!< 到期的刻度 */
+        Callback m_callback;            /*!< 回调函数 */
+        unsigned int m_prev;            /*!< 链表中的上一个定时器 */
+        unsigned int m_next;            /*!< 链表中的下一个定时器 */
+        unsigned int m_slot;            /*!< 所在的槽,未启动时为NIL */
+        unsigned int m_generation;      /*!< 节点被复用的次数,用以识别过期的定时器编号 */
+    };
+
+protected:
+    std::mutex m_mutex;                 /*!< 互斥锁 */
+    std::vector<TimerNode> m_nodes;     /*!< 定时器节点池 */
+    std::vector<unsigned int> m_free;   /*!< 空闲的节点 */
+    unsigned int m_slots[SLOTS];        /*!< 每个槽的链表头 */
+    std::chrono::milliseconds m_tick;   /*!< 精度 */
+    Time_t m_start;                     /*!< 刻度0对应的时间 */
+    unsigned long long m_now;           /*!< 当前刻度 */
+    size_t m_count;                     /*!< 已启动的定时器数量 */
+    std::vector<TimerId> m_pending;     /*!< 已到期尚未执行的定时器 */
+    std::vector<std::pair<TimerId,std::thread::id> > m_running;     /*!< 正在执行的定时器及执行的线程 */
+    std::condition_variable m_done;     /*!< 回调函数执行完毕的条件变量 */
+
+public:
+    /*!
+     * @brief 启动定时器
+     * @param const std::chrono::milliseconds& 延时时间
+     * @param const Callback& 到期时执行的回调函数
+     * @return TimerId 定时器编号
+     */
+    TimerId Start(const std::chrono::milliseconds& _delay,const Callback& _callback);
+
+    /*!
+     * @brief 重新设置定时器的到期时间
+     * @param const TimerId& 定时器编号
+     * @param const std::chrono::milliseconds& 从当前时间开始的延时时间
+     * @return bool 定时器已到期或已取消时返回false
+     */
+    bool Restart(const TimerId& _id,const std::chrono::milliseconds& _delay);
+
+    /*!
+     * @brief 取消定时器,已到期尚未执行的回调函数不再执行
+     * @param const TimerId& 定时器编号
+     * @return bool 定时器已执行或已取消时返回false
+     */
+    bool Cancel(const TimerId& _id);
+
+    /*!
+     * @brief 取消定时器,并等待正在其他线程中执行的回调函数返回
+     *
+     * 返回后回调函数不会再执行,可安全释放回调函数访问的对象
+     * 调用时不能持有回调函数需要的锁,否则会死锁;在回调函数自身中调用时不等待
+     * @param const TimerId& 定时器编号
+     * @return bool 定时器已执行或已取消时返回false
+     */
+    bool CancelSync(const TimerId& _id);
+
+    /*!
+     * @brief 推进时间轮并执行到期的回调函数
+     * @param const Time_t& 当前时间
+     * @return size_t 到期的定时器数量
+     */
+    size_t Advance(const Time_t& _now);
+
+    /*!
+     * @brief 获取已启动的定时器数量
+     * @return size_t 定时器数量
+     */
+    size_t GetCount();
+
+protected:
+    /*!
+     * @brief 将定时器挂到对应的槽上
+     * @param const unsigned int& 节点下标
+     */
+    void Link(const unsigned int& _index);
+
+    /*!
+     * @brief 将定时器从槽上摘下
+     * @param const unsigned int& 节点下标
+     */
+    void Unlink(const unsigned int& _index);
+
+    /*!
+     * @brief 将高层槽中的定时器重新分配到低层
+     * @param const unsigned int& 层
+     */
+    void Cascade(const unsigned int& _level);
+
+    /*!
+     * @brief 根据定时器编号查找节点
+     * @param const TimerId& 定时器编号
+     * @return unsigned int 节点下标,编号无效时返回NIL
+     */
+    unsigned int Find(const TimerId& _id) const;
+
+    /*!
+     * @brief 将时间转换为刻度
+     * @param const Time_t& 时间
+     * @return unsigned long long 刻度
+     */
+    unsigned long long ToTick(const Time_t& _time) const;
+
+    /*!
+     * @brief 计算从指定时间起延时后的到期刻度,不足一个刻度的部分向上取整
+     * @param const Time_t& 起始时间
+     * @param const std::chrono::milliseconds& 延时
+     * @return unsigned long long 到期的刻度
+     */
+    unsigned long long ToExpire(const Time_t& _time,const std::chrono::milliseconds& _delay) const;
+};
+
+/*!
+ * @class TimerService
+ * @brief 在独立线程中按精度推进时间轮的服务
+ *
+ * 心跳超时、动作超时、锁租约与重连退避等均共用此服务
+ * 回调函数在服务线程中执行,需要访问AGV对象时应通过QMetaObject::invokeMethod转发至AGV所在的线程
+ */
+class TimerService : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TimerService(const std::chrono::milliseconds& _tick = std::chrono::milliseconds(10),QObject *parent = nullptr);
+    ~TimerService();
+
+protected:
+    TimingWheel m_wheel;    /*!< 时间轮 */
+    QThread m_thread;       /*!< 推进时间轮的线程 */
+    QTimer m_timer;         /*!< 推进时间轮的计时器 */
+
+public:
+    /*!
+     * @brief 获取时间轮
+     * @return TimingWheel& 时间轮
+     */
+    TimingWheel& GetWheel();
+
+protected slots:
+    /*!
+     * @brief 推进时间轮的槽函数
+     */
+    void Tick();
+};
+
+#endif // TIMINGWHEEL_H
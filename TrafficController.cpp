@@ -0,0 +1,500 @@
+#include "TrafficController.h"
+
+#include <algorithm>
+
+TrafficController::TrafficController(RfidRegistry &_registry, const std::string &_labels, QObject *parent)
+    : QObject(parent),m_registry(_registry),m_labels(_labels)
+{
+    m_bScheduled = false;
+    m_pDetector = nullptr;
+    m_otherWait = AddWaitHistogram("other");
+    m_acquirer = [this](const AgvBase::AId_t& _id,const RfidBase::Rfid_t& _rfid,RfidBase::Rfid_t& _busy){
+        _busy = _rfid;
+        return m_registry.Lock(_rfid,_id);
+    };
+    m_releaser = [this](const AgvBase::AId_t& _id,const RfidBase::Rfid_t& _rfid){ m_registry.Free(_rfid,_id); };
+
+    m_freeHandler = m_registry.Subscribe([this](const RfidBase::Rfid_t& _rfid){ Freed(_rfid); });
+
+    moveToThread(&m_thread);
+    m_thread.start();
+}
+
+TrafficController::~TrafficController()
+{
+    // 返回后不会再有线程进入Freed
+    m_registry.Unsubscribe(m_freeHandler);
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        for(std::map<AgvBase::AId_t,AgvEntry>::iterator it = m_agvs.begin(); it != m_agvs.end(); ++it)
+        {
+            QObject::disconnect(it->second.m_connection);
+        }
+    }
+
+    m_thread.quit();
+    m_thread.wait();
+
+    MetricsRegistry& _metrics = MetricsRegistry::Instance();
+
+    for(std::map<Cross_t,MetricsRegistry::MetricId>::iterator it = m_metrics.begin(); it != m_metrics.end(); ++it)
+    {
+        _metrics.Remove(it->second);
+    }
+
+    _metrics.Remove(m_otherWait);
+}
+
+void TrafficController::SetAcquirer(const TrafficController::Acquirer &_acquirer, const TrafficController::Releaser &_releaser)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_acquirer = _acquirer;
+    m_releaser = _releaser;
+
+    return;
+}
+
+void TrafficController::SetDetector(DeadlockDetector *_detector)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_pDetector = _detector;
+
+    return;
+}
+
+void TrafficController::Watch(AgvBase *_agv, const int &_priority)
+{
+    if(_agv == nullptr)
+    {
+        return;
+    }
+
+    AgvBase::AId_t _id = _agv->GetID();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    AgvEntry& _entry = m_agvs[_id];
+
+    QObject::disconnect(_entry.m_connection);
+
+    _entry.m_pAgv = _agv;
+    _entry.m_priority = _priority;
+
+    // AGV离开等待位置后不再需要放行
+    _entry.m_connection = QObject::connect(_agv,&AgvBase::RfidChanged,[this,_id]{ Cancel(_id); });
+
+    return;
+}
+
+void TrafficController::Unwatch(const AgvBase::AId_t &_id)
+{
+    bool _bWaiting = false;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,AgvEntry>::iterator it = m_agvs.find(_id);
+
+        if(it == m_agvs.end())
+        {
+            return;
+        }
+
+        QObject::disconnect(it->second.m_connection);
+
+        _bWaiting = RemoveWaiter(_id);
+
+        m_agvs.erase(it);
+    }
+
+    if(_bWaiting)
+    {
+        Report(_id,false,0);
+    }
+
+    return;
+}
+
+void TrafficController::SetPriority(const AgvBase::AId_t &_id, const int &_priority)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,AgvEntry>::iterator it = m_agvs.find(_id);
+
+    if(it != m_agvs.end())
+    {
+        it->second.m_priority = _priority;
+    }
+
+    return;
+}
+
+void TrafficController::SetCross(const RfidBase::Rfid_t &_rfid, const TrafficController::Cross_t &_cross)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_crosses[_rfid] = _cross;
+
+    return;
+}
+
+bool TrafficController::Wait(const AgvBase::AId_t &_id, const RfidBase::Rfid_t &_rfid)
+{
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,AgvEntry>::iterator it = m_agvs.find(_id);
+
+        if(it == m_agvs.end())
+        {
+            return false;
+        }
+
+        std::map<AgvBase::AId_t,Waiter>::iterator _old = m_waiters.find(_id);
+
+        if(_old != m_waiters.end() && _old->second.m_rfid == _rfid)
+        {
+            // 重复登记,保留最初的等待时间
+            return true;
+        }
+
+        RemoveWaiter(_id);
+
+        Waiter& _waiter = m_waiters[_id];
+        _waiter.m_pAgv = it->second.m_pAgv;
+        _waiter.m_rfid = _rfid;
+        _waiter.m_blocker = _rfid;
+        _waiter.m_since = std::chrono::steady_clock::now();
+
+        m_queues[_rfid].push_back(_id);
+
+        if(m_registry.IsLocked(_rfid) == false)
+        {
+            // 登记前地标卡已被释放,不会再收到释放事件
+            Schedule(_rfid);
+        }
+    }
+
+    // 检测器的处理函数可能取消等待,报告时不持有锁
+    Report(_id,true,_rfid);
+
+    return true;
+}
+
+void TrafficController::Cancel(const AgvBase::AId_t &_id)
+{
+    bool _bWaiting = false;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        _bWaiting = RemoveWaiter(_id);
+    }
+
+    // AGV每到达一个地标卡都会取消,只在确有等待时报告
+    if(_bWaiting)
+    {
+        Report(_id,false,0);
+    }
+
+    return;
+}
+
+bool TrafficController::GetStats(const TrafficController::Cross_t &_cross, TrafficController::WaitStats &_stats)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<Cross_t,WaitStats>::const_iterator it = m_stats.find(_cross);
+
+    if(it == m_stats.end())
+    {
+        return false;
+    }
+
+    _stats = it->second;
+
+    return true;
+}
+
+void TrafficController::Freed(const RfidBase::Rfid_t &_rfid)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    if(m_queues.find(_rfid) == m_queues.end())
+    {
+        // 无等待者
+        return;
+    }
+
+    Schedule(_rfid);
+
+    return;
+}
+
+void TrafficController::Schedule(const RfidBase::Rfid_t &_rfid)
+{
+    m_pending.push_back(_rfid);
+
+    if(m_bScheduled)
+    {
+        return;
+    }
+
+    m_bScheduled = true;
+
+    QMetaObject::invokeMethod(this,"Dispatch",Qt::QueuedConnection);
+
+    return;
+}
+
+bool TrafficController::RemoveWaiter(const AgvBase::AId_t &_id)
+{
+    std::map<AgvBase::AId_t,Waiter>::iterator it = m_waiters.find(_id);
+
+    if(it == m_waiters.end())
+    {
+        return false;
+    }
+
+    std::map<RfidBase::Rfid_t,std::vector<AgvBase::AId_t> >::iterator _queue = m_queues.find(it->second.m_blocker);
+
+    if(_queue != m_queues.end())
+    {
+        _queue->second.erase(std::remove(_queue->second.begin(),_queue->second.end(),_id),_queue->second.end());
+
+        if(_queue->second.empty())
+        {
+            m_queues.erase(_queue);
+        }
+    }
+
+    m_waiters.erase(it);
+
+    return true;
+}
+
+void TrafficController::Report(const AgvBase::AId_t &_id, const bool &_bWaiting, const RfidBase::Rfid_t &_rfid)
+{
+    DeadlockDetector* _detector = nullptr;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        _detector = m_pDetector;
+    }
+
+    if(_detector == nullptr)
+    {
+        return;
+    }
+
+    if(_bWaiting)
+    {
+        _detector->Wait(_id,_rfid);
+    }
+    else
+    {
+        _detector->Resume(_id);
+    }
+
+    return;
+}
+
+void TrafficController::Record(const RfidBase::Rfid_t &_rfid, const long long &_wait)
+{
+    std::map<RfidBase::Rfid_t,Cross_t>::const_iterator _found = m_crosses.find(_rfid);
+
+    Cross_t _cross = _found == m_crosses.end() ? _rfid : _found->second;
+
+    MetricsRegistry::MetricId _metric = m_otherWait;
+
+    if(_found != m_crosses.end())
+    {
+        std::map<Cross_t,MetricsRegistry::MetricId>::iterator _series = m_metrics.find(_cross);
+
+        if(_series == m_metrics.end())
+        {
+            _series = m_metrics.insert(std::make_pair(_cross,AddWaitHistogram(std::to_string(_cross)))).first;
+        }
+
+        _metric = _series->second;
+    }
+
+    std::map<Cross_t,WaitStats>::iterator it = m_stats.find(_cross);
+
+    if(it == m_stats.end())
+    {
+        WaitStats _stats;
+        _stats.m_count = 0;
+        _stats.m_total = 0;
+        _stats.m_max = 0;
+
+        it = m_stats.insert(std::make_pair(_cross,_stats)).first;
+    }
+
+    ++it->second.m_count;
+    it->second.m_total += _wait;
+    it->second.m_max = std::max(it->second.m_max,_wait);
+
+    MetricsRegistry::Instance().Observe(_metric,static_cast<double>(_wait) / 1000.0);
+
+    return;
+}
+
+MetricsRegistry::MetricId TrafficController::AddWaitHistogram(const std::string &_cross) const
+{
+    std::string _labels = (m_labels.empty() ? "" : m_labels + ",") + "cross=\"" + _cross + "\"";
+
+    return MetricsRegistry::Instance().AddHistogram("agv_traffic_wait_seconds","Time AGVs waited in traffic stop before being passed",
+                                                    {0.1,0.5,1.0,2.0,5.0,10.0,30.0,60.0},_labels);
+}
+
+void TrafficController::Dispatch()
+{
+    /*! @brief 描述放行候选者的结构体 */
+    struct Candidate
+    {
+        AgvBase::AId_t m_id;
+        RfidBase::Rfid_t m_rfid;
+        int m_priority;
+        std::chrono::steady_clock::time_point m_since;
+
+        bool operator<(const Candidate& _candidate) const
+        {
+            if(m_priority != _candidate.m_priority)
+            {
+                return m_priority > _candidate.m_priority;
+            }
+
+            return m_since < _candidate.m_since;
+        }
+    };
+
+    std::vector<RfidBase::Rfid_t> _pending;
+    Acquirer _acquirer;
+    Releaser _releaser;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        _pending.swap(m_pending);
+        _acquirer = m_acquirer;
+        _releaser = m_releaser;
+
+        m_bScheduled = false;
+    }
+
+    std::sort(_pending.begin(),_pending.end());
+    _pending.erase(std::unique(_pending.begin(),_pending.end()),_pending.end());
+
+    for(std::vector<RfidBase::Rfid_t>::iterator it = _pending.begin(); it != _pending.end(); ++it)
+    {
+        std::vector<Candidate> _candidates;
+
+        {
+            std::lock_guard<std::mutex> _lock(m_mutex);
+
+            std::map<RfidBase::Rfid_t,std::vector<AgvBase::AId_t> >::const_iterator _queue = m_queues.find(*it);
+
+            if(_queue == m_queues.end())
+            {
+                continue;
+            }
+
+            for(std::vector<AgvBase::AId_t>::const_iterator _id = _queue->second.begin(); _id != _queue->second.end(); ++_id)
+            {
+                Candidate _candidate;
+                _candidate.m_id = *_id;
+                _candidate.m_rfid = m_waiters[*_id].m_rfid;
+                _candidate.m_priority = m_agvs[*_id].m_priority;
+                _candidate.m_since = m_waiters[*_id].m_since;
+
+                _candidates.push_back(_candidate);
+            }
+        }
+
+        std::sort(_candidates.begin(),_candidates.end());
+
+        // 锁定函数可能释放其他地标卡,调用时不持有锁;等待的地标卡可能不同,每个候选者都尝试
+        for(std::vector<Candidate>::iterator _candidate = _candidates.begin(); _candidate != _candidates.end(); ++_candidate)
+        {
+            bool _bHeld = m_registry.GetLocker(_candidate->m_rfid) == _candidate->m_id;
+            RfidBase::Rfid_t _busy = _candidate->m_rfid;
+
+            if(_acquirer(_candidate->m_id,_candidate->m_rfid,_busy) == false)
+            {
+                {
+                    std::lock_guard<std::mutex> _lock(m_mutex);
+
+                    std::map<AgvBase::AId_t,Waiter>::iterator _waiter = m_waiters.find(_candidate->m_id);
+
+                    if(_waiter == m_waiters.end() || _waiter->second.m_rfid != _candidate->m_rfid || _waiter->second.m_blocker == _busy)
+                    {
+                        continue;
+                    }
+
+                    // 改在实际被占用的地标卡释放时重试,否则等待者会停留在已释放的地标卡上
+                    std::vector<AgvBase::AId_t>& _queue = m_queues[_waiter->second.m_blocker];
+
+                    _queue.erase(std::remove(_queue.begin(),_queue.end(),_candidate->m_id),_queue.end());
+
+                    if(_queue.empty())
+                    {
+                        m_queues.erase(_waiter->second.m_blocker);
+                    }
+
+                    _waiter->second.m_blocker = _busy;
+
+                    m_queues[_busy].push_back(_candidate->m_id);
+
+                    if(m_registry.IsLocked(_busy) == false)
+                    {
+                        // 登记前地标卡已被释放,不会再收到释放事件
+                        Schedule(_busy);
+                    }
+                }
+
+                // 实际阻挡等待者的地标卡改变,死锁检测按新的地标卡判断
+                Report(_candidate->m_id,true,_busy);
+
+                continue;
+            }
+
+            AgvBase* _agv = nullptr;
+
+            {
+                std::lock_guard<std::mutex> _lock(m_mutex);
+
+                std::map<AgvBase::AId_t,Waiter>::iterator _waiter = m_waiters.find(_candidate->m_id);
+
+                if(_waiter != m_waiters.end() && _waiter->second.m_rfid == _candidate->m_rfid)
+                {
+                    _agv = _waiter->second.m_pAgv;
+
+                    Record(_candidate->m_rfid,std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _waiter->second.m_since).count());
+
+                    RemoveWaiter(_candidate->m_id);
+                }
+            }
+
+            if(_agv)
+            {
+                Report(_candidate->m_id,false,0);
+
+                // 指令需在AGV所在的线程中发送
+                QMetaObject::invokeMethod(_agv,"TrafficPass",Qt::QueuedConnection);
+            }
+            else if(_bHeld == false && _releaser)
+            {
+                // 锁定期间等待已被取消或改为其他地标卡,撤销本次锁定
+                _releaser(_candidate->m_id,_candidate->m_rfid);
+            }
+        }
+    }
+
+    return;
+}
@@ -0,0 +1,223 @@
+/*!
+ * @file TrafficController
+ * @brief 描述以事件驱动放行交通管制停止AGV功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef TRAFFICCONTROLLER_H
+#define TRAFFICCONTROLLER_H
+
+#include <QObject>
+#include <QThread>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DeadlockDetector.h"
+#include "RfidRegistry.h"
+
+/*!
+ * @class TrafficController
+ * @brief 在RFID地标卡释放时按优先级放行等待AGV的交通管制器
+ *
+ * AGV因地标卡被占用而处于交通管制停止状态时登记其等待的地标卡
+ * 注册表释放地标卡或登记时地标卡已空闲,都会将地标卡投递至管制器线程,不做轮询
+ * 管制器按优先级从高到低、等待时间从长到短为等待者锁定地标卡,成功后在AGV所在的线程中调用TrafficPass
+ * 以交叉口为单位统计等待时间,未指定交叉口的地标卡以自身编号作为交叉口
+ * 等待时间的指标只为指定的交叉口分别建立序列,其余地标卡合并为cross="other",序列数量不随经过的地标卡增长
+ */
+class TrafficController : public QObject
+{
+    Q_OBJECT
+public:
+    /*!
+     * @param RfidRegistry& RFID地标卡注册表
+     * @param const std::string& 指标的公共标签,如 zone="1",同一注册表有多个管制器时用以区分
+     */
+    explicit TrafficController(RfidRegistry& _registry,const std::string& _labels = "",QObject *parent = nullptr);
+    ~TrafficController();
+
+public:
+    typedef unsigned int Cross_t;
+
+    /*!
+     * @brief 为等待者锁定地标卡的函数,在管制器线程中调用
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const RfidBase::Rfid_t& 等待的RFID地标卡编号
+     * @param RfidBase::Rfid_t& 锁定失败时实际被占用的地标卡,等待者改在该地标卡释放时重试
+     * @return bool 锁定成功返回true
+     */
+    typedef std::function<bool(const AgvBase::AId_t&,const RfidBase::Rfid_t&,RfidBase::Rfid_t&)> Acquirer;
+
+    /*!
+     * @brief 撤销为已取消的等待者锁定的地标卡,在管制器线程中调用
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const RfidBase::Rfid_t& 等待的RFID地标卡编号
+     */
+    typedef std::function<void(const AgvBase::AId_t&,const RfidBase::Rfid_t&)> Releaser;
+
+    /*! @brief 描述交叉口等待时间统计的结构体 */
+    struct WaitStats
+    {
+        size_t m_count;                 /*!< 放行次数 */
+        long long m_total;              /*!< 累计等待时间:单位(ms) */
+        long long m_max;                /*!< 最长等待时间:单位(ms) */
+    };
+
+protected:
+    /*! @brief 描述等待者的结构体 */
+    struct Waiter
+    {
+        AgvBase* m_pAgv;                                    /*!< AGV对象 */
+        RfidBase::Rfid_t m_rfid;                            /*!< 等待的地标卡 */
+        RfidBase::Rfid_t m_blocker;                         /*!< 阻挡等待者的地标卡,其释放时重试 */
+        std::chrono::steady_clock::time_point m_since;      /*!< 开始等待的时间 */
+    };
+
+    /*! @brief 描述被管制AGV的结构体 */
+    struct AgvEntry
+    {
+        AgvBase* m_pAgv;                        /*!< AGV对象 */
+        int m_priority;                         /*!< 优先级,数值越大优先级越高 */
+        QMetaObject::Connection m_connection;   /*!< 当前地标卡改变信号的连接 */
+    };
+
+protected:
+    RfidRegistry& m_registry;                               /*!< RFID地标卡注册表 */
+    RfidRegistry::HandlerId_t m_freeHandler;                /*!< 释放处理函数的订阅编号 */
+    QThread m_thread;                                       /*!< 放行等待者的线程 */
+    std::mutex m_mutex;                                     /*!< 互斥锁 */
+    Acquirer m_acquirer;                                    /*!< 为等待者锁定地标卡的函数 */
+    Releaser m_releaser;                                    /*!< 撤销为已取消的等待者锁定的地标卡的函数 */
+    std::map<AgvBase::AId_t,AgvEntry> m_agvs;               /*!< 被管制的AGV */
+    std::map<AgvBase::AId_t,Waiter> m_waiters;              /*!< 各AGV的等待 */
+    std::map<RfidBase::Rfid_t,std::vector<AgvBase::AId_t> > m_queues;   /*!< 被各地标卡阻挡的等待者 */
+    std::vector<RfidBase::Rfid_t> m_pending;                /*!< 待处理的地标卡 */
+    bool m_bScheduled;                                      /*!< 是否已投递处理 */
+    std::map<RfidBase::Rfid_t,Cross_t> m_crosses;           /*!< 地标卡所属的交叉口 */
+    std::map<Cross_t,WaitStats> m_stats;                    /*!< 各交叉口的等待时间统计 */
+    std::string m_labels;                                   /*!< 指标的公共标签 */
+    std::map<Cross_t,MetricsRegistry::MetricId> m_metrics;  /*!< 指定的各交叉口等待时间的指标 */
+    MetricsRegistry::MetricId m_otherWait;                  /*!< 未指定交叉口的地标卡等待时间的指标 */
+    DeadlockDetector* m_pDetector;                          /*!< 死锁检测器 */
+
+public:
+    /*!
+     * @brief 设置为等待者锁定地标卡的函数
+     *
+     * 默认只锁定等待的地标卡;与RouteLocker共用时可改为以RouteLocker::Acquire整体锁定路线前方的地标卡,并输出被占用的地标卡
+     * 锁定成功但等待者已被取消时调用撤销函数;锁定前AGV已持有等待的地标卡时不撤销
+     * @param const Acquirer& 锁定函数
+     * @param const Releaser& 撤销函数,为空时不撤销,锁定的地标卡由锁定函数的提供者管理
+     */
+    void SetAcquirer(const Acquirer& _acquirer,const Releaser& _releaser = nullptr);
+
+    /*!
+     * @brief 设置死锁检测器,登记或改变等待时报告AGV等待的地标卡,放行或删除等待时报告AGV不再等待
+     * @param DeadlockDetector* 死锁检测器,为nullptr时不报告
+     */
+    void SetDetector(DeadlockDetector* _detector);
+
+    /*!
+     * @brief 开始管制AGV,AGV离开等待位置时自动删除其等待
+     * @param AgvBase* AGV对象
+     * @param const int& 优先级,数值越大优先级越高
+     */
+    void Watch(AgvBase* _agv,const int& _priority = 0);
+
+    /*!
+     * @brief 停止管制AGV并删除其等待
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Unwatch(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 设置AGV的优先级
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const int& 优先级,数值越大优先级越高
+     */
+    void SetPriority(const AgvBase::AId_t& _id,const int& _priority);
+
+    /*!
+     * @brief 设置地标卡所属的交叉口
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const Cross_t& 交叉口编号
+     */
+    void SetCross(const RfidBase::Rfid_t& _rfid,const Cross_t& _cross);
+
+    /*!
+     * @brief 登记AGV等待地标卡
+     *
+     * 地标卡已空闲时立即投递处理
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const RfidBase::Rfid_t& 等待的RFID地标卡编号
+     * @return bool AGV未被管制时返回false
+     */
+    bool Wait(const AgvBase::AId_t& _id,const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 删除AGV的等待
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Cancel(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 获取交叉口的等待时间统计
+     * @param const Cross_t& 交叉口编号
+     * @param WaitStats& 统计结果
+     * @return bool 交叉口有放行记录时返回true
+     */
+    bool GetStats(const Cross_t& _cross,WaitStats& _stats);
+
+protected:
+    /*!
+     * @brief 地标卡被释放,在释放地标卡的线程中调用
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Freed(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 将地标卡加入待处理列表,调用方需持有锁
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     */
+    void Schedule(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 删除AGV的等待,调用方需持有锁
+     * @param const AgvBase::AId_t& AGV编号
+     * @return bool AGV有等待返回true
+     */
+    bool RemoveWaiter(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 向死锁检测器报告AGV的等待,调用时不持有锁
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const bool& 是否在等待
+     * @param const RfidBase::Rfid_t& 等待时阻挡AGV的地标卡
+     */
+    void Report(const AgvBase::AId_t& _id,const bool& _bWaiting,const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 注册等待时间的直方图
+     * @param const std::string& 交叉口的标签值
+     * @return MetricsRegistry::MetricId 指标编号
+     */
+    MetricsRegistry::MetricId AddWaitHistogram(const std::string& _cross) const;
+
+    /*!
+     * @brief 记录放行的等待时间,调用方需持有锁
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @param const long long& 等待时间:单位(ms)
+     */
+    void Record(const RfidBase::Rfid_t& _rfid,const long long& _wait);
+
+protected slots:
+    /*!
+     * @brief 处理待处理的地标卡,按优先级放行等待者
+     */
+    void Dispatch();
+};
+
+#endif // TRAFFICCONTROLLER_H
@@ -57,3 +57,13 @@ std::string TransferAgv::GetActionName() const
 
     return _act + _actStatus;
 }
+
+AgvBase::AAction_t TransferAgv::GetLoadAction() const
+{
+    return 2;
+}
+
+AgvBase::AAction_t TransferAgv::GetUnloadAction() const
+{
+    return 1;
+}
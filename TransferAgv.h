@@ -34,6 +34,18 @@ public:
      * @return string 动作信息
      */
     std::string GetActionName() const;
+
+    /*!
+     * @brief 获取取货的动作码
+     * @return AAction_t 动作码
+     */
+    AAction_t GetLoadAction() const;
+
+    /*!
+     * @brief 获取卸货的动作码
+     * @return AAction_t 动作码
+     */
+    AAction_t GetUnloadAction() const;
 };
 
 #endif // TRANSFERAGV_H
@@ -0,0 +1,308 @@
+#include "WireRecorder.h"
+
+#include "AgvBase.h"
+
+#include <string.h>
+
+const char WireRecorder::FILE_MAGIC[8] = {'A','G','V','W','I','R','E','1'};
+
+static const size_t RECORD_HEAD_SIZE = 8 + 2 + 1 + 4;          /*!< 记录头大小 */
+static const size_t MAX_BUFFER_SIZE = 64 * 1024 * 1024;        /*!< 缓存区最大大小 */
+
+WireRecorder::WireRecorder()
+{
+    m_bRun = false;
+    m_flushSize = 64 * 1024;
+    m_dropped = 0;
+}
+
+WireRecorder::~WireRecorder()
+{
+    Close();
+}
+
+bool WireRecorder::Open(const std::string &_file, const size_t &_flushSize)
+{
+    Close();
+
+    m_file.open(_file.c_str(),std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if(m_file.is_open() == false)
+    {
+        return false;
+    }
+
+    m_file.write(FILE_MAGIC,sizeof(FILE_MAGIC));
+
+    m_flushSize = _flushSize;
+    m_dropped = 0;
+    m_buf.clear();
+    m_buf.reserve(m_flushSize * 2);
+    m_start = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+        m_bRun = true;
+    }
+
+    m_thread = std::thread(&WireRecorder::Run,this);
+
+    return true;
+}
+
+void WireRecorder::Close()
+{
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        if(m_bRun == false)
+        {
+            return;
+        }
+
+        m_bRun = false;
+    }
+
+    m_cond.notify_one();
+
+    if(m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    m_file.close();
+
+    return;
+}
+
+bool WireRecorder::IsOpen() const
+{
+    return m_file.is_open();
+}
+
+void WireRecorder::Record(const AId_t &_id, const WireDirection &_dir, const char *_data, const size_t &_size)
+{
+    unsigned long long _time = static_cast<unsigned long long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count());
+
+    char _head[RECORD_HEAD_SIZE];   /*!< 记录头 */
+    size_t _index = 0;              /*!< 下标 */
+
+    // 时间
+    for(size_t i = 0; i < 8; ++i)
+    {
+        _head[_index++] = static_cast<char>((_time >> 8 * i) & 0xFF);
+    }
+
+    // 编号
+    for(size_t i = 0; i < sizeof(_id); ++i)
+    {
+        _head[_index++] = static_cast<char>((_id >> 8 * i) & 0xFF);
+    }
+
+    // 方向
+    _head[_index++] = static_cast<char>(_dir);
+
+    // 数据长度
+    for(size_t i = 0; i < 4; ++i)
+    {
+        _head[_index++] = static_cast<char>((_size >> 8 * i) & 0xFF);
+    }
+
+    bool _notify = false;   /*!< 唤醒写线程标识 */
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        if(m_bRun == false)
+        {
+            return;
+        }
+
+        if(m_buf.size() + RECORD_HEAD_SIZE + _size > MAX_BUFFER_SIZE)
+        {
+            // 写入速度跟不上录制速度,丢弃数据以保护通信线程
+            m_dropped += RECORD_HEAD_SIZE + _size;
+            return;
+        }
+
+        m_buf.insert(m_buf.end(),_head,_head + RECORD_HEAD_SIZE);
+        m_buf.insert(m_buf.end(),_data,_data + _size);
+
+        _notify = m_buf.size() >= m_flushSize;
+    }
+
+    if(_notify)
+    {
+        m_cond.notify_one();
+    }
+
+    return;
+}
+
+void WireRecorder::Record(const AId_t &_id, const WireDirection &_dir, const QByteArray &_data)
+{
+    Record(_id,_dir,_data.data(),static_cast<size_t>(_data.size()));
+}
+
+unsigned long long WireRecorder::GetDropped()
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    return m_dropped;
+}
+
+void WireRecorder::Run()
+{
+    std::unique_lock<std::mutex> _lock(m_mutex);
+
+    while(1)
+    {
+        // 缓存区数据不足时最多等待1s,保证数据及时落盘
+        m_cond.wait_for(_lock,std::chrono::seconds(1),[this]{ return m_bRun == false || m_buf.size() >= m_flushSize; });
+
+        bool _run = m_bRun;
+
+        m_write.swap(m_buf);
+
+        _lock.unlock();
+
+        if(m_write.empty() == false)
+        {
+            m_file.write(m_write.data(),static_cast<std::streamsize>(m_write.size()));
+            m_file.flush();
+            m_write.clear();
+        }
+
+        _lock.lock();
+
+        if(_run == false && m_buf.empty())
+        {
+            break;
+        }
+    }
+
+    return;
+}
+
+WireReplayer::WireReplayer()
+{
+}
+
+bool WireReplayer::Load(const std::string &_file)
+{
+    m_records.clear();
+
+    std::ifstream _in(_file.c_str(),std::ios::in | std::ios::binary);
+
+    if(_in.is_open() == false)
+    {
+        return false;
+    }
+
+    char _magic[sizeof(WireRecorder::FILE_MAGIC)];
+
+    if(!_in.read(_magic,sizeof(_magic)) || memcmp(_magic,WireRecorder::FILE_MAGIC,sizeof(_magic)) != 0)
+    {
+        // 文件格式错误
+        return false;
+    }
+
+    unsigned char _head[RECORD_HEAD_SIZE];  /*!< 记录头 */
+
+    while(_in.read(reinterpret_cast<char*>(_head),RECORD_HEAD_SIZE))
+    {
+        WireRecord _record;
+        size_t _index = 0;
+
+        _record.m_time = 0;
+        for(size_t i = 0; i < 8; ++i)
+        {
+            _record.m_time |= static_cast<unsigned long long>(_head[_index++]) << (8 * i);
+        }
+
+        _record.m_id = 0;
+        for(size_t i = 0; i < sizeof(AId_t); ++i)
+        {
+            _record.m_id |= static_cast<AId_t>(_head[_index++] << (8 * i));
+        }
+
+        _record.m_dir = _head[_index++];
+
+        unsigned int _size = 0;
+        for(size_t i = 0; i < 4; ++i)
+        {
+            _size |= static_cast<unsigned int>(_head[_index++]) << (8 * i);
+        }
+
+        if(RECORD_HEAD_SIZE + _size > MAX_BUFFER_SIZE)
+        {
+            // 录制时不会写入超过缓存区的记录,长度损坏时不按其分配内存
+            m_records.clear();
+
+            return false;
+        }
+
+        std::vector<char> _data(_size);
+
+        if(_size > 0 && !_in.read(_data.data(),_size))
+        {
+            // 记录不完整,录制时程序异常退出
+            break;
+        }
+
+        _record.m_data = QByteArray(_data.data(),static_cast<int>(_size));
+
+        m_records.push_back(_record);
+    }
+
+    return true;
+}
+
+const std::vector<WireReplayer::WireRecord> &WireReplayer::GetRecords() const
+{
+    return m_records;
+}
+
+WireReplayer::ReplayStat WireReplayer::Replay(const std::map<AId_t, AgvBase *> &_agvs, const ReplayMode &_mode, const double &_rate) const
+{
+    ReplayStat _stat;
+    _stat.m_records = 0;
+    _stat.m_skipped = 0;
+    _stat.m_bytes = 0;
+    _stat.m_elapsed = 0.0;
+
+    std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();   /*!< 回放开始的时间 */
+    unsigned long long _base = m_records.empty() ? 0 : m_records.front().m_time;        /*!< 首条记录的时间 */
+
+    for(std::vector<WireRecord>::const_iterator it = m_records.begin(); it != m_records.end(); ++it)
+    {
+        if(it->m_dir != WireRecorder::Dir_In)
+        {
+            continue;
+        }
+
+        std::map<AId_t,AgvBase*>::const_iterator _agv = _agvs.find(it->m_id);
+
+        if(_agv == _agvs.end() || _agv->second == nullptr)
+        {
+            ++_stat.m_skipped;
+            continue;
+        }
+
+        if(_mode == Mode_RealTime && _rate > 0.0)
+        {
+            std::chrono::microseconds _offset(static_cast<long long>((it->m_time - _base) / _rate));
+            std::this_thread::sleep_until(_start + _offset);
+        }
+
+        _agv->second->ReceiveData(it->m_data);
+
+        ++_stat.m_records;
+        _stat.m_bytes += static_cast<unsigned long long>(it->m_data.size());
+    }
+
+    _stat.m_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+
+    return _stat;
+}
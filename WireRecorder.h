@@ -0,0 +1,172 @@
+/*!
+ * @file WireRecorder
+ * @brief 描述AGV通信原始数据录制与回放功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef WIRERECORDER_H
+#define WIRERECORDER_H
+
+#include <QByteArray>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AgvBase;
+
+/*!
+ * @class WireRecorder
+ * @brief 录制AGV收发原始字节流的类
+ *
+ * 录制数据先写入内存缓存区,由独立的写线程批量写入文件,不阻塞AGV的通信线程
+ * 文件格式: 文件头"AGVWIRE1" + 若干条记录
+ * 记录格式: 时间(8字节,单位us) + AGV编号(2字节) + 方向(1字节) + 数据长度(4字节) + 数据内容,均为小端字节序
+ */
+class WireRecorder
+{
+public:
+    WireRecorder();
+    ~WireRecorder();
+
+public:
+    typedef unsigned short AId_t;
+
+    /*! @brief 描述数据方向的枚举 */
+    enum WireDirection
+    {
+        Dir_In,     /*!< AGV上传至系统的数据 */
+        Dir_Out,    /*!< 系统下发至AGV的数据 */
+    };
+
+    /*! @brief 录制文件的文件头 */
+    static const char FILE_MAGIC[8];
+
+protected:
+    std::ofstream m_file;                               /*!< 录制文件 */
+    std::vector<char> m_buf;                            /*!< 待写入文件的缓存区 */
+    std::vector<char> m_write;                          /*!< 写线程正在写入的缓存区 */
+    std::mutex m_mutex;                                 /*!< 缓存区互斥锁 */
+    std::condition_variable m_cond;                     /*!< 唤醒写线程的条件变量 */
+    std::thread m_thread;                               /*!< 写线程 */
+    bool m_bRun;                                        /*!< 写线程运行标识 */
+    std::chrono::steady_clock::time_point m_start;      /*!< 录制开始的时间 */
+    size_t m_flushSize;                                 /*!< 触发写入文件的缓存区大小 */
+    unsigned long long m_dropped;                       /*!< 因缓存区已满而丢弃的字节数 */
+
+public:
+    /*!
+     * @brief 开始录制
+     * @param const std::string& 录制文件路径
+     * @param const size_t& 缓存区数据量达到此大小时写入文件:单位(byte)
+     * @return bool 打开文件成功返回true,否则返回false
+     */
+    bool Open(const std::string& _file,const size_t& _flushSize = 64 * 1024);
+
+    /*!
+     * @brief 停止录制,将缓存区内剩余的数据写入文件
+     */
+    void Close();
+
+    /*!
+     * @brief 是否正在录制
+     * @return bool 正在录制返回true,否则返回false
+     */
+    bool IsOpen() const;
+
+    /*!
+     * @brief 录制一段数据
+     * @param const AId_t& AGV编号
+     * @param const WireDirection& 数据方向
+     * @param const char* 数据内容
+     * @param const size_t& 数据大小
+     */
+    void Record(const AId_t& _id,const WireDirection& _dir,const char* _data,const size_t& _size);
+    void Record(const AId_t& _id,const WireDirection& _dir,const QByteArray& _data);
+
+    /*!
+     * @brief 获取因缓存区已满而丢弃的字节数
+     * @return unsigned long long 丢弃的字节数
+     */
+    unsigned long long GetDropped();
+
+protected:
+    /*!
+     * @brief 写线程的执行函数
+     */
+    void Run();
+};
+
+/*!
+ * @class WireReplayer
+ * @brief 将录制的原始字节流重新送入AGV对象进行处理的类
+ *
+ * 回放时直接调用AgvBase::ReceiveData,应在AGV未连接网络时使用
+ */
+class WireReplayer
+{
+public:
+    WireReplayer();
+
+public:
+    typedef WireRecorder::AId_t AId_t;
+
+    /*! @brief 描述录制记录的结构体 */
+    struct WireRecord
+    {
+        unsigned long long m_time;  /*!< 时间:单位(us) */
+        AId_t m_id;                 /*!< AGV编号 */
+        unsigned char m_dir;        /*!< 数据方向 */
+        QByteArray m_data;          /*!< 数据内容 */
+    };
+
+    /*! @brief 描述回放结果的结构体 */
+    struct ReplayStat
+    {
+        size_t m_records;           /*!< 回放的记录数量 */
+        size_t m_skipped;           /*!< 未找到对应AGV而跳过的记录数量 */
+        unsigned long long m_bytes; /*!< 回放的字节数 */
+        double m_elapsed;           /*!< 回放耗时:单位(s) */
+    };
+
+    /*! @brief 描述回放模式的枚举 */
+    enum ReplayMode
+    {
+        Mode_RealTime,  /*!< 按录制时的时间间隔回放 */
+        Mode_Fast,      /*!< 尽可能快地回放 */
+    };
+
+protected:
+    std::vector<WireRecord> m_records;  /*!< 录制记录 */
+
+public:
+    /*!
+     * @brief 读取录制文件
+     * @param const std::string& 录制文件路径
+     * @return bool 读取成功返回true,文件不存在或格式错误返回false
+     */
+    bool Load(const std::string& _file);
+
+    /*!
+     * @brief 获取录制记录
+     * @return const std::vector<WireRecord>& 录制记录
+     */
+    const std::vector<WireRecord>& GetRecords() const;
+
+    /*!
+     * @brief 回放录制记录
+     *
+     * 仅回放AGV上传至系统的数据
+     * @param const std::map<AId_t,AgvBase*>& AGV编号与AGV对象的映射
+     * @param const ReplayMode& 回放模式
+     * @param const double& 实时模式下的回放倍速
+     * @return ReplayStat 回放结果
+     */
+    ReplayStat Replay(const std::map<AId_t,AgvBase*>& _agvs,const ReplayMode& _mode = Mode_Fast,const double& _rate = 1.0) const;
+};
+
+#endif // WIRERECORDER_H
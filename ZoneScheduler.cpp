@@ -0,0 +1,585 @@
+#include "ZoneScheduler.h"
+
+#include <QTimer>
+#include <string>
+
+const int ZoneScheduler::UNSETTLED = -1;
+
+ZoneScheduler::ZoneScheduler(const RfidMap &_map, const ContractionHierarchy &_ch, RfidRegistry &_registry, TimingWheel &_wheel, const std::chrono::milliseconds &_window)
+    : m_map(_map),m_registry(_registry)
+{
+    m_handler = [this](const Dispatcher::Order& _order,AgvBase* _agv){
+        LifeGuard::Token _token = m_guard.GetToken();
+
+        // 指令需在AGV所在的线程中发送
+        QTimer::singleShot(0,_agv,[this,_token,_order,_agv]{
+            LifeGuard::Scope _scope(_token);
+
+            if(_scope.IsEntered())
+            {
+                Send(_order,_agv);
+            }
+        });
+    };
+
+    MetricsRegistry& _metrics = MetricsRegistry::Instance();
+
+    RfidMap::Node_t _count = m_map.GetNodeCount();
+
+    m_borders.assign(_count,false);
+
+    for(RfidMap::Node_t _node = 0; _node < _count; ++_node)
+    {
+        RfidMap::Zone_t _zone = m_map.GetZone(_node);
+
+        for(RfidMap::Edge_t _edge = m_map.EdgeBegin(_node); _edge != m_map.EdgeEnd(_node); ++_edge)
+        {
+            RfidMap::Node_t _target = m_map.GetTarget(_edge);
+
+            if(m_map.GetZone(_target) != _zone)
+            {
+                m_borders[_node] = true;
+                m_borders[_target] = true;
+            }
+        }
+
+        if(m_shards.find(_zone) != m_shards.end())
+        {
+            continue;
+        }
+
+        std::string _labels = "zone=\"" + std::to_string(static_cast<unsigned int>(_zone)) + "\"";
+
+        Shard& _shard = m_shards[_zone];
+        _shard.m_zone = _zone;
+        _shard.m_count = 0;
+        _shard.m_pIndex = new AgvIndex();
+        _shard.m_pDispatcher = new Dispatcher(_ch,*_shard.m_pIndex,_wheel,_window);
+        _shard.m_pTraffic = new TrafficController(m_registry,_labels);
+        _shard.m_agvs = _metrics.AddGauge("agv_zone_agvs","AGVs taking part in assignment within the zone",_labels);
+        _shard.m_submitted = _metrics.AddCounter("agv_zone_orders_submitted_total","Transport orders submitted to the zone",_labels);
+        _shard.m_handoffs = _metrics.AddCounter("agv_zone_handoffs_total","AGVs handed over into the zone for assignment",_labels);
+
+        _shard.m_pDispatcher->SetHandler([this,_zone](const Dispatcher::Order& _order,AgvBase* _agv){ Assigned(_zone,_order,_agv); });
+    }
+}
+
+ZoneScheduler::~ZoneScheduler()
+{
+    // 等待正在AGV线程中交接或发送指令的回调返回
+    m_guard.Close();
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        for(std::map<AgvBase::AId_t,Member>::iterator it = m_members.begin(); it != m_members.end(); ++it)
+        {
+            QObject::disconnect(it->second.m_connection);
+        }
+
+        m_members.clear();
+    }
+
+    MetricsRegistry& _metrics = MetricsRegistry::Instance();
+
+    for(std::map<RfidMap::Zone_t,Shard>::iterator it = m_shards.begin(); it != m_shards.end(); ++it)
+    {
+        delete it->second.m_pDispatcher;
+        delete it->second.m_pTraffic;
+        delete it->second.m_pIndex;
+
+        _metrics.Remove(it->second.m_agvs);
+        _metrics.Remove(it->second.m_submitted);
+        _metrics.Remove(it->second.m_handoffs);
+    }
+
+    m_shards.clear();
+}
+
+bool ZoneScheduler::AddAgv(AgvBase *_agv, const int &_priority)
+{
+    if(_agv == nullptr)
+    {
+        return false;
+    }
+
+    Shard* _shard = Find(_agv->GetCurRfid());
+
+    if(_shard == nullptr)
+    {
+        return false;
+    }
+
+    AgvBase::AId_t _id = _agv->GetID();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_id);
+
+    if(it != m_members.end())
+    {
+        // 已参与调度,只更新优先级
+        it->second.m_priority = _priority;
+
+        m_shards[it->second.m_traffic].m_pTraffic->SetPriority(_id,_priority);
+
+        return true;
+    }
+
+    Member& _member = m_members[_id];
+    _member.m_pAgv = _agv;
+    _member.m_priority = _priority;
+    _member.m_owner = _shard->m_zone;
+    _member.m_traffic = _shard->m_zone;
+    _member.m_bAssigned = false;
+    _member.m_pSettled = std::make_shared<std::atomic<int> >(UNSETTLED);
+
+    _shard->m_pIndex->Add(_agv);
+    _shard->m_pDispatcher->AddAgv(_agv);
+    _shard->m_pTraffic->Watch(_agv,_priority);
+
+    MetricsRegistry::Instance().Set(_shard->m_agvs,static_cast<long long>(++_shard->m_count));
+
+    Settle(_member);
+
+    LifeGuard::Token _token = m_guard.GetToken();
+    std::shared_ptr<std::atomic<int> > _settled = _member.m_pSettled;
+
+    // 信号在AGV所在的线程中发出,直接在该线程中交接
+    _member.m_connection = QObject::connect(_agv,&AgvBase::RfidChanged,[this,_token,_agv,_settled]{
+        LifeGuard::Scope _scope(_token);
+
+        if(_scope.IsEntered())
+        {
+            Relocate(_agv,*_settled);
+        }
+    });
+
+    return true;
+}
+
+void ZoneScheduler::RemoveAgv(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_id);
+
+    if(it == m_members.end())
+    {
+        return;
+    }
+
+    Member& _member = it->second;
+
+    QObject::disconnect(_member.m_connection);
+
+    ClearGuests(_id,_member);
+
+    m_shards[_member.m_traffic].m_pTraffic->Unwatch(_id);
+
+    Shard& _owner = m_shards[_member.m_owner];
+    _owner.m_pDispatcher->RemoveAgv(_id);
+    _owner.m_pIndex->Remove(_id);
+
+    MetricsRegistry::Instance().Set(_owner.m_agvs,static_cast<long long>(--_owner.m_count));
+
+    m_members.erase(it);
+
+    return;
+}
+
+bool ZoneScheduler::Submit(const RfidBase::Rfid_t &_pickup, const RfidBase::Rfid_t &_drop, const float &_weight, const unsigned char &_ability,
+                           const unsigned char &_priority, const std::chrono::milliseconds &_deadline, ZoneScheduler::OrderId_t &_id)
+{
+    Shard* _shard = Find(_pickup);
+
+    if(_shard == nullptr)
+    {
+        return false;
+    }
+
+    Dispatcher::OrderId_t _local = _shard->m_pDispatcher->Submit(_pickup,_drop,_weight,_ability,_priority,_deadline);
+
+    _id = (static_cast<OrderId_t>(_shard->m_zone) << 32) | _local;
+
+    MetricsRegistry::Instance().Add(_shard->m_submitted);
+
+    return true;
+}
+
+bool ZoneScheduler::Cancel(const ZoneScheduler::OrderId_t &_id)
+{
+    std::map<RfidMap::Zone_t,Shard>::iterator it = m_shards.find(static_cast<RfidMap::Zone_t>(_id >> 32));
+
+    if(it == m_shards.end())
+    {
+        return false;
+    }
+
+    return it->second.m_pDispatcher->Cancel(static_cast<Dispatcher::OrderId_t>(_id & 0xFFFFFFFF));
+}
+
+void ZoneScheduler::Complete(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_id);
+
+    if(it == m_members.end())
+    {
+        return;
+    }
+
+    Member& _member = it->second;
+
+    m_shards[_member.m_owner].m_pDispatcher->Complete(_id);
+
+    _member.m_bAssigned = false;
+
+    // 执行订单期间离开了原区域,空闲后由所在区域分配
+    if(_member.m_owner != _member.m_traffic)
+    {
+        Transfer(_member,_member.m_traffic);
+    }
+
+    Settle(_member);
+
+    return;
+}
+
+bool ZoneScheduler::Reject(const AgvBase::AId_t &_id, const Dispatcher::OrderId_t &_order)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_id);
+
+    if(it == m_members.end() || it->second.m_bAssigned == false)
+    {
+        return false;
+    }
+
+    Member& _member = it->second;
+
+    if(m_shards[_member.m_owner].m_pDispatcher->Reject(_id,_order) == false)
+    {
+        return false;
+    }
+
+    _member.m_bAssigned = false;
+
+    // 与完成订单相同,空闲后由所在区域分配
+    if(_member.m_owner != _member.m_traffic)
+    {
+        Transfer(_member,_member.m_traffic);
+    }
+
+    Settle(_member);
+
+    return true;
+}
+
+bool ZoneScheduler::IsAssigned(const AgvBase::AId_t &_id, const Dispatcher::OrderId_t &_order)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_id);
+
+    if(it == m_members.end() || it->second.m_bAssigned == false)
+    {
+        return false;
+    }
+
+    // 执行订单期间归属不会转移
+    return m_shards[it->second.m_owner].m_pDispatcher->IsAssigned(_id,_order);
+}
+
+bool ZoneScheduler::Confirm(const AgvBase::AId_t &_id, const Dispatcher::OrderId_t &_order)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_id);
+
+    if(it == m_members.end() || it->second.m_bAssigned == false)
+    {
+        return false;
+    }
+
+    return m_shards[it->second.m_owner].m_pDispatcher->Confirm(_id,_order);
+}
+
+void ZoneScheduler::SetHandler(const Dispatcher::Handler &_handler)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    m_handler = _handler;
+
+    return;
+}
+
+bool ZoneScheduler::Wait(const AgvBase::AId_t &_id, const RfidBase::Rfid_t &_rfid)
+{
+    Shard* _shard = Find(_rfid);
+
+    if(_shard == nullptr)
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_id);
+
+        if(it == m_members.end())
+        {
+            return false;
+        }
+
+        Member& _member = it->second;
+
+        // 每辆AGV同时只等待一张地标卡,撤销其他区域的登记
+        if(_member.m_traffic != _shard->m_zone)
+        {
+            m_shards[_member.m_traffic].m_pTraffic->Cancel(_id);
+
+            if(_member.m_guests.insert(_shard->m_zone).second)
+            {
+                // 在边界等待其他区域的地标卡,作为访客加入该区域的管制器
+                _shard->m_pTraffic->Watch(_member.m_pAgv,_member.m_priority);
+
+                Settle(_member);
+            }
+        }
+
+        for(std::set<RfidMap::Zone_t>::iterator _guest = _member.m_guests.begin(); _guest != _member.m_guests.end(); ++_guest)
+        {
+            if(*_guest != _shard->m_zone)
+            {
+                m_shards[*_guest].m_pTraffic->Cancel(_id);
+            }
+        }
+    }
+
+    return _shard->m_pTraffic->Wait(_id,_rfid);
+}
+
+void ZoneScheduler::CancelWait(const AgvBase::AId_t &_id)
+{
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_id);
+
+    if(it == m_members.end())
+    {
+        return;
+    }
+
+    m_shards[it->second.m_traffic].m_pTraffic->Cancel(_id);
+
+    for(std::set<RfidMap::Zone_t>::iterator _guest = it->second.m_guests.begin(); _guest != it->second.m_guests.end(); ++_guest)
+    {
+        m_shards[*_guest].m_pTraffic->Cancel(_id);
+    }
+
+    return;
+}
+
+Dispatcher *ZoneScheduler::GetDispatcher(const RfidMap::Zone_t &_zone)
+{
+    std::map<RfidMap::Zone_t,Shard>::iterator it = m_shards.find(_zone);
+
+    return it == m_shards.end() ? nullptr : it->second.m_pDispatcher;
+}
+
+TrafficController *ZoneScheduler::GetTraffic(const RfidMap::Zone_t &_zone)
+{
+    std::map<RfidMap::Zone_t,Shard>::iterator it = m_shards.find(_zone);
+
+    return it == m_shards.end() ? nullptr : it->second.m_pTraffic;
+}
+
+void ZoneScheduler::GetZones(std::vector<RfidMap::Zone_t> &_zones) const
+{
+    _zones.clear();
+
+    for(std::map<RfidMap::Zone_t,Shard>::const_iterator it = m_shards.begin(); it != m_shards.end(); ++it)
+    {
+        _zones.push_back(it->first);
+    }
+
+    return;
+}
+
+bool ZoneScheduler::IsBorder(const RfidBase::Rfid_t &_rfid) const
+{
+    RfidMap::Node_t _node = m_map.GetNode(_rfid);
+
+    return _node != RfidMap::NIL && m_borders[_node];
+}
+
+ZoneScheduler::Shard *ZoneScheduler::Find(const RfidBase::Rfid_t &_rfid)
+{
+    RfidMap::Node_t _node = m_map.GetNode(_rfid);
+
+    if(_node == RfidMap::NIL)
+    {
+        return nullptr;
+    }
+
+    // 分片在构造后不再改变,无需加锁
+    std::map<RfidMap::Zone_t,Shard>::iterator it = m_shards.find(m_map.GetZone(_node));
+
+    return it == m_shards.end() ? nullptr : &it->second;
+}
+
+void ZoneScheduler::Assigned(const RfidMap::Zone_t &_zone, const Dispatcher::Order &_order, AgvBase *_agv)
+{
+    Dispatcher::Handler _handler;
+
+    {
+        std::lock_guard<std::mutex> _lock(m_mutex);
+
+        std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_agv->GetID());
+
+        // 分配的同时AGV被交接到其他区域或被移除时,分配器已将订单放回队列
+        if(it == m_members.end() || m_shards[_zone].m_pDispatcher->IsAssigned(it->first,_order.m_id) == false)
+        {
+            return;
+        }
+
+        it->second.m_bAssigned = true;
+
+        Settle(it->second);
+
+        _handler = m_handler;
+    }
+
+    if(_handler)
+    {
+        _handler(_order,_agv);
+    }
+
+    return;
+}
+
+void ZoneScheduler::Send(const Dispatcher::Order &_order, AgvBase *_agv)
+{
+    AgvBase::AId_t _id = _agv->GetID();
+
+    // 回调排队期间订单可能已被抢占改派或随交接放回队列
+    if(IsAssigned(_id,_order.m_id) == false)
+    {
+        return;
+    }
+
+    if(_agv->Move(_order.m_pickup) != AgvBase::Cmd_Success)
+    {
+        Reject(_id,_order.m_id);
+
+        return;
+    }
+
+    Confirm(_id,_order.m_id);
+
+    return;
+}
+
+void ZoneScheduler::Relocate(AgvBase *_agv, const std::atomic<int> &_settled)
+{
+    Shard* _shard = Find(_agv->GetCurRfid());
+
+    if(_shard == nullptr)
+    {
+        return;
+    }
+
+    // 仍在原区域、没有访客管制且归属无需转移,是绝大多数移动的情况
+    if(_settled.load() == static_cast<int>(_shard->m_zone))
+    {
+        return;
+    }
+
+    AgvBase::AId_t _id = _agv->GetID();
+
+    std::lock_guard<std::mutex> _lock(m_mutex);
+
+    std::map<AgvBase::AId_t,Member>::iterator it = m_members.find(_id);
+
+    if(it == m_members.end())
+    {
+        return;
+    }
+
+    Member& _member = it->second;
+
+    if(_shard->m_zone != _member.m_traffic)
+    {
+        // 交通管制跟随位置立即交接
+        m_shards[_member.m_traffic].m_pTraffic->Unwatch(_id);
+
+        _member.m_traffic = _shard->m_zone;
+        _member.m_guests.erase(_shard->m_zone);
+
+        _shard->m_pTraffic->Watch(_member.m_pAgv,_member.m_priority);
+    }
+
+    // 离开边界后不再需要访客管制
+    ClearGuests(_id,_member);
+
+    if(_member.m_bAssigned == false && _member.m_owner != _shard->m_zone)
+    {
+        Transfer(_member,_shard->m_zone);
+    }
+
+    Settle(_member);
+
+    return;
+}
+
+void ZoneScheduler::Transfer(ZoneScheduler::Member &_member, const RfidMap::Zone_t &_zone)
+{
+    AgvBase::AId_t _id = _member.m_pAgv->GetID();
+
+    MetricsRegistry& _metrics = MetricsRegistry::Instance();
+
+    Shard& _from = m_shards[_member.m_owner];
+    _from.m_pDispatcher->RemoveAgv(_id);
+    _from.m_pIndex->Remove(_id);
+
+    _metrics.Set(_from.m_agvs,static_cast<long long>(--_from.m_count));
+
+    Shard& _to = m_shards[_zone];
+    _to.m_pIndex->Add(_member.m_pAgv);
+    _to.m_pDispatcher->AddAgv(_member.m_pAgv);
+
+    _metrics.Set(_to.m_agvs,static_cast<long long>(++_to.m_count));
+    _metrics.Add(_to.m_handoffs);
+
+    _member.m_owner = _zone;
+
+    return;
+}
+
+void ZoneScheduler::ClearGuests(const AgvBase::AId_t &_id, ZoneScheduler::Member &_member)
+{
+    for(std::set<RfidMap::Zone_t>::iterator it = _member.m_guests.begin(); it != _member.m_guests.end(); ++it)
+    {
+        if(*it != _member.m_traffic)
+        {
+            m_shards[*it].m_pTraffic->Unwatch(_id);
+        }
+    }
+
+    _member.m_guests.clear();
+
+    return;
+}
+
+void ZoneScheduler::Settle(ZoneScheduler::Member &_member)
+{
+    bool _bSettled = _member.m_guests.empty() && (_member.m_bAssigned || _member.m_owner == _member.m_traffic);
+
+    _member.m_pSettled->store(_bSettled ? static_cast<int>(_member.m_traffic) : UNSETTLED);
+
+    return;
+}
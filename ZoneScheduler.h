@@ -0,0 +1,262 @@
+/*!
+ * @file ZoneScheduler
+ * @brief 描述按区域分片并行调度AGV功能的文件
+ * @date 2026-10-19
+ * @version 1.0
+ */
+#ifndef ZONESCHEDULER_H
+#define ZONESCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "Dispatcher.h"
+#include "LifeGuard.h"
+#include "TrafficController.h"
+
+/*!
+ * @class ZoneScheduler
+ * @brief 按路线图区域划分车队,每个区域由独立的订单分配器与交通管制器并行调度
+ *
+ * 每个区域拥有自己的AGV索引、订单分配器与交通管制器,分配器与管制器各自运行在独立的线程中,区域内的分配与管制不共享锁
+ * 本调度器的锁只在交接、完成订单与边界等待登记时持有;AGV在区域内移动时由AGV线程读取原子标记判断无需交接,不加锁
+ * 地标卡注册表全局共享,以原子操作逐张锁定,跨区域路线与边界地标卡的互斥仍由注册表保证
+ * 各区域的管制器分别订阅注册表的释放通知,只处理本区域有等待者的地标卡;等待的登记交给地标卡所在区域的管制器
+ *
+ * 交接规则:
+ * 1.订单按取货点所在区域提交,由该区域分配
+ * 2.交通管制跟随AGV的位置,AGV进入其他区域的地标卡时立即由新区域的管制器管制
+ * 3.AGV在区域边界等待其他区域的地标卡时,作为访客加入该区域的管制器,进入新区域或离开后撤销
+ * 4.参与分配的归属在AGV空闲时跟随位置转移;执行订单期间保留在分配订单的区域,完成订单后再转移,避免两个区域同时分配同一辆AGV
+ */
+class ZoneScheduler
+{
+public:
+    /*!
+     * @param const RfidMap& 已加载的路线图
+     * @param const ContractionHierarchy& 已预处理的收缩层次路网
+     * @param RfidRegistry& RFID地标卡注册表
+     * @param TimingWheel& 时间轮
+     * @param const std::chrono::milliseconds& 分配器的批量分配窗口
+     */
+    ZoneScheduler(const RfidMap& _map,const ContractionHierarchy& _ch,RfidRegistry& _registry,TimingWheel& _wheel,
+                  const std::chrono::milliseconds& _window = std::chrono::milliseconds(500));
+    ~ZoneScheduler();
+
+public:
+    typedef unsigned long long OrderId_t;       /*!< 高32位为区域编号,低32位为区域内的订单编号 */
+
+protected:
+    /*! @brief 描述区域分片的结构体 */
+    struct Shard
+    {
+        RfidMap::Zone_t m_zone;                 /*!< 区域编号 */
+        size_t m_count;                         /*!< 区域内参与分配的AGV数量 */
+        AgvIndex* m_pIndex;                     /*!< 区域内参与分配的AGV索引 */
+        Dispatcher* m_pDispatcher;              /*!< 区域的订单分配器 */
+        TrafficController* m_pTraffic;          /*!< 区域的交通管制器 */
+        MetricsRegistry::MetricId m_agvs;       /*!< 区域内参与分配的AGV数量的指标 */
+        MetricsRegistry::MetricId m_submitted;  /*!< 区域内提交订单数量的指标 */
+        MetricsRegistry::MetricId m_handoffs;   /*!< 转入区域次数的指标 */
+    };
+
+    /*! @brief 描述AGV归属的结构体 */
+    struct Member
+    {
+        AgvBase* m_pAgv;                        /*!< AGV对象 */
+        int m_priority;                         /*!< 交通管制优先级 */
+        RfidMap::Zone_t m_owner;                /*!< 参与分配的区域 */
+        RfidMap::Zone_t m_traffic;              /*!< 负责交通管制的区域 */
+        std::set<RfidMap::Zone_t> m_guests;     /*!< 作为访客加入的区域 */
+        bool m_bAssigned;                       /*!< 是否正在执行订单 */
+        QMetaObject::Connection m_connection;   /*!< 当前地标卡改变信号的连接 */
+        std::shared_ptr<std::atomic<int> > m_pSettled;  /*!< 无需交接时为负责交通管制的区域,否则为UNSETTLED,在AGV线程中不加锁读取 */
+    };
+
+protected:
+    const RfidMap& m_map;                                   /*!< 路线图 */
+    RfidRegistry& m_registry;                               /*!< RFID地标卡注册表 */
+    std::map<RfidMap::Zone_t,Shard> m_shards;               /*!< 各区域的分片,构造后不再改变 */
+    std::vector<bool> m_borders;                            /*!< 各节点是否为边界地标卡 */
+    std::mutex m_mutex;                                     /*!< 互斥锁 */
+    std::map<AgvBase::AId_t,Member> m_members;              /*!< 参与调度的AGV */
+    Dispatcher::Handler m_handler;                          /*!< 执行分配结果的处理函数 */
+    LifeGuard m_guard;                                      /*!< 在AGV线程中调用的回调的存活标记 */
+
+    static const int UNSETTLED;                             /*!< AGV可能需要交接的标记 */
+
+public:
+    /*!
+     * @brief 添加参与调度的AGV,由当前地标卡所在的区域接管
+     * @param AgvBase* AGV对象
+     * @param const int& 交通管制优先级,数值越大优先级越高
+     * @return bool 当前地标卡不在路线图中返回false
+     */
+    bool AddAgv(AgvBase* _agv,const int& _priority = 0);
+
+    /*!
+     * @brief 移除参与调度的AGV
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void RemoveAgv(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 提交搬运订单,由取货点所在的区域分配
+     * @param const RfidBase::Rfid_t& 取货点RFID地标卡编号
+     * @param const RfidBase::Rfid_t& 卸货点RFID地标卡编号
+     * @param const float& 货物重量:单位(kg)
+     * @param const unsigned char& 需要的AGV功能,0为不限
+     * @param const unsigned char& 优先级,越大越优先
+     * @param const std::chrono::milliseconds& 自提交起的时限,0为默认时限
+     * @param OrderId_t& 订单编号
+     * @return bool 取货点不在路线图中返回false
+     */
+    bool Submit(const RfidBase::Rfid_t& _pickup,const RfidBase::Rfid_t& _drop,const float& _weight,const unsigned char& _ability,
+                const unsigned char& _priority,const std::chrono::milliseconds& _deadline,OrderId_t& _id);
+
+    /*!
+     * @brief 取消尚未分配的订单
+     * @param const OrderId_t& 订单编号
+     * @return bool 订单尚未分配返回true,否则返回false
+     */
+    bool Cancel(const OrderId_t& _id);
+
+    /*!
+     * @brief AGV完成订单,空闲后归属转移到当前所在的区域
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void Complete(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief AGV未能执行分配的订单,订单放回分配的区域,归属与完成订单时相同
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const Dispatcher::OrderId_t& 区域内的订单编号,即Dispatcher::Order::m_id
+     * @return bool AGV仍在执行该订单返回true
+     */
+    bool Reject(const AgvBase::AId_t& _id,const Dispatcher::OrderId_t& _order);
+
+    /*!
+     * @brief 设置执行分配结果的处理函数,在分配器线程中调用
+     *
+     * 应在AGV所在的线程中先以IsAssigned确认订单未被改派再发送指令,发送成功后调用Confirm,未能令AGV执行订单时应调用Reject放回订单
+     * @param const Dispatcher::Handler& 处理函数
+     */
+    void SetHandler(const Dispatcher::Handler& _handler);
+
+    /*!
+     * @brief AGV是否仍在执行该订单,处理函数发送指令前调用
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const Dispatcher::OrderId_t& 区域内的订单编号,即Dispatcher::Order::m_id
+     * @return bool AGV仍在执行该订单返回true
+     */
+    bool IsAssigned(const AgvBase::AId_t& _id,const Dispatcher::OrderId_t& _order);
+
+    /*!
+     * @brief AGV已接受订单的移动指令,此后订单才可被抢占
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const Dispatcher::OrderId_t& 区域内的订单编号,即Dispatcher::Order::m_id
+     * @return bool AGV仍在执行该订单返回true
+     */
+    bool Confirm(const AgvBase::AId_t& _id,const Dispatcher::OrderId_t& _order);
+
+    /*!
+     * @brief 登记因地标卡被占用而交通管制停止的AGV,由地标卡所在区域的管制器放行
+     * @param const AgvBase::AId_t& AGV编号
+     * @param const RfidBase::Rfid_t& 等待的RFID地标卡编号
+     * @return bool AGV未参与调度或地标卡不在路线图中返回false
+     */
+    bool Wait(const AgvBase::AId_t& _id,const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 撤销AGV的等待登记
+     * @param const AgvBase::AId_t& AGV编号
+     */
+    void CancelWait(const AgvBase::AId_t& _id);
+
+    /*!
+     * @brief 获取区域的订单分配器,用于设置分配参数
+     *
+     * 分配结果经由本调度器转交处理函数,不要替换分配器的处理函数
+     * @param const RfidMap::Zone_t& 区域编号
+     * @return Dispatcher* 分配器,区域不存在时返回nullptr
+     */
+    Dispatcher* GetDispatcher(const RfidMap::Zone_t& _zone);
+
+    /*!
+     * @brief 获取区域的交通管制器,用于设置交叉口
+     * @param const RfidMap::Zone_t& 区域编号
+     * @return TrafficController* 管制器,区域不存在时返回nullptr
+     */
+    TrafficController* GetTraffic(const RfidMap::Zone_t& _zone);
+
+    /*!
+     * @brief 获取所有区域编号
+     * @param std::vector<RfidMap::Zone_t>& 区域编号
+     */
+    void GetZones(std::vector<RfidMap::Zone_t>& _zones) const;
+
+    /*!
+     * @brief 地标卡是否为与其他区域相连的边界地标卡
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @return bool 是边界地标卡返回true
+     */
+    bool IsBorder(const RfidBase::Rfid_t& _rfid) const;
+
+protected:
+    /*!
+     * @brief 查找地标卡所在区域的分片
+     * @param const RfidBase::Rfid_t& RFID地标卡编号
+     * @return Shard* 分片,地标卡不在路线图中时返回nullptr
+     */
+    Shard* Find(const RfidBase::Rfid_t& _rfid);
+
+    /*!
+     * @brief 区域分配器分配了订单,在分配器线程中调用
+     * @param const RfidMap::Zone_t& 区域编号
+     * @param const Dispatcher::Order& 订单
+     * @param AgvBase* 执行订单的AGV
+     */
+    void Assigned(const RfidMap::Zone_t& _zone,const Dispatcher::Order& _order,AgvBase* _agv);
+
+    /*!
+     * @brief 默认的处理函数,在AGV所在的线程中发送订单的移动指令
+     * @param const Dispatcher::Order& 订单
+     * @param AgvBase* 分配的AGV
+     */
+    void Send(const Dispatcher::Order& _order,AgvBase* _agv);
+
+    /*!
+     * @brief AGV的当前地标卡改变,按新位置交接交通管制与分配归属,在AGV所在的线程中调用
+     *
+     * 仍在原区域且无需交接时直接返回,不加锁
+     * @param AgvBase* AGV对象
+     * @param const std::atomic<int>& AGV的交接标记
+     */
+    void Relocate(AgvBase* _agv,const std::atomic<int>& _settled);
+
+    /*!
+     * @brief 按AGV当前的归属更新交接标记,调用前需加锁
+     * @param Member& AGV归属
+     */
+    void Settle(Member& _member);
+
+    /*!
+     * @brief 将空闲AGV的分配归属转移到指定区域,调用前需加锁
+     * @param Member& AGV归属
+     * @param const RfidMap::Zone_t& 目标区域
+     */
+    void Transfer(Member& _member,const RfidMap::Zone_t& _zone);
+
+    /*!
+     * @brief 撤销AGV在各区域的访客管制,调用前需加锁
+     * @param const AgvBase::AId_t& AGV编号
+     * @param Member& AGV归属
+     */
+    void ClearGuests(const AgvBase::AId_t& _id,Member& _member);
+};
+
+#endif // ZONESCHEDULER_H